@@ -2,6 +2,7 @@
 
 #include "../../../Engine/Components/RenderComponent.h"
 #include "../../../Engine/RenderCore/Camera/Camera.h"
+#include "../../../Engine/RenderCore/Lighting/LightSource.h"
 
 Scene1::Scene1()
 {}
@@ -21,6 +22,38 @@ bool Scene1::OnCreate()
 	m_world->AddComponentToEntity<CameraComponent>( camera );
 	m_world->AddComponentToEntity<TransformComponent>( camera );
 
+	// Key light, reaching from the camera's start to the F-16
+	ECS::EntityId keyLight = m_world->CreateEntities( 1 ).front();
+	m_world->AddComponentToEntity<TransformComponent>(
+		keyLight,
+		glm::vec3( 0.0f, 20.0f, 25.0f ),
+		0.0f,
+		glm::vec3( 0.0f, 1.0f, 0.0f ),
+		glm::vec3( 1.0f, 1.0f, 1.0f )
+	);
+	m_world->AddComponentToEntity<LightSourceComponent>( keyLight, 0.2f, 0.8f, glm::vec3( 1.0f, 1.0f, 1.0f ), 150.0f );
+
+	// Small coloured lights along the row of models, each only reaching a few of them
+	const glm::vec3 lightColours[] = {
+		glm::vec3( 1.0f, 0.2f, 0.2f ),
+		glm::vec3( 0.2f, 1.0f, 0.2f ),
+		glm::vec3( 0.2f, 0.2f, 1.0f ),
+		glm::vec3( 1.0f, 0.8f, 0.2f )
+	};
+
+	std::vector<ECS::EntityId> lights = m_world->CreateEntities( 200 );
+	for ( int i = 0; i < lights.size(); i++ )
+	{
+		m_world->AddComponentToEntity<TransformComponent>(
+			lights[i],
+			glm::vec3( -49.0f + static_cast<float>( i ), 2.0f, ( i % 2 == 0 ) ? 2.0f : -2.0f ),
+			0.0f,
+			glm::vec3( 0.0f, 1.0f, 0.0f ),
+			glm::vec3( 1.0f, 1.0f, 1.0f )
+		);
+		m_world->AddComponentToEntity<LightSourceComponent>( lights[i], 0.0f, 1.0f, lightColours[i % 4], 4.0f );
+	}
+
 	// Shader
 	ShaderLinker* shaderLinker = new ShaderLinker( "PhongShader" );
 	shaderLinker->SubmitShader( new Shader( EShaderType::Vertex, "PhongVertex.glsl" ) );
@@ -6,6 +6,8 @@
 #include "../Graphics/OpenGL/OpenGLRenderer.h"
 #elif GRAPHICS_API == GRAPHICS_VULKAN
 #include "../Graphics/Vulkan/VulkanRenderer.h"
+#elif GRAPHICS_API == GRAPHICS_NULL
+#include "../Graphics/Null/NullRenderer.h"
 #endif
 
 IApp::IApp( const std::string& appName ) :
@@ -52,6 +54,11 @@ bool IApp::CreateRenderer(
 	m_renderer = new VulkanRenderer();
 	DEBUG_LOG( LOG::INFO, "Creating Vulkan Application: " + m_appName );
 
+#elif GRAPHICS_API == GRAPHICS_NULL
+
+	m_renderer = new NullRenderer();
+	DEBUG_LOG( LOG::INFO, "Creating Null Application: " + m_appName );
+
 #endif
 
 	if ( m_renderer == nullptr )
@@ -1,10 +1,94 @@
 #include "Engine.h"
+#include "ThreadPool.h"
 #include "../AppCore/App.h"
 #include "../Devices/Window.h"
+#include "../Graphics/Graphics.h"
+#include "../RenderCore/Loading/AssetLoader.h"
 
 #include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+	// Reads the frame stats a headless run wrote, one vector of values per column of the header
+	bool ReadFrameStats( const std::string& filePath, std::vector<std::string>& names, std::vector<std::vector<float>>& columns )
+	{
+		std::ifstream file( filePath );
+		std::string line;
+		if ( !file.is_open() || !std::getline( file, line ) )
+		{
+			return false;
+		}
+
+		std::istringstream header( line );
+		std::string name;
+		while ( std::getline( header, name, ',' ) )
+		{
+			names.push_back( name );
+		}
+		columns.assign( names.size(), std::vector<float>() );
+
+		while ( std::getline( file, line ) )
+		{
+			std::istringstream row( line );
+			std::string value;
+			for ( size_t column = 0; column < names.size() && std::getline( row, value, ',' ); ++column )
+			{
+				columns[column].push_back( std::strtof( value.c_str(), nullptr ) );
+			}
+		}
+
+		return true;
+	}
+
+	// Median of the values that are not negative, GPU timings are negative until their first results come back
+	// Returns a negative value if there are none
+	float Median( const std::vector<float>& values )
+	{
+		std::vector<float> sorted;
+		std::copy_if( values.begin(), values.end(), std::back_inserter( sorted ), []( const float value ) { return value >= 0.0f; } );
+		if ( sorted.empty() )
+		{
+			return -1.0f;
+		}
+
+		std::sort( sorted.begin(), sorted.end() );
+		return sorted[sorted.size() / 2];
+	}
+
+	// Reads a binary PPM with 8 bit channels, as IRenderer::SaveFrame writes them
+	bool ReadPpm( const std::string& filePath, int& width, int& height, std::vector<unsigned char>& pixels )
+	{
+		std::ifstream file( filePath, std::ios::binary );
+		std::string format;
+		int maxValue = 0;
+		if ( !( file >> format >> width >> height >> maxValue ) || format != "P6" || width <= 0 || height <= 0 || maxValue != 255 )
+		{
+			return false;
+		}
+
+		// A single whitespace character separates the header from the pixels
+		file.get();
+		pixels.resize( static_cast<size_t>( width ) * static_cast<size_t>( height ) * 3 );
+		file.read( reinterpret_cast<char*>( pixels.data() ), static_cast<std::streamsize>( pixels.size() ) );
+		return file.gcount() == static_cast<std::streamsize>( pixels.size() );
+	}
+
+	// Returns the index of the passed column, or the number of columns if there is none of that name
+	size_t FindColumn( const std::vector<std::string>& names, const std::string& name )
+	{
+		return static_cast<size_t>( std::find( names.begin(), names.end(), name ) - names.begin() );
+	}
+}
 
 std::unique_ptr<Engine> Engine::g_engineInstance( nullptr );
 
@@ -15,11 +99,41 @@ Engine::Engine() :
 	m_isAppRunning( false ),
 	m_fps( 120 ),
 	m_app(nullptr),
-	m_window(nullptr)
+	m_window(nullptr),
+	m_threadPool(nullptr),
+	m_isHeadless( false ),
+	m_headlessSettings(),
+	m_headlessFrameCount( 0 ),
+	m_headlessStatsFile(),
+	m_headlessFrameTimes(),
+	m_headlessWarmupFramesLeft( 0 ),
+	m_headlessLoadStart(),
+	m_headlessRunFailed( false ),
+	m_renderSettings{ true, true, 0.5f, 1.0f }
 {}
 
 Engine::~Engine() {}
 
+// Clamps both resolution scale limits to [RenderSettings::m_lowestResolutionScale, 1], with the minimum no
+// larger than the maximum. Limits that are not numbers are replaced by the lowest and the highest scale
+void Engine::SetRenderSettings( const RenderSettings& settings )
+{
+	m_renderSettings = settings;
+
+	// Written so NaN fails every comparison and falls to the fallback
+	auto clampScale = []( const float scale, const float fallback )
+	{
+		return scale >= RenderSettings::m_lowestResolutionScale ? std::min( scale, 1.0f ) :
+			( scale > 0.0f ? RenderSettings::m_lowestResolutionScale : fallback );
+	};
+
+	m_renderSettings.maxResolutionScale = clampScale( settings.maxResolutionScale, 1.0f );
+	m_renderSettings.minResolutionScale = std::min(
+		clampScale( settings.minResolutionScale, RenderSettings::m_lowestResolutionScale ),
+		m_renderSettings.maxResolutionScale
+	);
+}
+
 // Initializes Engine Components
 bool Engine::Init( 
 	const char* engineName, 
@@ -27,21 +141,11 @@ bool Engine::Init(
 	const int windowWidth, 
 	const int windowHeight )
 {
-	DEBUG_INIT();
-	m_engineName = engineName;
-
-	m_engineClock = new EngineClock();
-	if (m_engineClock == nullptr)
+	if ( !InitCore( engineName, fps ) )
 	{
-		DEBUG_LOG( LOG::FATAL, "Failed to create engine clock!" );
-		CONSOLE_LOG( LOG::FATAL, "Failed to create engine clock!" );
 		return false;
 	}
 
-	m_fps = fps;
-	m_engineClock->SetFPS( m_fps );
-
-
 	m_window = new Window();
 	const char* appName = "Titan Force Engine";
 	if ( m_app != nullptr )	
@@ -61,6 +165,91 @@ bool Engine::Init(
 	return m_isRunning;
 }
 
+// Initialize Engine without a window, frames are drawn offscreen at the passed size and frame times are recorded
+bool Engine::InitHeadless(
+	const char* engineName,
+	const unsigned int fps,
+	const int width,
+	const int height,
+	const HeadlessSettings& settings )
+{
+	if ( !InitCore( engineName, fps ) )
+	{
+		return false;
+	}
+
+	m_isHeadless = true;
+	m_headlessSettings = settings;
+
+	// Frame dumps and frame times are compared across runs, so the resolution must not depend on timing
+	m_renderSettings.dynamicResolution = false;
+	m_headlessFrameCount = 0;
+	m_headlessFrameTimes.clear();
+	m_headlessFrameTimes.reserve( settings.frameCount );
+	m_headlessWarmupFramesLeft = m_headlessWarmupFrames;
+	m_headlessRunFailed = false;
+
+	// Only OpenGL draws through the window's context, Vulkan draws into images of its own and the null renderer draws nothing
+	m_window = new Window();
+	if ( m_window->OnCreateHeadless( width, height, GRAPHICS_API == GRAPHICS_OPENGL ) == false )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create headless window!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create headless window!" );
+		return false;
+	}
+
+	const std::string statsPath = settings.outputDirectory + "/FrameStats.csv";
+	std::error_code error;
+	std::filesystem::create_directories( settings.outputDirectory, error );
+
+	m_headlessStatsFile.open( statsPath, std::ios::trunc );
+	if ( !m_headlessStatsFile.is_open() )
+	{
+		DEBUG_LOG( LOG::FATAL, "Cannot write frame stats: " + statsPath );
+		CONSOLE_LOG( LOG::FATAL, "Cannot write frame stats: " + statsPath );
+		return false;
+	}
+
+	m_headlessStatsFile << "frame,cpu_frame_ms";
+	for ( const char* pass : g_renderPassNames )
+	{
+		m_headlessStatsFile << ",cpu_" << pass << "_ms";
+	}
+	m_headlessStatsFile << ",gpu_frame";
+	for ( const char* pass : g_renderPassNames )
+	{
+		m_headlessStatsFile << ",gpu_" << pass << "_ms";
+	}
+	m_headlessStatsFile << ",draw_calls,triangles,program_binds,texture_binds,vertex_array_binds,uniform_uploads,uploaded_bytes,resolution_scale\n";
+
+	m_isRunning = true;
+	return m_isRunning;
+}
+
+// Creates the thread pool and the engine clock, shared by Init and InitHeadless
+bool Engine::InitCore( const char* engineName, const unsigned int fps )
+{
+	DEBUG_INIT();
+	m_engineName = engineName;
+
+	m_engineClock = new EngineClock();
+	if (m_engineClock == nullptr)
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create engine clock!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create engine clock!" );
+		return false;
+	}
+
+	m_fps = fps;
+	m_engineClock->SetFPS( m_fps );
+
+	m_threadPool = new ThreadPool();
+	DEBUG_LOG( LOG::INFO, "Created thread pool with " + std::to_string( m_threadPool->GetWorkerCount() ) + " workers" );
+	CONSOLE_LOG( LOG::INFO, "Created thread pool with " + std::to_string( m_threadPool->GetWorkerCount() ) + " workers" );
+
+	return true;
+}
+
 // Loads Passed Application, beginning with creating its desired renderer
 bool Engine::LoadApplication(IApp* app)
 {
@@ -99,11 +288,30 @@ bool Engine::LoadApplication(IApp* app)
 void Engine::Run()
 {
 
+	if ( m_isHeadless )
+	{
+		// Assets the app queued while it was created are finalized before the first frame, anything queued later
+		// is waited for by IsHeadlessWarmedUp
+		AssetLoader::Get()->Flush();
+		m_headlessLoadStart = std::chrono::steady_clock::now();
+	}
+
 	while ( m_isRunning )
 	{
+		if ( m_isHeadless )
+		{
+			// There is no display to keep pace with, frames are drawn back to back
+			Update( 1.0f / static_cast<float>( m_fps ) );
+			if ( IsHeadlessWarmedUp() )
+			{
+				RecordHeadlessFrame();
+			}
+			continue;
+		}
+
 		m_engineClock->UpdateFrameTicks();
 		Update(m_engineClock->GetDeltaTime() );
-		Sleep(m_engineClock->GetSleepTime(m_engineClock->GetFPS() ) );
+		std::this_thread::sleep_for( std::chrono::milliseconds( m_engineClock->GetSleepTime( m_engineClock->GetFPS() ) ) );
 	}
 
 	if ( !m_isRunning )
@@ -153,6 +361,18 @@ void Engine::OnDestroy()
 		m_app = nullptr;
 	}
 
+	// Workers finish their queued jobs before the window and its GL context go away
+	if ( m_threadPool )
+	{
+		delete m_threadPool;
+		m_threadPool = nullptr;
+	}
+
+	if ( m_headlessStatsFile.is_open() )
+	{
+		m_headlessStatsFile.close();
+	}
+
 	if ( m_window )
 	{
 		m_window->OnDestroy();
@@ -185,9 +405,237 @@ void Engine::Update( const float deltaTime ) {
 	}
 
 	
-	glfwPollEvents();
+	m_window->PollEvents();
+
+}
+
+// Returns true once nothing is loading or uploading and m_headlessWarmupFrames more frames have been drawn
+// Until then frames are drawn without being recorded, so streaming and first use costs stay out of the stats
+bool Engine::IsHeadlessWarmedUp()
+{
+	if ( m_headlessWarmupFramesLeft == 0 || m_app == nullptr || m_app->m_renderer == nullptr )
+	{
+		return true;
+	}
+
+	if ( AssetLoader::Get()->GetPendingCount() > 0 || m_app->m_renderer->HasPendingUploads() )
+	{
+		const std::chrono::duration<float> waited = std::chrono::steady_clock::now() - m_headlessLoadStart;
+		if ( waited.count() > m_headlessLoadTimeoutSeconds )
+		{
+			DEBUG_LOG( LOG::ERRORLOG, "Headless run is still loading after " + std::to_string( waited.count() ) + " seconds!" );
+			CONSOLE_LOG( LOG::ERRORLOG, "Headless run is still loading after " + std::to_string( waited.count() ) + " seconds!" );
+			m_headlessRunFailed = true;
+			Exit();
+		}
+
+		// Warm-up only counts frames drawn with every asset resident
+		m_headlessWarmupFramesLeft = m_headlessWarmupFrames;
+		return false;
+	}
+
+	--m_headlessWarmupFramesLeft;
+	return false;
+}
+
+// Writes the finished frame's render stats to the stats file and saves the frame every dumpInterval frames
+void Engine::RecordHeadlessFrame()
+{
+	if ( m_app == nullptr || m_app->m_renderer == nullptr )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Headless run has no application renderer to record!" );
+		CONSOLE_LOG( LOG::ERRORLOG, "Headless run has no application renderer to record!" );
+		Exit();
+		return;
+	}
+
+	const RenderStats& stats = m_app->m_renderer->GetStats();
+
+	m_headlessStatsFile << stats.frameIndex << "," << stats.cpuFrameMilliseconds;
+	for ( const float milliseconds : stats.cpuMilliseconds )
+	{
+		m_headlessStatsFile << "," << milliseconds;
+	}
+	m_headlessStatsFile << "," << stats.gpuFrameIndex;
+	for ( const float milliseconds : stats.gpuMilliseconds )
+	{
+		m_headlessStatsFile << "," << milliseconds;
+	}
+	m_headlessStatsFile << "," << stats.drawCalls
+		<< "," << stats.triangles
+		<< "," << stats.programBinds
+		<< "," << stats.textureBinds
+		<< "," << stats.vertexArrayBinds
+		<< "," << stats.uniformUploads
+		<< "," << stats.uploadedBytes
+		<< "," << stats.resolutionScale << "\n";
+
+	m_headlessFrameTimes.push_back( stats.cpuFrameMilliseconds );
+	++m_headlessFrameCount;
+
+	if ( m_headlessSettings.dumpInterval > 0 && m_headlessFrameCount % m_headlessSettings.dumpInterval == 0 )
+	{
+		// Padded so the images sort in frame order
+		std::string number = std::to_string( stats.frameIndex );
+		number.insert( 0, number.size() < 6 ? 6 - number.size() : 0, '0' );
+		m_app->m_renderer->SaveFrame( m_headlessSettings.outputDirectory + "/Frame" + number + ".ppm" );
+	}
+
+	if ( m_headlessFrameCount >= m_headlessSettings.frameCount )
+	{
+		m_headlessStatsFile.flush();
+		LogHeadlessSummary();
+
+		if ( !m_headlessSettings.baselinePath.empty() && !CompareHeadlessBaseline() )
+		{
+			m_headlessRunFailed = true;
+		}
+
+		if ( !m_headlessSettings.referenceImagePath.empty() && !CompareHeadlessImage() )
+		{
+			m_headlessRunFailed = true;
+		}
+
+		Exit();
+	}
+}
+
+// Logs a summary of the recorded frame times once a headless run is done
+void Engine::LogHeadlessSummary() const
+{
+	if ( m_headlessFrameTimes.empty() )
+	{
+		return;
+	}
+
+	std::vector<float> frameTimes = m_headlessFrameTimes;
+	std::sort( frameTimes.begin(), frameTimes.end() );
+
+	const float mean = std::accumulate( frameTimes.begin(), frameTimes.end(), 0.0f ) / static_cast<float>( frameTimes.size() );
+	const float median = frameTimes[frameTimes.size() / 2];
+	const float percentile95 = frameTimes[std::min( frameTimes.size() - 1, frameTimes.size() * 95 / 100 )];
+	const float maximum = frameTimes.back();
+
+	DEBUG_LOG( LOG::INFO, "Headless run of " + std::to_string( frameTimes.size() ) + " frames, CPU frame ms: mean " + std::to_string( mean ) + ", median " + std::to_string( median ) + ", 95th percentile " + std::to_string( percentile95 ) + ", max " + std::to_string( maximum ) );
+	CONSOLE_LOG( LOG::INFO, "Headless run of " + std::to_string( frameTimes.size() ) + " frames, CPU frame ms: mean " + std::to_string( mean ) + ", median " + std::to_string( median ) + ", 95th percentile " + std::to_string( percentile95 ) + ", max " + std::to_string( maximum ) );
+}
 
+// Compares the medians of the run's frame stats against the baseline's, returns false if any rose above the threshold
+bool Engine::CompareHeadlessBaseline() const
+{
+	std::vector<std::string> baselineNames, names;
+	std::vector<std::vector<float>> baselineColumns, columns;
+	if ( !ReadFrameStats( m_headlessSettings.baselinePath, baselineNames, baselineColumns ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot read baseline frame stats: " + m_headlessSettings.baselinePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot read baseline frame stats: " + m_headlessSettings.baselinePath );
+		return false;
+	}
+
+	const std::string statsPath = m_headlessSettings.outputDirectory + "/FrameStats.csv";
+	if ( !ReadFrameStats( statsPath, names, columns ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot read frame stats: " + statsPath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot read frame stats: " + statsPath );
+		return false;
+	}
+
+	// Counters only rise when more work is drawn, timings also when the same work got slower
+	std::vector<std::string> compared = { "draw_calls", "triangles", "cpu_frame_ms" };
+	for ( const char* pass : g_renderPassNames )
+	{
+		compared.push_back( std::string( "gpu_" ) + pass + "_ms" );
+	}
+
+	bool hasPassed = true;
+	for ( const std::string& name : compared )
+	{
+		const size_t baselineColumn = FindColumn( baselineNames, name );
+		const size_t column = FindColumn( names, name );
+		if ( baselineColumn == baselineNames.size() || column == names.size() )
+		{
+			DEBUG_LOG( LOG::WARNING, "Baseline frame stats have no " + name + " column to compare" );
+			CONSOLE_LOG( LOG::WARNING, "Baseline frame stats have no " + name + " column to compare" );
+			continue;
+		}
+
+		// Renderers that cannot time the GPU leave its timings negative, those are not compared
+		const float baselineMedian = Median( baselineColumns[baselineColumn] );
+		const float median = Median( columns[column] );
+		if ( baselineMedian < 0.0f || median < 0.0f )
+		{
+			continue;
+		}
+
+		const bool isTiming = name.size() > 3 && name.compare( name.size() - 3, 3, "_ms" ) == 0;
+		const float limit = baselineMedian * ( 1.0f + m_headlessSettings.regressionThreshold ) + ( isTiming ? m_headlessTimingSlackMilliseconds : 0.0f );
+		if ( median > limit )
+		{
+			DEBUG_LOG( LOG::ERRORLOG, "Headless run regressed, median " + name + " " + std::to_string( median ) + " against the baseline's " + std::to_string( baselineMedian ) );
+			CONSOLE_LOG( LOG::ERRORLOG, "Headless run regressed, median " + name + " " + std::to_string( median ) + " against the baseline's " + std::to_string( baselineMedian ) );
+			hasPassed = false;
+		}
+	}
+
+	if ( hasPassed )
+	{
+		DEBUG_LOG( LOG::INFO, "Headless run is within the regression threshold of its baseline: " + m_headlessSettings.baselinePath );
+		CONSOLE_LOG( LOG::INFO, "Headless run is within the regression threshold of its baseline: " + m_headlessSettings.baselinePath );
+	}
+
+	return hasPassed;
 }
 
+// Saves the last frame and compares it against the reference image, returns false if it differs by more than the tolerance
+// Software renderers such as lavapipe draw the same frame on every machine, so a small tolerance only covers rounding
+bool Engine::CompareHeadlessImage()
+{
+	const std::string framePath = m_headlessSettings.outputDirectory + "/LastFrame.ppm";
+	if ( !m_app->m_renderer->SaveFrame( framePath ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Renderer cannot save the last frame to compare against: " + m_headlessSettings.referenceImagePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Renderer cannot save the last frame to compare against: " + m_headlessSettings.referenceImagePath );
+		return false;
+	}
+
+	int referenceWidth = 0, referenceHeight = 0, width = 0, height = 0;
+	std::vector<unsigned char> referencePixels, pixels;
+	if ( !ReadPpm( m_headlessSettings.referenceImagePath, referenceWidth, referenceHeight, referencePixels ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot read reference image: " + m_headlessSettings.referenceImagePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot read reference image: " + m_headlessSettings.referenceImagePath );
+		return false;
+	}
+
+	if ( !ReadPpm( framePath, width, height, pixels ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot read saved frame: " + framePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot read saved frame: " + framePath );
+		return false;
+	}
+
+	if ( width != referenceWidth || height != referenceHeight )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Headless frame is " + std::to_string( width ) + "x" + std::to_string( height ) + ", its reference is " + std::to_string( referenceWidth ) + "x" + std::to_string( referenceHeight ) );
+		CONSOLE_LOG( LOG::ERRORLOG, "Headless frame is " + std::to_string( width ) + "x" + std::to_string( height ) + ", its reference is " + std::to_string( referenceWidth ) + "x" + std::to_string( referenceHeight ) );
+		return false;
+	}
+
+	uint64_t difference = 0;
+	for ( size_t i = 0; i < pixels.size(); ++i )
+	{
+		difference += static_cast<uint64_t>( std::abs( static_cast<int>( pixels[i] ) - static_cast<int>( referencePixels[i] ) ) );
+	}
+	const float meanDifference = static_cast<float>( static_cast<double>( difference ) / static_cast<double>( pixels.size() ) );
 
+	if ( meanDifference > m_headlessSettings.imageTolerance )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Headless frame differs from its reference by " + std::to_string( meanDifference ) + " per channel: " + m_headlessSettings.referenceImagePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Headless frame differs from its reference by " + std::to_string( meanDifference ) + " per channel: " + m_headlessSettings.referenceImagePath );
+		return false;
+	}
 
+	DEBUG_LOG( LOG::INFO, "Headless frame is within " + std::to_string( m_headlessSettings.imageTolerance ) + " per channel of its reference, it differs by " + std::to_string( meanDifference ) );
+	CONSOLE_LOG( LOG::INFO, "Headless frame is within " + std::to_string( m_headlessSettings.imageTolerance ) + " per channel of its reference, it differs by " + std::to_string( meanDifference ) );
+	return true;
+}
@@ -2,11 +2,30 @@
 #define ENGINE_H
 
 #include "EngineClock.h"
+#include "../RenderCore/RenderSettings.h"
 
+#include <chrono>
+#include <fstream>
 #include <memory>
+#include <string>
+#include <vector>
 
 class IApp;
 class Window;
+class ThreadPool;
+
+// Settings of a headless run, which draws a fixed number of frames offscreen and exits
+struct HeadlessSettings
+{
+	unsigned int	frameCount;			// Frames drawn before the engine exits
+	unsigned int	dumpInterval;		// Frames between saving the frame as an image, 0 saves none
+	std::string		outputDirectory;	// Where frame images and frame stats are written
+	bool			captureCommands;	// NullRenderer only, writes every frame's commands to Commands.bin
+	std::string		baselinePath;		// Frame stats of an earlier run to compare against, empty compares nothing
+	float			regressionThreshold;	// Fraction a compared median may rise above the baseline's before the run fails
+	std::string		referenceImagePath;	// Frame image the run's last frame is compared against, empty compares none
+	float			imageTolerance;		// Mean difference per colour channel, out of 255, the last frame may have before the run fails
+};
 
 // Singleton Engine Class
 class Engine
@@ -22,6 +41,16 @@ public:
 		const int windowHeight 
 	);
 
+	// Initialize Engine without a window, frames are drawn offscreen at the passed size and frame times are recorded
+	// Each frame advances the app by 1 / fps seconds, however long it took, so runs of the same scene can be compared
+	bool InitHeadless(
+		const char* engineName,
+		const unsigned int fps,
+		const int width,
+		const int height,
+		const HeadlessSettings& settings
+	);
+
 	// Loads Passed Application, beginning with creating its desired renderer
 	bool LoadApplication(IApp* app);
 
@@ -45,6 +74,25 @@ public:
 
 	Window* GetWindow() const { return m_window; }
 
+	// Frame rate the engine paces itself to, see EngineClock::SetFPS
+	const EngineClock* GetEngineClock() const { return m_engineClock; }
+
+	// Worker threads shared by engine systems, such as asset loading
+	ThreadPool* GetThreadPool() const { return m_threadPool; }
+
+	// Returns true if the engine was started with InitHeadless, its settings are only meaningful if it was
+	bool IsHeadless() const { return m_isHeadless; }
+	const HeadlessSettings& GetHeadlessSettings() const { return m_headlessSettings; }
+
+	// Returns true if a headless run could not finish loading, regressed against its baseline or drew a different image
+	bool HasHeadlessRunFailed() const { return m_headlessRunFailed; }
+
+	const RenderSettings& GetRenderSettings() const { return m_renderSettings; }
+
+	// Clamps both resolution scale limits to [RenderSettings::m_lowestResolutionScale, 1], with the minimum no
+	// larger than the maximum. Limits that are not numbers are replaced by the lowest and the highest scale
+	void SetRenderSettings( const RenderSettings& settings );
+
 private:
 
 	// The Engine class should not be copied or moved hence removing the functionality
@@ -62,6 +110,34 @@ private:
 	void OnDestroy();
 	void Update(const float deltaTime);
 
+	// Creates the thread pool and the engine clock, shared by Init and InitHeadless
+	bool InitCore( const char* engineName, const unsigned int fps );
+
+	// Frames drawn once nothing is loading or uploading any more, before headless frames are recorded
+	static constexpr unsigned int m_headlessWarmupFrames = 8;
+
+	// Time a headless run may spend waiting for its assets before it fails
+	static constexpr float m_headlessLoadTimeoutSeconds = 300.0f;
+
+	// Timings compared against a baseline may also rise by this much, so passes taking next to no time do not fail on noise
+	static constexpr float m_headlessTimingSlackMilliseconds = 0.05f;
+
+	// Returns true once nothing is loading or uploading and m_headlessWarmupFrames more frames have been drawn
+	// Until then frames are drawn without being recorded, so streaming and first use costs stay out of the stats
+	bool IsHeadlessWarmedUp();
+
+	// Writes the finished frame's render stats to the stats file and saves the frame every dumpInterval frames
+	void RecordHeadlessFrame();
+
+	// Logs a summary of the recorded frame times once a headless run is done
+	void LogHeadlessSummary() const;
+
+	// Compares the medians of the run's frame stats against the baseline's, returns false if any rose above the threshold
+	bool CompareHeadlessBaseline() const;
+
+	// Saves the last frame and compares it against the reference image, returns false if it differs by more than the tolerance
+	bool CompareHeadlessImage();
+
 	const char*			m_engineName;
 
 	EngineClock*		m_engineClock;
@@ -74,6 +150,19 @@ private:
 	IApp*				m_app;
 
 	Window*				m_window;
+
+	ThreadPool*			m_threadPool;
+
+	bool				m_isHeadless;
+	HeadlessSettings	m_headlessSettings;
+	unsigned int		m_headlessFrameCount;
+	std::ofstream		m_headlessStatsFile;
+	std::vector<float>	m_headlessFrameTimes;	// CPU frame time of every recorded frame, in milliseconds
+	unsigned int		m_headlessWarmupFramesLeft;
+	std::chrono::steady_clock::time_point	m_headlessLoadStart;
+	bool				m_headlessRunFailed;
+
+	RenderSettings		m_renderSettings;
 	
 
 
@@ -15,7 +15,7 @@ public:
 	EngineClock();
 	~EngineClock();
 
-	unsigned int GetFPS() { return m_fps; }
+	unsigned int GetFPS() const { return m_fps; }
 	void SetFPS(unsigned int fps);
 
 	void Reset();
@@ -1,5 +1,7 @@
 #include "High-ResTimer.h"
 
+#ifdef _WIN32
+
 HighResTimer::HighResTimer():
 	currentTicks()
 {
@@ -23,3 +25,28 @@ unsigned int HighResTimer::GetCurrentTimeInMilliSeconds() {
 
 	return static_cast<unsigned int>(currentTicks.QuadPart);
 }
+
+#else
+
+#include <time.h>
+
+// Without a performance counter the monotonic clock is used, it never jumps when the system time is changed
+HighResTimer::HighResTimer() {}
+
+HighResTimer::~HighResTimer(){}
+
+unsigned int HighResTimer::GetCurrentTimeInMicroSeconds() {
+	timespec now = {};
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return static_cast<unsigned int>(static_cast<long long>(now.tv_sec) * SECONDS_TO_MICROSECONDS + now.tv_nsec / 1000);
+}
+
+unsigned int HighResTimer::GetCurrentTimeInMilliSeconds() {
+	timespec now = {};
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return static_cast<unsigned int>(static_cast<long long>(now.tv_sec) * SECONDS_TO_MILLISECONDS + now.tv_nsec / 1000000);
+}
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef HIGHRESTIMER_H
 #define HIGHRESTIMER_H
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 #define MILLISECONDS_TO_SECONDS (1 / 1000.0f)
 #define MICROSECONDS_TO_SECONDS (1 / 1000000.0f)
@@ -27,11 +29,13 @@ public:
 
 private:
 
+#ifdef _WIN32
 	LARGE_INTEGER frequency;	// 'Ticks-per-second' 
 	LARGE_INTEGER currentTicks;
 
 	//**IMPORTANT: LARGE_INTEGER is a union that has member value called 'QuadPart' which stores a 64bit signed int
 		// 'QuadPart' should be used for a compiler with support for 64-bit integers, where as 'HighPart' and 'LowPart' should be used otherwise.
+#endif
 
 };
 
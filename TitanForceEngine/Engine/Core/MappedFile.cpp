@@ -0,0 +1,140 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	m_data( nullptr ),
+	m_size( 0 ),
+#ifdef _WIN32
+	m_fileHandle( INVALID_HANDLE_VALUE ),
+	m_mappingHandle( nullptr )
+#else
+	m_fileDescriptor( -1 )
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+// Maps the file at the passed path, returns false if the file does not exist or cannot be mapped
+bool MappedFile::Open( const std::string& filePath )
+{
+	Close();
+
+	m_fileHandle = CreateFileA( filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if ( m_fileHandle == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx( m_fileHandle, &fileSize ) || fileSize.QuadPart == 0 )
+	{
+		Close();
+		return false;
+	}
+
+	m_mappingHandle = CreateFileMappingA( m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( m_mappingHandle == nullptr )
+	{
+		Close();
+		return false;
+	}
+
+	m_data = static_cast<const unsigned char*>( MapViewOfFile( m_mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+	if ( m_data == nullptr )
+	{
+		Close();
+		return false;
+	}
+
+	m_size = static_cast<size_t>( fileSize.QuadPart );
+	return true;
+}
+
+// Unmaps the file, pointers returned by GetData are no longer valid
+void MappedFile::Close()
+{
+	if ( m_data )
+	{
+		UnmapViewOfFile( m_data );
+		m_data = nullptr;
+	}
+
+	if ( m_mappingHandle )
+	{
+		CloseHandle( m_mappingHandle );
+		m_mappingHandle = nullptr;
+	}
+
+	if ( m_fileHandle != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( m_fileHandle );
+		m_fileHandle = INVALID_HANDLE_VALUE;
+	}
+
+	m_size = 0;
+}
+
+#else
+
+// Maps the file at the passed path, returns false if the file does not exist or cannot be mapped
+bool MappedFile::Open( const std::string& filePath )
+{
+	Close();
+
+	m_fileDescriptor = open( filePath.c_str(), O_RDONLY );
+	if ( m_fileDescriptor < 0 )
+	{
+		return false;
+	}
+
+	struct stat fileStats;
+	if ( fstat( m_fileDescriptor, &fileStats ) != 0 || fileStats.st_size == 0 )
+	{
+		Close();
+		return false;
+	}
+
+	void* data = mmap( nullptr, static_cast<size_t>( fileStats.st_size ), PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0 );
+	if ( data == MAP_FAILED )
+	{
+		Close();
+		return false;
+	}
+
+	m_data = static_cast<const unsigned char*>( data );
+	m_size = static_cast<size_t>( fileStats.st_size );
+	return true;
+}
+
+// Unmaps the file, pointers returned by GetData are no longer valid
+void MappedFile::Close()
+{
+	if ( m_data )
+	{
+		munmap( const_cast<unsigned char*>( m_data ), m_size );
+		m_data = nullptr;
+	}
+
+	if ( m_fileDescriptor >= 0 )
+	{
+		close( m_fileDescriptor );
+		m_fileDescriptor = -1;
+	}
+
+	m_size = 0;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read only view of a whole file mapped into memory, pages are loaded by the OS as they are touched
+class MappedFile
+{
+
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+	MappedFile( MappedFile&& ) = delete;
+	MappedFile& operator=( MappedFile&& ) = delete;
+
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	// Maps the file at the passed path, returns false if the file does not exist or cannot be mapped
+	bool Open( const std::string& filePath );
+
+	// Unmaps the file, pointers returned by GetData are no longer valid
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+
+	const unsigned char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+
+	const unsigned char*	m_data;
+	size_t					m_size;
+
+#ifdef _WIN32
+	void*					m_fileHandle;
+	void*					m_mappingHandle;
+#else
+	int						m_fileDescriptor;
+#endif
+
+};
+
+#endif // !MAPPEDFILE_H
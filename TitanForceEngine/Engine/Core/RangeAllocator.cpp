@@ -0,0 +1,106 @@
+#include "RangeAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+RangeAllocator::RangeAllocator( const size_t capacity ) :
+	m_capacity( capacity ),
+	m_usedSize( 0 ),
+	m_freeRanges()
+{
+	Reset();
+}
+
+RangeAllocator::~RangeAllocator()
+{}
+
+// Returns the offset of a free range of the passed size, or m_invalidOffset if none is large enough
+size_t RangeAllocator::Allocate( const size_t size )
+{
+	if ( size == 0 )
+	{
+		return m_invalidOffset;
+	}
+
+	for ( auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it )
+	{
+		if ( it->second < size )
+		{
+			continue;
+		}
+
+		const size_t offset = it->first;
+		const size_t remaining = it->second - size;
+		m_freeRanges.erase( it );
+
+		if ( remaining > 0 )
+			// The tail of the range stays free
+		{
+			m_freeRanges.emplace( offset + size, remaining );
+		}
+
+		m_usedSize += size;
+		return offset;
+	}
+
+	return m_invalidOffset;
+}
+
+// Returns a range given out by Allocate, merging it with the free ranges on either side
+void RangeAllocator::Free( const size_t offset, const size_t size )
+{
+	if ( offset == m_invalidOffset || size == 0 )
+	{
+		return;
+	}
+
+	assert( offset + size <= m_capacity && size <= m_usedSize );
+
+	size_t start = offset;
+	size_t end = offset + size;
+
+	// First free range after the freed one, merged if the two touch
+	auto next = m_freeRanges.lower_bound( offset );
+	if ( next != m_freeRanges.end() && next->first == end )
+	{
+		end += next->second;
+		next = m_freeRanges.erase( next );
+	}
+
+	// Last free range before the freed one, merged if the two touch
+	if ( next != m_freeRanges.begin() )
+	{
+		auto previous = std::prev( next );
+		if ( previous->first + previous->second == start )
+		{
+			start = previous->first;
+			m_freeRanges.erase( previous );
+		}
+	}
+
+	m_freeRanges.emplace( start, end - start );
+	m_usedSize -= size;
+}
+
+// Frees every range at once
+void RangeAllocator::Reset()
+{
+	m_freeRanges.clear();
+	if ( m_capacity > 0 )
+	{
+		m_freeRanges.emplace( 0, m_capacity );
+	}
+	m_usedSize = 0;
+}
+
+// Returns the size of the largest free range, the largest allocation that can currently succeed
+size_t RangeAllocator::GetLargestFreeRange() const
+{
+	size_t largest = 0;
+	for ( const auto& range : m_freeRanges )
+	{
+		largest = std::max( largest, range.second );
+	}
+	return largest;
+}
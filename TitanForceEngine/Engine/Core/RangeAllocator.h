@@ -0,0 +1,50 @@
+#ifndef RANGEALLOCATOR_H
+#define RANGEALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+// Hands out ranges of a fixed capacity, such as elements of a GPU buffer, without owning any memory itself
+// Free ranges are kept sorted by offset, allocations take the first range that fits and freed ranges are merged
+// with their neighbours so the space can be reused by larger allocations later on
+class RangeAllocator
+{
+
+	RangeAllocator( const RangeAllocator& ) = delete;
+	RangeAllocator& operator=( const RangeAllocator& ) = delete;
+	RangeAllocator( RangeAllocator&& ) = delete;
+	RangeAllocator& operator=( RangeAllocator&& ) = delete;
+
+public:
+
+	// Returned by Allocate when no free range is large enough
+	static constexpr size_t m_invalidOffset = SIZE_MAX;
+
+	explicit RangeAllocator( const size_t capacity );
+	~RangeAllocator();
+
+	// Returns the offset of a free range of the passed size, or m_invalidOffset if none is large enough
+	size_t Allocate( const size_t size );
+
+	// Returns a range given out by Allocate, merging it with the free ranges on either side
+	void Free( const size_t offset, const size_t size );
+
+	// Frees every range at once
+	void Reset();
+
+	size_t GetCapacity() const { return m_capacity; }
+	size_t GetUsedSize() const { return m_usedSize; }
+
+	// Returns the size of the largest free range, the largest allocation that can currently succeed
+	size_t GetLargestFreeRange() const;
+
+private:
+
+	size_t						m_capacity;
+	size_t						m_usedSize;
+	std::map<size_t, size_t>	m_freeRanges;	// Offset to size
+
+};
+
+#endif // !RANGEALLOCATOR_H
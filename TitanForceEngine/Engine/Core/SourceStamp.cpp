@@ -0,0 +1,24 @@
+#include "SourceStamp.h"
+
+#include <filesystem>
+
+// Reads the size and last write time of the passed file, returns false if it does not exist
+bool SourceStamp::Read( const std::string& filePath, SourceStamp& stamp )
+{
+	std::error_code error;
+	const auto size = std::filesystem::file_size( filePath, error );
+	if ( error )
+	{
+		return false;
+	}
+
+	const auto writeTime = std::filesystem::last_write_time( filePath, error );
+	if ( error )
+	{
+		return false;
+	}
+
+	stamp.size = static_cast<uint64_t>( size );
+	stamp.writeTime = static_cast<int64_t>( writeTime.time_since_epoch().count() );
+	return true;
+}
@@ -0,0 +1,20 @@
+#ifndef SOURCESTAMP_H
+#define SOURCESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+// Identifies the version of a source asset that a cooked file was built from
+struct SourceStamp
+{
+	uint64_t	size;
+	int64_t		writeTime;
+
+	bool operator==( const SourceStamp& other ) const { return size == other.size && writeTime == other.writeTime; }
+	bool operator!=( const SourceStamp& other ) const { return !( *this == other ); }
+
+	// Reads the size and last write time of the passed file, returns false if it does not exist
+	static bool Read( const std::string& filePath, SourceStamp& stamp );
+};
+
+#endif // !SOURCESTAMP_H
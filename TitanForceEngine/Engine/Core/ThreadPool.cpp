@@ -0,0 +1,127 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+// Creates the passed number of workers, 0 creates one per hardware thread, leaving one for the calling thread
+ThreadPool::ThreadPool( unsigned int workerCount ) :
+	m_isStopping( false )
+{
+	if ( workerCount == 0 )
+	{
+		const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	m_workers.reserve( workerCount );
+	for ( unsigned int i = 0; i < workerCount; ++i )
+	{
+		m_workers.emplace_back( &ThreadPool::WorkerLoop, this );
+	}
+}
+
+// Finishes every queued job before joining the workers
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_isStopping = true;
+	}
+	m_jobAvailable.notify_all();
+
+	for ( auto& worker : m_workers )
+	{
+		worker.join();
+	}
+}
+
+// Queues the passed job to run on a worker thread
+void ThreadPool::Submit( std::function<void()> job )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_jobs.push_back( std::move( job ) );
+	}
+	m_jobAvailable.notify_one();
+}
+
+// Splits [0, count) into ranges of at least minRangeSize and runs them on the workers and the calling thread
+// Returns once every range is done, so the job may reference the caller's stack
+void ThreadPool::ParallelFor( const size_t count, const size_t minRangeSize, const std::function<void( size_t begin, size_t end )>& job )
+{
+	if ( count == 0 )
+	{
+		return;
+	}
+
+	const size_t threadCount = m_workers.size() + 1;
+	const size_t rangeSize = std::max( std::max<size_t>( minRangeSize, 1 ), ( count + threadCount - 1 ) / threadCount );
+	const size_t rangeCount = ( count + rangeSize - 1 ) / rangeSize;
+
+	if ( rangeCount == 1 )
+	{
+		job( 0, count );
+		return;
+	}
+
+	// Shared with the helper jobs, which may only start after this call has returned
+	struct Batch
+	{
+		std::atomic<size_t>		nextRange{ 0 };
+		std::atomic<size_t>		completedRanges{ 0 };
+		std::mutex				mutex;
+		std::condition_variable	done;
+	};
+	std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+
+	// Ranges are claimed from a shared counter, whichever thread is free takes the next one
+	auto runRanges = [batch, count, rangeSize, rangeCount, &job]()
+	{
+		for ( size_t range = batch->nextRange++; range < rangeCount; range = batch->nextRange++ )
+		{
+			const size_t begin = range * rangeSize;
+			job( begin, std::min( begin + rangeSize, count ) );
+
+			if ( ++batch->completedRanges == rangeCount )
+			{
+				std::lock_guard<std::mutex> lock( batch->mutex );
+				batch->done.notify_all();
+			}
+		}
+	};
+
+	const size_t helperCount = std::min( m_workers.size(), rangeCount - 1 );
+	for ( size_t i = 0; i < helperCount; ++i )
+	{
+		Submit( runRanges );
+	}
+
+	runRanges();
+
+	std::unique_lock<std::mutex> lock( batch->mutex );
+	batch->done.wait( lock, [&batch, rangeCount]() { return batch->completedRanges == rangeCount; } );
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while ( true )
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_jobAvailable.wait( lock, [this]() { return m_isStopping || !m_jobs.empty(); } );
+
+			if ( m_jobs.empty() )
+				// Only reached once stopping with nothing left to run
+			{
+				return;
+			}
+
+			job = std::move( m_jobs.front() );
+			m_jobs.pop_front();
+		}
+
+		job();
+	}
+}
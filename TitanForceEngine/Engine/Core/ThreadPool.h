@@ -0,0 +1,49 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling jobs from a shared queue
+class ThreadPool
+{
+
+	ThreadPool( const ThreadPool& ) = delete;
+	ThreadPool& operator=( const ThreadPool& ) = delete;
+	ThreadPool( ThreadPool&& ) = delete;
+	ThreadPool& operator=( ThreadPool&& ) = delete;
+
+public:
+
+	// Creates the passed number of workers, 0 creates one per hardware thread, leaving one for the calling thread
+	explicit ThreadPool( unsigned int workerCount = 0 );
+
+	// Finishes every queued job before joining the workers
+	~ThreadPool();
+
+	// Queues the passed job to run on a worker thread
+	void Submit( std::function<void()> job );
+
+	// Splits [0, count) into ranges of at least minRangeSize and runs them on the workers and the calling thread
+	// Returns once every range is done, so the job may reference the caller's stack
+	void ParallelFor( const size_t count, const size_t minRangeSize, const std::function<void( size_t begin, size_t end )>& job );
+
+	unsigned int GetWorkerCount() const { return static_cast<unsigned int>( m_workers.size() ); }
+
+private:
+
+	std::vector<std::thread>			m_workers;
+	std::deque<std::function<void()>>	m_jobs;
+	std::mutex							m_mutex;
+	std::condition_variable				m_jobAvailable;
+	bool								m_isStopping;
+
+	void WorkerLoop();
+
+};
+
+#endif // !THREADPOOL_H
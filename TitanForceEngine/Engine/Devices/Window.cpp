@@ -1,14 +1,30 @@
 #include "Window.h"
+#include "../Graphics/Graphics.h"
 
 #include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
 
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
 
 
 
 Window::Window() :
 	m_glfwWindow( nullptr ),
 	m_width( 1280 ),
-	m_height( 720 )
+	m_height( 720 ),
+	m_isHeadless( false ),
+	m_eglDisplay( nullptr ),
+	m_eglContext( nullptr ),
+	m_framebuffer( 0 ),
+	m_colourRenderbuffer( 0 ),
+	m_depthRenderbuffer( 0 )
 {}
 
 Window::~Window() {}
@@ -37,6 +53,7 @@ bool Window::OnCreate( const std::string& name, const int width, const int heigh
 		return false;
 	}
 
+#if GRAPHICS_API != GRAPHICS_VULKAN
 	glfwMakeContextCurrent( m_glfwWindow );
 
 	m_glfwWindow = glfwGetCurrentContext();
@@ -47,6 +64,7 @@ bool Window::OnCreate( const std::string& name, const int width, const int heigh
 		CONSOLE_LOG( LOG::FATAL, "Failed to init GLAD!" );
 		return false;
 	}
+#endif
 
 	SetPost_Attributes();
 
@@ -64,10 +82,213 @@ bool Window::OnCreate( const std::string& name, const int width, const int heigh
 	return true;
 }
 
+// Creates an OpenGL context without a window, frames are drawn into an offscreen framebuffer of the passed size
+// Uses a surfaceless EGL display, so it runs on machines without a display or GPU such as Mesa's llvmpipe
+// Without a context the window only has a size, for renderers that do not draw through OpenGL
+bool Window::OnCreateHeadless( const int width, const int height, const bool hasContext )
+{
+	if ( !hasContext )
+	{
+		m_width = width;
+		m_height = height;
+		m_isHeadless = true;
+		return true;
+	}
+
+#ifdef _WIN32
+
+	DEBUG_LOG( LOG::FATAL, "Headless windows need EGL, which is not available on Windows!" );
+	CONSOLE_LOG( LOG::FATAL, "Headless windows need EGL, which is not available on Windows!" );
+	return false;
+
+#else
+
+	m_width = width;
+	m_height = height;
+	m_isHeadless = true;
+
+	// The surfaceless platform needs no display server, without it EGL picks whatever its default platform is
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>( eglGetProcAddress( "eglGetPlatformDisplayEXT" ) );
+	if ( getPlatformDisplay )
+	{
+		display = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr );
+	}
+	if ( display == EGL_NO_DISPLAY )
+	{
+		display = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+	}
+
+	if ( display == EGL_NO_DISPLAY || !eglInitialize( display, nullptr, nullptr ) )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to init EGL!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to init EGL!" );
+		return false;
+	}
+	m_eglDisplay = display;
+
+	if ( !eglBindAPI( EGL_OPENGL_API ) )
+	{
+		DEBUG_LOG( LOG::FATAL, "EGL does not support desktop OpenGL!" );
+		CONSOLE_LOG( LOG::FATAL, "EGL does not support desktop OpenGL!" );
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if ( !eglChooseConfig( display, configAttributes, &config, 1, &configCount ) || configCount == 0 )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to find an EGL config!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to find an EGL config!" );
+		return false;
+	}
+
+	// The renderer needs 4.3, drivers hand out the newest core version compatible with the one asked for
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	EGLContext context = eglCreateContext( display, config, EGL_NO_CONTEXT, contextAttributes );
+	if ( context == EGL_NO_CONTEXT )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create EGL context!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create EGL context!" );
+		return false;
+	}
+	m_eglContext = context;
+
+	// Needs EGL_KHR_surfaceless_context, everything is drawn into the framebuffer created below
+	if ( !eglMakeCurrent( display, EGL_NO_SURFACE, EGL_NO_SURFACE, context ) )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to make the EGL context current without a surface!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to make the EGL context current without a surface!" );
+		return false;
+	}
+
+	if ( !gladLoadGLLoader( (GLADloadproc)eglGetProcAddress ) )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to init GLAD!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to init GLAD!" );
+		return false;
+	}
+
+	if ( !CreateFramebuffer() )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create headless framebuffer!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create headless framebuffer!" );
+		return false;
+	}
+
+	DEBUG_LOG( LOG::INFO, "Created headless window of " + std::to_string( m_width ) + "x" + std::to_string( m_height ) + " on " + reinterpret_cast<const char*>( glGetString( GL_RENDERER ) ) );
+	CONSOLE_LOG( LOG::INFO, "Created headless window of " + std::to_string( m_width ) + "x" + std::to_string( m_height ) + " on " + reinterpret_cast<const char*>( glGetString( GL_RENDERER ) ) );
+
+	return true;
+
+#endif
+}
+
 void Window::OnDestroy()
 {
-	glfwDestroyWindow( m_glfwWindow );
-	glfwTerminate();
+	if ( !m_isHeadless )
+	{
+		glfwDestroyWindow( m_glfwWindow );
+		glfwTerminate();
+		return;
+	}
+
+#ifndef _WIN32
+	if ( m_eglContext )
+	{
+		DestroyFramebuffer();
+		eglMakeCurrent( m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+		eglDestroyContext( m_eglDisplay, m_eglContext );
+		m_eglContext = nullptr;
+	}
+
+	if ( m_eglDisplay )
+	{
+		eglTerminate( m_eglDisplay );
+		m_eglDisplay = nullptr;
+	}
+#endif
+}
+
+// Shows the drawn frame, a headless window keeps it in its framebuffer instead
+void Window::SwapBuffers()
+{
+	if ( !m_isHeadless )
+	{
+		glfwSwapBuffers( m_glfwWindow );
+	}
+}
+
+// Handles the window's events, a headless window has none
+void Window::PollEvents()
+{
+	if ( !m_isHeadless )
+	{
+		glfwPollEvents();
+	}
+}
+
+// Loads a GL function by name, for functions GLAD was not generated with
+void* Window::GetProcAddress( const char* name ) const
+{
+#ifndef _WIN32
+	if ( m_isHeadless )
+	{
+		return reinterpret_cast<void*>( eglGetProcAddress( name ) );
+	}
+#endif
+	return reinterpret_cast<void*>( glfwGetProcAddress( name ) );
+}
+
+// Reads the last drawn frame back and writes it to the passed path as a binary PPM
+// Only a headless window still holds the frame after SwapBuffers, returns false if there is no context to read from
+bool Window::SaveFrame( const std::string& filePath ) const
+{
+	if ( m_isHeadless && m_eglContext == nullptr )
+	{
+		return false;
+	}
+
+	const size_t rowSize = static_cast<size_t>( m_width ) * 3;
+	std::vector<unsigned char> pixels( rowSize * m_height );
+
+	glBindFramebuffer( GL_READ_FRAMEBUFFER, m_framebuffer );
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	glReadPixels( 0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data() );
+
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( filePath ).parent_path(), error );
+
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Cannot write frame: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Cannot write frame: " + filePath );
+		return false;
+	}
+
+	file << "P6\n" << m_width << " " << m_height << "\n255\n";
+
+	// GL reads the bottom row first, PPM starts at the top
+	for ( int row = m_height - 1; row >= 0; --row )
+	{
+		file.write( reinterpret_cast<const char*>( pixels.data() + rowSize * row ), static_cast<std::streamsize>( rowSize ) );
+	}
+
+	return file.good();
 }
 
 
@@ -77,7 +298,12 @@ void Window::SetPre_Attributes()
 {
 	// Window hints can be use before the window has been created to give the window properties and functionality. 
 	// Once a window has been created a new window hint will not affect it/ cannot be applied after the fact
+#if GRAPHICS_API == GRAPHICS_VULKAN
+	// Vulkan presents to a surface created from the window, see VulkanDevice, so the window has no context
+	glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+#else
 	glfwWindowHint( GLFW_CLIENT_API, GLFW_OPENGL_API );
+#endif
 	// glfwWindowHint( GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API );
 	
 	
@@ -91,6 +317,44 @@ void Window::SetPost_Attributes() {
 	glfwWindowHint( GLFW_DEPTH_BITS, 64 );
 }
 
+// Creates the headless window's framebuffer at the window's size
+bool Window::CreateFramebuffer()
+{
+	glGenRenderbuffers( 1, &m_colourRenderbuffer );
+	glBindRenderbuffer( GL_RENDERBUFFER, m_colourRenderbuffer );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, m_width, m_height );
 
+	glGenRenderbuffers( 1, &m_depthRenderbuffer );
+	glBindRenderbuffer( GL_RENDERBUFFER, m_depthRenderbuffer );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height );
 
+	glGenFramebuffers( 1, &m_framebuffer );
+	glBindFramebuffer( GL_FRAMEBUFFER, m_framebuffer );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colourRenderbuffer );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer );
 
+	return glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void Window::DestroyFramebuffer()
+{
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+	if ( m_framebuffer != 0 )
+	{
+		glDeleteFramebuffers( 1, &m_framebuffer );
+		m_framebuffer = 0;
+	}
+
+	if ( m_colourRenderbuffer != 0 )
+	{
+		glDeleteRenderbuffers( 1, &m_colourRenderbuffer );
+		m_colourRenderbuffer = 0;
+	}
+
+	if ( m_depthRenderbuffer != 0 )
+	{
+		glDeleteRenderbuffers( 1, &m_depthRenderbuffer );
+		m_depthRenderbuffer = 0;
+	}
+}
@@ -14,12 +14,36 @@ public:
 
 	// Creates Window with the passed name and dimensions
 	bool OnCreate(const std::string& name, const int width_, const int height_);
+
+	// Creates an OpenGL context without a window, frames are drawn into an offscreen framebuffer of the passed size
+	// Uses a surfaceless EGL display, so it runs on machines without a display or GPU such as Mesa's llvmpipe
+	// Without a context the window only has a size, for renderers that do not draw through OpenGL
+	bool OnCreateHeadless( const int width, const int height, const bool hasContext = true );
+
 	void OnDestroy();
 
 	GLFWwindow* GetGLFW_Window() const { return m_glfwWindow; }
 	int GetWidth() const { return m_width; }
 	int GetHeight() const { return m_height; }
 
+	bool IsHeadless() const { return m_isHeadless; }
+
+	// Framebuffer frames are drawn into, 0 unless headless
+	GLuint GetFramebuffer() const { return m_framebuffer; }
+
+	// Shows the drawn frame, a headless window keeps it in its framebuffer instead
+	void SwapBuffers();
+
+	// Handles the window's events, a headless window has none
+	void PollEvents();
+
+	// Loads a GL function by name, for functions GLAD was not generated with
+	void* GetProcAddress( const char* name ) const;
+
+	// Reads the last drawn frame back and writes it to the passed path as a binary PPM
+	// Only a headless window still holds the frame after SwapBuffers, returns false if there is no context to read from
+	bool SaveFrame( const std::string& filePath ) const;
+
 private:
 
 	GLFWwindow*		m_glfwWindow;
@@ -27,11 +51,25 @@ private:
 	int				m_width;
 	int				m_height;
 
+	bool			m_isHeadless;
+
+	// EGLDisplay and EGLContext, kept as void* so EGL is only included where it is used
+	void*			m_eglDisplay;
+	void*			m_eglContext;
+
+	GLuint			m_framebuffer;
+	GLuint			m_colourRenderbuffer;
+	GLuint			m_depthRenderbuffer;
+
 	void SetPre_Attributes();
 	void SetPost_Attributes();
 
+	// Creates the headless window's framebuffer at the window's size
+	bool CreateFramebuffer();
+	void DestroyFramebuffer();
+
 
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -18,5 +18,10 @@
 #define GRAPHICS_DIRECTX12 2
 #endif // !GRAPHICS_DIRECTX12
 
+// Records what would be drawn without a graphics API, see NullRenderer
+#ifndef GRAPHICS_NULL
+#define GRAPHICS_NULL 3
+#endif // !GRAPHICS_NULL
+
 
 #endif // !GRAPHICS_H
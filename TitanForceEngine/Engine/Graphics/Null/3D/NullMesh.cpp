@@ -0,0 +1,22 @@
+#include "NullMesh.h"
+
+NullMesh::NullMesh( const char* objFileName ) :
+	IMesh( objFileName ),
+	m_arenaKey( 0 )
+{}
+
+NullMesh::~NullMesh()
+{}
+
+void NullMesh::GenerateBuffers()
+{
+	// Index sizes are 2 or 4, so they fit below the layout id
+	m_arenaKey = m_subMesh->layout.GetId() * 8 + m_subMesh->indexSize;
+	m_isReady = true;
+}
+
+void NullMesh::Render()
+{}
+
+void NullMesh::RenderDepthOnly()
+{}
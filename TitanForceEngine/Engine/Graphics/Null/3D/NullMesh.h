@@ -0,0 +1,33 @@
+#ifndef NULLMESH_H
+#define NULLMESH_H
+
+#include "../../../RenderCore/3D/Mesh.h"
+
+#include <cstdint>
+
+// Mesh without GPU buffers for NullRenderer, ready as soon as its sub mesh has been loaded
+class NullMesh : public IMesh
+{
+
+public:
+
+	NullMesh( const char* objFileName );
+	~NullMesh();
+
+	virtual void GenerateBuffers() override final;
+
+	virtual void Render() override final;
+
+	virtual void RenderDepthOnly() override final;
+
+	// Stands in for the mesh arena a GPU backend would draw the mesh from, meshes with the same vertex layout and
+	// index size share one. 0 until the sub mesh has been loaded
+	uint32_t GetArenaKey() const { return m_arenaKey; }
+
+private:
+
+	uint32_t	m_arenaKey;
+
+};
+
+#endif // !NULLMESH_H
@@ -0,0 +1,466 @@
+#include "NullRenderer.h"
+#include "3D/NullMesh.h"
+#include "Texture/NullTexture2D.h"
+
+#include "../../Devices/Window.h"
+#include "../../RenderCore/Model/Model.h"
+#include "../../Components/RenderComponent.h"
+#include "../../Components/TransformComponent.h"
+#include "../../RenderCore/Camera/Camera.h"
+#include "../../RenderCore/Commands/DrawRecorder.h"
+#include "../../RenderCore/Culling/SceneCuller.h"
+#include "../../RenderCore/Extraction/DrawExtractor.h"
+#include "../../RenderCore/Lighting/LightCuller.h"
+#include "../../RenderCore/Material/MaterialTable.h"
+#include "../../RenderCore/Loading/AssetLoader.h"
+#include "../../RenderCore/Shader/ShaderLinker.h"
+#include "../../Core/Engine.h"
+#include "../../Core/ThreadPool.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <tuple>
+
+NullRenderer::NullRenderer() :
+	IRenderer(),
+	m_sceneCuller( nullptr ),
+	m_drawExtractor( nullptr ),
+	m_drawRecorder( nullptr ),
+	m_depthLinker( nullptr ),
+	m_hasDepthPrepass( false ),
+	m_materialVersion( 0 ),
+	m_hasMaterials( false ),
+	m_draws(),
+	m_drawGroups(),
+	m_objectData(),
+	m_commands(),
+	m_boundProgram( 0 ),
+	m_boundTexture( 0 ),
+	m_boundArena( 0 ),
+	m_captureFile(),
+	m_frameIndex( 0 ),
+	m_frameStats()
+{}
+
+NullRenderer::~NullRenderer()
+{
+	OnDestroy();
+}
+
+bool NullRenderer::OnCreate(
+	const char * applicationName,
+	const char * engineName,
+	int version,
+	bool enableValidationLayers,
+	Window * window )
+{
+	m_window = window;
+	m_sceneCuller = new SceneCuller();
+	m_drawExtractor = new DrawExtractor();
+	m_drawRecorder = new DrawRecorder();
+
+	// Only gets a program id, so the pre-pass's binds are filtered as OpenGLRenderer's are
+	m_depthLinker = new ShaderLinker( "DepthShader" );
+	m_depthLinker->SubmitShader( new Shader( EShaderType::Vertex, "DepthVertex.glsl" ) );
+	m_depthLinker->SubmitShader( new Shader( EShaderType::Fragment, "DepthFragment.glsl" ) );
+	m_depthLinker->LinkShaders();
+
+	const Engine* engine = Engine::Get();
+	if ( engine->IsHeadless() && engine->GetHeadlessSettings().captureCommands )
+	{
+		const std::string capturePath = engine->GetHeadlessSettings().outputDirectory + "/Commands.bin";
+		m_captureFile.open( capturePath, std::ios::binary | std::ios::trunc );
+		if ( !m_captureFile.is_open() )
+		{
+			DEBUG_LOG( LOG::WARNING, "Cannot write command capture: " + capturePath );
+			CONSOLE_LOG( LOG::WARNING, "Cannot write command capture: " + capturePath );
+		}
+	}
+
+	DEBUG_LOG( LOG::INFO, "Created null renderer, nothing is drawn" );
+	CONSOLE_LOG( LOG::INFO, "Created null renderer, nothing is drawn" );
+
+	return true;
+}
+
+void NullRenderer::OnDestroy()
+{
+	if ( m_sceneCuller )
+	{
+		delete m_sceneCuller;
+		m_sceneCuller = nullptr;
+	}
+
+	if ( m_drawExtractor )
+	{
+		delete m_drawExtractor;
+		m_drawExtractor = nullptr;
+	}
+
+	if ( m_drawRecorder )
+	{
+		delete m_drawRecorder;
+		m_drawRecorder = nullptr;
+	}
+
+	if ( m_depthLinker )
+	{
+		delete m_depthLinker;
+		m_depthLinker = nullptr;
+	}
+
+	if ( m_captureFile.is_open() )
+	{
+		m_captureFile.close();
+	}
+}
+
+void NullRenderer::RenderScene( IScene * scene )
+{
+	const auto frameStart = std::chrono::steady_clock::now();
+	m_frameStats = {};
+	m_frameStats.frameIndex = m_frameIndex;
+	m_frameStats.resolutionScale = 1.0f;
+	m_commands.clear();
+
+	BeginScene( scene );
+
+	RunPass( ERenderPass::Clear, &NullRenderer::Begin );
+
+	// Collecting the draws is not part of any pass, it only counts towards the whole frame
+	PrepareDraws();
+
+	RunPass( ERenderPass::DepthPrepass, &NullRenderer::DrawDepthPrepass );
+	RunPass( ERenderPass::Opaque, &NullRenderer::Present );
+	RunPass( ERenderPass::Present, &NullRenderer::End );
+
+	EndScene();
+
+	const std::chrono::duration<float, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+	UpdateStats( frameTime.count() );
+}
+
+// Nothing is drawn, so there is no frame to save
+bool NullRenderer::SaveFrame( const std::string& filePath )
+{
+	return false;
+}
+
+// Nothing is copied to a GPU, assets are resident once the AssetLoader has finalized them
+bool NullRenderer::HasPendingUploads()
+{
+	return false;
+}
+
+// Runs the passed pass, timing it on the CPU
+void NullRenderer::RunPass( const ERenderPass pass, void ( NullRenderer::*function )() )
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	( this->*function )();
+
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	m_frameStats.cpuMilliseconds[static_cast<int>( pass )] = elapsed.count();
+}
+
+// Gathers the finished frame's counters into m_stats, and logs them every m_statsLogInterval frames
+void NullRenderer::UpdateStats( const float cpuFrameMilliseconds )
+{
+	m_frameStats.cpuFrameMilliseconds = cpuFrameMilliseconds;
+
+	// There is no GPU work to time
+	for ( int pass = 0; pass < static_cast<int>( ERenderPass::TOTAL ); ++pass )
+	{
+		m_frameStats.gpuMilliseconds[pass] = -1.0f;
+	}
+	m_frameStats.gpuFrameIndex = 0;
+
+	m_stats = m_frameStats;
+
+	if ( ++m_frameIndex % m_statsLogInterval == 0 )
+	{
+		uint32_t counts[static_cast<int>( ENullCommand::TOTAL )] = {};
+		for ( const NullCommand& command : m_commands )
+		{
+			counts[static_cast<int>( command.type )]++;
+		}
+
+		std::string commandText;
+		for ( int type = 0; type < static_cast<int>( ENullCommand::TOTAL ); ++type )
+		{
+			commandText += std::string( type > 0 ? ", " : "" ) + g_nullCommandNames[type] + " " + std::to_string( counts[type] );
+		}
+
+		DEBUG_LOG( LOG::INFO, std::to_string( m_commands.size() ) + " commands recorded: " + commandText );
+		CONSOLE_LOG( LOG::INFO, std::to_string( m_commands.size() ) + " commands recorded: " + commandText );
+
+		DEBUG_LOG( LOG::INFO, std::to_string( m_stats.drawCalls ) + " draw calls, " + std::to_string( m_stats.triangles ) + " triangles, " + std::to_string( m_stats.uploadedBytes ) + " bytes written, CPU frame " + std::to_string( m_stats.cpuFrameMilliseconds ) + " ms" );
+		CONSOLE_LOG( LOG::INFO, std::to_string( m_stats.drawCalls ) + " draw calls, " + std::to_string( m_stats.triangles ) + " triangles, " + std::to_string( m_stats.uploadedBytes ) + " bytes written, CPU frame " + std::to_string( m_stats.cpuFrameMilliseconds ) + " ms" );
+	}
+}
+
+void NullRenderer::BeginScene( IScene * scene )
+{
+	if ( scene == nullptr )
+	{
+		return;
+	}
+
+	// Meshes and textures are finalized the same way as on a GPU backend, their buffers are just never created
+	AssetLoader::Get()->ProcessUploads( m_uploadBudgetMilliseconds );
+
+	m_models.clear();
+
+	auto registry = ECS::Parser<RenderComponent, TransformComponent>( scene->m_world );
+	for ( auto c : registry.GetComponents() )
+	{
+		RenderComponent* r = std::get<RenderComponent*>( c );
+
+		SubmitModel( r->GetModel() );
+	}
+
+	auto cameraRegistry = ECS::Parser<CameraComponent, TransformComponent>( scene->m_world );
+	m_camera = std::get<CameraComponent*>( cameraRegistry.GetComponents().front() );
+
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	m_sceneCuller->CullOccludedModels( m_models, *m_camera, threadPool );
+	m_sceneCuller->CullLights( scene, *m_camera, threadPool );
+}
+
+void NullRenderer::EndScene()
+{}
+
+void NullRenderer::Begin()
+{
+	// Nothing stays bound between frames, like after OpenGLStateCache::BeginFrame
+	m_boundProgram = 0;
+	m_boundTexture = 0;
+	m_boundArena = 0;
+
+	Record( ENullCommand::Clear, 0, 0, 0 );
+}
+
+// Records the frame's block writes and collects its draws, like OpenGLRenderer::PrepareDraws
+void NullRenderer::PrepareDraws()
+{
+	WriteFrameData();
+	BuildDrawGroups();
+	WriteDrawData();
+
+	// Every group's object data is streamed once, before either pass draws it
+	for ( const DrawGroup& group : m_drawGroups )
+	{
+		Record( ENullCommand::WriteStorageBlock, static_cast<uint32_t>( EStorageBlock::Object ), 0, static_cast<uint32_t>( group.count * sizeof( ObjectUniforms ) ) );
+	}
+}
+
+// Records every group's depth with the depth program, if the pre-pass is turned on
+void NullRenderer::DrawDepthPrepass()
+{
+	m_hasDepthPrepass = false;
+	if ( m_drawGroups.empty() || !Engine::Get()->GetRenderSettings().depthPrepass || !m_depthLinker->IsReady() )
+	{
+		return;
+	}
+
+	Record( ENullCommand::BeginPass, static_cast<uint32_t>( ERenderPass::DepthPrepass ), 0, 0 );
+	SubmitDrawGroups( true );
+	m_hasDepthPrepass = true;
+}
+
+void NullRenderer::Present()
+{
+	Record( ENullCommand::BeginPass, static_cast<uint32_t>( ERenderPass::Opaque ), m_hasDepthPrepass ? 1 : 0, 0 );
+	SubmitDrawGroups( false );
+}
+
+void NullRenderer::End()
+{
+	Record( ENullCommand::Present, 0, 0, 0 );
+
+	if ( m_captureFile.is_open() )
+	{
+		WriteCapture();
+	}
+}
+
+void NullRenderer::SubmitModel( Model* model )
+{
+	m_models.push_back( model );
+}
+
+// Appends a command to the frame's command list
+void NullRenderer::Record( const ENullCommand type, const uint32_t object, const uint32_t count, const uint32_t size )
+{
+	m_commands.push_back( NullCommand{ type, object, count, size } );
+
+	if ( type == ENullCommand::WriteUniformBlock || type == ENullCommand::WriteStorageBlock )
+	{
+		m_frameStats.uniformUploads++;
+		m_frameStats.uploadedBytes += size;
+	}
+}
+
+// Records a bind, unless the object is already bound
+void NullRenderer::RecordBind( const ENullCommand type, uint32_t& bound, const uint32_t object )
+{
+	if ( bound == object )
+	{
+		return;
+	}
+	bound = object;
+
+	Record( type, object, 0, 0 );
+
+	switch ( type )
+	{
+	case ENullCommand::BindProgram:	m_frameStats.programBinds++;		break;
+	case ENullCommand::BindTexture:	m_frameStats.textureBinds++;		break;
+	case ENullCommand::BindMesh:	m_frameStats.vertexArrayBinds++;	break;
+	default:															break;
+	}
+}
+
+// Records the frame uniforms, light lists and material table writes
+void NullRenderer::WriteFrameData()
+{
+	const LightCuller& lightCuller = m_sceneCuller->GetLightCuller();
+
+	Record( ENullCommand::WriteUniformBlock, static_cast<uint32_t>( EUniformBlock::Frame ), 0, sizeof( FrameUniforms ) );
+
+	// Sized the same way as OpenGLRenderer::WriteLightData, empty lists keep room for one entry
+	const size_t lightSize = sizeof( LightUniforms ) * std::max<size_t>( lightCuller.GetLights().size(), 1 );
+	const size_t clusterSize = sizeof( ClusterUniforms ) * lightCuller.GetClusters().size();
+	const size_t indexSize = sizeof( uint32_t ) * std::max<size_t>( lightCuller.GetLightIndices().size(), 1 );
+	Record( ENullCommand::WriteStorageBlock, static_cast<uint32_t>( EStorageBlock::Lights ), 0, static_cast<uint32_t>( lightSize ) );
+	Record( ENullCommand::WriteStorageBlock, static_cast<uint32_t>( EStorageBlock::Clusters ), 0, static_cast<uint32_t>( clusterSize ) );
+	Record( ENullCommand::WriteStorageBlock, static_cast<uint32_t>( EStorageBlock::LightIndices ), 0, static_cast<uint32_t>( indexSize ) );
+
+	// The table is only written again when it changed
+	const MaterialTable* table = MaterialTable::Get();
+	if ( !m_hasMaterials || table->GetVersion() != m_materialVersion )
+	{
+		Record( ENullCommand::WriteStorageBlock, static_cast<uint32_t>( EStorageBlock::Materials ), 0, static_cast<uint32_t>( sizeof( MaterialUniforms ) * table->GetCount() ) );
+		m_materialVersion = table->GetVersion();
+		m_hasMaterials = true;
+	}
+}
+
+// Extracts every model's object data, records their draws through DrawRecorder and splits the merged draws into
+// groups that can be drawn together
+void NullRenderer::BuildDrawGroups()
+{
+	m_draws.clear();
+	m_drawGroups.clear();
+
+	// Pixels one unit covers at a distance of one unit
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	const float projectionScale = m_camera->GetPerspective()[1][1] * 0.5f * static_cast<float>( m_window->GetHeight() );
+	const glm::mat4 view = m_camera->GetView();
+	m_drawExtractor->Extract( m_models, view, m_camera->GetPerspective() * view, m_camera->GetCameraPosition(), projectionScale, threadPool );
+
+	auto fill = []( const Model& model, DrawCommand& command )
+	{
+		const NullMesh* mesh = static_cast<const NullMesh*>( model.GetMesh() );
+		const NullTexture2D* texture = static_cast<const NullTexture2D*>( model.GetTexture() );
+
+		command.texture = texture ? texture->GetArrayKey() : 0;
+		command.arena = mesh->GetArenaKey();
+		command.firstIndex = 0;
+	};
+
+	m_drawRecorder->Record( m_models, *m_drawExtractor, fill, threadPool );
+	m_drawRecorder->Merge();
+
+	const std::vector<const DrawCommand*>& commands = m_drawRecorder->GetDraws();
+	m_draws.reserve( commands.size() );
+	for ( size_t i = 0; i < commands.size(); ++i )
+	{
+		const DrawCommand* command = commands[i];
+		if ( i == 0 || !commands[i - 1]->SharesState( *command ) )
+		{
+			m_drawGroups.push_back( DrawGroup{ i, 0 } );
+		}
+
+		m_draws.push_back( DrawItem{ command, &m_drawExtractor->GetObject( command->sequence ) } );
+		m_drawGroups.back().count++;
+	}
+}
+
+// Copies every draw's extracted object data on the worker threads, as the GPU backends do
+void NullRenderer::WriteDrawData()
+{
+	m_objectData.resize( m_draws.size() );
+
+	auto fill = [this]( size_t begin, size_t end )
+	{
+		for ( size_t i = begin; i < end; ++i )
+		{
+			const DrawItem& draw = m_draws[i];
+
+			ObjectUniforms& object = m_objectData[i];
+			object = *draw.object;
+			object.indices.x = draw.command->material;
+			object.indices.y = draw.command->layer;
+		}
+	};
+
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	if ( threadPool )
+	{
+		threadPool->ParallelFor( m_draws.size(), m_drawFillRangeSize, fill );
+	}
+	else
+	{
+		fill( 0, m_draws.size() );
+	}
+}
+
+// Records one multi draw per group, with the depth program and the arenas' positions only if isDepthOnly is set
+void NullRenderer::SubmitDrawGroups( const bool isDepthOnly )
+{
+	for ( const DrawGroup& group : m_drawGroups )
+	{
+		const DrawCommand& first = *m_draws[group.first].command;
+		const uint32_t arena = static_cast<uint32_t>( first.arena );
+
+		// Groups keep their object data for the pre-pass, only the program and vertex streams differ
+		if ( isDepthOnly )
+		{
+			RecordBind( ENullCommand::BindProgram, m_boundProgram, m_depthLinker->GetShaderProgramId() );
+			RecordBind( ENullCommand::BindMesh, m_boundArena, arena | m_depthArenaBit );
+		}
+		else
+		{
+			RecordBind( ENullCommand::BindProgram, m_boundProgram, first.program );
+			RecordBind( ENullCommand::BindTexture, m_boundTexture, first.texture );
+			RecordBind( ENullCommand::BindMesh, m_boundArena, arena );
+		}
+
+		uint64_t triangles = 0;
+		for ( size_t d = 0; d < group.count; ++d )
+		{
+			triangles += m_draws[group.first + d].command->indexCount / 3;
+		}
+
+		Record( ENullCommand::MultiDraw, arena, static_cast<uint32_t>( group.count ), static_cast<uint32_t>( triangles ) );
+		m_frameStats.drawCalls++;
+		m_frameStats.triangles += triangles;
+	}
+}
+
+// Appends the frame's commands to the capture file
+void NullRenderer::WriteCapture()
+{
+	CaptureFrameHeader header = {};
+	header.magic = m_captureMagic;
+	header.version = m_captureVersion;
+	header.frameIndex = m_frameIndex;
+	header.commandCount = m_commands.size();
+
+	m_captureFile.write( reinterpret_cast<const char*>( &header ), sizeof( CaptureFrameHeader ) );
+	m_captureFile.write( reinterpret_cast<const char*>( m_commands.data() ), static_cast<std::streamsize>( m_commands.size() * sizeof( NullCommand ) ) );
+}
@@ -0,0 +1,208 @@
+#ifndef NULLRENDERER_H
+#define NULLRENDERER_H
+
+#include "../../RenderCore/Renderer.h"
+#include "../../RenderCore/Shader/UniformBlocks.h"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+class DrawExtractor;
+class DrawRecorder;
+class SceneCuller;
+class ShaderLinker;
+struct DrawCommand;
+
+// Commands NullRenderer records in place of graphics API calls
+enum class ENullCommand : uint32_t
+{
+	Clear,
+	BeginPass,			// Start of a drawing ERenderPass, the depth and colour state it sets follows from the pass
+	BindProgram,
+	BindTexture,
+	BindMesh,			// Vertex and index buffers of a mesh arena
+	WriteUniformBlock,	// Uniform block data streamed for the frame
+	WriteStorageBlock,	// Storage block data streamed for the frame, or the material table when it changed
+	MultiDraw,
+	Present,
+	TOTAL
+};
+
+// Names of the ENullCommand commands, in the same order as the enum
+constexpr const char* g_nullCommandNames[static_cast<int>( ENullCommand::TOTAL )] =
+{
+	"Clear",
+	"BeginPass",
+	"BindProgram",
+	"BindTexture",
+	"BindMesh",
+	"WriteUniformBlock",
+	"WriteStorageBlock",
+	"MultiDraw",
+	"Present"
+};
+
+// A single recorded command, written to the capture file as is
+struct NullCommand
+{
+	ENullCommand	type;
+	uint32_t		object;		// Pass, program, texture array key, mesh arena key or block binding the command refers to
+	uint32_t		count;		// Draws of a multi draw, or 1 if a BeginPass of the opaque pass shades on the pre-pass's depth
+	uint32_t		size;		// Bytes of a block write, or triangles of a multi draw
+};
+
+static_assert( sizeof( NullCommand ) == 16, "NullCommand is written to capture files and must stay 16 bytes" );
+
+// Renderer that runs the same culling, LOD selection, sorting, batching and depth pre-pass as OpenGLRenderer without a graphics API
+// Binds, block writes and draws are recorded as NullCommands instead of being issued, so the render side CPU work can
+// be measured and compared on machines without a GPU. Binds are filtered the way OpenGLStateCache filters them
+// Headless runs started with captureCommands append every frame's commands to Commands.bin, see CaptureFrameHeader
+class NullRenderer : public IRenderer
+{
+public:
+
+	NullRenderer();
+	~NullRenderer();
+
+	// Initializes Renderer
+	virtual bool OnCreate(
+		const char* applicationName,
+		const char* engineName,
+		int version,
+		bool enableValidationLayers,
+		Window* window ) override final;
+	virtual void OnDestroy() override final;
+
+	virtual void RenderScene( IScene* scene ) override final;
+
+	// Nothing is drawn, so there is no frame to save
+	virtual bool SaveFrame( const std::string& filePath ) override final;
+
+	// Nothing is copied to a GPU, assets are resident once the AssetLoader has finalized them
+	virtual bool HasPendingUploads() override final;
+
+	// Commands recorded for the last frame
+	const std::vector<NullCommand>& GetCommands() const { return m_commands; }
+
+private:
+
+	// Time each frame may spend finalizing assets that finished loading
+	static constexpr float m_uploadBudgetMilliseconds = 2.0f;
+
+	// Draws filled per worker range
+	static constexpr size_t m_drawFillRangeSize = 64;
+
+	// Frames between logging the frame's RenderStats and command counts
+	static constexpr uint64_t m_statsLogInterval = 600;
+
+	// Written before every frame's commands in the capture file
+	struct CaptureFrameHeader
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint64_t	frameIndex;
+		uint64_t	commandCount;
+	};
+
+	static constexpr uint32_t m_captureMagic = 0x434E4654;	// "TFNC"
+	static constexpr uint32_t m_captureVersion = 2;
+
+	// Set on the arena key of BindMesh commands binding only the arena's positions, as the depth pre-pass does
+	static constexpr uint32_t m_depthArenaBit = 0x80000000;
+
+	// A recorded draw in replay order, draws sharing a program, texture and arena form one multi draw
+	struct DrawItem
+	{
+		const DrawCommand*		command;
+		const ObjectUniforms*	object;			// The model's record in DrawExtractor
+	};
+
+	struct DrawGroup
+	{
+		size_t		first;			// First draw of the group in m_draws
+		size_t		count;
+	};
+
+	// Drops hidden models, clusters lights and picks LODs, see SceneCuller
+	SceneCuller*			m_sceneCuller;
+
+	// Writes every model's object data on the worker threads before the draws are recorded
+	DrawExtractor*			m_drawExtractor;
+
+	// Records and merges the frame's draws exactly as OpenGLRenderer does, see DrawRecorder
+	// Draw textures are NullTexture2D::GetArrayKey and arenas NullMesh::GetArenaKey
+	DrawRecorder*			m_drawRecorder;
+
+	// Stands in for OpenGLRenderer's depth only program, see RenderSettings::depthPrepass
+	ShaderLinker*			m_depthLinker;
+	bool					m_hasDepthPrepass;	// The pre-pass ran this frame
+
+	uint64_t				m_materialVersion;
+	bool					m_hasMaterials;
+
+	// Rebuilt every frame, kept as members so their storage is reused
+	std::vector<DrawItem>		m_draws;
+	std::vector<DrawGroup>		m_drawGroups;
+	std::vector<ObjectUniforms>	m_objectData;	// Filled like the GPU backends' object data, then dropped
+	std::vector<NullCommand>	m_commands;
+
+	// Last bound objects, binds of what is already bound are not recorded
+	uint32_t				m_boundProgram;
+	uint32_t				m_boundTexture;
+	uint32_t				m_boundArena;
+
+	std::ofstream			m_captureFile;
+
+	uint64_t				m_frameIndex;
+
+	// Counters and timings of the frame being recorded, copied into m_stats once it is finished
+	RenderStats				m_frameStats;
+
+	virtual void BeginScene( IScene* scene ) override final;
+	virtual void EndScene() override final;
+
+	virtual void Begin() override final;
+	virtual void Present() override final;
+	virtual void End() override final;
+
+	virtual void SubmitModel( Model* model ) override final;
+
+	// Runs the passed pass, timing it on the CPU
+	void RunPass( const ERenderPass pass, void ( NullRenderer::*function )() );
+
+	// Gathers the finished frame's counters into m_stats, and logs them every m_statsLogInterval frames
+	void UpdateStats( const float cpuFrameMilliseconds );
+
+	// Appends a command to the frame's command list
+	void Record( const ENullCommand type, const uint32_t object, const uint32_t count, const uint32_t size );
+
+	// Records a bind, unless the object is already bound
+	void RecordBind( const ENullCommand type, uint32_t& bound, const uint32_t object );
+
+	// Records the frame's block writes and collects its draws, like OpenGLRenderer::PrepareDraws
+	void PrepareDraws();
+
+	// Records every group's depth with the depth program, if the pre-pass is turned on
+	void DrawDepthPrepass();
+
+	// Records the frame uniforms, light lists and material table writes
+	void WriteFrameData();
+
+	// Extracts every model's object data, records their draws through DrawRecorder and splits the merged draws into
+	// groups that can be drawn together
+	void BuildDrawGroups();
+
+	// Copies every draw's extracted object data on the worker threads, as the GPU backends do
+	void WriteDrawData();
+
+	// Records one multi draw per group, with the depth program and the arenas' positions only if isDepthOnly is set
+	void SubmitDrawGroups( const bool isDepthOnly );
+
+	// Appends the frame's commands to the capture file
+	void WriteCapture();
+
+};
+
+
+#endif // !NULLRENDERER_H
@@ -0,0 +1,57 @@
+#include "NullTexture2D.h"
+
+#include "../../../RenderCore/Loading/AssetLoader.h"
+
+NullTexture2D::NullTexture2D( const char* fileName ) :
+	Texture2D( fileName ), m_arrayKey( 0 )
+{
+	if ( m_fileName == "" )
+	{
+		return;
+	}
+
+	m_arrayKey = m_placeholderArrayKey;
+
+	// Decoded on a worker thread like any other texture, so loading costs the same as on a GPU backend
+	AssetLoader::Get()->LoadTexture( this, m_fileName );
+}
+
+NullTexture2D::~NullTexture2D()
+{}
+
+// Decodes the texture immediately, blocking the calling thread
+void NullTexture2D::GenerateTexture()
+{
+	if ( m_fileName == "" )
+	{
+		return;
+	}
+
+	std::shared_ptr<TextureData> data = Decode( m_fileName );
+	if ( data )
+	{
+		Upload( data );
+	}
+}
+
+void NullTexture2D::Bind()
+{}
+
+void NullTexture2D::Unbind()
+{}
+
+void NullTexture2D::Upload( const std::shared_ptr<TextureData>& data )
+{
+	m_width = data->width;
+	m_height = data->height;
+	m_arrayKey = MakeArrayKey( *data );
+}
+
+// Format in the top bits, then 14 bits each of width and height
+uint32_t NullTexture2D::MakeArrayKey( const TextureData& data )
+{
+	const uint32_t format = static_cast<uint32_t>( data.format ) + 1;
+	const uint32_t width = static_cast<uint32_t>( data.width ) & 0x3FFF;
+	const uint32_t height = static_cast<uint32_t>( data.height ) & 0x3FFF;
+	return ( format << 28 ) | ( width << 14 ) | height;
+}
@@ -0,0 +1,39 @@
+#ifndef NULL_TEXTURE_2D_H
+#define NULL_TEXTURE_2D_H
+
+#include "../../../RenderCore/Texture/Texture2D.h"
+
+#include <cstdint>
+
+// Texture that only keeps the format and size of its image for NullRenderer, nothing is uploaded
+class NullTexture2D : public Texture2D
+{
+public:
+
+	// Key of the placeholder every texture is drawn with until its image has been decoded
+	static constexpr uint32_t m_placeholderArrayKey = 1;
+
+	NullTexture2D( const char* fileName );
+	~NullTexture2D();
+
+	virtual void GenerateTexture() override;
+	virtual void Bind() override;
+	virtual void Unbind() override;
+
+	virtual void Upload( const std::shared_ptr<TextureData>& data ) override;
+
+	// Stands in for the texture array a GPU backend would store the image in, images of the same format and size
+	// share one. 0 for textures without a file name
+	uint32_t GetArrayKey() const { return m_arrayKey; }
+
+private:
+
+	uint32_t m_arrayKey;
+
+	// Format in the top bits, then 14 bits each of width and height
+	static uint32_t MakeArrayKey( const TextureData& data );
+
+};
+
+
+#endif // !NULL_TEXTURE_2D_H
@@ -1,59 +1,71 @@
 #include "OpenGLMesh.h"
-
-
-#include <gtc/type_ptr.hpp>
+#include "OpenGLMeshPool.h"
+#include "../OpenGLStateCache.h"
 
 OpenGLMesh::OpenGLMesh( const char* objFileName ) :
 	IMesh( objFileName ),
-	VAO( 0 ), 
-	VBO( 0 )
+	m_allocation( nullptr )
 {
-	GenerateBuffers();
+	// Buffers are generated once the AssetLoader has finished loading the sub mesh
 }
 
 OpenGLMesh::~OpenGLMesh()
 {
-	glDeleteVertexArrays( 1, &VAO );
-	glDeleteBuffers( 1, &VBO );
+	if ( m_subMesh )
+	{
+		OpenGLMeshPool::Get()->Release( this, m_subMesh.get() );
+	}
+	m_allocation = nullptr;
 
 }
 
 void OpenGLMesh::GenerateBuffers()
 {
+	// Suballocated from the mesh pool, the mesh starts drawing once its sub mesh has been written into the arena
+	m_allocation = OpenGLMeshPool::Get()->Acquire(
+		this,
+		m_subMesh,
+		[this]( const OpenGLMeshAllocation& )
+		{
+			m_isReady = true;
+		}
+	);
 
-	glGenVertexArrays( 1, &VAO );
-	glGenBuffers( 1, &VBO );
-	glBindVertexArray( VAO );
-	glBindBuffer( GL_ARRAY_BUFFER, VBO );
-	glBufferData( GL_ARRAY_BUFFER, m_subMesh->vertexList.size() * sizeof( Vertex ), &m_subMesh->vertexList[0], GL_STATIC_DRAW );
-
-	//Position
-	glEnableVertexAttribArray( 0 );
-	glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, sizeof( Vertex ), (GLvoid*)0 );
+}
 
-	//Normal
-	glEnableVertexAttribArray( 1 );
-	glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, sizeof( Vertex ), (GLvoid*)offsetof( Vertex, normal ) );
+void OpenGLMesh::Render()
+{
+	if ( !m_isReady )
+	{
+		return;
+	}
 
-	//Texture Coordinates
-	glEnableVertexAttribArray( 2 );
-	glVertexAttribPointer( 2, 3, GL_FLOAT, GL_FALSE, sizeof( Vertex ), (GLvoid*)offsetof( Vertex, texCoords ) );
+	Draw( m_allocation->arena->VAO );
 
-	//Colour
-	glEnableVertexAttribArray( 3 );
-	glVertexAttribPointer( 3, 3, GL_FLOAT, GL_FALSE, sizeof( Vertex ), (GLvoid*)offsetof( Vertex, colour ) );
+}
 
-	glBindVertexArray( 0 );
-	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+void OpenGLMesh::RenderDepthOnly()
+{
+	if ( !m_isReady )
+	{
+		return;
+	}
 
+	Draw( m_allocation->arena->depthVAO );
 
 }
 
-void OpenGLMesh::Render()
+// Draws the full detail level of the allocation's range of the passed arena VAO
+void OpenGLMesh::Draw( const GLuint vertexArray )
 {
-
-	glBindVertexArray( VAO );
-	glDrawArrays( GL_TRIANGLES, 0, m_subMesh->vertexList.size() );
-	glBindVertexArray( 0 );
-
+	const MeshLod& lod = m_subMesh->lods[0];
+
+	OpenGLStateCache::Get()->BindVertexArray( vertexArray );
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		static_cast<GLsizei>( lod.indexCount ),
+		m_allocation->arena->indexType,
+		m_allocation->GetIndexOffset( lod.firstIndex ),
+		static_cast<GLint>( m_allocation->baseVertex )
+	);
 }
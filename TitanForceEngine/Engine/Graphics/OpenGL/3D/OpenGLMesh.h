@@ -5,6 +5,8 @@
 
 #include <glad/glad.h>
 
+struct OpenGLMeshAllocation;
+
 class OpenGLMesh : public IMesh
 {
 	friend class OpenGLRenderer;
@@ -18,9 +20,18 @@ public:
 
 	virtual void Render() override final;
 
+	virtual void RenderDepthOnly() override final;
+
+	// Where this mesh's vertices and indices live inside of the mesh pool, nullptr until the sub mesh has been loaded
+	const OpenGLMeshAllocation* GetAllocation() const { return m_allocation; }
+
 private:
 
-	GLuint VAO, VBO;
+	// Shared with every other mesh loaded from the same file
+	const OpenGLMeshAllocation*	m_allocation;
+
+	// Draws the full detail level of the allocation's range of the passed arena VAO
+	void Draw( const GLuint vertexArray );
 
 };
 
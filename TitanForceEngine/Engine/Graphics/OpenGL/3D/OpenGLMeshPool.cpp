@@ -0,0 +1,366 @@
+#include "OpenGLMeshPool.h"
+#include "../OpenGLUploader.h"
+#include "../OpenGLStateCache.h"
+
+#include "../../../RenderCore/3D/Mesh.h"
+#include "../../../Core/RangeAllocator.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <string>
+
+namespace
+{
+	struct GLVertexFormat
+	{
+		GLint		components;
+		GLenum		type;
+		GLboolean	normalized;
+	};
+
+	GLVertexFormat GetGLVertexFormat( const EVertexFormat format )
+	{
+		switch ( format )
+		{
+		case EVertexFormat::Float2:				return { 2, GL_FLOAT, GL_FALSE };
+		case EVertexFormat::Float3:				return { 3, GL_FLOAT, GL_FALSE };
+		case EVertexFormat::Half2:				return { 2, GL_HALF_FLOAT, GL_FALSE };
+		case EVertexFormat::Octahedral16:		return { 2, GL_SHORT, GL_TRUE };
+		case EVertexFormat::Snorm10_10_10_2:	return { 4, GL_INT_2_10_10_10_REV, GL_TRUE };
+		case EVertexFormat::Unorm8x4:			return { 4, GL_UNSIGNED_BYTE, GL_TRUE };
+		default:								return { 0, GL_FLOAT, GL_FALSE };
+		}
+	}
+}
+
+std::unique_ptr<OpenGLMeshPool> OpenGLMeshPool::g_openGLMeshPoolInstance( nullptr );
+
+OpenGLMeshPool::OpenGLMeshPool() :
+	m_arenas(),
+	m_entries()
+{}
+
+OpenGLMeshPool::~OpenGLMeshPool()
+{
+	OnDestroy();
+}
+
+// Get Instance of OpenGL Mesh Pool
+OpenGLMeshPool* OpenGLMeshPool::Get()
+{
+	if ( g_openGLMeshPoolInstance == nullptr )
+	{
+		g_openGLMeshPoolInstance.reset( new OpenGLMeshPool );
+	}
+	return g_openGLMeshPoolInstance.get();
+}
+
+// Returns the allocation holding the passed sub mesh, allocating and uploading it if no other mesh holds it yet
+// onResident is called once the data can be drawn, straight away if it already can. Returns nullptr if out of memory
+const OpenGLMeshAllocation* OpenGLMeshPool::Acquire( const void* owner, const std::shared_ptr<SubMesh>& subMesh, ResidentFunction onResident )
+{
+	auto found = m_entries.find( subMesh.get() );
+	if ( found != m_entries.end() )
+	{
+		Entry* entry = found->second;
+		entry->refCount++;
+
+		if ( entry->allocation.isResident )
+		{
+			onResident( entry->allocation );
+		}
+		else
+		{
+			entry->waiting.emplace_back( owner, std::move( onResident ) );
+		}
+		return &entry->allocation;
+	}
+
+	Entry* entry = new Entry();
+	if ( !AllocateRanges( *subMesh, entry->allocation ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to allocate " + std::to_string( subMesh->vertexCount ) + " vertices in the mesh pool" );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to allocate " + std::to_string( subMesh->vertexCount ) + " vertices in the mesh pool" );
+		delete entry;
+		return nullptr;
+	}
+
+	entry->refCount = 1;
+	entry->waiting.emplace_back( owner, std::move( onResident ) );
+	m_entries.emplace( subMesh.get(), entry );
+
+	Upload( entry, subMesh );
+	return &entry->allocation;
+}
+
+// Drops the owner's reference to the passed sub mesh, its ranges are freed once no mesh holds it
+void OpenGLMeshPool::Release( const void* owner, const SubMesh* subMesh )
+{
+	auto found = m_entries.find( subMesh );
+	if ( found == m_entries.end() )
+	{
+		return;
+	}
+
+	Entry* entry = found->second;
+	entry->waiting.erase(
+		std::remove_if( entry->waiting.begin(), entry->waiting.end(),
+			[owner]( const std::pair<const void*, ResidentFunction>& waiting ) { return waiting.first == owner; } ),
+		entry->waiting.end()
+	);
+
+	if ( --entry->refCount > 0 )
+	{
+		return;
+	}
+
+	// Jobs run in order, so a later job writing into the freed ranges cannot be overwritten by this one
+	OpenGLUploader::Get()->Cancel( entry );
+	FreeRanges( entry->allocation );
+
+	m_entries.erase( found );
+	delete entry;
+}
+
+// Deletes every arena, allocations handed out before this are no longer valid
+void OpenGLMeshPool::OnDestroy()
+{
+	for ( auto& entry : m_entries )
+	{
+		OpenGLUploader::Get()->Cancel( entry.second );
+		delete entry.second;
+	}
+	m_entries.clear();
+
+	for ( OpenGLMeshArena* arena : m_arenas )
+	{
+		DestroyArena( arena );
+	}
+	m_arenas.clear();
+}
+
+// Finds room for the passed sub mesh in an arena of its layout and index size, creating a new arena if none has room
+bool OpenGLMeshPool::AllocateRanges( const SubMesh& subMesh, OpenGLMeshAllocation& allocation )
+{
+	const uint32_t layoutId = subMesh.layout.GetId();
+
+	allocation = {};
+	allocation.vertexCount = subMesh.vertexCount;
+	allocation.indexCount = subMesh.indexCount;
+
+	for ( OpenGLMeshArena* arena : m_arenas )
+	{
+		if ( arena->layoutId != layoutId || arena->indexSize != subMesh.indexSize )
+		{
+			continue;
+		}
+
+		const size_t baseVertex = arena->vertices->Allocate( subMesh.vertexCount );
+		if ( baseVertex == RangeAllocator::m_invalidOffset )
+		{
+			continue;
+		}
+
+		const size_t firstIndex = arena->indices->Allocate( subMesh.indexCount );
+		if ( firstIndex == RangeAllocator::m_invalidOffset )
+		{
+			arena->vertices->Free( baseVertex, subMesh.vertexCount );
+			continue;
+		}
+
+		allocation.arena = arena;
+		allocation.baseVertex = static_cast<uint32_t>( baseVertex );
+		allocation.firstIndex = static_cast<uint32_t>( firstIndex );
+		return true;
+	}
+
+	// Arenas never grow, growing would mean copying every mesh already in it, a new one is added instead
+	OpenGLMeshArena* arena = CreateArena(
+		subMesh.layout,
+		subMesh.indexSize,
+		std::max<size_t>( m_arenaVertexCapacity, subMesh.vertexCount ),
+		std::max<size_t>( m_arenaIndexCapacity, subMesh.indexCount )
+	);
+	if ( arena == nullptr )
+	{
+		return false;
+	}
+
+	allocation.arena = arena;
+	allocation.baseVertex = static_cast<uint32_t>( arena->vertices->Allocate( subMesh.vertexCount ) );
+	allocation.firstIndex = static_cast<uint32_t>( arena->indices->Allocate( subMesh.indexCount ) );
+	return true;
+}
+
+void OpenGLMeshPool::FreeRanges( const OpenGLMeshAllocation& allocation )
+{
+	if ( allocation.arena == nullptr )
+	{
+		return;
+	}
+
+	allocation.arena->vertices->Free( allocation.baseVertex, allocation.vertexCount );
+	allocation.arena->indices->Free( allocation.firstIndex, allocation.indexCount );
+}
+
+OpenGLMeshArena* OpenGLMeshPool::CreateArena( const VertexLayout& layout, const uint32_t indexSize, const size_t vertexCapacity, const size_t indexCapacity )
+{
+	OpenGLMeshArena* arena = new OpenGLMeshArena();
+	arena->layout = layout;
+	arena->layoutId = layout.GetId();
+	arena->indexSize = indexSize;
+	arena->indexType = ( indexSize == sizeof( uint16_t ) ) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	arena->vertices = new RangeAllocator( vertexCapacity );
+	arena->indices = new RangeAllocator( indexCapacity );
+
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+
+	glGenBuffers( VertexLayout::m_maxStreams, arena->vertexBuffers );
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		stateCache->BindBuffer( GL_ARRAY_BUFFER, arena->vertexBuffers[s] );
+		glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( vertexCapacity * layout.strides[s] ), nullptr, GL_STATIC_DRAW );
+	}
+
+	glGenBuffers( 1, &arena->indexBuffer );
+
+	// Element buffer binding is stored inside of each VAO
+	glGenVertexArrays( 1, &arena->VAO );
+	stateCache->BindVertexArray( arena->VAO );
+	stateCache->BindBuffer( GL_ELEMENT_ARRAY_BUFFER, arena->indexBuffer );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>( indexCapacity * indexSize ), nullptr, GL_STATIC_DRAW );
+	SetUpVertexAttributes( *arena, false );
+
+	glGenVertexArrays( 1, &arena->depthVAO );
+	stateCache->BindVertexArray( arena->depthVAO );
+	stateCache->BindBuffer( GL_ELEMENT_ARRAY_BUFFER, arena->indexBuffer );
+	SetUpVertexAttributes( *arena, true );
+
+	// Unbound so nothing bound later changes the arena's VAOs by accident
+	stateCache->BindVertexArray( 0 );
+
+	if ( glGetError() == GL_OUT_OF_MEMORY )
+	{
+		DestroyArena( arena );
+		return nullptr;
+	}
+
+	DEBUG_LOG( LOG::INFO, "Created mesh arena " + std::to_string( m_arenas.size() ) + " with " + std::to_string( vertexCapacity ) + " vertices and " + std::to_string( indexCapacity ) + " indices" );
+	CONSOLE_LOG( LOG::INFO, "Created mesh arena " + std::to_string( m_arenas.size() ) + " with " + std::to_string( vertexCapacity ) + " vertices and " + std::to_string( indexCapacity ) + " indices" );
+
+	m_arenas.push_back( arena );
+	return arena;
+}
+
+void OpenGLMeshPool::DestroyArena( OpenGLMeshArena* arena )
+{
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+	stateCache->DeleteVertexArrays( 1, &arena->VAO );
+	stateCache->DeleteVertexArrays( 1, &arena->depthVAO );
+	stateCache->DeleteBuffers( VertexLayout::m_maxStreams, arena->vertexBuffers );
+	stateCache->DeleteBuffers( 1, &arena->indexBuffer );
+
+	delete arena->vertices;
+	delete arena->indices;
+	delete arena;
+}
+
+// Writes the sub mesh into its ranges, on the upload thread when it is running
+void OpenGLMeshPool::Upload( Entry* entry, const std::shared_ptr<SubMesh>& subMesh )
+{
+	const OpenGLMeshAllocation& allocation = entry->allocation;
+	const OpenGLMeshArena& arena = *allocation.arena;
+
+	size_t vertexOffsets[VertexLayout::m_maxStreams];
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		vertexOffsets[s] = static_cast<size_t>( allocation.baseVertex ) * arena.layout.strides[s];
+	}
+	const size_t indexOffset = static_cast<size_t>( allocation.firstIndex ) * arena.indexSize;
+
+	GLuint vertexBuffers[VertexLayout::m_maxStreams];
+	std::copy( arena.vertexBuffers, arena.vertexBuffers + VertexLayout::m_maxStreams, vertexBuffers );
+	const GLuint indexBuffer = arena.indexBuffer;
+
+	OpenGLUploader* uploader = OpenGLUploader::Get();
+	if ( uploader->IsRunning() )
+		// Arena buffers are shared with the upload context, so only the copies happen on the upload thread
+	{
+		uploader->Submit(
+			entry,
+			[subMesh, vertexBuffers, vertexOffsets, indexBuffer, indexOffset]( OpenGLUploader& uploader, OpenGLUploadResult& )
+			{
+				for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+				{
+					uploader.WriteBuffer( vertexBuffers[s], vertexOffsets[s], subMesh->vertexStreams[s].data, subMesh->vertexStreams[s].size );
+				}
+				uploader.WriteBuffer( indexBuffer, indexOffset, subMesh->indexStream.data, subMesh->indexStream.size );
+			},
+			[this, entry]( const OpenGLUploadResult& )
+			{
+				OnResident( entry );
+			}
+		);
+		return;
+	}
+
+	// Uploading straight from the packed blobs, which may point into a memory mapped cooked mesh
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		const MeshBlob& stream = subMesh->vertexStreams[s];
+		if ( stream.size == 0 )
+		{
+			continue;
+		}
+
+		OpenGLStateCache::Get()->BindBuffer( GL_COPY_WRITE_BUFFER, vertexBuffers[s] );
+		glBufferSubData( GL_COPY_WRITE_BUFFER, static_cast<GLintptr>( vertexOffsets[s] ), static_cast<GLsizeiptr>( stream.size ), stream.data );
+	}
+
+	OpenGLStateCache::Get()->BindBuffer( GL_COPY_WRITE_BUFFER, indexBuffer );
+	glBufferSubData( GL_COPY_WRITE_BUFFER, static_cast<GLintptr>( indexOffset ), static_cast<GLsizeiptr>( subMesh->indexStream.size ), subMesh->indexStream.data );
+
+	OnResident( entry );
+}
+
+void OpenGLMeshPool::OnResident( Entry* entry )
+{
+	entry->allocation.isResident = true;
+
+	// Moved out first, a callback may release its owner's reference
+	std::vector<std::pair<const void*, ResidentFunction>> waiting;
+	waiting.swap( entry->waiting );
+	for ( auto& owner : waiting )
+	{
+		owner.second( entry->allocation );
+	}
+}
+
+// Points the attributes of the arena's layout at its vertex buffers, on the currently bound VAO
+void OpenGLMeshPool::SetUpVertexAttributes( const OpenGLMeshArena& arena, const bool positionOnly )
+{
+	const VertexLayout& layout = arena.layout;
+	for ( size_t a = 0; a < layout.attributes.size(); ++a )
+	{
+		const VertexAttributeDesc& attribute = layout.attributes[a];
+		if ( attribute.format == EVertexFormat::None || ( positionOnly && attribute.stream != VertexLayout::m_positionStream ) )
+		{
+			continue;
+		}
+
+		const GLVertexFormat glFormat = GetGLVertexFormat( attribute.format );
+		const GLuint location = static_cast<GLuint>( a );
+
+		OpenGLStateCache::Get()->BindBuffer( GL_ARRAY_BUFFER, arena.vertexBuffers[attribute.stream] );
+		glEnableVertexAttribArray( location );
+		glVertexAttribPointer(
+			location,
+			glFormat.components,
+			glFormat.type,
+			glFormat.normalized,
+			layout.strides[attribute.stream],
+			reinterpret_cast<const GLvoid*>( static_cast<uintptr_t>( attribute.offset ) )
+		);
+	}
+}
@@ -0,0 +1,119 @@
+#ifndef OPENGLMESHPOOL_H
+#define OPENGLMESHPOOL_H
+
+#include "../../../RenderCore/3D/VertexLayout.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class RangeAllocator;
+struct SubMesh;
+
+// Large vertex and index buffers shared by every mesh with the same vertex layout and index size
+// Meshes are suballocated from them, so a whole arena is drawn through a single VAO
+struct OpenGLMeshArena
+{
+	VertexLayout	layout;
+	uint32_t		layoutId;
+	uint32_t		indexSize;		// Bytes per index, 2 or 4
+	GLenum			indexType;
+	GLuint			vertexBuffers[VertexLayout::m_maxStreams];
+	GLuint			indexBuffer;
+	GLuint			VAO;			// Reads every stream
+	GLuint			depthVAO;		// Reads only the position stream
+	RangeAllocator*	vertices;		// Counted in vertices
+	RangeAllocator*	indices;		// Counted in indices
+};
+
+// Where a sub mesh lives inside of its arena, shared by every mesh drawing the same sub mesh
+struct OpenGLMeshAllocation
+{
+	OpenGLMeshArena*	arena;
+	uint32_t			baseVertex;
+	uint32_t			vertexCount;
+	uint32_t			firstIndex;
+	uint32_t			indexCount;		// Of every level of detail together
+	bool				isResident;		// True once the sub mesh has been written into the arena's buffers
+
+	// Byte offset inside of the arena's index buffer of the passed index of the sub mesh, such as a LOD's first index
+	const void* GetIndexOffset( const uint32_t index = 0 ) const
+	{
+		return reinterpret_cast<const void*>( static_cast<uintptr_t>( firstIndex + index ) * arena->indexSize );
+	}
+};
+
+// Singleton that suballocates static mesh data from a few large arenas, render thread only
+// Sub meshes loaded from the same file are stored once, however many meshes draw them
+class OpenGLMeshPool
+{
+
+	OpenGLMeshPool( const OpenGLMeshPool& ) = delete;
+	OpenGLMeshPool& operator=( const OpenGLMeshPool& ) = delete;
+	OpenGLMeshPool( OpenGLMeshPool&& ) = delete;
+	OpenGLMeshPool& operator=( OpenGLMeshPool&& ) = delete;
+
+public:
+
+	// Called on the render thread once an allocation's data can be drawn
+	using ResidentFunction = std::function<void( const OpenGLMeshAllocation& )>;
+
+	// Elements each arena is created with, sub meshes larger than this get an arena sized to fit them
+	static constexpr size_t m_arenaVertexCapacity = 1024 * 1024;
+	static constexpr size_t m_arenaIndexCapacity = 4 * 1024 * 1024;
+
+	// Get Instance of OpenGL Mesh Pool
+	static OpenGLMeshPool* Get();
+
+	// Returns the allocation holding the passed sub mesh, allocating and uploading it if no other mesh holds it yet
+	// onResident is called once the data can be drawn, straight away if it already can. Returns nullptr if out of memory
+	const OpenGLMeshAllocation* Acquire( const void* owner, const std::shared_ptr<SubMesh>& subMesh, ResidentFunction onResident );
+
+	// Drops the owner's reference to the passed sub mesh, its ranges are freed once no mesh holds it
+	void Release( const void* owner, const SubMesh* subMesh );
+
+	// Deletes every arena, allocations handed out before this are no longer valid
+	void OnDestroy();
+
+	size_t GetArenaCount() const { return m_arenas.size(); }
+
+private:
+
+	struct Entry
+	{
+		OpenGLMeshAllocation										allocation;
+		std::vector<std::pair<const void*, ResidentFunction>>		waiting;	// Owners to notify once resident
+		uint32_t													refCount;
+	};
+
+	OpenGLMeshPool();
+	~OpenGLMeshPool();
+
+	static std::unique_ptr<OpenGLMeshPool> g_openGLMeshPoolInstance;
+	friend std::default_delete<OpenGLMeshPool>;
+
+	std::vector<OpenGLMeshArena*>						m_arenas;
+	std::unordered_map<const SubMesh*, Entry*>			m_entries;
+
+	// Finds room for the passed sub mesh in an arena of its layout and index size, creating a new arena if none has room
+	bool AllocateRanges( const SubMesh& subMesh, OpenGLMeshAllocation& allocation );
+	void FreeRanges( const OpenGLMeshAllocation& allocation );
+
+	OpenGLMeshArena* CreateArena( const VertexLayout& layout, const uint32_t indexSize, const size_t vertexCapacity, const size_t indexCapacity );
+	void DestroyArena( OpenGLMeshArena* arena );
+
+	// Writes the sub mesh into its ranges, on the upload thread when it is running
+	void Upload( Entry* entry, const std::shared_ptr<SubMesh>& subMesh );
+	void OnResident( Entry* entry );
+
+	// Points the attributes of the arena's layout at its vertex buffers, on the currently bound VAO
+	static void SetUpVertexAttributes( const OpenGLMeshArena& arena, const bool positionOnly );
+
+};
+
+#endif // !OPENGLMESHPOOL_H
@@ -0,0 +1,39 @@
+#include "OpenGLExtensions.h"
+
+#include <glad/glad.h>
+
+std::unordered_set<std::string> OpenGLExtensions::m_extensions;
+int OpenGLExtensions::m_majorVersion = 0;
+int OpenGLExtensions::m_minorVersion = 0;
+
+// Reads the extension list of the current context, called by the renderer once the context exists
+void OpenGLExtensions::Initialize()
+{
+	m_extensions.clear();
+
+	glGetIntegerv( GL_MAJOR_VERSION, &m_majorVersion );
+	glGetIntegerv( GL_MINOR_VERSION, &m_minorVersion );
+
+	GLint count = 0;
+	glGetIntegerv( GL_NUM_EXTENSIONS, &count );
+	for ( GLint i = 0; i < count; ++i )
+	{
+		const GLubyte* name = glGetStringi( GL_EXTENSIONS, static_cast<GLuint>( i ) );
+		if ( name )
+		{
+			m_extensions.insert( reinterpret_cast<const char*>( name ) );
+		}
+	}
+}
+
+// Returns true if the passed extension, for example "GL_EXT_texture_compression_s3tc", is supported
+bool OpenGLExtensions::IsSupported( const std::string& extension )
+{
+	return m_extensions.find( extension ) != m_extensions.end();
+}
+
+// Returns true if the context is at least the passed version, for features that were promoted into core
+bool OpenGLExtensions::HasVersion( const int major, const int minor )
+{
+	return m_majorVersion > major || ( m_majorVersion == major && m_minorVersion >= minor );
+}
@@ -0,0 +1,36 @@
+#ifndef OPENGLEXTENSIONS_H
+#define OPENGLEXTENSIONS_H
+
+#include <string>
+#include <unordered_set>
+
+// Extensions reported by the current context, queried once after GLAD has loaded
+class OpenGLExtensions
+{
+
+	OpenGLExtensions() = delete;	// Static class, no constructor needed
+	OpenGLExtensions( const OpenGLExtensions& ) = delete;
+	OpenGLExtensions& operator=( const OpenGLExtensions& ) = delete;
+	OpenGLExtensions( OpenGLExtensions&& ) = delete;
+	OpenGLExtensions& operator=( OpenGLExtensions&& ) = delete;
+
+public:
+
+	// Reads the extension list of the current context, called by the renderer once the context exists
+	static void Initialize();
+
+	// Returns true if the passed extension, for example "GL_EXT_texture_compression_s3tc", is supported
+	static bool IsSupported( const std::string& extension );
+
+	// Returns true if the context is at least the passed version, for features that were promoted into core
+	static bool HasVersion( const int major, const int minor );
+
+private:
+
+	static std::unordered_set<std::string> m_extensions;
+	static int m_majorVersion;
+	static int m_minorVersion;
+
+};
+
+#endif // !OPENGLEXTENSIONS_H
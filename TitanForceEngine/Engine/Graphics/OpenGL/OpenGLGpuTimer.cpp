@@ -0,0 +1,168 @@
+#include "OpenGLGpuTimer.h"
+
+OpenGLGpuTimer::OpenGLGpuTimer() :
+	m_sets(),
+	m_pendingSets(),
+	m_freeSets(),
+	m_current( -1 ),
+	m_activePass( -1 ),
+	m_hasResults( false ),
+	m_resultFrameIndex( 0 ),
+	m_resultMilliseconds()
+{}
+
+OpenGLGpuTimer::~OpenGLGpuTimer()
+{}
+
+void OpenGLGpuTimer::OnCreate()
+{
+	m_sets.reserve( m_maxFrameLatency );
+	for ( uint32_t i = 0; i < m_frameLatency; ++i )
+	{
+		const int set = CreateSet();
+		if ( set >= 0 )
+		{
+			m_freeSets.push_back( static_cast<uint32_t>( set ) );
+		}
+	}
+}
+
+void OpenGLGpuTimer::OnDestroy()
+{
+	if ( m_activePass >= 0 )
+	{
+		EndPass();
+	}
+
+	for ( QuerySet& set : m_sets )
+	{
+		glDeleteQueries( m_passCount, set.queries );
+	}
+	m_sets.clear();
+	m_pendingSets.clear();
+	m_freeSets.clear();
+	m_current = -1;
+}
+
+// Starts timing the passed frame, collecting the results of every pending set the GPU is done with first
+void OpenGLGpuTimer::BeginFrame( const uint64_t frameIndex )
+{
+	// The last frame's set waits for its results, or is reused straight away if nothing was timed
+	if ( m_current >= 0 )
+	{
+		if ( m_sets[m_current].isPending )
+		{
+			m_pendingSets.push_back( static_cast<uint32_t>( m_current ) );
+		}
+		else
+		{
+			m_freeSets.push_back( static_cast<uint32_t>( m_current ) );
+		}
+		m_current = -1;
+	}
+
+	// Results still unavailable are left pending, neither waited on nor dropped
+	while ( !m_pendingSets.empty() && Collect( m_sets[m_pendingSets.front()] ) )
+	{
+		m_freeSets.push_back( m_pendingSets.front() );
+		m_pendingSets.pop_front();
+	}
+
+	if ( !m_freeSets.empty() )
+	{
+		m_current = static_cast<int>( m_freeSets.back() );
+		m_freeSets.pop_back();
+	}
+	else
+	{
+		m_current = CreateSet();
+	}
+
+	if ( m_current < 0 )
+	{
+		return;
+	}
+
+	QuerySet& set = m_sets[m_current];
+	set.isPending = false;
+	set.frameIndex = frameIndex;
+	for ( bool& isIssued : set.isIssued )
+	{
+		isIssued = false;
+	}
+}
+
+// Only one pass can be timed at a time, GL_TIME_ELAPSED queries cannot overlap
+void OpenGLGpuTimer::BeginPass( const ERenderPass pass )
+{
+	if ( m_current < 0 || m_activePass >= 0 )
+	{
+		return;
+	}
+
+	QuerySet& set = m_sets[m_current];
+	const int index = static_cast<int>( pass );
+
+	glBeginQuery( GL_TIME_ELAPSED, set.queries[index] );
+	set.isIssued[index] = true;
+	set.isPending = true;
+	m_activePass = index;
+}
+
+void OpenGLGpuTimer::EndPass()
+{
+	if ( m_activePass < 0 )
+	{
+		return;
+	}
+
+	glEndQuery( GL_TIME_ELAPSED );
+	m_activePass = -1;
+}
+
+// Returns true and fills the results if every query of the passed set is available
+bool OpenGLGpuTimer::Collect( QuerySet& set )
+{
+	for ( int pass = 0; pass < m_passCount; ++pass )
+	{
+		if ( !set.isIssued[pass] )
+		{
+			continue;
+		}
+
+		GLint isAvailable = 0;
+		glGetQueryObjectiv( set.queries[pass], GL_QUERY_RESULT_AVAILABLE, &isAvailable );
+		if ( !isAvailable )
+		{
+			return false;
+		}
+	}
+
+	for ( int pass = 0; pass < m_passCount; ++pass )
+	{
+		GLuint64 nanoseconds = 0;
+		if ( set.isIssued[pass] )
+		{
+			glGetQueryObjectui64v( set.queries[pass], GL_QUERY_RESULT, &nanoseconds );
+		}
+		m_resultMilliseconds[pass] = static_cast<float>( static_cast<double>( nanoseconds ) / 1000000.0 );
+	}
+
+	m_resultFrameIndex = set.frameIndex;
+	m_hasResults = true;
+	return true;
+}
+
+// Returns the index of a new set of queries, or -1 if m_maxFrameLatency sets already exist
+int OpenGLGpuTimer::CreateSet()
+{
+	if ( m_sets.size() >= m_maxFrameLatency )
+	{
+		return -1;
+	}
+
+	QuerySet set = {};
+	glGenQueries( m_passCount, set.queries );
+	m_sets.push_back( set );
+	return static_cast<int>( m_sets.size() ) - 1;
+}
@@ -0,0 +1,79 @@
+#ifndef OPENGLGPUTIMER_H
+#define OPENGLGPUTIMER_H
+
+#include "../../RenderCore/RenderStats.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Times each ERenderPass on the GPU with GL_TIME_ELAPSED queries
+// Every frame in flight has its own set of queries, a set is only read once the GPU has finished with it, so reading
+// results never waits. Sets stay pending until their results arrive, more sets are created while the GPU lags behind
+class OpenGLGpuTimer
+{
+
+	OpenGLGpuTimer( const OpenGLGpuTimer& ) = delete;
+	OpenGLGpuTimer& operator=( const OpenGLGpuTimer& ) = delete;
+	OpenGLGpuTimer( OpenGLGpuTimer&& ) = delete;
+	OpenGLGpuTimer& operator=( OpenGLGpuTimer&& ) = delete;
+
+public:
+
+	// Sets of queries created up front, one more than the stream buffer's frames in flight so results are normally ready when read
+	static constexpr uint32_t m_frameLatency = 4;
+
+	// Most sets ever created, frames begun while every one of them is still pending are not timed
+	static constexpr uint32_t m_maxFrameLatency = 16;
+
+	OpenGLGpuTimer();
+	~OpenGLGpuTimer();
+
+	void OnCreate();
+	void OnDestroy();
+
+	// Starts timing the passed frame, collecting the results of every pending set the GPU is done with first
+	void BeginFrame( const uint64_t frameIndex );
+
+	// Only one pass can be timed at a time, GL_TIME_ELAPSED queries cannot overlap
+	void BeginPass( const ERenderPass pass );
+	void EndPass();
+
+	// Returns false until the first set of results has been collected
+	bool HasResults() const { return m_hasResults; }
+	uint64_t GetResultFrameIndex() const { return m_resultFrameIndex; }
+	float GetResultMilliseconds( const ERenderPass pass ) const { return m_resultMilliseconds[static_cast<int>( pass )]; }
+
+private:
+
+	static constexpr int m_passCount = static_cast<int>( ERenderPass::TOTAL );
+
+	struct QuerySet
+	{
+		GLuint		queries[m_passCount];
+		bool		isIssued[m_passCount];
+		bool		isPending;		// Has issued queries whose results have not been collected
+		uint64_t	frameIndex;
+	};
+
+	std::vector<QuerySet>	m_sets;
+	std::deque<uint32_t>	m_pendingSets;		// Oldest first, results are collected in the order frames were timed
+	std::vector<uint32_t>	m_freeSets;
+	int						m_current;			// -1 when the frame is not timed
+	int						m_activePass;		// -1 when no pass is being timed
+
+	bool		m_hasResults;
+	uint64_t	m_resultFrameIndex;
+	float		m_resultMilliseconds[m_passCount];
+
+	// Returns true and fills the results if every query of the passed set is available
+	bool Collect( QuerySet& set );
+
+	// Returns the index of a new set of queries, or -1 if m_maxFrameLatency sets already exist
+	int CreateSet();
+
+};
+
+#endif // !OPENGLGPUTIMER_H
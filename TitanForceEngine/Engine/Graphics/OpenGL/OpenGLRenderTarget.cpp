@@ -0,0 +1,62 @@
+#include "OpenGLRenderTarget.h"
+
+OpenGLRenderTarget::OpenGLRenderTarget( const int width, const int height ) :
+	m_width( width ),
+	m_height( height ),
+	m_framebuffer( 0 ),
+	m_colourRenderbuffer( 0 ),
+	m_depthRenderbuffer( 0 )
+{}
+
+OpenGLRenderTarget::~OpenGLRenderTarget()
+{
+	OnDestroy();
+}
+
+// Creates the framebuffer and its attachments, returns false if the driver cannot draw into them
+bool OpenGLRenderTarget::OnCreate()
+{
+	glGenRenderbuffers( 1, &m_colourRenderbuffer );
+	glBindRenderbuffer( GL_RENDERBUFFER, m_colourRenderbuffer );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, m_width, m_height );
+
+	glGenRenderbuffers( 1, &m_depthRenderbuffer );
+	glBindRenderbuffer( GL_RENDERBUFFER, m_depthRenderbuffer );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height );
+
+	glGenFramebuffers( 1, &m_framebuffer );
+	glBindFramebuffer( GL_FRAMEBUFFER, m_framebuffer );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colourRenderbuffer );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer );
+
+	return glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void OpenGLRenderTarget::OnDestroy()
+{
+	if ( m_framebuffer != 0 )
+	{
+		glDeleteFramebuffers( 1, &m_framebuffer );
+		m_framebuffer = 0;
+	}
+
+	if ( m_colourRenderbuffer != 0 )
+	{
+		glDeleteRenderbuffers( 1, &m_colourRenderbuffer );
+		m_colourRenderbuffer = 0;
+	}
+
+	if ( m_depthRenderbuffer != 0 )
+	{
+		glDeleteRenderbuffers( 1, &m_depthRenderbuffer );
+		m_depthRenderbuffer = 0;
+	}
+}
+
+// Stretches the lower left width by height pixels over the whole of the passed framebuffer with bilinear filtering
+void OpenGLRenderTarget::Upscale( const int width, const int height, const GLuint framebuffer, const int framebufferWidth, const int framebufferHeight ) const
+{
+	glBindFramebuffer( GL_READ_FRAMEBUFFER, m_framebuffer );
+	glBindFramebuffer( GL_DRAW_FRAMEBUFFER, framebuffer );
+	glBlitFramebuffer( 0, 0, width, height, 0, 0, framebufferWidth, framebufferHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+}
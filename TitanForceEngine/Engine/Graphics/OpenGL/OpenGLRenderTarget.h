@@ -0,0 +1,44 @@
+#ifndef OPENGLRENDERTARGET_H
+#define OPENGLRENDERTARGET_H
+
+#include <glad/glad.h>
+
+// Offscreen colour and depth framebuffer the scene is drawn into when it is not drawn at the window's size
+// It is created at the largest size it is drawn at, smaller frames only use its lower left corner, so changing the
+// resolution from frame to frame never reallocates it
+class OpenGLRenderTarget
+{
+
+	OpenGLRenderTarget( const OpenGLRenderTarget& ) = delete;
+	OpenGLRenderTarget& operator=( const OpenGLRenderTarget& ) = delete;
+	OpenGLRenderTarget( OpenGLRenderTarget&& ) = delete;
+	OpenGLRenderTarget& operator=( OpenGLRenderTarget&& ) = delete;
+
+public:
+
+	OpenGLRenderTarget( const int width, const int height );
+	~OpenGLRenderTarget();
+
+	// Creates the framebuffer and its attachments, returns false if the driver cannot draw into them
+	bool OnCreate();
+	void OnDestroy();
+
+	GLuint GetFramebuffer() const { return m_framebuffer; }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+	// Stretches the lower left width by height pixels over the whole of the passed framebuffer with bilinear filtering
+	void Upscale( const int width, const int height, const GLuint framebuffer, const int framebufferWidth, const int framebufferHeight ) const;
+
+private:
+
+	int			m_width;
+	int			m_height;
+
+	GLuint		m_framebuffer;
+	GLuint		m_colourRenderbuffer;
+	GLuint		m_depthRenderbuffer;
+
+};
+
+#endif // !OPENGLRENDERTARGET_H
@@ -1,21 +1,104 @@
 #include "OpenGLRenderer.h"
+#include "OpenGLExtensions.h"
+#include "OpenGLUploader.h"
+#include "OpenGLStreamBuffer.h"
+#include "OpenGLStateCache.h"
+#include "OpenGLGpuTimer.h"
+#include "OpenGLRenderTarget.h"
+#include "3D/OpenGLMesh.h"
+#include "3D/OpenGLMeshPool.h"
+#include "Texture/OpenGLTexture2D.h"
+#include "Texture/OpenGLTextureArrayPool.h"
 
 #include "../../Devices/Window.h"
 #include "../../RenderCore/Model/Model.h"
 #include "../../Components/RenderComponent.h"
 #include "../../Components/TransformComponent.h"
 #include "../../RenderCore/Camera/Camera.h"
+#include "../../RenderCore/Commands/DrawRecorder.h"
+#include "../../RenderCore/Culling/OcclusionCuller.h"
+#include "../../RenderCore/Culling/SceneCuller.h"
+#include "../../RenderCore/Extraction/DrawExtractor.h"
+#include "../../RenderCore/Lighting/LightCuller.h"
+#include "../../RenderCore/Material/MaterialTable.h"
+#include "../../RenderCore/Loading/AssetLoader.h"
+#include "../../RenderCore/Resolution/ResolutionController.h"
+#include "../../RenderCore/Texture/Texture2D.h"
+#include "../../RenderCore/Shader/UniformBlocks.h"
+#include "../../RenderCore/Shader/ShaderLinker.h"
+#include "../../Core/Engine.h"
+#include "../../Core/ThreadPool.h"
 
 #include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
 
+#include <algorithm>
+#include <chrono>
 #include <string>
+#include <tuple>
+
+namespace
+{
+	// Layout of a single command read by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		GLuint	count;
+		GLuint	instanceCount;
+		GLuint	firstIndex;
+		GLint	baseVertex;
+		GLuint	baseInstance;
+	};
+
+	static_assert( sizeof( DrawElementsIndirectCommand ) == 20, "DrawElementsIndirectCommand must be tightly packed" );
+
+	size_t AlignUp( const size_t value, const size_t alignment )
+	{
+		return ( ( value + alignment - 1 ) / alignment ) * alignment;
+	}
+
+	std::string FormatPassTimes( const float milliseconds[] )
+	{
+		std::string text;
+		for ( int pass = 0; pass < static_cast<int>( ERenderPass::TOTAL ); ++pass )
+		{
+			text += std::string( pass > 0 ? ", " : "" ) + g_renderPassNames[pass] + " " + std::to_string( milliseconds[pass] ) + " ms";
+		}
+		return text;
+	}
+}
 
 OpenGLRenderer::OpenGLRenderer() :
-	IRenderer()
+	IRenderer(),
+	m_streamBuffer( nullptr ),
+	m_uniformAlignment( 256 ),
+	m_storageAlignment( 256 ),
+	m_hasDrawParameters( false ),
+	m_sceneCuller( nullptr ),
+	m_drawExtractor( nullptr ),
+	m_materialBuffer( 0 ),
+	m_materialBufferSize( 0 ),
+	m_materialVersion( 0 ),
+	m_drawRecorder( nullptr ),
+	m_draws(),
+	m_drawGroups(),
+	m_objectDataSize( 0 ),
+	m_objectData(),
+	m_commandData(),
+	m_hasDrawData( false ),
+	m_depthLinker( nullptr ),
+	m_hasDepthPrepass( false ),
+	m_resolutionController( nullptr ),
+	m_sceneTarget( nullptr ),
+	m_renderWidth( 0 ),
+	m_renderHeight( 0 ),
+	m_frameIndex( 0 ),
+	m_frameStats(),
+	m_gpuTimer( nullptr )
 {}
 
 OpenGLRenderer::~OpenGLRenderer()
-{}
+{
+	OnDestroy();
+}
 
 bool OpenGLRenderer::OnCreate(
 	const char * applicationName,
@@ -26,7 +109,8 @@ bool OpenGLRenderer::OnCreate(
 {
 	m_window = window;
 
-	if ( !gladLoadGL() )
+	// A headless window's GL functions come from EGL, they were loaded when its context was created
+	if ( !m_window->IsHeadless() && !gladLoadGL() )
 	{
 		DEBUG_LOG( LOG::FATAL, "Failed to init GL with GLAD!" );
 		CONSOLE_LOG( LOG::FATAL, "Failed to init GL with GLAD!" );
@@ -35,29 +119,255 @@ bool OpenGLRenderer::OnCreate(
 
 	int major, minor;
 	GetInstalledOpenGLInfo( &major, &minor );
+	OpenGLExtensions::Initialize();
+
+	// Per draw data is read from a shader storage buffer and draws are issued with glMultiDrawElementsIndirect
+	if ( !OpenGLExtensions::HasVersion( 4, 3 ) )
+	{
+		DEBUG_LOG( LOG::FATAL, "OpenGL 4.3 is required, found " + std::to_string( major ) + "." + std::to_string( minor ) );
+		CONSOLE_LOG( LOG::FATAL, "OpenGL 4.3 is required, found " + std::to_string( major ) + "." + std::to_string( minor ) );
+		return false;
+	}
+
+	// The shaders are #version 430 and only use gl_DrawIDARB when the extension is advertised, core 4.6 alone is not enough
+	m_hasDrawParameters = OpenGLExtensions::IsSupported( "GL_ARB_shader_draw_parameters" );
+	if ( !m_hasDrawParameters )
+	{
+		DEBUG_LOG( LOG::WARNING, "GL_ARB_shader_draw_parameters is not supported, draws are issued one at a time" );
+		CONSOLE_LOG( LOG::WARNING, "GL_ARB_shader_draw_parameters is not supported, draws are issued one at a time" );
+	}
+
+	// Cooked textures are BC1 and BC3, without S3TC every texture is decoded from its source image instead
+	const bool hasS3TC = OpenGLExtensions::IsSupported( "GL_EXT_texture_compression_s3tc" );
+	Texture2D::SetBlockCompressionSupported( hasS3TC );
+	if ( !hasS3TC )
+	{
+		DEBUG_LOG( LOG::WARNING, "GL_EXT_texture_compression_s3tc is not supported, cooked textures are disabled" );
+		CONSOLE_LOG( LOG::WARNING, "GL_EXT_texture_compression_s3tc is not supported, cooked textures are disabled" );
+	}
+
+	// Shaders are compiled on the driver's threads, programs are drawn with once they finish
+	const bool hasParallelCompile = OpenGLExtensions::IsSupported( "GL_KHR_parallel_shader_compile" ) ||
+		OpenGLExtensions::IsSupported( "GL_ARB_parallel_shader_compile" );
+	ShaderLinker::SetParallelCompileSupported( hasParallelCompile );
+	if ( hasParallelCompile )
+	{
+		SetMaxShaderCompilerThreads();
+	}
+
+	// Frames are drawn without the depth pre-pass until its program has linked
+	m_depthLinker = new ShaderLinker( "DepthShader" );
+	m_depthLinker->SubmitShader( new Shader( EShaderType::Vertex, "DepthVertex.glsl" ) );
+	m_depthLinker->SubmitShader( new Shader( EShaderType::Fragment, "DepthFragment.glsl" ) );
+	m_depthLinker->LinkShaders();
+
+	if ( !m_window->IsHeadless() )
+	{
+		glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, major );
+		glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, minor );
+	}
+
+	// Nothing is known about the new context's state yet
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+	stateCache->Invalidate();
+	stateCache->Enable( GL_DEPTH_TEST );
+	stateCache->Enable( GL_MULTISAMPLE ); // enables multisampling
+
+	stateCache->Viewport( 0, 0, m_window->GetWidth(), m_window->GetHeight() );
+
+	// Without the upload thread every buffer and texture is created on this thread instead
+	OpenGLUploader::Get()->OnCreate( m_window );
+
+	GLint uniformAlignment = 0;
+	glGetIntegerv( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment );
+	if ( uniformAlignment > 0 )
+	{
+		m_uniformAlignment = static_cast<size_t>( uniformAlignment );
+	}
 
-	glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, major );
-	glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, minor );
-	glEnable( GL_DEPTH_TEST );
-	glEnable( GL_MULTISAMPLE ); // enables multisampling
+	GLint storageAlignment = 0;
+	glGetIntegerv( GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment );
+	if ( storageAlignment > 0 )
+	{
+		m_storageAlignment = static_cast<size_t>( storageAlignment );
+	}
+
+	m_streamBuffer = new OpenGLStreamBuffer( GL_UNIFORM_BUFFER, m_streamBufferSize );
+	if ( !m_streamBuffer->OnCreate() )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create stream buffer!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create stream buffer!" );
+		return false;
+	}
 
-	glViewport( 0, 0, m_window->GetWidth(), m_window->GetHeight() );
+	m_sceneCuller = new SceneCuller();
+	m_drawExtractor = new DrawExtractor();
+	m_drawRecorder = new DrawRecorder();
+	m_resolutionController = new ResolutionController();
+
+	m_gpuTimer = new OpenGLGpuTimer();
+	m_gpuTimer->OnCreate();
 
 	return true;
 }
 
 void OpenGLRenderer::OnDestroy()
-{}
+{
+	if ( m_streamBuffer )
+	{
+		delete m_streamBuffer;
+		m_streamBuffer = nullptr;
+	}
+
+	if ( m_sceneCuller )
+	{
+		delete m_sceneCuller;
+		m_sceneCuller = nullptr;
+	}
+
+	if ( m_drawExtractor )
+	{
+		delete m_drawExtractor;
+		m_drawExtractor = nullptr;
+	}
+
+	if ( m_depthLinker )
+	{
+		delete m_depthLinker;
+		m_depthLinker = nullptr;
+	}
+
+	if ( m_resolutionController )
+	{
+		delete m_resolutionController;
+		m_resolutionController = nullptr;
+	}
+
+	if ( m_sceneTarget )
+	{
+		delete m_sceneTarget;
+		m_sceneTarget = nullptr;
+	}
+
+	if ( m_drawRecorder )
+	{
+		delete m_drawRecorder;
+		m_drawRecorder = nullptr;
+	}
+
+	if ( m_gpuTimer )
+	{
+		m_gpuTimer->OnDestroy();
+		delete m_gpuTimer;
+		m_gpuTimer = nullptr;
+	}
+
+	if ( m_materialBuffer )
+	{
+		OpenGLStateCache::Get()->DeleteBuffers( 1, &m_materialBuffer );
+		m_materialBuffer = 0;
+		m_materialBufferSize = 0;
+	}
+
+	// Arenas are shared with the upload context, its jobs are cancelled before the uploader stops
+	OpenGLMeshPool::Get()->OnDestroy();
+	OpenGLTextureArrayPool::Get()->OnDestroy();
+	OpenGLUploader::Get()->OnDestroy();
+}
 
 void OpenGLRenderer::RenderScene( IScene * scene )
 {
+	const auto frameStart = std::chrono::steady_clock::now();
+	m_frameStats = {};
+	m_frameStats.frameIndex = m_frameIndex;
+	m_gpuTimer->BeginFrame( m_frameIndex );
+
 	BeginScene( scene );
 
-	Begin();
-	Present();
-	End();
+	RunPass( ERenderPass::Clear, &OpenGLRenderer::Begin );
+
+	// Recording and streaming the draws is not part of any pass, it only counts towards the whole frame
+	PrepareDraws();
+
+	RunPass( ERenderPass::DepthPrepass, &OpenGLRenderer::DrawDepthPrepass );
+	RunPass( ERenderPass::Opaque, &OpenGLRenderer::Present );
+	RunPass( ERenderPass::Present, &OpenGLRenderer::End );
 
 	EndScene();
+
+	const std::chrono::duration<float, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+	UpdateStats( frameTime.count() );
+
+	// The next frame's size follows from this frame's CPU time and the latest GPU times
+	const float targetMilliseconds = 1000.0f / static_cast<float>( std::max<unsigned int>( Engine::Get()->GetEngineClock()->GetFPS(), 1 ) );
+	m_resolutionController->Update( m_stats, Engine::Get()->GetRenderSettings(), targetMilliseconds );
+}
+
+// Reads the window's framebuffer back, see Window::SaveFrame
+bool OpenGLRenderer::SaveFrame( const std::string& filePath )
+{
+	return m_window->SaveFrame( filePath );
+}
+
+// Returns true while OpenGLUploader still holds jobs that have not been handed back
+bool OpenGLRenderer::HasPendingUploads()
+{
+	return OpenGLUploader::Get()->GetPendingCount() > 0;
+}
+
+// Runs the passed pass, timing it on the CPU and on the GPU
+void OpenGLRenderer::RunPass( const ERenderPass pass, void ( OpenGLRenderer::*function )() )
+{
+	const auto start = std::chrono::steady_clock::now();
+	m_gpuTimer->BeginPass( pass );
+
+	( this->*function )();
+
+	m_gpuTimer->EndPass();
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	m_frameStats.cpuMilliseconds[static_cast<int>( pass )] = elapsed.count();
+}
+
+// Gathers the finished frame's counters into m_stats, and logs them every m_stateStatsLogInterval frames
+void OpenGLRenderer::UpdateStats( const float cpuFrameMilliseconds )
+{
+	const OpenGLStateStats& stateStats = OpenGLStateCache::Get()->GetFrameStats();
+	m_frameStats.programBinds = stateStats.programBinds;
+	m_frameStats.textureBinds = stateStats.textureBinds;
+	m_frameStats.vertexArrayBinds = stateStats.vertexArrayBinds;
+	m_frameStats.uniformUploads += stateStats.bufferRangeBinds;
+	m_frameStats.uploadedBytes += m_streamBuffer->GetUsedSize() + OpenGLUploader::Get()->TakeUploadedBytes();
+	m_frameStats.cpuFrameMilliseconds = cpuFrameMilliseconds;
+
+	for ( int pass = 0; pass < static_cast<int>( ERenderPass::TOTAL ); ++pass )
+	{
+		m_frameStats.gpuMilliseconds[pass] = m_gpuTimer->HasResults() ? m_gpuTimer->GetResultMilliseconds( static_cast<ERenderPass>( pass ) ) : -1.0f;
+	}
+	m_frameStats.gpuFrameIndex = m_gpuTimer->GetResultFrameIndex();
+
+	m_stats = m_frameStats;
+
+	if ( ++m_frameIndex % m_stateStatsLogInterval == 0 )
+	{
+		DEBUG_LOG( LOG::INFO, "State changes this frame: " + std::to_string( stateStats.submitted ) + " submitted, " + std::to_string( stateStats.filtered ) + " filtered" );
+		CONSOLE_LOG( LOG::INFO, "State changes this frame: " + std::to_string( stateStats.submitted ) + " submitted, " + std::to_string( stateStats.filtered ) + " filtered" );
+
+		DEBUG_LOG( LOG::INFO, "Occlusion culled " + std::to_string( m_sceneCuller->GetOccludedModelCount() ) + " models behind " + std::to_string( m_sceneCuller->GetOcclusionCuller().GetOccluderTriangleCount() ) + " occluder triangles" );
+		CONSOLE_LOG( LOG::INFO, "Occlusion culled " + std::to_string( m_sceneCuller->GetOccludedModelCount() ) + " models behind " + std::to_string( m_sceneCuller->GetOcclusionCuller().GetOccluderTriangleCount() ) + " occluder triangles" );
+
+		const LightCuller& lightCuller = m_sceneCuller->GetLightCuller();
+		DEBUG_LOG( LOG::INFO, "Clustered " + std::to_string( lightCuller.GetLights().size() ) + " lights into " + std::to_string( lightCuller.GetLightIndices().size() ) + " cluster references, " + std::to_string( lightCuller.GetDroppedReferenceCount() ) + " dropped" );
+		CONSOLE_LOG( LOG::INFO, "Clustered " + std::to_string( lightCuller.GetLights().size() ) + " lights into " + std::to_string( lightCuller.GetLightIndices().size() ) + " cluster references, " + std::to_string( lightCuller.GetDroppedReferenceCount() ) + " dropped" );
+
+		DEBUG_LOG( LOG::INFO, std::to_string( m_stats.drawCalls ) + " draw calls, " + std::to_string( m_stats.triangles ) + " triangles, " + std::to_string( m_stats.uploadedBytes ) + " bytes uploaded, resolution scale " + std::to_string( m_stats.resolutionScale ) );
+		CONSOLE_LOG( LOG::INFO, std::to_string( m_stats.drawCalls ) + " draw calls, " + std::to_string( m_stats.triangles ) + " triangles, " + std::to_string( m_stats.uploadedBytes ) + " bytes uploaded, resolution scale " + std::to_string( m_stats.resolutionScale ) );
+
+		DEBUG_LOG( LOG::INFO, "CPU frame " + std::to_string( m_stats.cpuFrameMilliseconds ) + " ms: " + FormatPassTimes( m_stats.cpuMilliseconds ) );
+		CONSOLE_LOG( LOG::INFO, "CPU frame " + std::to_string( m_stats.cpuFrameMilliseconds ) + " ms: " + FormatPassTimes( m_stats.cpuMilliseconds ) );
+
+		DEBUG_LOG( LOG::INFO, "GPU frame " + std::to_string( m_stats.gpuFrameIndex ) + ": " + FormatPassTimes( m_stats.gpuMilliseconds ) );
+		CONSOLE_LOG( LOG::INFO, "GPU frame " + std::to_string( m_stats.gpuFrameIndex ) + ": " + FormatPassTimes( m_stats.gpuMilliseconds ) );
+	}
 }
 
 void OpenGLRenderer::BeginScene( IScene * scene )
@@ -68,9 +378,14 @@ void OpenGLRenderer::BeginScene( IScene * scene )
 		return;
 	}
 
-	// TEMP
-		// What I will be doing in the future is clearing out command queue, instead of vector of meshes
+	// Binds made while finalizing uploads belong to this frame's counts, so counting starts before them
+	OpenGLStateCache::Get()->BeginFrame();
+
+	// Finalizing assets loaded by the worker threads, within a budget so streaming does not cause hitches
+	AssetLoader::Get()->ProcessUploads( m_uploadBudgetMilliseconds );
+	OpenGLUploader::Get()->ProcessCompleted();
 
+	// Models are turned into draws after culling, see RecordCommandLists
 	m_models.clear();
 	
 	auto registry = ECS::Parser<RenderComponent, TransformComponent>( scene->m_world );
@@ -85,6 +400,10 @@ void OpenGLRenderer::BeginScene( IScene * scene )
 	auto cameraRegistry = ECS::Parser<CameraComponent, TransformComponent>( scene->m_world );
 	m_camera = std::get<CameraComponent*>( cameraRegistry.GetComponents().front() );
 
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	m_sceneCuller->CullOccludedModels( m_models, *m_camera, threadPool );
+	m_sceneCuller->CullLights( scene, *m_camera, threadPool );
+
 }
 
 void OpenGLRenderer::EndScene()
@@ -92,27 +411,405 @@ void OpenGLRenderer::EndScene()
 
 void OpenGLRenderer::Begin()
 {
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+
+	// glClear honours the write masks, the last frame's shaded draws left depth writes off
+	stateCache->DepthMask( GL_TRUE );
+	stateCache->ColorMask( GL_TRUE );
+
+	glBindFramebuffer( GL_FRAMEBUFFER, SelectRenderTarget() );
+	stateCache->Viewport( 0, 0, m_renderWidth, m_renderHeight );
 	glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-	glEnable( GL_DEPTH_TEST );
-	glEnable( GL_CULL_FACE );
+
+	stateCache->Enable( GL_DEPTH_TEST );
+	stateCache->Enable( GL_CULL_FACE );
+}
+
+// Picks the size the frame is drawn at and returns the framebuffer it is drawn into
+// Frames below the window's size are drawn into m_sceneTarget, which is created or resized if the settings changed
+GLuint OpenGLRenderer::SelectRenderTarget()
+{
+	const int windowWidth = m_window->GetWidth();
+	const int windowHeight = m_window->GetHeight();
+
+	m_renderWidth = m_resolutionController->GetScaledSize( windowWidth );
+	m_renderHeight = m_resolutionController->GetScaledSize( windowHeight );
+	m_frameStats.resolutionScale = m_resolutionController->GetScale();
+	if ( m_renderWidth == windowWidth && m_renderHeight == windowHeight )
+	{
+		return m_window->GetFramebuffer();
+	}
+
+	// Sized for the largest scale, so the scale moving between the limits never reallocates the target
+	const float maxScale = Engine::Get()->GetRenderSettings().maxResolutionScale;
+	const int targetWidth = std::max( m_renderWidth, static_cast<int>( static_cast<float>( windowWidth ) * maxScale + 0.5f ) );
+	const int targetHeight = std::max( m_renderHeight, static_cast<int>( static_cast<float>( windowHeight ) * maxScale + 0.5f ) );
+	if ( m_sceneTarget && m_sceneTarget->GetWidth() == targetWidth && m_sceneTarget->GetHeight() == targetHeight )
+	{
+		return m_sceneTarget->GetFramebuffer();
+	}
+
+	delete m_sceneTarget;
+	m_sceneTarget = new OpenGLRenderTarget( targetWidth, targetHeight );
+	if ( m_sceneTarget->OnCreate() )
+	{
+		return m_sceneTarget->GetFramebuffer();
+	}
+
+	// Without a target every frame is drawn at the window's size, turning the setting off so it is not tried again
+	DEBUG_LOG( LOG::WARNING, "Failed to create the scene render target, dynamic resolution is turned off" );
+	CONSOLE_LOG( LOG::WARNING, "Failed to create the scene render target, dynamic resolution is turned off" );
+	delete m_sceneTarget;
+	m_sceneTarget = nullptr;
+
+	RenderSettings settings = Engine::Get()->GetRenderSettings();
+	settings.dynamicResolution = false;
+	Engine::Get()->SetRenderSettings( settings );
+
+	m_renderWidth = windowWidth;
+	m_renderHeight = windowHeight;
+	m_frameStats.resolutionScale = 1.0f;
+	return m_window->GetFramebuffer();
+}
+
+// Streams the frame's uniforms, records the draws and writes their object data and indirect commands
+void OpenGLRenderer::PrepareDraws()
+{
+	m_streamBuffer->BeginFrame();
+
+	WriteFrameUniforms();
+	WriteLightData();
+	UploadMaterials();
+	RecordCommandLists();
+	BuildDrawGroups();
+
+	m_objectData = {};
+	m_commandData = {};
+	m_hasDrawData = WriteDrawData( m_objectData, m_commandData );
+
+	// Written data has to be visible to the GPU before anything reading it is issued
+	m_streamBuffer->Flush();
+}
+
+// Draws every group's depth with the depth program, if the pre-pass is turned on and the program is linked
+void OpenGLRenderer::DrawDepthPrepass()
+{
+	m_hasDepthPrepass = false;
+	if ( !m_hasDrawData || !Engine::Get()->GetRenderSettings().depthPrepass || !m_depthLinker->IsReady() )
+	{
+		return;
+	}
+
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+	stateCache->DepthFunc( GL_LESS );
+	stateCache->DepthMask( GL_TRUE );
+	stateCache->ColorMask( GL_FALSE );
+
+	SubmitDrawGroups( true );
+
+	stateCache->ColorMask( GL_TRUE );
+	m_hasDepthPrepass = true;
 }
 
 void OpenGLRenderer::Present()
 {
-	for ( auto& m : m_models )
+	// After the pre-pass the depth buffer already holds the nearest surface, so only fragments on it are shaded
+	// Every vertex shader computes its position as an invariant, so those fragments land on exactly the same depth
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+	stateCache->DepthFunc( m_hasDepthPrepass ? GL_LEQUAL : GL_LESS );
+	stateCache->DepthMask( m_hasDepthPrepass ? GL_FALSE : GL_TRUE );
+
+	if ( m_hasDrawData )
+	{
+		SubmitDrawGroups( false );
+	}
+
+	m_streamBuffer->EndFrame();
+}
+
+// Writes the frame uniforms and binds them for every program
+void OpenGLRenderer::WriteFrameUniforms()
+{
+	const StreamAllocation frameUniforms = m_streamBuffer->Allocate( sizeof( FrameUniforms ), m_uniformAlignment );
+	if ( !frameUniforms.IsValid() )
+	{
+		return;
+	}
+
+	const LightCuller& lightCuller = m_sceneCuller->GetLightCuller();
+	FrameUniforms* frame = static_cast<FrameUniforms*>( frameUniforms.data );
+	frame->projectionMatrix = m_camera->GetPerspective();
+	frame->viewMatrix = m_camera->GetView();
+	frame->clusterScale = glm::vec4(
+		static_cast<float>( LightCuller::m_clusterCountX ) / static_cast<float>( m_renderWidth ),
+		static_cast<float>( LightCuller::m_clusterCountY ) / static_cast<float>( m_renderHeight ),
+		lightCuller.GetSliceScale(),
+		lightCuller.GetSliceBias()
+	);
+	frame->clusterCounts = glm::uvec4(
+		LightCuller::m_clusterCountX,
+		LightCuller::m_clusterCountY,
+		LightCuller::m_clusterCountZ,
+		static_cast<unsigned int>( lightCuller.GetLights().size() )
+	);
+
+	OpenGLStateCache::Get()->BindBufferRange( GL_UNIFORM_BUFFER, static_cast<GLuint>( EUniformBlock::Frame ), frameUniforms.buffer, frameUniforms.offset, sizeof( FrameUniforms ) );
+}
+
+// Writes the clustered light lists and binds them for every program
+void OpenGLRenderer::WriteLightData()
+{
+	const LightCuller& lightCuller = m_sceneCuller->GetLightCuller();
+	const std::vector<LightUniforms>& lights = lightCuller.GetLights();
+	const std::vector<ClusterUniforms>& clusters = lightCuller.GetClusters();
+	const std::vector<uint32_t>& lightIndices = lightCuller.GetLightIndices();
+
+	// Empty ranges cannot be bound, so each list keeps room for at least one entry
+	const size_t lightSize = sizeof( LightUniforms ) * std::max<size_t>( lights.size(), 1 );
+	const size_t clusterSize = sizeof( ClusterUniforms ) * clusters.size();
+	const size_t indexSize = sizeof( uint32_t ) * std::max<size_t>( lightIndices.size(), 1 );
+
+	const StreamAllocation lightData = m_streamBuffer->Allocate( lightSize, m_storageAlignment );
+	const StreamAllocation clusterData = m_streamBuffer->Allocate( clusterSize, m_storageAlignment );
+	const StreamAllocation indexData = m_streamBuffer->Allocate( indexSize, m_storageAlignment );
+	if ( !lightData.IsValid() || !clusterData.IsValid() || !indexData.IsValid() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Stream buffer is full, skipping " + std::to_string( lights.size() ) + " lights" );
+		CONSOLE_LOG( LOG::WARNING, "Stream buffer is full, skipping " + std::to_string( lights.size() ) + " lights" );
+		return;
+	}
+
+	std::copy( lights.begin(), lights.end(), static_cast<LightUniforms*>( lightData.data ) );
+	std::copy( clusters.begin(), clusters.end(), static_cast<ClusterUniforms*>( clusterData.data ) );
+	std::copy( lightIndices.begin(), lightIndices.end(), static_cast<uint32_t*>( indexData.data ) );
+
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+	stateCache->BindBufferRange( GL_SHADER_STORAGE_BUFFER, static_cast<GLuint>( EStorageBlock::Lights ), lightData.buffer, lightData.offset, static_cast<GLsizeiptr>( lightSize ) );
+	stateCache->BindBufferRange( GL_SHADER_STORAGE_BUFFER, static_cast<GLuint>( EStorageBlock::Clusters ), clusterData.buffer, clusterData.offset, static_cast<GLsizeiptr>( clusterSize ) );
+	stateCache->BindBufferRange( GL_SHADER_STORAGE_BUFFER, static_cast<GLuint>( EStorageBlock::LightIndices ), indexData.buffer, indexData.offset, static_cast<GLsizeiptr>( indexSize ) );
+}
+
+// Uploads MaterialTable if it changed since the last frame and binds it for every program
+void OpenGLRenderer::UploadMaterials()
+{
+	const MaterialTable* table = MaterialTable::Get();
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+
+	if ( m_materialBuffer == 0 || table->GetVersion() != m_materialVersion )
 	{
-		if ( m )
+		std::vector<MaterialUniforms> materials( table->GetCount() );
+		table->WriteUniforms( materials.data() );
+
+		if ( m_materialBuffer == 0 )
 		{
-			m->Render( m_camera );
+			glGenBuffers( 1, &m_materialBuffer );
+		}
+
+		// Respecifying the storage leaves draws still in flight reading the old table
+		m_materialBufferSize = sizeof( MaterialUniforms ) * materials.size();
+		stateCache->BindBuffer( GL_SHADER_STORAGE_BUFFER, m_materialBuffer );
+		glBufferData( GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>( m_materialBufferSize ), materials.data(), GL_STATIC_DRAW );
+		m_materialVersion = table->GetVersion();
+		m_frameStats.uploadedBytes += m_materialBufferSize;
+	}
+
+	stateCache->BindBufferRange( GL_SHADER_STORAGE_BUFFER, static_cast<GLuint>( EStorageBlock::Materials ), m_materialBuffer, 0, static_cast<GLsizeiptr>( m_materialBufferSize ) );
+}
+
+// Extracts every model's object data, then records their draws through DrawRecorder, both on the worker threads
+void OpenGLRenderer::RecordCommandLists()
+{
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+
+	// Pixels one unit covers at a distance of one unit, at the size the frame is drawn at
+	const float projectionScale = m_camera->GetPerspective()[1][1] * 0.5f * static_cast<float>( m_renderHeight );
+	const glm::mat4 view = m_camera->GetView();
+	m_drawExtractor->Extract( m_models, view, m_camera->GetPerspective() * view, m_camera->GetCameraPosition(), projectionScale, threadPool );
+
+	auto fill = []( const Model& model, DrawCommand& command )
+	{
+		const OpenGLMesh* mesh = static_cast<const OpenGLMesh*>( model.GetMesh() );
+		const OpenGLTexture2D* texture = static_cast<const OpenGLTexture2D*>( model.GetTexture() );
+		const OpenGLMeshAllocation* allocation = mesh->GetAllocation();
+
+		command.texture = texture ? texture->GetArrayId() : 0;
+		command.layer = texture ? texture->GetLayer() : 0;
+		command.arena = reinterpret_cast<uintptr_t>( allocation->arena );
+		command.firstIndex = allocation->firstIndex;
+		command.baseVertex = static_cast<int32_t>( allocation->baseVertex );
+		command.drawIndexLocation = model.GetShaderLinker()->GetUniformId( EUniform::DrawIndex );
+	};
+
+	m_drawRecorder->Record( m_models, *m_drawExtractor, fill, threadPool );
+}
+
+// Merges the recorded lists into the order draws are replayed in and splits them into groups that can be drawn together
+void OpenGLRenderer::BuildDrawGroups()
+{
+	m_draws.clear();
+	m_drawGroups.clear();
+	m_objectDataSize = 0;
+
+	m_drawRecorder->Merge();
+	const std::vector<const DrawCommand*>& commands = m_drawRecorder->GetDraws();
+	m_draws.reserve( commands.size() );
+
+	// Each group's object data starts on its own aligned offset, so it can be bound as the start of the array
+	for ( size_t i = 0; i < commands.size(); ++i )
+	{
+		const DrawCommand* command = commands[i];
+		if ( i == 0 || !commands[i - 1]->SharesState( *command ) )
+		{
+			DrawGroup group = {};
+			group.first = i;
+			group.count = 0;
+			group.objectOffset = AlignUp( m_objectDataSize, m_storageAlignment );
+			group.drawIndexLocation = command->drawIndexLocation;
+			m_drawGroups.push_back( group );
+
+			m_objectDataSize = group.objectOffset;
+		}
+
+		m_draws.push_back( DrawItem{ command, &m_drawExtractor->GetObject( command->sequence ), m_objectDataSize } );
+		m_objectDataSize += sizeof( ObjectUniforms );
+		m_drawGroups.back().count++;
+	}
+}
+
+// Copies every draw's object data and writes its indirect command, filled on the worker threads
+bool OpenGLRenderer::WriteDrawData( StreamAllocation& objects, StreamAllocation& commands )
+{
+	if ( m_draws.empty() )
+	{
+		return false;
+	}
+
+	objects = m_streamBuffer->Allocate( m_objectDataSize, m_storageAlignment );
+	commands = m_streamBuffer->Allocate( sizeof( DrawElementsIndirectCommand ) * m_draws.size(), sizeof( GLuint ) );
+	if ( !objects.IsValid() || !commands.IsValid() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Stream buffer is full, skipping " + std::to_string( m_draws.size() ) + " draws" );
+		CONSOLE_LOG( LOG::WARNING, "Stream buffer is full, skipping " + std::to_string( m_draws.size() ) + " draws" );
+		return false;
+	}
+
+	unsigned char* objectBase = static_cast<unsigned char*>( objects.data );
+	DrawElementsIndirectCommand* commandBase = static_cast<DrawElementsIndirectCommand*>( commands.data );
+	auto fill = [this, objectBase, commandBase]( size_t begin, size_t end )
+	{
+		for ( size_t i = begin; i < end; ++i )
+		{
+			const DrawItem& draw = m_draws[i];
+
+			// Records are streamed as extracted, ranges of one model only differ in their material
+			ObjectUniforms* object = reinterpret_cast<ObjectUniforms*>( objectBase + draw.objectOffset );
+			*object = *draw.object;
+			object->indices.x = draw.command->material;
+			object->indices.y = draw.command->layer;
+
+			DrawElementsIndirectCommand& command = commandBase[i];
+			command.count = draw.command->indexCount;
+			command.instanceCount = 1;
+			command.firstIndex = draw.command->firstIndex;
+			command.baseVertex = draw.command->baseVertex;
+			command.baseInstance = 0;
+		}
+	};
+
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	if ( threadPool )
+	{
+		threadPool->ParallelFor( m_draws.size(), m_drawFillRangeSize, fill );
+	}
+	else
+	{
+		fill( 0, m_draws.size() );
+	}
+
+	return true;
+}
+
+// Issues one multi draw per group, with the depth program and position only VAOs if isDepthOnly is set
+void OpenGLRenderer::SubmitDrawGroups( const bool isDepthOnly )
+{
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+	stateCache->BindBuffer( GL_DRAW_INDIRECT_BUFFER, m_commandData.buffer );
+
+	const GLint depthDrawIndexLocation = m_depthLinker->GetUniformId( EUniform::DrawIndex );
+
+	for ( const DrawGroup& group : m_drawGroups )
+	{
+		const DrawCommand& first = *m_draws[group.first].command;
+		const OpenGLMeshArena* arena = reinterpret_cast<const OpenGLMeshArena*>( first.arena );
+
+		// Groups keep their object data and commands for the pre-pass, only the program and vertex streams differ
+		if ( isDepthOnly )
+		{
+			stateCache->UseProgram( m_depthLinker->GetShaderProgramId() );
+			stateCache->BindVertexArray( arena->depthVAO );
+		}
+		else
+		{
+			stateCache->UseProgram( first.program );
+			stateCache->BindTexture( 0, GL_TEXTURE_2D_ARRAY, first.texture );
+			stateCache->BindVertexArray( arena->VAO );
+		}
+
+		stateCache->BindBufferRange(
+			GL_SHADER_STORAGE_BUFFER,
+			static_cast<GLuint>( EStorageBlock::Object ),
+			m_objectData.buffer,
+			m_objectData.offset + static_cast<GLintptr>( group.objectOffset ),
+			static_cast<GLsizeiptr>( group.count * sizeof( ObjectUniforms ) )
+		);
+
+		if ( m_hasDrawParameters )
+		{
+			const GLintptr commandOffset = m_commandData.offset + static_cast<GLintptr>( group.first * sizeof( DrawElementsIndirectCommand ) );
+			glMultiDrawElementsIndirect(
+				GL_TRIANGLES,
+				arena->indexType,
+				reinterpret_cast<const void*>( commandOffset ),
+				static_cast<GLsizei>( group.count ),
+				sizeof( DrawElementsIndirectCommand )
+			);
+
+			m_frameStats.drawCalls++;
+			for ( size_t d = 0; d < group.count; ++d )
+			{
+				m_frameStats.triangles += m_draws[group.first + d].command->indexCount / 3;
+			}
+			continue;
+		}
+
+		for ( size_t d = 0; d < group.count; ++d )
+		{
+			const DrawCommand& draw = *m_draws[group.first + d].command;
+			glUniform1i( isDepthOnly ? depthDrawIndexLocation : group.drawIndexLocation, static_cast<GLint>( d ) );
+			glDrawElementsBaseVertex(
+				GL_TRIANGLES,
+				static_cast<GLsizei>( draw.indexCount ),
+				arena->indexType,
+				reinterpret_cast<const void*>( static_cast<uintptr_t>( draw.firstIndex ) * arena->indexSize ),
+				draw.baseVertex
+			);
+
+			m_frameStats.uniformUploads++;
+			m_frameStats.drawCalls++;
+			m_frameStats.triangles += draw.indexCount / 3;
 		}
 	}
 }
 
 void OpenGLRenderer::End()
 {
-	glfwSwapBuffers( glfwGetCurrentContext() );
-	glUseProgram( 0 );
+	if ( m_renderWidth != m_window->GetWidth() || m_renderHeight != m_window->GetHeight() )
+	{
+		m_sceneTarget->Upscale( m_renderWidth, m_renderHeight, m_window->GetFramebuffer(), m_window->GetWidth(), m_window->GetHeight() );
+	}
+
+	m_window->SwapBuffers();
 }
 
 void OpenGLRenderer::SubmitModel( Model* model )
@@ -120,6 +817,25 @@ void OpenGLRenderer::SubmitModel( Model* model )
 	m_models.push_back( model );
 }
 
+// Lets the driver use as many threads as it likes for compiling shaders
+void OpenGLRenderer::SetMaxShaderCompilerThreads()
+{
+	using MaxShaderCompilerThreadsFunction = void ( APIENTRY* )( GLuint count );
+
+	// Loaded here, GLAD only loads the extension functions it was generated with
+	MaxShaderCompilerThreadsFunction maxShaderCompilerThreads =
+		reinterpret_cast<MaxShaderCompilerThreadsFunction>( m_window->GetProcAddress( "glMaxShaderCompilerThreadsKHR" ) );
+	if ( maxShaderCompilerThreads == nullptr )
+	{
+		maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsFunction>( m_window->GetProcAddress( "glMaxShaderCompilerThreadsARB" ) );
+	}
+
+	if ( maxShaderCompilerThreads )
+	{
+		maxShaderCompilerThreads( 0xFFFFFFFF );
+	}
+}
+
 void OpenGLRenderer::GetInstalledOpenGLInfo( int * major, int * minor )
 {
 	// You can to get some info regarding versions and manufacturer
@@ -2,8 +2,23 @@
 #define OPENGLRENDERER_H
 
 #include "../../RenderCore/Renderer.h"
+#include "OpenGLStreamBuffer.h"
 
 #include <glad/glad.h>
+#include <glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class DrawExtractor;
+class DrawRecorder;
+class OpenGLGpuTimer;
+class OpenGLRenderTarget;
+class ResolutionController;
+class SceneCuller;
+class ShaderLinker;
+struct DrawCommand;
+struct ObjectUniforms;
 
 class OpenGLRenderer : public IRenderer
 {
@@ -23,20 +38,144 @@ public:
 
 	virtual void RenderScene( IScene* scene ) override final;
 
+	// Reads the window's framebuffer back, see Window::SaveFrame
+	virtual bool SaveFrame( const std::string& filePath ) override final;
+
+	// Returns true while OpenGLUploader still holds jobs that have not been handed back
+	virtual bool HasPendingUploads() override final;
+
 private:
 
+	// Time each frame may spend creating GPU resources for assets that finished loading
+	static constexpr float m_uploadBudgetMilliseconds = 2.0f;
+
+	// Bytes of streamed data each frame may write, and the number of draws filled per worker range
+	static constexpr size_t m_streamBufferSize = 4 * 1024 * 1024;
+	static constexpr size_t m_drawFillRangeSize = 64;
+
+	// Frames between logging how many state changes the state cache filtered, how many models occlusion culling removed,
+	// how many lights were clustered and the frame's RenderStats
+	static constexpr uint64_t m_stateStatsLogInterval = 600;
+
+	// A recorded draw in replay order, draws sharing a program, texture array and mesh arena form one multi draw
+	// Draws are sorted front to back inside of their group, materials are read by index and never split a group
+	struct DrawItem
+	{
+		const DrawCommand*				command;
+		const ObjectUniforms*			object;
+		size_t							objectOffset;	// Of its ObjectUniforms, relative to the frame's object data
+	};
+
+	struct DrawGroup
+	{
+		size_t		first;			// First draw of the group in m_draws
+		size_t		count;
+		size_t		objectOffset;	// Of the group's first ObjectUniforms, aligned for binding
+		GLint		drawIndexLocation;
+	};
+
+	// Frame uniforms, per draw object data and indirect commands are all written into this ring
+	OpenGLStreamBuffer*		m_streamBuffer;
+	size_t					m_uniformAlignment;
+	size_t					m_storageAlignment;
+
+	// gl_DrawIDARB is available, so a whole group is issued with a single glMultiDrawElementsIndirect
+	// Otherwise each draw of a group is issued on its own with its index set through the drawIndex uniform
+	bool					m_hasDrawParameters;
+
+	// Drops hidden models, clusters lights and picks LODs, see SceneCuller
+	SceneCuller*			m_sceneCuller;
+
+	// Writes every model's object data on the worker threads before the draws are recorded
+	DrawExtractor*			m_drawExtractor;
+
+	// Every entry of MaterialTable, only uploaded again when the table changes
+	GLuint					m_materialBuffer;
+	size_t					m_materialBufferSize;
+	uint64_t				m_materialVersion;
+
+	// Records the frame's draws into command lists on the worker threads and merges them, see DrawRecorder
+	// Draw arenas are the OpenGLMeshArena the draw's mesh lives in
+	DrawRecorder*			m_drawRecorder;
+
+	// Rebuilt every frame, kept as members so their storage is reused
+	std::vector<DrawItem>	m_draws;
+	std::vector<DrawGroup>	m_drawGroups;
+	size_t					m_objectDataSize;
+
+	// Object data and indirect commands of the frame's draws, read by the depth pre-pass and the shaded draws alike
+	StreamAllocation		m_objectData;
+	StreamAllocation		m_commandData;
+	bool					m_hasDrawData;
+
+	// Position only program laying down depth before the shaded draws, see RenderSettings::depthPrepass
+	// Once it has run the shaded draws test with GL_LEQUAL without writing, so only visible fragments are shaded
+	ShaderLinker*			m_depthLinker;
+	bool					m_hasDepthPrepass;	// The pre-pass ran this frame
+
+	// Draws the scene below the window's size when frames run over budget and upscales it in End, see ResolutionController
+	// The target is only created once a frame is drawn below the window's size, at the largest scale the settings allow
+	ResolutionController*	m_resolutionController;
+	OpenGLRenderTarget*		m_sceneTarget;
+	int						m_renderWidth;		// Size the frame is drawn at
+	int						m_renderHeight;
+
+	uint64_t				m_frameIndex;
+
+	// Counters and timings of the frame being rendered, copied into m_stats once it is finished
+	RenderStats				m_frameStats;
+	OpenGLGpuTimer*			m_gpuTimer;
+
 	virtual void BeginScene( IScene* scene ) override final;
 	virtual void EndScene() override final;
 
 	virtual void Begin() override final;
 	virtual void Present() override final;
+
+	// Draws every group's depth with the depth program, if the pre-pass is turned on and the program is linked
+	void DrawDepthPrepass();
 	virtual void End() override final;
 
 	virtual void SubmitModel( Model* model ) override final;
 
 	void GetInstalledOpenGLInfo( int* major, int* minor );
 
-	
+	// Runs the passed pass, timing it on the CPU and on the GPU
+	void RunPass( const ERenderPass pass, void ( OpenGLRenderer::*function )() );
+
+	// Gathers the finished frame's counters into m_stats, and logs them every m_stateStatsLogInterval frames
+	void UpdateStats( const float cpuFrameMilliseconds );
+
+	// Lets the driver use as many threads as it likes for compiling shaders
+	void SetMaxShaderCompilerThreads();
+
+	// Writes the frame uniforms and binds them for every program
+	void WriteFrameUniforms();
+
+	// Writes the clustered light lists and binds them for every program
+	void WriteLightData();
+
+	// Uploads MaterialTable if it changed since the last frame and binds it for every program
+	void UploadMaterials();
+
+	// Picks the size the frame is drawn at and returns the framebuffer it is drawn into
+	// Frames below the window's size are drawn into m_sceneTarget, which is created or resized if the settings changed
+	GLuint SelectRenderTarget();
+
+	// Streams the frame's uniforms, records the draws and writes their object data and indirect commands
+	void PrepareDraws();
+
+	// Extracts every model's object data, then records their draws through DrawRecorder, both on the worker threads
+	void RecordCommandLists();
+
+	// Merges the recorded lists into the order draws are replayed in and splits them into groups that can be drawn together
+	void BuildDrawGroups();
+
+	// Copies every draw's object data and writes its indirect command, filled on the worker threads
+	bool WriteDrawData( StreamAllocation& objects, StreamAllocation& commands );
+
+	// Issues one multi draw per group, with the depth program and position only VAOs if isDepthOnly is set
+	void SubmitDrawGroups( const bool isDepthOnly );
 
 };
 
@@ -0,0 +1,411 @@
+#include "OpenGLStateCache.h"
+
+std::unique_ptr<OpenGLStateCache> OpenGLStateCache::g_openGLStateCacheInstance( nullptr );
+
+OpenGLStateCache::OpenGLStateCache() :
+	m_program( m_unknown ),
+	m_vertexArray( m_unknown ),
+	m_activeTextureUnit( m_unknown ),
+	m_textures(),
+	m_buffers(),
+	m_bufferRanges(),
+	m_capabilities(),
+	m_depthFunc( m_unknown ),
+	m_depthMask( m_unknown ),
+	m_colorMask( m_unknown ),
+	m_blendSource( m_unknown ),
+	m_blendDestination( m_unknown ),
+	m_blendEquation( m_unknown ),
+	m_cullFace( m_unknown ),
+	m_viewport(),
+	m_frameStats(),
+	m_lastFrameStats()
+{
+	Invalidate();
+}
+
+OpenGLStateCache::~OpenGLStateCache()
+{}
+
+// Get Instance of OpenGL State Cache
+OpenGLStateCache* OpenGLStateCache::Get()
+{
+	if ( g_openGLStateCacheInstance == nullptr )
+	{
+		g_openGLStateCacheInstance.reset( new OpenGLStateCache );
+	}
+	return g_openGLStateCacheInstance.get();
+}
+
+// Forgets everything shadowed, the next call of each kind always reaches the driver
+void OpenGLStateCache::Invalidate()
+{
+	m_program = m_unknown;
+	m_vertexArray = m_unknown;
+	m_activeTextureUnit = m_unknown;
+
+	for ( auto& unit : m_textures )
+	{
+		unit.fill( m_unknown );
+	}
+	m_buffers.fill( m_unknown );
+	for ( auto& target : m_bufferRanges )
+	{
+		target.fill( { m_unknown, 0, 0 } );
+	}
+	m_capabilities.fill( m_unknown );
+
+	m_depthFunc = m_unknown;
+	m_depthMask = m_unknown;
+	m_colorMask = m_unknown;
+	m_blendSource = m_unknown;
+	m_blendDestination = m_unknown;
+	m_blendEquation = m_unknown;
+	m_cullFace = m_unknown;
+	m_viewport[0] = m_viewport[1] = m_viewport[2] = m_viewport[3] = -1;
+}
+
+// Starts counting a new frame, the previous frame's counts are kept for GetLastFrameStats
+void OpenGLStateCache::BeginFrame()
+{
+	m_lastFrameStats = m_frameStats;
+	m_frameStats = {};
+}
+
+void OpenGLStateCache::UseProgram( const GLuint program )
+{
+	if ( Count( m_program != program ) )
+	{
+		m_frameStats.programBinds++;
+		m_program = program;
+		glUseProgram( program );
+	}
+}
+
+void OpenGLStateCache::BindVertexArray( const GLuint vertexArray )
+{
+	if ( Count( m_vertexArray != vertexArray ) )
+	{
+		m_frameStats.vertexArrayBinds++;
+		m_vertexArray = vertexArray;
+		glBindVertexArray( vertexArray );
+	}
+}
+
+void OpenGLStateCache::BindTexture( const GLuint unit, const GLenum target, const GLuint texture )
+{
+	const int targetIndex = GetTextureTargetIndex( target );
+	if ( targetIndex < 0 || unit >= m_maxTextureUnits )
+	{
+		Count( true );
+		m_frameStats.textureBinds++;
+		ActiveTexture( unit );
+		glBindTexture( target, texture );
+		return;
+	}
+
+	GLuint& bound = m_textures[unit][targetIndex];
+	if ( Count( bound != texture ) )
+	{
+		m_frameStats.textureBinds++;
+		bound = texture;
+		ActiveTexture( unit );
+		glBindTexture( target, texture );
+	}
+}
+
+// GL_ELEMENT_ARRAY_BUFFER is part of the bound VAO's state, so it is never filtered
+void OpenGLStateCache::BindBuffer( const GLenum target, const GLuint buffer )
+{
+	const int targetIndex = GetBufferTargetIndex( target );
+	if ( targetIndex < 0 )
+	{
+		Count( true );
+		glBindBuffer( target, buffer );
+		return;
+	}
+
+	if ( Count( m_buffers[targetIndex] != buffer ) )
+	{
+		m_buffers[targetIndex] = buffer;
+		glBindBuffer( target, buffer );
+	}
+}
+
+void OpenGLStateCache::BindBufferRange( const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size )
+{
+	const int targetIndex = GetIndexedTargetIndex( target );
+	if ( targetIndex < 0 || index >= m_maxIndexedBindings )
+	{
+		Count( true );
+		SetBufferRange( target, index, buffer, offset, size );
+		return;
+	}
+
+	BufferRange& bound = m_bufferRanges[targetIndex][index];
+	if ( Count( bound.buffer != buffer || bound.offset != offset || bound.size != size ) )
+	{
+		bound = { buffer, offset, size };
+		SetBufferRange( target, index, buffer, offset, size );
+	}
+}
+
+// Binds the range, a filtered out bind leaves the generic binding point as it is, so only this updates its shadow
+void OpenGLStateCache::SetBufferRange( const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size )
+{
+	m_frameStats.bufferRangeBinds++;
+	glBindBufferRange( target, index, buffer, offset, size );
+
+	// Binding a range also binds the buffer to the target's generic binding point
+	const int bufferIndex = GetBufferTargetIndex( target );
+	if ( bufferIndex >= 0 )
+	{
+		m_buffers[bufferIndex] = buffer;
+	}
+}
+
+void OpenGLStateCache::Enable( const GLenum capability )
+{
+	SetEnabled( capability, true );
+}
+
+void OpenGLStateCache::Disable( const GLenum capability )
+{
+	SetEnabled( capability, false );
+}
+
+void OpenGLStateCache::SetEnabled( const GLenum capability, const bool isEnabled )
+{
+	const int capabilityIndex = GetCapabilityIndex( capability );
+	const GLuint state = isEnabled ? 1 : 0;
+	if ( capabilityIndex >= 0 )
+	{
+		if ( !Count( m_capabilities[capabilityIndex] != state ) )
+		{
+			return;
+		}
+		m_capabilities[capabilityIndex] = state;
+	}
+	else
+	{
+		Count( true );
+	}
+
+	if ( isEnabled )
+	{
+		glEnable( capability );
+	}
+	else
+	{
+		glDisable( capability );
+	}
+}
+
+void OpenGLStateCache::DepthFunc( const GLenum function )
+{
+	if ( Count( m_depthFunc != function ) )
+	{
+		m_depthFunc = function;
+		glDepthFunc( function );
+	}
+}
+
+void OpenGLStateCache::DepthMask( const GLboolean isWritable )
+{
+	if ( Count( m_depthMask != isWritable ) )
+	{
+		m_depthMask = isWritable;
+		glDepthMask( isWritable );
+	}
+}
+
+void OpenGLStateCache::ColorMask( const GLboolean isWritable )
+{
+	if ( Count( m_colorMask != isWritable ) )
+	{
+		m_colorMask = isWritable;
+		glColorMask( isWritable, isWritable, isWritable, isWritable );
+	}
+}
+
+void OpenGLStateCache::BlendFunc( const GLenum source, const GLenum destination )
+{
+	if ( Count( m_blendSource != source || m_blendDestination != destination ) )
+	{
+		m_blendSource = source;
+		m_blendDestination = destination;
+		glBlendFunc( source, destination );
+	}
+}
+
+void OpenGLStateCache::BlendEquation( const GLenum equation )
+{
+	if ( Count( m_blendEquation != equation ) )
+	{
+		m_blendEquation = equation;
+		glBlendEquation( equation );
+	}
+}
+
+void OpenGLStateCache::CullFace( const GLenum face )
+{
+	if ( Count( m_cullFace != face ) )
+	{
+		m_cullFace = face;
+		glCullFace( face );
+	}
+}
+
+void OpenGLStateCache::Viewport( const GLint x, const GLint y, const GLsizei width, const GLsizei height )
+{
+	if ( Count( m_viewport[0] != x || m_viewport[1] != y || m_viewport[2] != width || m_viewport[3] != height ) )
+	{
+		m_viewport[0] = x;
+		m_viewport[1] = y;
+		m_viewport[2] = width;
+		m_viewport[3] = height;
+		glViewport( x, y, width, height );
+	}
+}
+
+// Deleting a bound object binds 0 in its place, so these forget any binding of the deleted object
+void OpenGLStateCache::DeleteProgram( const GLuint program )
+{
+	if ( m_program == program )
+	{
+		m_program = m_unknown;
+	}
+	glDeleteProgram( program );
+}
+
+void OpenGLStateCache::DeleteVertexArrays( const GLsizei count, const GLuint* vertexArrays )
+{
+	for ( GLsizei i = 0; i < count; ++i )
+	{
+		if ( m_vertexArray == vertexArrays[i] )
+		{
+			m_vertexArray = m_unknown;
+		}
+	}
+	glDeleteVertexArrays( count, vertexArrays );
+}
+
+void OpenGLStateCache::DeleteTextures( const GLsizei count, const GLuint* textures )
+{
+	for ( GLsizei i = 0; i < count; ++i )
+	{
+		for ( auto& unit : m_textures )
+		{
+			for ( GLuint& bound : unit )
+			{
+				if ( bound == textures[i] )
+				{
+					bound = m_unknown;
+				}
+			}
+		}
+	}
+	glDeleteTextures( count, textures );
+}
+
+void OpenGLStateCache::DeleteBuffers( const GLsizei count, const GLuint* buffers )
+{
+	for ( GLsizei i = 0; i < count; ++i )
+	{
+		for ( GLuint& bound : m_buffers )
+		{
+			if ( bound == buffers[i] )
+			{
+				bound = m_unknown;
+			}
+		}
+
+		for ( auto& target : m_bufferRanges )
+		{
+			for ( BufferRange& bound : target )
+			{
+				if ( bound.buffer == buffers[i] )
+				{
+					bound.buffer = m_unknown;
+				}
+			}
+		}
+	}
+	glDeleteBuffers( count, buffers );
+}
+
+int OpenGLStateCache::GetTextureTargetIndex( const GLenum target )
+{
+	switch ( target )
+	{
+	case GL_TEXTURE_2D:				return 0;
+	case GL_TEXTURE_2D_ARRAY:		return 1;
+	case GL_TEXTURE_CUBE_MAP:		return 2;
+	default:						return -1;
+	}
+}
+
+int OpenGLStateCache::GetBufferTargetIndex( const GLenum target )
+{
+	switch ( target )
+	{
+	case GL_ARRAY_BUFFER:			return 0;
+	case GL_UNIFORM_BUFFER:			return 1;
+	case GL_SHADER_STORAGE_BUFFER:	return 2;
+	case GL_DRAW_INDIRECT_BUFFER:	return 3;
+	case GL_COPY_READ_BUFFER:		return 4;
+	case GL_COPY_WRITE_BUFFER:		return 5;
+	case GL_PIXEL_UNPACK_BUFFER:	return 6;
+	case GL_PIXEL_PACK_BUFFER:		return 7;
+	default:						return -1;
+	}
+}
+
+int OpenGLStateCache::GetIndexedTargetIndex( const GLenum target )
+{
+	switch ( target )
+	{
+	case GL_UNIFORM_BUFFER:			return 0;
+	case GL_SHADER_STORAGE_BUFFER:	return 1;
+	default:						return -1;
+	}
+}
+
+int OpenGLStateCache::GetCapabilityIndex( const GLenum capability )
+{
+	switch ( capability )
+	{
+	case GL_DEPTH_TEST:				return 0;
+	case GL_CULL_FACE:				return 1;
+	case GL_BLEND:					return 2;
+	case GL_MULTISAMPLE:			return 3;
+	case GL_SCISSOR_TEST:			return 4;
+	case GL_STENCIL_TEST:			return 5;
+	case GL_POLYGON_OFFSET_FILL:	return 6;
+	case GL_FRAMEBUFFER_SRGB:		return 7;
+	default:						return -1;
+	}
+}
+
+void OpenGLStateCache::ActiveTexture( const GLuint unit )
+{
+	if ( m_activeTextureUnit != unit )
+	{
+		m_activeTextureUnit = unit;
+		glActiveTexture( GL_TEXTURE0 + unit );
+	}
+}
+
+// Records whether a call reached the driver, returns isChanged so callers can branch on it
+bool OpenGLStateCache::Count( const bool isChanged )
+{
+	if ( isChanged )
+	{
+		m_frameStats.submitted++;
+	}
+	else
+	{
+		m_frameStats.filtered++;
+	}
+	return isChanged;
+}
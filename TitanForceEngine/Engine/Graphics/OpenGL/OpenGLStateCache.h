@@ -0,0 +1,135 @@
+#ifndef OPENGLSTATECACHE_H
+#define OPENGLSTATECACHE_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+// Number of state changes that reached the driver and that were dropped because they changed nothing
+// followed by how many of the submitted ones were binds of each kind
+struct OpenGLStateStats
+{
+	uint32_t	submitted;
+	uint32_t	filtered;
+	uint32_t	programBinds;
+	uint32_t	textureBinds;
+	uint32_t	vertexArrayBinds;
+	uint32_t	bufferRangeBinds;
+};
+
+// Singleton shadowing the render thread context's bindings, enable flags and depth/ colour/ blend state
+// Calls that would set what is already set are dropped. Render thread only, the upload context has its own state
+// Everything bound or deleted on the render thread has to go through here, or the shadowed state goes stale
+class OpenGLStateCache
+{
+
+	OpenGLStateCache( const OpenGLStateCache& ) = delete;
+	OpenGLStateCache& operator=( const OpenGLStateCache& ) = delete;
+	OpenGLStateCache( OpenGLStateCache&& ) = delete;
+	OpenGLStateCache& operator=( OpenGLStateCache&& ) = delete;
+
+public:
+
+	static constexpr uint32_t m_maxTextureUnits = 16;
+	static constexpr uint32_t m_maxIndexedBindings = 8;
+
+	// Get Instance of OpenGL State Cache
+	static OpenGLStateCache* Get();
+
+	// Forgets everything shadowed, the next call of each kind always reaches the driver
+	void Invalidate();
+
+	// Starts counting a new frame, the previous frame's counts are kept for GetLastFrameStats
+	void BeginFrame();
+
+	const OpenGLStateStats& GetFrameStats() const { return m_frameStats; }
+	const OpenGLStateStats& GetLastFrameStats() const { return m_lastFrameStats; }
+
+	void UseProgram( const GLuint program );
+	void BindVertexArray( const GLuint vertexArray );
+	void BindTexture( const GLuint unit, const GLenum target, const GLuint texture );
+
+	// GL_ELEMENT_ARRAY_BUFFER is part of the bound VAO's state, so it is never filtered
+	void BindBuffer( const GLenum target, const GLuint buffer );
+	void BindBufferRange( const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size );
+
+	void Enable( const GLenum capability );
+	void Disable( const GLenum capability );
+	void SetEnabled( const GLenum capability, const bool isEnabled );
+
+	void DepthFunc( const GLenum function );
+	void DepthMask( const GLboolean isWritable );
+	void ColorMask( const GLboolean isWritable );	// All four channels at once
+	void BlendFunc( const GLenum source, const GLenum destination );
+	void BlendEquation( const GLenum equation );
+	void CullFace( const GLenum face );
+	void Viewport( const GLint x, const GLint y, const GLsizei width, const GLsizei height );
+
+	// Deleting a bound object binds 0 in its place, so these forget any binding of the deleted object
+	void DeleteProgram( const GLuint program );
+	void DeleteVertexArrays( const GLsizei count, const GLuint* vertexArrays );
+	void DeleteTextures( const GLsizei count, const GLuint* textures );
+	void DeleteBuffers( const GLsizei count, const GLuint* buffers );
+
+private:
+
+	// Marks shadowed values that are not known, the next call always reaches the driver
+	static constexpr GLuint m_unknown = 0xFFFFFFFF;
+
+	static constexpr uint32_t m_textureTargetCount = 3;
+	static constexpr uint32_t m_bufferTargetCount = 8;
+	static constexpr uint32_t m_indexedTargetCount = 2;
+	static constexpr uint32_t m_capabilityCount = 8;
+
+	struct BufferRange
+	{
+		GLuint		buffer;
+		GLintptr	offset;
+		GLsizeiptr	size;
+	};
+
+	OpenGLStateCache();
+	~OpenGLStateCache();
+
+	static std::unique_ptr<OpenGLStateCache> g_openGLStateCacheInstance;
+	friend std::default_delete<OpenGLStateCache>;
+
+	GLuint		m_program;
+	GLuint		m_vertexArray;
+	GLuint		m_activeTextureUnit;
+	std::array<std::array<GLuint, m_textureTargetCount>, m_maxTextureUnits>		m_textures;
+	std::array<GLuint, m_bufferTargetCount>										m_buffers;
+	std::array<std::array<BufferRange, m_maxIndexedBindings>, m_indexedTargetCount>	m_bufferRanges;
+	std::array<GLuint, m_capabilityCount>										m_capabilities;	// 0, 1 or m_unknown
+
+	GLuint		m_depthFunc;
+	GLuint		m_depthMask;
+	GLuint		m_colorMask;
+	GLuint		m_blendSource;
+	GLuint		m_blendDestination;
+	GLuint		m_blendEquation;
+	GLuint		m_cullFace;
+	GLint		m_viewport[4];
+
+	OpenGLStateStats	m_frameStats;
+	OpenGLStateStats	m_lastFrameStats;
+
+	// Returns the slot shadowing the passed enum, or -1 if it is not shadowed and always reaches the driver
+	static int GetTextureTargetIndex( const GLenum target );
+	static int GetBufferTargetIndex( const GLenum target );
+	static int GetIndexedTargetIndex( const GLenum target );
+	static int GetCapabilityIndex( const GLenum capability );
+
+	void ActiveTexture( const GLuint unit );
+
+	// Binds the range, a filtered out bind leaves the generic binding point as it is, so only this updates its shadow
+	void SetBufferRange( const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size );
+
+	// Records whether a call reached the driver, returns isChanged so callers can branch on it
+	bool Count( const bool isChanged );
+
+};
+
+#endif // !OPENGLSTATECACHE_H
@@ -0,0 +1,182 @@
+#include "OpenGLStreamBuffer.h"
+#include "OpenGLExtensions.h"
+#include "OpenGLStateCache.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <string>
+
+namespace
+{
+	constexpr GLuint64 g_fenceTimeoutNanoseconds = 1000000000;
+}
+
+OpenGLStreamBuffer::OpenGLStreamBuffer( const GLenum target, const size_t frameSize ) :
+	m_target( target ),
+	m_frameSize( frameSize ),
+	m_buffer( 0 ),
+	m_mappedData( nullptr ),
+	m_frameData( nullptr ),
+	m_fences(),
+	m_frame( 0 ),
+	m_head( 0 ),
+	m_isPersistent( false )
+{}
+
+OpenGLStreamBuffer::~OpenGLStreamBuffer()
+{
+	OnDestroy();
+}
+
+// Creates and maps the buffer, returns false if the buffer cannot be created
+bool OpenGLStreamBuffer::OnCreate()
+{
+	m_isPersistent = OpenGLExtensions::HasVersion( 4, 4 ) || OpenGLExtensions::IsSupported( "GL_ARB_buffer_storage" );
+
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+
+	glGenBuffers( 1, &m_buffer );
+	stateCache->BindBuffer( m_target, m_buffer );
+
+	if ( m_isPersistent )
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr size = static_cast<GLsizeiptr>( m_frameSize * m_frameCount );
+
+		glBufferStorage( m_target, size, nullptr, flags );
+		m_mappedData = static_cast<unsigned char*>( glMapBufferRange( m_target, 0, size, flags ) );
+
+		if ( m_mappedData == nullptr )
+		{
+			DEBUG_LOG( LOG::WARNING, "Failed to persistently map stream buffer, falling back to mapping every frame" );
+			CONSOLE_LOG( LOG::WARNING, "Failed to persistently map stream buffer, falling back to mapping every frame" );
+			stateCache->DeleteBuffers( 1, &m_buffer );
+			glGenBuffers( 1, &m_buffer );
+			stateCache->BindBuffer( m_target, m_buffer );
+			m_isPersistent = false;
+		}
+	}
+
+	if ( !m_isPersistent )
+	{
+		glBufferData( m_target, static_cast<GLsizeiptr>( m_frameSize ), nullptr, GL_STREAM_DRAW );
+	}
+
+	DEBUG_LOG( LOG::INFO, "Created " + std::string( m_isPersistent ? "persistent" : "per frame mapped" ) + " stream buffer, " + std::to_string( m_frameSize ) + " bytes per frame" );
+	CONSOLE_LOG( LOG::INFO, "Created " + std::string( m_isPersistent ? "persistent" : "per frame mapped" ) + " stream buffer, " + std::to_string( m_frameSize ) + " bytes per frame" );
+	return m_buffer != 0;
+}
+
+void OpenGLStreamBuffer::OnDestroy()
+{
+	for ( GLsync& fence : m_fences )
+	{
+		if ( fence )
+		{
+			glDeleteSync( fence );
+			fence = nullptr;
+		}
+	}
+
+	if ( m_buffer != 0 )
+	{
+		if ( m_mappedData )
+		{
+			OpenGLStateCache::Get()->BindBuffer( m_target, m_buffer );
+			glUnmapBuffer( m_target );
+		}
+		OpenGLStateCache::Get()->DeleteBuffers( 1, &m_buffer );
+		m_buffer = 0;
+	}
+
+	m_mappedData = nullptr;
+	m_frameData = nullptr;
+}
+
+// Starts a new frame, waiting if the GPU is still reading the region this frame will write into. Render thread only
+void OpenGLStreamBuffer::BeginFrame()
+{
+	m_head.store( 0, std::memory_order_relaxed );
+
+	if ( m_isPersistent )
+	{
+		m_frame = ( m_frame + 1 ) % m_frameCount;
+
+		GLsync& fence = m_fences[m_frame];
+		if ( fence )
+			// Only blocks when the CPU is more than m_frameCount frames ahead of the GPU
+		{
+			while ( glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_fenceTimeoutNanoseconds ) == GL_TIMEOUT_EXPIRED )
+			{}
+			glDeleteSync( fence );
+			fence = nullptr;
+		}
+
+		m_frameData = m_mappedData + m_frame * m_frameSize;
+	}
+	else
+		// Orphaning hands the driver a fresh allocation, so mapping does not wait on draws still reading the old one
+	{
+		OpenGLStateCache::Get()->BindBuffer( m_target, m_buffer );
+		glBufferData( m_target, static_cast<GLsizeiptr>( m_frameSize ), nullptr, GL_STREAM_DRAW );
+		m_frameData = static_cast<unsigned char*>( glMapBufferRange( m_target, 0, static_cast<GLsizeiptr>( m_frameSize ), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT ) );
+	}
+}
+
+// Fences every draw issued this frame, the region is reused once the fence has been signalled. Render thread only
+void OpenGLStreamBuffer::EndFrame()
+{
+	if ( m_isPersistent )
+	{
+		m_fences[m_frame] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	}
+	else
+	{
+		Flush();
+	}
+}
+
+// Reserves size bytes, with an offset that is a multiple of alignment, from this frame's region
+// Safe to call from any thread between BeginFrame and Flush, returns an invalid allocation if the region is full
+StreamAllocation OpenGLStreamBuffer::Allocate( const size_t size, const size_t alignment )
+{
+	StreamAllocation allocation = { nullptr, m_buffer, 0, 0 };
+	if ( m_frameData == nullptr )
+	{
+		return allocation;
+	}
+
+	const size_t regionOffset = m_isPersistent ? m_frame * m_frameSize : 0;
+
+	size_t head = m_head.load( std::memory_order_relaxed );
+	size_t offset;
+	do
+	{
+		// Aligning the absolute offset, regions are not necessarily a multiple of the alignment
+		offset = ( ( regionOffset + head + alignment - 1 ) / alignment ) * alignment - regionOffset;
+		if ( offset + size > m_frameSize )
+		{
+			return allocation;
+		}
+	}
+	while ( !m_head.compare_exchange_weak( head, offset + size, std::memory_order_relaxed ) );
+
+	allocation.data = m_frameData + offset;
+	allocation.offset = static_cast<GLintptr>( regionOffset + offset );
+	allocation.size = static_cast<GLsizeiptr>( size );
+	return allocation;
+}
+
+// Makes this frame's writes visible to the GPU, call before issuing draws that read them. Render thread only
+void OpenGLStreamBuffer::Flush()
+{
+	if ( m_isPersistent || m_frameData == nullptr )
+		// Coherent mappings need no flush
+	{
+		return;
+	}
+
+	OpenGLStateCache::Get()->BindBuffer( m_target, m_buffer );
+	glUnmapBuffer( m_target );
+	m_frameData = nullptr;
+}
@@ -0,0 +1,83 @@
+#ifndef OPENGLSTREAMBUFFER_H
+#define OPENGLSTREAMBUFFER_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Chunk of a stream buffer handed out for the current frame, written through data and read by the GPU at offset
+struct StreamAllocation
+{
+	void*		data;
+	GLuint		buffer;
+	GLintptr	offset;
+	GLsizeiptr	size;
+
+	bool IsValid() const { return data != nullptr; }
+};
+
+// Ring buffer for data written once per frame, such as per draw uniforms, debug geometry and UI vertices
+// One persistently and coherently mapped buffer is split into a region per frame in flight, each guarded by a fence,
+// so the CPU writes straight into memory the GPU is not reading without mapping, unmapping or glBufferSubData
+class OpenGLStreamBuffer
+{
+
+	OpenGLStreamBuffer( const OpenGLStreamBuffer& ) = delete;
+	OpenGLStreamBuffer& operator=( const OpenGLStreamBuffer& ) = delete;
+	OpenGLStreamBuffer( OpenGLStreamBuffer&& ) = delete;
+	OpenGLStreamBuffer& operator=( OpenGLStreamBuffer&& ) = delete;
+
+public:
+
+	// Frames the CPU may run ahead of the GPU before BeginFrame has to wait
+	static constexpr uint32_t m_frameCount = 3;
+
+	// Creates a buffer bound to the passed target, with frameSize bytes available to each frame
+	OpenGLStreamBuffer( const GLenum target, const size_t frameSize );
+	~OpenGLStreamBuffer();
+
+	// Creates and maps the buffer, returns false if the buffer cannot be created
+	bool OnCreate();
+	void OnDestroy();
+
+	// Starts a new frame, waiting if the GPU is still reading the region this frame will write into. Render thread only
+	void BeginFrame();
+
+	// Fences every draw issued this frame, the region is reused once the fence has been signalled. Render thread only
+	void EndFrame();
+
+	// Reserves size bytes, with an offset that is a multiple of alignment, from this frame's region
+	// Safe to call from any thread between BeginFrame and Flush, returns an invalid allocation if the region is full
+	StreamAllocation Allocate( const size_t size, const size_t alignment );
+
+	// Makes this frame's writes visible to the GPU, call before issuing draws that read them. Render thread only
+	void Flush();
+
+	GLuint GetBuffer() const { return m_buffer; }
+	size_t GetFrameSize() const { return m_frameSize; }
+
+	// Returns the bytes allocated so far this frame
+	size_t GetUsedSize() const { return m_head.load( std::memory_order_relaxed ); }
+
+private:
+
+	GLenum				m_target;
+	size_t				m_frameSize;
+	GLuint				m_buffer;
+
+	// Start of the mapped buffer, and of the current frame's region inside of it
+	unsigned char*		m_mappedData;
+	unsigned char*		m_frameData;
+
+	GLsync				m_fences[m_frameCount];
+	uint32_t			m_frame;
+	std::atomic<size_t>	m_head;
+
+	// Without buffer storage the buffer is orphaned and mapped once per frame, then unmapped by Flush
+	bool				m_isPersistent;
+
+};
+
+#endif // !OPENGLSTREAMBUFFER_H
@@ -0,0 +1,504 @@
+#include "OpenGLUploader.h"
+#include "OpenGLExtensions.h"
+
+#include "../../Devices/Window.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	// How long the upload thread sleeps between polls of unsignalled fences
+	constexpr std::chrono::milliseconds g_fencePollInterval( 1 );
+	constexpr GLuint64 g_fenceTimeoutNanoseconds = 1000000000;
+
+	void WaitForFence( const GLsync fence )
+	{
+		while ( glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_fenceTimeoutNanoseconds ) == GL_TIMEOUT_EXPIRED )
+		{}
+	}
+}
+
+std::unique_ptr<OpenGLUploader> OpenGLUploader::g_openGLUploaderInstance( nullptr );
+
+OpenGLUploader::OpenGLUploader() :
+	m_context( nullptr ),
+	m_isRunning( false ),
+	m_startupDone( false ),
+	m_startupSucceeded( false ),
+	m_stopRequested( false ),
+	m_uploadedBytes( 0 ),
+	m_stagingBuffer( 0 ),
+	m_stagingData( nullptr ),
+	m_segmentFences(),
+	m_segment( 0 ),
+	m_segmentOffset( 0 )
+{}
+
+OpenGLUploader::~OpenGLUploader()
+{
+	OnDestroy();
+}
+
+// Get Instance of OpenGL Uploader
+OpenGLUploader* OpenGLUploader::Get()
+{
+	if ( g_openGLUploaderInstance == nullptr )
+	{
+		g_openGLUploaderInstance.reset( new OpenGLUploader );
+	}
+	return g_openGLUploaderInstance.get();
+}
+
+// Creates the shared context and starts the upload thread, must be called on the thread that owns the window's context
+// Returns false if persistent mapping is unsupported, jobs then have to be done on the render thread instead
+bool OpenGLUploader::OnCreate( Window* window )
+{
+	if ( m_isRunning )
+	{
+		return true;
+	}
+
+	if ( !OpenGLExtensions::HasVersion( 4, 4 ) && !OpenGLExtensions::IsSupported( "GL_ARB_buffer_storage" ) )
+	{
+		DEBUG_LOG( LOG::WARNING, "GL_ARB_buffer_storage is not supported, uploads stay on the render thread" );
+		CONSOLE_LOG( LOG::WARNING, "GL_ARB_buffer_storage is not supported, uploads stay on the render thread" );
+		return false;
+	}
+
+	// Shared contexts are created through GLFW, which a headless window's EGL context did not come from
+	if ( window->IsHeadless() )
+	{
+		DEBUG_LOG( LOG::INFO, "Headless window, uploads stay on the render thread" );
+		CONSOLE_LOG( LOG::INFO, "Headless window, uploads stay on the render thread" );
+		return false;
+	}
+
+	// Uses the hints the window was created with, so the contexts match and can share objects
+	glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+	m_context = glfwCreateWindow( 1, 1, "Upload Context", nullptr, window->GetGLFW_Window() );
+	glfwWindowHint( GLFW_VISIBLE, GLFW_TRUE );
+
+	if ( m_context == nullptr )
+	{
+		DEBUG_LOG( LOG::WARNING, "Failed to create shared upload context, uploads stay on the render thread" );
+		CONSOLE_LOG( LOG::WARNING, "Failed to create shared upload context, uploads stay on the render thread" );
+		return false;
+	}
+
+	m_startupDone = false;
+	m_startupSucceeded = false;
+	m_stopRequested = false;
+	m_thread = std::thread( &OpenGLUploader::Run, this );
+
+	{
+		std::unique_lock<std::mutex> lock( m_mutex );
+		m_started.wait( lock, [this]() { return m_startupDone; } );
+	}
+
+	if ( !m_startupSucceeded )
+	{
+		m_thread.join();
+		glfwDestroyWindow( m_context );
+		m_context = nullptr;
+		DEBUG_LOG( LOG::WARNING, "Failed to map the upload staging ring, uploads stay on the render thread" );
+		CONSOLE_LOG( LOG::WARNING, "Failed to map the upload staging ring, uploads stay on the render thread" );
+		return false;
+	}
+
+	m_isRunning = true;
+	DEBUG_LOG( LOG::INFO, "Started upload thread with a " + std::to_string( m_stagingSize / ( 1024 * 1024 ) ) + "MB staging ring" );
+	CONSOLE_LOG( LOG::INFO, "Started upload thread with a " + std::to_string( m_stagingSize / ( 1024 * 1024 ) ) + "MB staging ring" );
+	return true;
+}
+
+// Stops the upload thread, deleting everything that was not handed back yet
+void OpenGLUploader::OnDestroy()
+{
+	if ( !m_isRunning )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_stopRequested = true;
+		m_isRunning = false;
+	}
+	m_jobQueued.notify_all();
+	m_thread.join();
+
+	// The upload thread has cleaned up its own jobs, finished ones are deleted through the render thread's context
+	for ( const std::shared_ptr<Job>& job : m_completed )
+	{
+		DeleteObjects( job->result );
+	}
+	m_completed.clear();
+	m_queued.clear();
+
+	glfwDestroyWindow( m_context );
+	m_context = nullptr;
+}
+
+// Queues a job for the upload thread, complete is called from ProcessCompleted once the job is resident
+void OpenGLUploader::Submit( const void* owner, UploadFunction upload, CompleteFunction complete )
+{
+	std::shared_ptr<Job> job = std::make_shared<Job>();
+	job->owner = owner;
+	job->upload = std::move( upload );
+	job->complete = std::move( complete );
+	job->fence = nullptr;
+	job->cancelled = false;
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_queued.push_back( job );
+	}
+	m_jobQueued.notify_one();
+}
+
+// Drops every job queued by the passed owner, deleting anything those jobs already created. Render thread only
+void OpenGLUploader::Cancel( const void* owner )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	m_queued.erase(
+		std::remove_if( m_queued.begin(), m_queued.end(), [owner]( const std::shared_ptr<Job>& j ) { return j->owner == owner; } ),
+		m_queued.end()
+	);
+
+	// Jobs still on the upload thread delete their objects themselves once their fence is signalled
+	for ( const std::shared_ptr<Job>& job : m_inFlight )
+	{
+		if ( job->owner == owner )
+		{
+			job->cancelled = true;
+		}
+	}
+
+	auto completed = std::remove_if( m_completed.begin(), m_completed.end(), [owner]( const std::shared_ptr<Job>& j ) { return j->owner == owner; } );
+	for ( auto it = completed; it != m_completed.end(); ++it )
+	{
+		DeleteObjects( ( *it )->result );
+	}
+	m_completed.erase( completed, m_completed.end() );
+}
+
+// Hands finished jobs back to their owners. Render thread only
+void OpenGLUploader::ProcessCompleted()
+{
+	std::deque<std::shared_ptr<Job>> completed;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		completed.swap( m_completed );
+	}
+
+	for ( const std::shared_ptr<Job>& job : completed )
+	{
+		job->complete( job->result );
+	}
+}
+
+// Returns the number of jobs queued, in flight or waiting for ProcessCompleted
+size_t OpenGLUploader::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_queued.size() + m_inFlight.size() + m_completed.size();
+}
+
+// Creates a buffer holding the passed bytes, copied through the staging ring. Upload thread only
+GLuint OpenGLUploader::CreateBuffer( OpenGLUploadResult& result, const void* data, const size_t size )
+{
+	GLuint buffer = 0;
+	if ( size > 0 )
+	{
+		glGenBuffers( 1, &buffer );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, buffer );
+		glBufferData( GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>( size ), nullptr, GL_STATIC_DRAW );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+
+		WriteBuffer( buffer, 0, data, size );
+	}
+
+	// Empty buffers are still recorded, so owners can read the result back in the order they created it
+	result.buffers.push_back( buffer );
+	return buffer;
+}
+
+// Copies the passed bytes into an existing buffer at the passed offset, through the staging ring. Upload thread only
+void OpenGLUploader::WriteBuffer( const GLuint buffer, const size_t offset, const void* data, const size_t size )
+{
+	if ( buffer == 0 || size == 0 )
+	{
+		return;
+	}
+
+	glBindBuffer( GL_COPY_WRITE_BUFFER, buffer );
+	m_uploadedBytes.fetch_add( size, std::memory_order_relaxed );
+
+	// Writes larger than a segment are copied a segment at a time
+	const unsigned char* source = static_cast<const unsigned char*>( data );
+	for ( size_t written = 0; written < size; written += m_segmentSize )
+	{
+		const size_t chunkSize = std::min( m_segmentSize, size - written );
+		const size_t stagingOffset = Stage( source + written, chunkSize );
+		glCopyBufferSubData(
+			GL_COPY_READ_BUFFER,
+			GL_COPY_WRITE_BUFFER,
+			static_cast<GLintptr>( stagingOffset ),
+			static_cast<GLintptr>( offset + written ),
+			static_cast<GLsizeiptr>( chunkSize )
+		);
+	}
+
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+}
+
+// Creates a texture object and binds it to GL_TEXTURE_2D. Upload thread only
+GLuint OpenGLUploader::CreateTexture( OpenGLUploadResult& result )
+{
+	GLuint texture = 0;
+	glGenTextures( 1, &texture );
+	glBindTexture( GL_TEXTURE_2D, texture );
+	result.textures.push_back( texture );
+	return texture;
+}
+
+// Copies the passed pixels into the staging ring and binds it as the pixel unpack buffer, returns the pointer to pass
+// to glTexImage2D. Callers split images into bands of at most m_segmentSize bytes, a larger one is read straight
+// from the passed pointer, blocking the upload thread on the copy. Upload thread only
+const void* OpenGLUploader::StagePixels( const void* data, const size_t size )
+{
+	m_uploadedBytes.fetch_add( size, std::memory_order_relaxed );
+
+	if ( size == 0 || size > m_segmentSize )
+	{
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+		return data;
+	}
+
+	const size_t offset = Stage( data, size );
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, m_stagingBuffer );
+	return reinterpret_cast<const void*>( static_cast<uintptr_t>( offset ) );
+}
+
+void OpenGLUploader::Run()
+{
+	glfwMakeContextCurrent( m_context );
+	const bool created = CreateStagingRing();
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_startupDone = true;
+		m_startupSucceeded = created;
+	}
+	m_started.notify_all();
+
+	if ( !created )
+	{
+		glfwMakeContextCurrent( nullptr );
+		return;
+	}
+
+	while ( true )
+	{
+		std::shared_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+			if ( m_inFlight.empty() )
+			{
+				m_jobQueued.wait( lock, [this]() { return m_stopRequested || !m_queued.empty(); } );
+			}
+			else
+				// Fences to poll, waking up regularly even if nothing new is queued
+			{
+				m_jobQueued.wait_for( lock, g_fencePollInterval, [this]() { return m_stopRequested || !m_queued.empty(); } );
+			}
+
+			if ( m_stopRequested )
+			{
+				break;
+			}
+
+			if ( !m_queued.empty() )
+			{
+				job = m_queued.front();
+				m_queued.pop_front();
+				m_inFlight.push_back( job );
+			}
+		}
+
+		if ( job )
+		{
+			job->upload( *this, job->result );
+			glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+			glBindTexture( GL_TEXTURE_2D, 0 );
+
+			// Flushed straight away, so the GPU starts on the copies while the next job is being recorded
+			job->fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+			glFlush();
+		}
+
+		RetireJobs();
+	}
+
+	// Shutting down, everything still on this thread is deleted without being handed back
+	glFinish();
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		for ( const std::shared_ptr<Job>& job : m_inFlight )
+		{
+			if ( job->fence )
+			{
+				glDeleteSync( job->fence );
+			}
+			DeleteObjects( job->result );
+		}
+		m_inFlight.clear();
+	}
+
+	DestroyStagingRing();
+	glfwMakeContextCurrent( nullptr );
+}
+
+bool OpenGLUploader::CreateStagingRing()
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers( 1, &m_stagingBuffer );
+	glBindBuffer( GL_COPY_READ_BUFFER, m_stagingBuffer );
+	glBufferStorage( GL_COPY_READ_BUFFER, static_cast<GLsizeiptr>( m_stagingSize ), nullptr, flags );
+	m_stagingData = static_cast<unsigned char*>( glMapBufferRange( GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>( m_stagingSize ), flags ) );
+
+	if ( m_stagingData == nullptr )
+	{
+		DestroyStagingRing();
+		return false;
+	}
+
+	// The ring stays bound as GL_COPY_READ_BUFFER for the life of the thread, every buffer copy reads from it
+	for ( GLsync& fence : m_segmentFences )
+	{
+		fence = nullptr;
+	}
+	m_segment = 0;
+	m_segmentOffset = 0;
+	return true;
+}
+
+void OpenGLUploader::DestroyStagingRing()
+{
+	for ( GLsync& fence : m_segmentFences )
+	{
+		if ( fence )
+		{
+			glDeleteSync( fence );
+			fence = nullptr;
+		}
+	}
+
+	if ( m_stagingBuffer != 0 )
+	{
+		glBindBuffer( GL_COPY_READ_BUFFER, m_stagingBuffer );
+		if ( m_stagingData )
+		{
+			glUnmapBuffer( GL_COPY_READ_BUFFER );
+			m_stagingData = nullptr;
+		}
+		glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+		glDeleteBuffers( 1, &m_stagingBuffer );
+		m_stagingBuffer = 0;
+	}
+}
+
+// Reserves space in the current segment, moving to the next one and waiting on its fence when it is full
+size_t OpenGLUploader::Stage( const void* data, const size_t size )
+{
+	size_t offset = ( m_segmentOffset + m_stagingAlignment - 1 ) & ~( m_stagingAlignment - 1 );
+	if ( offset + size > m_segmentSize )
+	{
+		AdvanceSegment();
+		offset = 0;
+	}
+
+	const size_t stagingOffset = m_segment * m_segmentSize + offset;
+	std::memcpy( m_stagingData + stagingOffset, data, size );
+	m_segmentOffset = offset + size;
+	return stagingOffset;
+}
+
+void OpenGLUploader::AdvanceSegment()
+{
+	// Every copy reading from the segment being left has been issued, one fence covers all of them
+	m_segmentFences[m_segment] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+	m_segment = ( m_segment + 1 ) % m_segmentCount;
+	m_segmentOffset = 0;
+
+	GLsync& fence = m_segmentFences[m_segment];
+	if ( fence )
+		// Only waits if the GPU is still reading the copies from the last time this segment was used
+	{
+		WaitForFence( fence );
+		glDeleteSync( fence );
+		fence = nullptr;
+	}
+}
+
+// Moves jobs whose fence has been signalled to the completed queue, without blocking
+void OpenGLUploader::RetireJobs()
+{
+	while ( true )
+	{
+		std::shared_ptr<Job> job;
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			if ( m_inFlight.empty() || m_inFlight.front()->fence == nullptr )
+			{
+				return;
+			}
+			job = m_inFlight.front();
+		}
+
+		const GLenum status = glClientWaitSync( job->fence, 0, 0 );
+		if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+			// Fences signal in order, nothing behind this job is done either
+		{
+			return;
+		}
+
+		glDeleteSync( job->fence );
+		job->fence = nullptr;
+
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_inFlight.pop_front();
+		if ( job->cancelled )
+		{
+			DeleteObjects( job->result );
+		}
+		else
+		{
+			m_completed.push_back( job );
+		}
+	}
+}
+
+void OpenGLUploader::DeleteObjects( const OpenGLUploadResult& result )
+{
+	for ( GLuint buffer : result.buffers )
+	{
+		if ( buffer != 0 )
+		{
+			glDeleteBuffers( 1, &buffer );
+		}
+	}
+
+	if ( !result.textures.empty() )
+	{
+		glDeleteTextures( static_cast<GLsizei>( result.textures.size() ), result.textures.data() );
+	}
+}
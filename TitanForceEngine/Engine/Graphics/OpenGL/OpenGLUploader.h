@@ -0,0 +1,151 @@
+#ifndef OPENGLUPLOADER_H
+#define OPENGLUPLOADER_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Window;
+struct GLFWwindow;
+
+// GL objects created by an upload job, handed to the job's owner once they are resident
+struct OpenGLUploadResult
+{
+	std::vector<GLuint>	buffers;
+	std::vector<GLuint>	textures;
+};
+
+// Singleton that creates buffers and textures on its own thread, through a hidden GL context shared with the window's
+// Data is copied into a persistently mapped staging ring and from there into the destination objects, each job is
+// fenced and only handed back to the render thread once the GPU has finished with it
+class OpenGLUploader
+{
+
+	OpenGLUploader( const OpenGLUploader& ) = delete;
+	OpenGLUploader& operator=( const OpenGLUploader& ) = delete;
+	OpenGLUploader( OpenGLUploader&& ) = delete;
+	OpenGLUploader& operator=( OpenGLUploader&& ) = delete;
+
+public:
+
+	// Runs on the upload thread, every object created through the uploader is recorded in the result
+	using UploadFunction = std::function<void( OpenGLUploader&, OpenGLUploadResult& )>;
+
+	// Runs on the render thread once every object in the result is resident
+	using CompleteFunction = std::function<void( const OpenGLUploadResult& )>;
+
+	// Size of the staging ring and the number of fenced segments it is split into
+	static constexpr size_t m_stagingSize = 64 * 1024 * 1024;
+	static constexpr size_t m_segmentCount = 4;
+	static constexpr size_t m_segmentSize = m_stagingSize / m_segmentCount;
+	static constexpr size_t m_stagingAlignment = 16;
+
+	// Get Instance of OpenGL Uploader
+	static OpenGLUploader* Get();
+
+	// Creates the shared context and starts the upload thread, must be called on the thread that owns the window's context
+	// Returns false if persistent mapping is unsupported, jobs then have to be done on the render thread instead
+	bool OnCreate( Window* window );
+
+	// Stops the upload thread, deleting everything that was not handed back yet
+	void OnDestroy();
+
+	// Returns true while the upload thread is accepting jobs
+	bool IsRunning() const { return m_isRunning; }
+
+	// Queues a job for the upload thread, complete is called from ProcessCompleted once the job is resident
+	void Submit( const void* owner, UploadFunction upload, CompleteFunction complete );
+
+	// Drops every job queued by the passed owner, deleting anything those jobs already created. Render thread only
+	void Cancel( const void* owner );
+
+	// Hands finished jobs back to their owners. Render thread only
+	void ProcessCompleted();
+
+	// Returns the number of jobs queued, in flight or waiting for ProcessCompleted
+	size_t GetPendingCount();
+
+	// Creates a buffer holding the passed bytes, copied through the staging ring. Upload thread only
+	GLuint CreateBuffer( OpenGLUploadResult& result, const void* data, const size_t size );
+
+	// Copies the passed bytes into an existing buffer at the passed offset, through the staging ring. Upload thread only
+	// The buffer is not recorded in the result, it stays owned by whoever created it
+	void WriteBuffer( const GLuint buffer, const size_t offset, const void* data, const size_t size );
+
+	// Creates a texture object and binds it to GL_TEXTURE_2D. Upload thread only
+	GLuint CreateTexture( OpenGLUploadResult& result );
+
+	// Copies the passed pixels into the staging ring and binds it as the pixel unpack buffer, returns the pointer to pass
+	// to glTexImage2D. Callers split images into bands of at most m_segmentSize bytes, a larger one is read straight
+	// from the passed pointer, blocking the upload thread on the copy. Upload thread only
+	const void* StagePixels( const void* data, const size_t size );
+
+	// Returns the bytes written into buffers and textures since the last call, safe to call from any thread
+	size_t TakeUploadedBytes() { return m_uploadedBytes.exchange( 0, std::memory_order_relaxed ); }
+
+private:
+
+	struct Job
+	{
+		const void*			owner;
+		UploadFunction		upload;
+		CompleteFunction	complete;
+		OpenGLUploadResult	result;
+		GLsync				fence;
+		bool				cancelled;
+	};
+
+	OpenGLUploader();
+	~OpenGLUploader();
+
+	static std::unique_ptr<OpenGLUploader> g_openGLUploaderInstance;
+	friend std::default_delete<OpenGLUploader>;
+
+	GLFWwindow*							m_context;
+	std::thread							m_thread;
+	bool								m_isRunning;
+
+	std::mutex							m_mutex;
+	std::condition_variable				m_jobQueued;
+	std::condition_variable				m_started;
+	bool								m_startupDone;
+	bool								m_startupSucceeded;
+	bool								m_stopRequested;
+
+	std::deque<std::shared_ptr<Job>>	m_queued;		// Waiting for the upload thread
+	std::deque<std::shared_ptr<Job>>	m_inFlight;		// Running, or waiting on their fence
+	std::deque<std::shared_ptr<Job>>	m_completed;	// Resident, waiting for the render thread
+	std::atomic<size_t>					m_uploadedBytes;
+
+	// Upload thread only
+	GLuint								m_stagingBuffer;
+	unsigned char*						m_stagingData;
+	GLsync								m_segmentFences[m_segmentCount];
+	size_t								m_segment;
+	size_t								m_segmentOffset;
+
+	void Run();
+
+	bool CreateStagingRing();
+	void DestroyStagingRing();
+
+	// Reserves space in the current segment, moving to the next one and waiting on its fence when it is full
+	size_t Stage( const void* data, const size_t size );
+	void AdvanceSegment();
+
+	// Moves jobs whose fence has been signalled to the completed queue, without blocking
+	void RetireJobs();
+
+	static void DeleteObjects( const OpenGLUploadResult& result );
+
+};
+
+#endif // !OPENGLUPLOADER_H
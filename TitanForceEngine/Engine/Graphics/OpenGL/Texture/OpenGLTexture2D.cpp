@@ -1,20 +1,45 @@
 #include "OpenGLTexture2D.h"
+#include "../OpenGLUploader.h"
+#include "../OpenGLStateCache.h"
+
+#include "../../../RenderCore/Loading/AssetLoader.h"
+#include "../../../RenderCore/Texture/BlockCompressor.h"
 
 #include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include <algorithm>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
 
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
 
 OpenGLTexture2D::OpenGLTexture2D( const char* fileName ) :
-	Texture2D( fileName ), m_id( 0 )
+	Texture2D( fileName ), m_layer()
 {
-	GenerateTexture();
+	if ( m_fileName == "" )
+	{
+		DEBUG_LOG( LOG::WARNING, "Failed to load texture: no file name provided" );
+		CONSOLE_LOG( LOG::WARNING, "Failed to load texture: no file name provided" );
+		return;
+	}
+
+	m_layer = OpenGLTextureArrayPool::Get()->GetPlaceholder();
+
+	// Decoded on a worker thread, then uploaded and moved into a layer of its own through Upload
+	AssetLoader::Get()->LoadTexture( this, m_fileName );
 }
 
 OpenGLTexture2D::~OpenGLTexture2D()
-{}
+{
+	OpenGLUploader::Get()->Cancel( this );
+	OpenGLTextureArrayPool::Get()->Release( m_layer );
+}
 
+// Decodes and uploads the texture immediately, blocking the calling thread
 void OpenGLTexture2D::GenerateTexture()
 {
 
@@ -25,46 +50,248 @@ void OpenGLTexture2D::GenerateTexture()
 		return;
 	}
 
-	std::string filePath = "./Resources/Textures/" + m_fileName;
+	std::shared_ptr<TextureData> data = Decode( m_fileName );
+	if ( data )
+	{
+		UploadImmediate( *data );
+	}
 
-	DEBUG_LOG( LOG::INFO, "Generating texture... at file: " + filePath );
-	CONSOLE_LOG( LOG::INFO, "Generating texture... at file: " + filePath );
+}
 
-	glGenTextures( 1, &m_id );
-	glBindTexture( GL_TEXTURE_2D, m_id );
+void OpenGLTexture2D::Upload( const std::shared_ptr<TextureData>& data )
+{
+	OpenGLUploader* uploader = OpenGLUploader::Get();
+	if ( !uploader->IsRunning() )
+	{
+		UploadImmediate( *data );
+		return;
+	}
 
-	// set the texture wrapping/filtering options (on the currently bound texture object)
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	// Written into a new texture object on the upload thread, the placeholder is drawn with until it is resident
+	const int width = data->width;
+	const int height = data->height;
+	const GLenum internalFormat = GetInternalFormat( *data );
+	const int levels = GetLevelCount( *data );
+	uploader->Submit(
+		this,
+		[data]( OpenGLUploader& uploader, OpenGLUploadResult& result )
+		{
+			uploader.CreateTexture( result );
+			SetSamplerParameters();
+			WriteImage( *data, &uploader );
+		},
+		[this, width, height, internalFormat, levels]( const OpenGLUploadResult& result )
+		{
+			MoveIntoLayer( result.textures.front(), internalFormat, width, height, levels );
+			m_width = width;
+			m_height = height;
+
+			DEBUG_LOG( LOG::INFO, "Generating texture... COMPLETED: " + m_fileName );
+			CONSOLE_LOG( LOG::INFO, "Generating texture... COMPLETED: " + m_fileName );
+		}
+	);
+}
 
-	int nrChannels;
-	unsigned char *data = stbi_load( filePath.c_str(), &m_width, &m_height, &nrChannels, 0 );
+// Writes the passed image into a new 2D texture on the calling thread, then moves it into a layer
+void OpenGLTexture2D::UploadImmediate( const TextureData& data )
+{
+	GLuint texture = 0;
+	glGenTextures( 1, &texture );
+	OpenGLStateCache::Get()->BindTexture( 0, GL_TEXTURE_2D, texture );
+	SetSamplerParameters();
+	WriteImage( data, nullptr );
 
-	if ( data )
+	MoveIntoLayer( texture, GetInternalFormat( data ), data.width, data.height, GetLevelCount( data ) );
+	m_width = data.width;
+	m_height = data.height;
+
+	DEBUG_LOG( LOG::INFO, "Generating texture... COMPLETED: " + m_fileName );
+	CONSOLE_LOG( LOG::INFO, "Generating texture... COMPLETED: " + m_fileName );
+}
+
+// Moves the image of the passed 2D texture into a layer of a matching array and deletes the 2D texture
+void OpenGLTexture2D::MoveIntoLayer( GLuint texture, const GLenum internalFormat, const int width, const int height, const int levels )
+{
+	OpenGLTextureArrayPool* pool = OpenGLTextureArrayPool::Get();
+
+	const OpenGLTextureLayer layer = pool->Acquire( texture, internalFormat, width, height, levels );
+	if ( layer.IsValid() )
+	{
+		pool->Release( m_layer );
+		m_layer = layer;
+	}
+	else
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to find a texture array layer for: " + m_fileName );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to find a texture array layer for: " + m_fileName );
+	}
+
+	OpenGLStateCache::Get()->DeleteTextures( 1, &texture );
+}
+
+// Returns the sized format the passed image is stored with on the GPU
+GLenum OpenGLTexture2D::GetInternalFormat( const TextureData& data )
+{
+	switch ( data.format )
+	{
+	case ETextureFormat::BC1:	return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case ETextureFormat::BC3:	return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default:					break;
+	}
+
+	switch ( data.channels )
 	{
-		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data );
-		glGenerateMipmap( GL_TEXTURE_2D );
+	case 1:		return GL_R8;
+	case 2:		return GL_RG8;
+	case 3:		return GL_RGB8;
+	default:	return GL_RGBA8;
+	}
+}
+
+// Returns the number of levels the passed image has once written, including the ones generated by the driver
+int OpenGLTexture2D::GetLevelCount( const TextureData& data )
+{
+	if ( data.format != ETextureFormat::Uncompressed )
+	{
+		return static_cast<int>( data.mips.size() );
+	}
+
+	int levels = 1;
+	for ( int size = std::max( data.width, data.height ); size > 1; size /= 2 )
+	{
+		++levels;
+	}
+	return levels;
+}
 
-		DEBUG_LOG( LOG::INFO, "Generating texture... COMPLETED: " + filePath );
-		CONSOLE_LOG( LOG::INFO, "Generating texture... COMPLETED: " + filePath );
+// Writes every level of the passed image into the bound texture, staged through the uploader when one is passed
+void OpenGLTexture2D::WriteImage( const TextureData& data, OpenGLUploader* uploader )
+{
+	if ( data.format == ETextureFormat::Uncompressed )
+	{
+		WritePixels( data, uploader );
 	}
 	else
 	{
-		DEBUG_LOG( LOG::ERRORLOG, "Generating texture... FAILED: " + filePath );
-		CONSOLE_LOG( LOG::ERRORLOG, "Generating texture... FAILED: " + filePath );
+		WriteCompressedMips( data, uploader );
 	}
-	stbi_image_free( data );
 
+	// Trilinear filtering across the mip chain
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
 }
 
+// Writes the top level of an uncompressed image, the mips below it are generated by the driver
+// Images larger than a staging segment are written in bands of rows, each staged through the uploader on its own
+void OpenGLTexture2D::WritePixels( const TextureData& data, OpenGLUploader* uploader )
+{
+	GLenum format;
+	switch ( data.channels )
+	{
+	case 1:		format = GL_RED;	break;
+	case 2:		format = GL_RG;		break;
+	case 3:		format = GL_RGB;	break;
+	default:	format = GL_RGBA;	break;
+	}
+
+	const size_t rowSize = static_cast<size_t>( data.width ) * data.channels;
+	const size_t size = rowSize * data.height;
+
+	// Rows of three channel images are not always four byte aligned
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+	if ( uploader == nullptr || size <= OpenGLUploader::m_segmentSize )
+	{
+		const void* pixels = uploader ? uploader->StagePixels( data.pixels, size ) : data.pixels;
+		glTexImage2D( GL_TEXTURE_2D, 0, GetInternalFormat( data ), data.width, data.height, 0, format, GL_UNSIGNED_BYTE, pixels );
+	}
+	else
+		// Larger than a staging segment, written in bands of rows that are each staged through the ring
+	{
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+		glTexImage2D( GL_TEXTURE_2D, 0, GetInternalFormat( data ), data.width, data.height, 0, format, GL_UNSIGNED_BYTE, nullptr );
+
+		const int bandRows = static_cast<int>( std::max<size_t>( 1, OpenGLUploader::m_segmentSize / rowSize ) );
+		for ( int y = 0; y < data.height; y += bandRows )
+		{
+			const int rows = std::min( bandRows, data.height - y );
+			const void* pixels = uploader->StagePixels( data.pixels + rowSize * y, rowSize * rows );
+			glTexSubImage2D( GL_TEXTURE_2D, 0, 0, y, data.width, rows, format, GL_UNSIGNED_BYTE, pixels );
+		}
+	}
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000 );
+	glGenerateMipmap( GL_TEXTURE_2D );
+}
+
+// Writes every level of a cooked mip chain as is, nothing is decoded or generated at runtime
+// Levels larger than a staging segment are written in bands of block rows, as WritePixels does
+void OpenGLTexture2D::WriteCompressedMips( const TextureData& data, OpenGLUploader* uploader )
+{
+	const GLenum internalFormat = GetInternalFormat( data );
+	const size_t blockSize = BlockCompressor::GetBlockSize( data.format );
+
+	for ( size_t m = 0; m < data.mips.size(); ++m )
+	{
+		const TextureMip& mip = data.mips[m];
+		if ( uploader && mip.size > OpenGLUploader::m_segmentSize )
+			// Larger than a staging segment, written in bands of block rows that are each staged through the ring
+		{
+			glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+			glCompressedTexImage2D( GL_TEXTURE_2D, static_cast<GLint>( m ), internalFormat, mip.width, mip.height, 0, static_cast<GLsizei>( mip.size ), nullptr );
+
+			const size_t blockRowSize = static_cast<size_t>( ( mip.width + 3 ) / 4 ) * blockSize;
+			const int bandBlockRows = static_cast<int>( std::max<size_t>( 1, OpenGLUploader::m_segmentSize / blockRowSize ) );
+			for ( int y = 0; y < mip.height; y += bandBlockRows * 4 )
+			{
+				const int height = std::min( bandBlockRows * 4, mip.height - y );
+				const size_t bandSize = blockRowSize * ( ( height + 3 ) / 4 );
+				const void* pixels = uploader->StagePixels( mip.data + blockRowSize * ( y / 4 ), bandSize );
+				glCompressedTexSubImage2D(
+					GL_TEXTURE_2D,
+					static_cast<GLint>( m ),
+					0,
+					y,
+					mip.width,
+					height,
+					internalFormat,
+					static_cast<GLsizei>( bandSize ),
+					pixels
+				);
+			}
+			continue;
+		}
+
+		const void* pixels = uploader ? uploader->StagePixels( mip.data, mip.size ) : mip.data;
+		glCompressedTexImage2D(
+			GL_TEXTURE_2D,
+			static_cast<GLint>( m ),
+			internalFormat,
+			mip.width,
+			mip.height,
+			0,
+			static_cast<GLsizei>( mip.size ),
+			pixels
+		);
+	}
+
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>( data.mips.size() ) - 1 );
+}
+
+// Binds the texture's whole array, shaders pick the layer from the draw's object data
 void OpenGLTexture2D::Bind()
 {
-	glBindTexture( GL_TEXTURE_2D, m_id );
+	OpenGLStateCache::Get()->BindTexture( 0, GL_TEXTURE_2D_ARRAY, GetArrayId() );
 }
 
 void OpenGLTexture2D::Unbind()
 {
 
 }
+
+// Sets the wrapping and filtering options on the bound texture
+void OpenGLTexture2D::SetSamplerParameters()
+{
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+}
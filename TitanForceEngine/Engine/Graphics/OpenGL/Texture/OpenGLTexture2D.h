@@ -1,11 +1,17 @@
 #ifndef OPENGL_TEXTURE_2D_H
 #define OPENGL_TEXTURE_2D_H
 
+#include "OpenGLTextureArrayPool.h"
 #include "../../../RenderCore/Texture/Texture2D.h"
 
 #include <glad/glad.h>
 
+class OpenGLUploader;
 
+
+// Texture whose image is stored as a layer of one of OpenGLTextureArrayPool's arrays
+// Images are written into a 2D texture of their own first, on the upload thread when it is running, then copied
+// into their layer once resident. Until then the texture points at the pool's placeholder layer
 class OpenGLTexture2D : public Texture2D
 {
 public:
@@ -16,9 +22,42 @@ public:
 	virtual void Bind() override;
 	virtual void Unbind() override;
 
+	virtual void Upload( const std::shared_ptr<TextureData>& data ) override;
+
+	// Array texture and layer currently holding the image, the placeholder's until the image is resident
+	// Textures without a file name have no array, GetArrayId returns 0
+	GLuint GetArrayId() const { return m_layer.IsValid() ? m_layer.array->texture : 0; }
+	uint32_t GetLayer() const { return m_layer.layer; }
+
 private:
 
-	GLuint m_id;
+	OpenGLTextureLayer m_layer;
+
+	// Writes the passed image into a new 2D texture on the calling thread, then moves it into a layer
+	void UploadImmediate( const TextureData& data );
+
+	// Moves the image of the passed 2D texture into a layer of a matching array and deletes the 2D texture
+	void MoveIntoLayer( GLuint texture, const GLenum internalFormat, const int width, const int height, const int levels );
+
+	// Returns the sized format the passed image is stored with on the GPU
+	static GLenum GetInternalFormat( const TextureData& data );
+
+	// Returns the number of levels the passed image has once written, including the ones generated by the driver
+	static int GetLevelCount( const TextureData& data );
+
+	// Sets the wrapping and filtering options on the bound texture
+	static void SetSamplerParameters();
+
+	// Writes every level of the passed image into the bound texture, staged through the uploader when one is passed
+	static void WriteImage( const TextureData& data, OpenGLUploader* uploader );
+
+	// Writes the top level of an uncompressed image, the mips below it are generated by the driver
+	// Images larger than a staging segment are written in bands of rows, each staged through the uploader on its own
+	static void WritePixels( const TextureData& data, OpenGLUploader* uploader );
+
+	// Writes every level of a cooked mip chain as is, nothing is decoded or generated at runtime
+	// Levels larger than a staging segment are written in bands of block rows, as WritePixels does
+	static void WriteCompressedMips( const TextureData& data, OpenGLUploader* uploader );
 
 };
 
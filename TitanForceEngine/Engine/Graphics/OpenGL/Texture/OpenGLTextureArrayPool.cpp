@@ -0,0 +1,213 @@
+#include "OpenGLTextureArrayPool.h"
+#include "../OpenGLStateCache.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <string>
+
+std::unique_ptr<OpenGLTextureArrayPool> OpenGLTextureArrayPool::g_openGLTextureArrayPoolInstance( nullptr );
+
+OpenGLTextureArrayPool::OpenGLTextureArrayPool() :
+	m_arrays(),
+	m_placeholder( nullptr )
+{}
+
+OpenGLTextureArrayPool::~OpenGLTextureArrayPool()
+{
+	OnDestroy();
+}
+
+// Get Instance of OpenGL Texture Array Pool
+OpenGLTextureArrayPool* OpenGLTextureArrayPool::Get()
+{
+	if ( g_openGLTextureArrayPoolInstance == nullptr )
+	{
+		g_openGLTextureArrayPoolInstance.reset( new OpenGLTextureArrayPool );
+	}
+	return g_openGLTextureArrayPoolInstance.get();
+}
+
+// Copies every level of the passed 2D texture into a free layer of an array with the same format, size and mip count
+// The 2D texture is left as it is and can be deleted afterwards. Returns an invalid layer if no array could be created
+OpenGLTextureLayer OpenGLTextureArrayPool::Acquire( const GLuint texture, const GLenum internalFormat, const int width, const int height, const int levels )
+{
+	OpenGLTextureLayer result = {};
+
+	for ( OpenGLTextureArray* array : m_arrays )
+	{
+		if ( array != m_placeholder &&
+			array->internalFormat == internalFormat &&
+			array->width == width &&
+			array->height == height &&
+			array->levels == levels &&
+			AllocateLayer( array, result.layer ) )
+		{
+			result.array = array;
+			break;
+		}
+	}
+
+	if ( result.array == nullptr )
+	{
+		OpenGLTextureArray* array = CreateArray( internalFormat, width, height, levels );
+		if ( array == nullptr || !AllocateLayer( array, result.layer ) )
+		{
+			return OpenGLTextureLayer{};
+		}
+		result.array = array;
+	}
+
+	CopyLayer( *result.array, texture, GL_TEXTURE_2D, 0, result.array->texture, result.layer );
+	return result;
+}
+
+// Hands the layer back to its array, the next texture acquired from the array may overwrite it
+void OpenGLTextureArrayPool::Release( const OpenGLTextureLayer& layer )
+{
+	// Layers of arrays deleted by OnDestroy, and the placeholder, are never handed back
+	if ( !layer.IsValid() ||
+		layer.array == m_placeholder ||
+		std::find( m_arrays.begin(), m_arrays.end(), layer.array ) == m_arrays.end() )
+	{
+		return;
+	}
+
+	layer.array->freeLayers.push_back( layer.layer );
+}
+
+// Layer of a 1x1 array holding a single white texel, drawn with until a texture's image is resident
+OpenGLTextureLayer OpenGLTextureArrayPool::GetPlaceholder()
+{
+	if ( m_placeholder == nullptr )
+	{
+		m_placeholder = CreateArray( GL_RGBA8, 1, 1, 1 );
+		if ( m_placeholder == nullptr )
+		{
+			return OpenGLTextureLayer{};
+		}
+
+		uint32_t layer = 0;
+		AllocateLayer( m_placeholder, layer );
+
+		const unsigned char white[4] = { 255, 255, 255, 255 };
+		glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white );
+	}
+
+	return OpenGLTextureLayer{ m_placeholder, 0 };
+}
+
+// Deletes every array, layers handed out before this are no longer valid
+void OpenGLTextureArrayPool::OnDestroy()
+{
+	for ( OpenGLTextureArray* array : m_arrays )
+	{
+		DestroyArray( array );
+	}
+	m_arrays.clear();
+	m_placeholder = nullptr;
+}
+
+// Returns a free layer of the passed array, growing it first if every layer is in use. Returns false if it is full
+bool OpenGLTextureArrayPool::AllocateLayer( OpenGLTextureArray* array, uint32_t& layer )
+{
+	if ( !array->freeLayers.empty() )
+	{
+		layer = array->freeLayers.back();
+		array->freeLayers.pop_back();
+		return true;
+	}
+
+	if ( array->layerCount == array->capacity )
+	{
+		if ( array->capacity >= m_maxLayerCapacity )
+		{
+			return false;
+		}
+		Reallocate( array, std::min( array->capacity * 2, m_maxLayerCapacity ) );
+	}
+
+	layer = array->layerCount++;
+	return true;
+}
+
+OpenGLTextureArray* OpenGLTextureArrayPool::CreateArray( const GLenum internalFormat, const int width, const int height, const int levels )
+{
+	OpenGLTextureArray* array = new OpenGLTextureArray();
+	array->internalFormat = internalFormat;
+	array->width = width;
+	array->height = height;
+	array->levels = levels;
+	array->texture = 0;
+	array->capacity = 0;
+	array->layerCount = 0;
+
+	Reallocate( array, m_initialLayerCapacity );
+	if ( array->texture == 0 )
+	{
+		delete array;
+		return nullptr;
+	}
+
+	m_arrays.push_back( array );
+
+	DEBUG_LOG( LOG::INFO, "Created texture array of " + std::to_string( width ) + "x" + std::to_string( height ) + " layers, " + std::to_string( m_arrays.size() ) + " arrays in total" );
+	CONSOLE_LOG( LOG::INFO, "Created texture array of " + std::to_string( width ) + "x" + std::to_string( height ) + " layers, " + std::to_string( m_arrays.size() ) + " arrays in total" );
+
+	return array;
+}
+
+void OpenGLTextureArrayPool::DestroyArray( OpenGLTextureArray* array )
+{
+	if ( array->texture != 0 )
+	{
+		OpenGLStateCache::Get()->DeleteTextures( 1, &array->texture );
+	}
+	delete array;
+}
+
+// Creates the array's texture with room for the passed number of layers, copying the layers it already holds
+// Draws already issued with the old texture still read it, GL only deletes it once they are done
+void OpenGLTextureArrayPool::Reallocate( OpenGLTextureArray* array, const uint32_t capacity )
+{
+	OpenGLStateCache* stateCache = OpenGLStateCache::Get();
+
+	GLuint texture = 0;
+	glGenTextures( 1, &texture );
+	stateCache->BindTexture( 0, GL_TEXTURE_2D_ARRAY, texture );
+	glTexStorage3D( GL_TEXTURE_2D_ARRAY, array->levels, array->internalFormat, array->width, array->height, static_cast<GLsizei>( capacity ) );
+
+	glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, array->levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+
+	for ( uint32_t layer = 0; layer < array->layerCount; ++layer )
+	{
+		CopyLayer( *array, array->texture, GL_TEXTURE_2D_ARRAY, layer, texture, layer );
+	}
+
+	if ( array->texture != 0 )
+	{
+		stateCache->DeleteTextures( 1, &array->texture );
+	}
+
+	array->texture = texture;
+	array->capacity = capacity;
+}
+
+// Copies every level of a layer between two textures, either of which may be a 2D texture at layer 0
+void OpenGLTextureArrayPool::CopyLayer( const OpenGLTextureArray& array, const GLuint source, const GLenum sourceTarget, const uint32_t sourceLayer, const GLuint destination, const uint32_t destinationLayer )
+{
+	// Compressed levels smaller than a block are copied whole, which GL allows as the region reaches the level's edge
+	for ( int level = 0; level < array.levels; ++level )
+	{
+		glCopyImageSubData(
+			source, sourceTarget, level, 0, 0, static_cast<GLint>( sourceLayer ),
+			destination, GL_TEXTURE_2D_ARRAY, level, 0, 0, static_cast<GLint>( destinationLayer ),
+			std::max( array.width >> level, 1 ),
+			std::max( array.height >> level, 1 ),
+			1
+		);
+	}
+}
@@ -0,0 +1,92 @@
+#ifndef OPENGLTEXTUREARRAYPOOL_H
+#define OPENGLTEXTUREARRAYPOOL_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 2D array texture holding every image of one format, size and mip count, each image is a layer of it
+struct OpenGLTextureArray
+{
+	GLenum					internalFormat;
+	int						width;
+	int						height;
+	int						levels;
+	GLuint					texture;		// Replaced when the array grows
+	uint32_t				capacity;		// Layers the texture has storage for
+	uint32_t				layerCount;		// Layers handed out so far, including freed ones
+	std::vector<uint32_t>	freeLayers;
+};
+
+// Where a texture's image lives, the array's texture and the layer are all a draw needs to sample it
+struct OpenGLTextureLayer
+{
+	OpenGLTextureArray*		array;
+	uint32_t				layer;
+
+	bool IsValid() const { return array != nullptr; }
+};
+
+// Singleton packing textures into a few 2D array textures, render thread only
+// Textures with the same format, size and mip count share an array, so draws with different textures can still be
+// issued as one multi draw, each reading its layer from its object data instead of binding its own texture
+class OpenGLTextureArrayPool
+{
+
+	OpenGLTextureArrayPool( const OpenGLTextureArrayPool& ) = delete;
+	OpenGLTextureArrayPool& operator=( const OpenGLTextureArrayPool& ) = delete;
+	OpenGLTextureArrayPool( OpenGLTextureArrayPool&& ) = delete;
+	OpenGLTextureArrayPool& operator=( OpenGLTextureArrayPool&& ) = delete;
+
+public:
+
+	// Layers an array is created with, it doubles whenever it is full until it holds m_maxLayerCapacity
+	static constexpr uint32_t m_initialLayerCapacity = 4;
+	static constexpr uint32_t m_maxLayerCapacity = 256;
+
+	// Get Instance of OpenGL Texture Array Pool
+	static OpenGLTextureArrayPool* Get();
+
+	// Copies every level of the passed 2D texture into a free layer of an array with the same format, size and mip count
+	// The 2D texture is left as it is and can be deleted afterwards. Returns an invalid layer if no array could be created
+	OpenGLTextureLayer Acquire( const GLuint texture, const GLenum internalFormat, const int width, const int height, const int levels );
+
+	// Hands the layer back to its array, the next texture acquired from the array may overwrite it
+	void Release( const OpenGLTextureLayer& layer );
+
+	// Layer of a 1x1 array holding a single white texel, drawn with until a texture's image is resident
+	OpenGLTextureLayer GetPlaceholder();
+
+	// Deletes every array, layers handed out before this are no longer valid
+	void OnDestroy();
+
+	size_t GetArrayCount() const { return m_arrays.size(); }
+
+private:
+
+	OpenGLTextureArrayPool();
+	~OpenGLTextureArrayPool();
+
+	static std::unique_ptr<OpenGLTextureArrayPool> g_openGLTextureArrayPoolInstance;
+	friend std::default_delete<OpenGLTextureArrayPool>;
+
+	std::vector<OpenGLTextureArray*>	m_arrays;
+	OpenGLTextureArray*					m_placeholder;
+
+	// Returns a free layer of the passed array, growing it first if every layer is in use. Returns false if it is full
+	bool AllocateLayer( OpenGLTextureArray* array, uint32_t& layer );
+
+	OpenGLTextureArray* CreateArray( const GLenum internalFormat, const int width, const int height, const int levels );
+	void DestroyArray( OpenGLTextureArray* array );
+
+	// Creates the array's texture with room for the passed number of layers, copying the layers it already holds
+	void Reallocate( OpenGLTextureArray* array, const uint32_t capacity );
+
+	// Copies every level of a layer between two textures, either of which may be a 2D texture at layer 0
+	static void CopyLayer( const OpenGLTextureArray& array, const GLuint source, const GLenum sourceTarget, const uint32_t sourceLayer, const GLuint destination, const uint32_t destinationLayer );
+
+};
+
+#endif // !OPENGLTEXTUREARRAYPOOL_H
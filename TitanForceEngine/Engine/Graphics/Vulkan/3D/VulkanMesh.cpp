@@ -1,14 +1,152 @@
 #include "VulkanMesh.h"
+#include "../VulkanUploader.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <string>
+
+std::unordered_map<const SubMesh*, std::weak_ptr<VulkanMeshBuffer>> VulkanMesh::g_meshBuffers;
+
+namespace
+{
+	// Vertex buffer offsets have no alignment requirement, index buffer offsets need a multiple of the index size
+	VkDeviceSize AlignUp( const VkDeviceSize value, const VkDeviceSize alignment )
+	{
+		return ( ( value + alignment - 1 ) / alignment ) * alignment;
+	}
+}
 
 VulkanMesh::VulkanMesh( const char* objFileName ) :
-	IMesh( objFileName )
-{}
+	IMesh( objFileName ),
+	m_buffer()
+{
+	// Buffers are generated once the AssetLoader has finished loading the sub mesh
+}
 
 VulkanMesh::~VulkanMesh()
-{}
+{
+	VulkanUploader::Get()->Cancel( this );
+	m_buffer.reset();
+}
 
 void VulkanMesh::GenerateBuffers()
-{}
+{
+	std::weak_ptr<VulkanMeshBuffer>& shared = g_meshBuffers[m_subMesh.get()];
+	m_buffer = shared.lock();
+	if ( m_buffer == nullptr )
+	{
+		m_buffer = CreateBuffer( m_subMesh.get() );
+		shared = m_buffer;
+	}
+
+	if ( m_buffer == nullptr )
+	{
+		return;
+	}
+
+	// The mesh starts drawing once the staging copies into its buffer have finished
+	if ( m_buffer->isResident )
+	{
+		m_isReady = true;
+		return;
+	}
+
+	VulkanUploader::Get()->OnComplete(
+		this,
+		[this]()
+		{
+			m_isReady = true;
+		}
+	);
+}
 
 void VulkanMesh::Render()
 {}
+
+void VulkanMesh::RenderDepthOnly()
+{}
+
+// Binds the mesh's vertex streams and indices. Only reads the mesh, so it may be called from any thread
+void VulkanMesh::Bind( VkCommandBuffer commandBuffer ) const
+{
+	const VkBuffer buffers[VertexLayout::m_maxStreams] = { m_buffer->buffer.buffer, m_buffer->buffer.buffer };
+	vkCmdBindVertexBuffers( commandBuffer, 0, VertexLayout::m_maxStreams, buffers, m_buffer->streamOffsets );
+	vkCmdBindIndexBuffer( commandBuffer, m_buffer->buffer.buffer, m_buffer->indexOffset, m_buffer->indexType );
+}
+
+// Records a draw of the passed range of a level of detail, the mesh must be bound
+void VulkanMesh::Draw( VkCommandBuffer commandBuffer, const MeshRange& range ) const
+{
+	vkCmdDrawIndexed( commandBuffer, range.indexCount, 1, range.firstIndex, 0, 0 );
+}
+
+// Creates the buffer for m_subMesh and queues its data through the VulkanUploader
+std::shared_ptr<VulkanMeshBuffer> VulkanMesh::CreateBuffer( const SubMesh* subMesh )
+{
+	VkDeviceSize size = 0;
+	VkDeviceSize streamOffsets[VertexLayout::m_maxStreams] = {};
+	for ( uint32_t stream = 0; stream < VertexLayout::m_maxStreams; ++stream )
+	{
+		streamOffsets[stream] = size;
+		size += subMesh->vertexStreams[stream].size;
+	}
+	const VkDeviceSize indexOffset = AlignUp( size, 4 );
+	size = indexOffset + subMesh->indexStream.size;
+
+	VulkanBuffer buffer = VulkanDevice::Get()->CreateBuffer(
+		size,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+	);
+	if ( !buffer.IsValid() )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to create a mesh buffer of " + std::to_string( size ) + " bytes" );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to create a mesh buffer of " + std::to_string( size ) + " bytes" );
+		return nullptr;
+	}
+
+	// Frames still in flight may be drawing the buffer when the last mesh using it is deleted
+	const SubMesh* key = subMesh;
+	std::shared_ptr<VulkanMeshBuffer> meshBuffer(
+		new VulkanMeshBuffer(),
+		[key]( VulkanMeshBuffer* meshBuffer )
+		{
+			VulkanUploader::Get()->Cancel( meshBuffer );
+			if ( VulkanDevice::Get()->IsCreated() )
+			{
+				VulkanDevice::Get()->RetireBuffer( meshBuffer->buffer );
+			}
+
+			auto shared = g_meshBuffers.find( key );
+			if ( shared != g_meshBuffers.end() && shared->second.expired() )
+			{
+				g_meshBuffers.erase( shared );
+			}
+			delete meshBuffer;
+		}
+	);
+
+	meshBuffer->buffer = buffer;
+	meshBuffer->indexOffset = indexOffset;
+	meshBuffer->indexType = subMesh->indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	meshBuffer->isResident = false;
+
+	VulkanUploader* uploader = VulkanUploader::Get();
+	for ( uint32_t stream = 0; stream < VertexLayout::m_maxStreams; ++stream )
+	{
+		meshBuffer->streamOffsets[stream] = streamOffsets[stream];
+		uploader->WriteBuffer( buffer.buffer, streamOffsets[stream], subMesh->vertexStreams[stream].data, subMesh->vertexStreams[stream].size );
+	}
+	uploader->WriteBuffer( buffer.buffer, indexOffset, subMesh->indexStream.data, subMesh->indexStream.size );
+
+	VulkanMeshBuffer* resident = meshBuffer.get();
+	uploader->OnComplete(
+		resident,
+		[resident]()
+		{
+			resident->isResident = true;
+		}
+	);
+
+	return meshBuffer;
+}
@@ -1,8 +1,23 @@
 #ifndef VULKANMESH_H
 #define VULKANMESH_H
 
+#include "../VulkanDevice.h"
 #include "../../../RenderCore/3D/Mesh.h"
 
+#include <memory>
+#include <unordered_map>
+
+// Device local buffer holding a sub mesh's vertex streams followed by its indices
+// Shared by every mesh loaded from the same file, and retired once the last of them is gone
+struct VulkanMeshBuffer
+{
+	VulkanBuffer	buffer;
+	VkDeviceSize	streamOffsets[VertexLayout::m_maxStreams];
+	VkDeviceSize	indexOffset;
+	VkIndexType		indexType;
+	bool			isResident;		// True once the staging copies into the buffer have finished
+};
+
 class VulkanMesh : public IMesh
 {
 
@@ -13,7 +28,30 @@ public:
 
 	virtual void GenerateBuffers() override final;
 
+	// Vulkan draws are recorded into command buffers by VulkanRenderer, see Bind and Draw
 	virtual void Render() override final;
+
+	virtual void RenderDepthOnly() override final;
+
+	// Null until the sub mesh has been loaded
+	const VulkanMeshBuffer* GetBuffer() const { return m_buffer.get(); }
+
+	// Binds the mesh's vertex streams and indices. Only reads the mesh, so it may be called from any thread
+	void Bind( VkCommandBuffer commandBuffer ) const;
+
+	// Records a draw of the passed range of a level of detail, the mesh must be bound
+	void Draw( VkCommandBuffer commandBuffer, const MeshRange& range ) const;
+
+private:
+
+	std::shared_ptr<VulkanMeshBuffer>	m_buffer;
+
+	// Buffers of every loaded sub mesh, so meshes loaded from the same file share one. Render thread only
+	static std::unordered_map<const SubMesh*, std::weak_ptr<VulkanMeshBuffer>> g_meshBuffers;
+
+	// Creates the buffer for m_subMesh and queues its data through the VulkanUploader
+	static std::shared_ptr<VulkanMeshBuffer> CreateBuffer( const SubMesh* subMesh );
+
 };
 
 #endif // !VULKANMESH_H
@@ -0,0 +1,350 @@
+#include "VulkanTexture2D.h"
+#include "../VulkanUploader.h"
+
+#include "../../../RenderCore/Loading/AssetLoader.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <string>
+
+VkDescriptorSetLayout VulkanTexture2D::g_descriptorSetLayout = VK_NULL_HANDLE;
+VkDescriptorPool VulkanTexture2D::g_descriptorPool = VK_NULL_HANDLE;
+VkSampler VulkanTexture2D::g_sampler = VK_NULL_HANDLE;
+VulkanImage VulkanTexture2D::g_placeholderImage = {};
+VkDescriptorSet VulkanTexture2D::g_placeholderSet = VK_NULL_HANDLE;
+std::vector<VulkanTexture2D::RetiredSet> VulkanTexture2D::g_retiredSets;
+
+namespace
+{
+	// Three channel images cannot be sampled on every device, so every image is stored as RGBA
+	std::vector<unsigned char> ExpandToRgba( const TextureData& data )
+	{
+		const size_t pixelCount = static_cast<size_t>( data.width ) * data.height;
+		std::vector<unsigned char> rgba( pixelCount * 4 );
+
+		for ( size_t i = 0; i < pixelCount; ++i )
+		{
+			const unsigned char* source = data.pixels + i * data.channels;
+			unsigned char* destination = &rgba[i * 4];
+
+			// One and two channel images are grey, with alpha in the second channel
+			const bool isGrey = data.channels < 3;
+			destination[0] = source[0];
+			destination[1] = isGrey ? source[0] : source[1];
+			destination[2] = isGrey ? source[0] : source[2];
+			destination[3] = ( data.channels == 2 || data.channels == 4 ) ? source[data.channels - 1] : 255;
+		}
+
+		return rgba;
+	}
+}
+
+VulkanTexture2D::VulkanTexture2D( const char* fileName ) :
+	Texture2D( fileName ),
+	m_image(),
+	m_descriptorSet( VK_NULL_HANDLE ),
+	m_pendingImage()
+{
+	if ( m_fileName == "" )
+	{
+		return;
+	}
+
+	AssetLoader::Get()->LoadTexture( this, m_fileName );
+}
+
+VulkanTexture2D::~VulkanTexture2D()
+{
+	VulkanUploader::Get()->Cancel( this );
+
+	// Frames still in flight may be sampling the image, and the uploader may still be copying into the pending one
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	if ( vulkanDevice->IsCreated() )
+	{
+		vulkanDevice->RetireImage( m_image );
+		vulkanDevice->RetireImage( m_pendingImage );
+	}
+
+	// Destroying the pool already freed the set
+	if ( g_descriptorPool != VK_NULL_HANDLE )
+	{
+		RetireDescriptorSet( m_descriptorSet );
+	}
+}
+
+// Decodes the texture immediately, blocking the calling thread
+void VulkanTexture2D::GenerateTexture()
+{
+	if ( m_fileName == "" )
+	{
+		return;
+	}
+
+	std::shared_ptr<TextureData> data = Decode( m_fileName );
+	if ( data )
+	{
+		Upload( data );
+	}
+}
+
+void VulkanTexture2D::Bind()
+{}
+
+void VulkanTexture2D::Unbind()
+{}
+
+void VulkanTexture2D::Upload( const std::shared_ptr<TextureData>& data )
+{
+	// VulkanRenderer never enables block compression, so Decode only returns uncompressed pixels
+	if ( data->format != ETextureFormat::Uncompressed )
+	{
+		DEBUG_LOG( LOG::WARNING, "Vulkan textures cannot be block compressed yet: " + m_fileName );
+		CONSOLE_LOG( LOG::WARNING, "Vulkan textures cannot be block compressed yet: " + m_fileName );
+		return;
+	}
+
+	m_width = data->width;
+	m_height = data->height;
+
+	if ( g_descriptorPool == VK_NULL_HANDLE )
+	{
+		return;
+	}
+
+	// A newer image replaces one still being copied, the current one is drawn until the newer one is resident
+	VulkanUploader* uploader = VulkanUploader::Get();
+	uploader->Cancel( this );
+	VulkanDevice::Get()->RetireImage( m_pendingImage );
+
+	m_pendingImage = CreateImage( *data );
+	if ( !m_pendingImage.IsValid() )
+	{
+		return;
+	}
+
+	uploader->OnComplete(
+		this,
+		[this]()
+		{
+			MakePendingImageCurrent();
+		}
+	);
+}
+
+// Creates the descriptor set layout, pool and sampler shared by every texture, and the placeholder
+// The device and the VulkanUploader must already be created
+bool VulkanTexture2D::CreateSharedResources()
+{
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	const VkDevice device = vulkanDevice->GetDevice();
+
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+
+	// Sets are never freed one by one, retired sets are reused instead, see AllocateDescriptorSet
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = m_maxDescriptorSets + 1;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = m_maxDescriptorSets + 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	// Images have a single level, so there are no mips to filter between
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.maxLod = 0.0f;
+
+	if ( vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &g_descriptorSetLayout ) != VK_SUCCESS ||
+		vkCreateDescriptorPool( device, &poolInfo, nullptr, &g_descriptorPool ) != VK_SUCCESS ||
+		vkCreateSampler( device, &samplerInfo, nullptr, &g_sampler ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan texture descriptors!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan texture descriptors!" );
+		return false;
+	}
+
+	// Copied with the first batch of uploads, which is submitted ahead of the first frame
+	TextureData white;
+	unsigned char pixel[4] = { 255, 255, 255, 255 };
+	white.width = 1;
+	white.height = 1;
+	white.channels = 4;
+	white.pixels = pixel;
+
+	g_placeholderImage = CreateImage( white );
+	white.pixels = nullptr;
+
+	if ( g_placeholderImage.IsValid() )
+	{
+		g_placeholderSet = AllocateDescriptorSet( g_placeholderImage );
+	}
+
+	if ( g_placeholderSet == VK_NULL_HANDLE )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create the Vulkan placeholder texture!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create the Vulkan placeholder texture!" );
+		return false;
+	}
+
+	return true;
+}
+
+// Destroys what CreateSharedResources created, the device must be idle
+void VulkanTexture2D::DestroySharedResources()
+{
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	const VkDevice device = vulkanDevice->GetDevice();
+
+	// Destroying the pool frees every set allocated from it
+	vkDestroyDescriptorPool( device, g_descriptorPool, nullptr );
+	vkDestroyDescriptorSetLayout( device, g_descriptorSetLayout, nullptr );
+	vkDestroySampler( device, g_sampler, nullptr );
+	vulkanDevice->DestroyImage( g_placeholderImage );
+
+	g_descriptorPool = VK_NULL_HANDLE;
+	g_descriptorSetLayout = VK_NULL_HANDLE;
+	g_sampler = VK_NULL_HANDLE;
+	g_placeholderSet = VK_NULL_HANDLE;
+	g_retiredSets.clear();
+}
+
+// Creates a device local image of the decoded size and queues the copy of its pixels, expanded to RGBA
+VulkanImage VulkanTexture2D::CreateImage( const TextureData& data )
+{
+	const uint32_t width = static_cast<uint32_t>( data.width );
+	const uint32_t height = static_cast<uint32_t>( data.height );
+
+	VulkanImage image = VulkanDevice::Get()->CreateImage(
+		width,
+		height,
+		VK_FORMAT_R8G8B8A8_UNORM,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT
+	);
+	if ( !image.IsValid() )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to create a " + std::to_string( width ) + "x" + std::to_string( height ) + " texture image" );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to create a " + std::to_string( width ) + "x" + std::to_string( height ) + " texture image" );
+		return VulkanImage{};
+	}
+
+	const size_t size = static_cast<size_t>( width ) * height * 4;
+
+	bool isQueued = false;
+	if ( data.channels == 4 )
+	{
+		isQueued = VulkanUploader::Get()->WriteImage( image, width, height, data.pixels, size );
+	}
+	else
+	{
+		const std::vector<unsigned char> rgba = ExpandToRgba( data );
+		isQueued = VulkanUploader::Get()->WriteImage( image, width, height, rgba.data(), size );
+	}
+
+	// Nothing has been recorded into the image if its copy could not be queued
+	if ( !isQueued )
+	{
+		VulkanDevice::Get()->DestroyImage( image );
+	}
+
+	return image;
+}
+
+// Returns a set sampling the passed image, reusing a retired set no frame can be reading any more
+// Returns VK_NULL_HANDLE if every set is in use
+VkDescriptorSet VulkanTexture2D::AllocateDescriptorSet( const VulkanImage& image )
+{
+	const VkDevice device = VulkanDevice::Get()->GetDevice();
+	const uint64_t frameIndex = VulkanDevice::Get()->GetFrameIndex();
+
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	for ( size_t i = 0; i < g_retiredSets.size(); ++i )
+	{
+		if ( g_retiredSets[i].releaseFrame <= frameIndex )
+		{
+			descriptorSet = g_retiredSets[i].descriptorSet;
+			g_retiredSets[i] = g_retiredSets.back();
+			g_retiredSets.pop_back();
+			break;
+		}
+	}
+
+	if ( descriptorSet == VK_NULL_HANDLE )
+	{
+		VkDescriptorSetAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = g_descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &g_descriptorSetLayout;
+
+		if ( vkAllocateDescriptorSets( device, &allocateInfo, &descriptorSet ) != VK_SUCCESS )
+		{
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.sampler = g_sampler;
+	imageInfo.imageView = image.view;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = descriptorSet;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets( device, 1, &write, 0, nullptr );
+
+	return descriptorSet;
+}
+
+// Hands the set back once every frame that may still be drawing with it has finished
+void VulkanTexture2D::RetireDescriptorSet( VkDescriptorSet& descriptorSet )
+{
+	if ( descriptorSet != VK_NULL_HANDLE )
+	{
+		g_retiredSets.push_back( RetiredSet{ descriptorSet, VulkanDevice::Get()->GetFrameIndex() + VulkanDevice::m_frameCount } );
+	}
+	descriptorSet = VK_NULL_HANDLE;
+}
+
+// Retires the sampled image and its set, then samples the pending image instead
+void VulkanTexture2D::MakePendingImageCurrent()
+{
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+
+	const VkDescriptorSet descriptorSet = AllocateDescriptorSet( m_pendingImage );
+	if ( descriptorSet == VK_NULL_HANDLE )
+	{
+		DEBUG_LOG( LOG::WARNING, "Out of Vulkan texture descriptor sets, drawing with the placeholder: " + m_fileName );
+		CONSOLE_LOG( LOG::WARNING, "Out of Vulkan texture descriptor sets, drawing with the placeholder: " + m_fileName );
+		vulkanDevice->RetireImage( m_pendingImage );
+		return;
+	}
+
+	RetireDescriptorSet( m_descriptorSet );
+	vulkanDevice->RetireImage( m_image );
+
+	m_image = m_pendingImage;
+	m_pendingImage = VulkanImage{};
+	m_descriptorSet = descriptorSet;
+}
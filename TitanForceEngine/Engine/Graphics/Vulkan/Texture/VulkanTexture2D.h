@@ -0,0 +1,86 @@
+#ifndef VULKAN_TEXTURE_2D_H
+#define VULKAN_TEXTURE_2D_H
+
+#include "../VulkanDevice.h"
+#include "../../../RenderCore/Texture/Texture2D.h"
+
+#include <cstdint>
+#include <vector>
+
+// Texture sampled by VulkanRenderer through a descriptor set of its own, at set 0 binding 0 of the fragment shader
+// Until its image has been decoded and copied to the GPU the texture is drawn with a white placeholder
+class VulkanTexture2D : public Texture2D
+{
+public:
+
+	// Textures that can have a descriptor set at once, the rest are drawn with the placeholder
+	static constexpr uint32_t m_maxDescriptorSets = 1024;
+
+	VulkanTexture2D( const char* fileName );
+	~VulkanTexture2D();
+
+	virtual void GenerateTexture() override;
+
+	// Vulkan textures are bound by VulkanRenderer, see GetDescriptorSet
+	virtual void Bind() override;
+	virtual void Unbind() override;
+
+	virtual void Upload( const std::shared_ptr<TextureData>& data ) override;
+
+	// Set sampling the texture's image, or the placeholder's until the image is resident
+	// Only changed from VulkanUploader::ProcessCompleted, so it may be read while slices are recorded
+	VkDescriptorSet GetDescriptorSet() const { return m_descriptorSet != VK_NULL_HANDLE ? m_descriptorSet : g_placeholderSet; }
+
+	// Creates the descriptor set layout, pool and sampler shared by every texture, and the placeholder
+	// The device and the VulkanUploader must already be created
+	static bool CreateSharedResources();
+
+	// Destroys what CreateSharedResources created, the device must be idle
+	static void DestroySharedResources();
+
+	static VkDescriptorSetLayout GetDescriptorSetLayout() { return g_descriptorSetLayout; }
+
+	// Set of the white placeholder, for models without a texture
+	static VkDescriptorSet GetPlaceholderSet() { return g_placeholderSet; }
+
+private:
+
+	// Image being sampled and the set sampling it
+	VulkanImage		m_image;
+	VkDescriptorSet	m_descriptorSet;
+
+	// Image still being copied to the GPU, replaces m_image once the copy has finished
+	VulkanImage		m_pendingImage;
+
+	static VkDescriptorSetLayout	g_descriptorSetLayout;
+	static VkDescriptorPool			g_descriptorPool;
+	static VkSampler				g_sampler;
+	static VulkanImage				g_placeholderImage;
+	static VkDescriptorSet			g_placeholderSet;
+
+	// Sets of destroyed or replaced textures, with the frame no draw recorded before it can still be reading them
+	struct RetiredSet
+	{
+		VkDescriptorSet	descriptorSet;
+		uint64_t		releaseFrame;
+	};
+
+	static std::vector<RetiredSet>	g_retiredSets;
+
+	// Creates a device local image of the decoded size and queues the copy of its pixels, expanded to RGBA
+	static VulkanImage CreateImage( const TextureData& data );
+
+	// Returns a set sampling the passed image, reusing a retired set no frame can be reading any more
+	// Returns VK_NULL_HANDLE if every set is in use
+	static VkDescriptorSet AllocateDescriptorSet( const VulkanImage& image );
+
+	// Hands the set back once every frame that may still be drawing with it has finished
+	static void RetireDescriptorSet( VkDescriptorSet& descriptorSet );
+
+	// Retires the sampled image and its set, then samples the pending image instead
+	void MakePendingImageCurrent();
+
+};
+
+
+#endif // !VULKAN_TEXTURE_2D_H
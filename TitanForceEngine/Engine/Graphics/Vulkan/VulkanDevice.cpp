@@ -0,0 +1,561 @@
+#include "VulkanDevice.h"
+
+#include "../../Devices/Window.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+std::unique_ptr<VulkanDevice> VulkanDevice::g_vulkanDeviceInstance( nullptr );
+
+namespace
+{
+	constexpr const char* g_validationLayerName = "VK_LAYER_KHRONOS_validation";
+
+	VKAPI_ATTR VkBool32 VKAPI_CALL OnValidationMessage(
+		VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+		VkDebugUtilsMessageTypeFlagsEXT type,
+		const VkDebugUtilsMessengerCallbackDataEXT* callbackData,
+		void* userData )
+	{
+		if ( severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT )
+		{
+			DEBUG_LOG( LOG::ERRORLOG, std::string( "Vulkan: " ) + callbackData->pMessage );
+			CONSOLE_LOG( LOG::ERRORLOG, std::string( "Vulkan: " ) + callbackData->pMessage );
+		}
+		else if ( severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT )
+		{
+			DEBUG_LOG( LOG::WARNING, std::string( "Vulkan: " ) + callbackData->pMessage );
+			CONSOLE_LOG( LOG::WARNING, std::string( "Vulkan: " ) + callbackData->pMessage );
+		}
+		return VK_FALSE;
+	}
+}
+
+VulkanDevice::VulkanDevice() :
+	m_instance( VK_NULL_HANDLE ),
+	m_debugMessenger( VK_NULL_HANDLE ),
+	m_surface( VK_NULL_HANDLE ),
+	m_physicalDevice( VK_NULL_HANDLE ),
+	m_properties(),
+	m_memoryProperties(),
+	m_device( VK_NULL_HANDLE ),
+	m_queue( VK_NULL_HANDLE ),
+	m_queueFamily( 0 ),
+	m_retiredBuffers(),
+	m_retiredImages(),
+	m_frameIndex( 0 )
+{}
+
+VulkanDevice::~VulkanDevice()
+{
+	OnDestroy();
+}
+
+// Get Instance of Vulkan Device
+VulkanDevice* VulkanDevice::Get()
+{
+	if ( g_vulkanDeviceInstance == nullptr )
+	{
+		g_vulkanDeviceInstance.reset( new VulkanDevice );
+	}
+	return g_vulkanDeviceInstance.get();
+}
+
+// Creates the instance, the window's surface unless the window is headless, and a device with a graphics queue
+// that can present to that surface. Validation layers are only enabled when they are installed
+bool VulkanDevice::OnCreate( const char* applicationName, const char* engineName, const int version, const bool enableValidationLayers, Window* window )
+{
+	const bool isHeadless = window->IsHeadless();
+
+	if ( !CreateInstance( applicationName, engineName, version, enableValidationLayers, isHeadless ) )
+	{
+		return false;
+	}
+
+	if ( !isHeadless && glfwCreateWindowSurface( m_instance, window->GetGLFW_Window(), nullptr, &m_surface ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan surface!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan surface!" );
+		return false;
+	}
+
+	if ( !PickPhysicalDevice() || !CreateDevice( isHeadless ) )
+	{
+		return false;
+	}
+
+	DEBUG_LOG( LOG::INFO, std::string( "Vulkan device: " ) + m_properties.deviceName + ", API " + std::to_string( VK_VERSION_MAJOR( m_properties.apiVersion ) ) + "." + std::to_string( VK_VERSION_MINOR( m_properties.apiVersion ) ) );
+	CONSOLE_LOG( LOG::INFO, std::string( "Vulkan device: " ) + m_properties.deviceName + ", API " + std::to_string( VK_VERSION_MAJOR( m_properties.apiVersion ) ) + "." + std::to_string( VK_VERSION_MINOR( m_properties.apiVersion ) ) );
+
+	return true;
+}
+
+// Waits for the device to be idle and destroys everything, buffers and images created through it must be gone first
+void VulkanDevice::OnDestroy()
+{
+	if ( m_device != VK_NULL_HANDLE )
+	{
+		vkDeviceWaitIdle( m_device );
+		for ( RetiredBuffer& retired : m_retiredBuffers )
+		{
+			DestroyBuffer( retired.buffer );
+		}
+		m_retiredBuffers.clear();
+		for ( RetiredImage& retired : m_retiredImages )
+		{
+			DestroyImage( retired.image );
+		}
+		m_retiredImages.clear();
+
+		vkDestroyDevice( m_device, nullptr );
+		m_device = VK_NULL_HANDLE;
+		m_queue = VK_NULL_HANDLE;
+	}
+
+	if ( m_surface != VK_NULL_HANDLE )
+	{
+		vkDestroySurfaceKHR( m_instance, m_surface, nullptr );
+		m_surface = VK_NULL_HANDLE;
+	}
+
+	if ( m_debugMessenger != VK_NULL_HANDLE )
+	{
+		PFN_vkDestroyDebugUtilsMessengerEXT destroyMessenger =
+			reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>( vkGetInstanceProcAddr( m_instance, "vkDestroyDebugUtilsMessengerEXT" ) );
+		if ( destroyMessenger )
+		{
+			destroyMessenger( m_instance, m_debugMessenger, nullptr );
+		}
+		m_debugMessenger = VK_NULL_HANDLE;
+	}
+
+	if ( m_instance != VK_NULL_HANDLE )
+	{
+		vkDestroyInstance( m_instance, nullptr );
+		m_instance = VK_NULL_HANDLE;
+	}
+
+	m_physicalDevice = VK_NULL_HANDLE;
+}
+
+// Returns the index of a memory type allowed by typeBits with every passed property, or UINT32_MAX if there is none
+uint32_t VulkanDevice::FindMemoryType( const uint32_t typeBits, const VkMemoryPropertyFlags properties ) const
+{
+	for ( uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i )
+	{
+		if ( ( typeBits & ( 1u << i ) ) && ( m_memoryProperties.memoryTypes[i].propertyFlags & properties ) == properties )
+		{
+			return i;
+		}
+	}
+	return UINT32_MAX;
+}
+
+// Creates a buffer with memory of the passed properties, host visible buffers are mapped straight away
+// Returns an invalid buffer if either cannot be created
+VulkanBuffer VulkanDevice::CreateBuffer( const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties )
+{
+	VulkanBuffer result = {};
+	result.size = size;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if ( vkCreateBuffer( m_device, &bufferInfo, nullptr, &result.buffer ) != VK_SUCCESS )
+	{
+		return VulkanBuffer{};
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements( m_device, result.buffer, &requirements );
+
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = FindMemoryType( requirements.memoryTypeBits, properties );
+
+	if ( allocateInfo.memoryTypeIndex == UINT32_MAX ||
+		vkAllocateMemory( m_device, &allocateInfo, nullptr, &result.memory ) != VK_SUCCESS )
+	{
+		DestroyBuffer( result );
+		return VulkanBuffer{};
+	}
+
+	vkBindBufferMemory( m_device, result.buffer, result.memory, 0 );
+
+	if ( ( properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) &&
+		vkMapMemory( m_device, result.memory, 0, VK_WHOLE_SIZE, 0, &result.mapped ) != VK_SUCCESS )
+	{
+		DestroyBuffer( result );
+		return VulkanBuffer{};
+	}
+
+	return result;
+}
+
+void VulkanDevice::DestroyBuffer( VulkanBuffer& buffer )
+{
+	// Freeing the memory unmaps it
+	if ( buffer.buffer != VK_NULL_HANDLE )
+	{
+		vkDestroyBuffer( m_device, buffer.buffer, nullptr );
+	}
+	if ( buffer.memory != VK_NULL_HANDLE )
+	{
+		vkFreeMemory( m_device, buffer.memory, nullptr );
+	}
+	buffer = VulkanBuffer{};
+}
+
+// Destroys the buffer once every frame that may still read it has finished, instead of straight away
+void VulkanDevice::RetireBuffer( VulkanBuffer& buffer )
+{
+	if ( buffer.IsValid() )
+	{
+		m_retiredBuffers.push_back( RetiredBuffer{ buffer, m_frameIndex + m_frameCount } );
+	}
+	buffer = VulkanBuffer{};
+}
+
+// Starts the passed frame, the renderer has waited for every frame m_frameCount or more before it
+// Buffers and images retired that long ago are destroyed. Render thread only
+void VulkanDevice::BeginFrame( const uint64_t frameIndex )
+{
+	m_frameIndex = frameIndex;
+
+	for ( size_t i = 0; i < m_retiredBuffers.size(); )
+	{
+		if ( m_retiredBuffers[i].releaseFrame <= frameIndex )
+		{
+			DestroyBuffer( m_retiredBuffers[i].buffer );
+			m_retiredBuffers[i] = m_retiredBuffers.back();
+			m_retiredBuffers.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	for ( size_t i = 0; i < m_retiredImages.size(); )
+	{
+		if ( m_retiredImages[i].releaseFrame <= frameIndex )
+		{
+			DestroyImage( m_retiredImages[i].image );
+			m_retiredImages[i] = m_retiredImages.back();
+			m_retiredImages.pop_back();
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+// Creates a single level 2D image in device local memory, with a view of the passed aspect
+VulkanImage VulkanDevice::CreateImage( const uint32_t width, const uint32_t height, const VkFormat format, const VkImageUsageFlags usage, const VkImageAspectFlags aspect )
+{
+	VulkanImage result = {};
+	result.format = format;
+
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = format;
+	imageInfo.extent = { width, height, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = usage;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if ( vkCreateImage( m_device, &imageInfo, nullptr, &result.image ) != VK_SUCCESS )
+	{
+		return VulkanImage{};
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements( m_device, result.image, &requirements );
+
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = requirements.size;
+	allocateInfo.memoryTypeIndex = FindMemoryType( requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT );
+
+	if ( allocateInfo.memoryTypeIndex == UINT32_MAX ||
+		vkAllocateMemory( m_device, &allocateInfo, nullptr, &result.memory ) != VK_SUCCESS )
+	{
+		DestroyImage( result );
+		return VulkanImage{};
+	}
+
+	vkBindImageMemory( m_device, result.image, result.memory, 0 );
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = result.image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = aspect;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	if ( vkCreateImageView( m_device, &viewInfo, nullptr, &result.view ) != VK_SUCCESS )
+	{
+		DestroyImage( result );
+		return VulkanImage{};
+	}
+
+	return result;
+}
+
+void VulkanDevice::DestroyImage( VulkanImage& image )
+{
+	if ( image.view != VK_NULL_HANDLE )
+	{
+		vkDestroyImageView( m_device, image.view, nullptr );
+	}
+	if ( image.image != VK_NULL_HANDLE )
+	{
+		vkDestroyImage( m_device, image.image, nullptr );
+	}
+	if ( image.memory != VK_NULL_HANDLE )
+	{
+		vkFreeMemory( m_device, image.memory, nullptr );
+	}
+	image = VulkanImage{};
+}
+
+// Destroys the image once every frame that may still sample it has finished, instead of straight away
+void VulkanDevice::RetireImage( VulkanImage& image )
+{
+	if ( image.IsValid() )
+	{
+		m_retiredImages.push_back( RetiredImage{ image, m_frameIndex + m_frameCount } );
+	}
+	image = VulkanImage{};
+}
+
+// Returns the most precise depth format the device supports as a depth attachment
+VkFormat VulkanDevice::FindDepthFormat() const
+{
+	const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT };
+
+	for ( const VkFormat format : candidates )
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties( m_physicalDevice, format, &properties );
+		if ( properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT )
+		{
+			return format;
+		}
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+bool VulkanDevice::CreateInstance( const char* applicationName, const char* engineName, const int version, const bool enableValidationLayers, const bool isHeadless )
+{
+	VkApplicationInfo applicationInfo = {};
+	applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	applicationInfo.pApplicationName = applicationName;
+	applicationInfo.applicationVersion = static_cast<uint32_t>( version );
+	applicationInfo.pEngineName = engineName;
+	applicationInfo.engineVersion = static_cast<uint32_t>( version );
+	applicationInfo.apiVersion = VK_API_VERSION_1_1;
+
+	// A headless instance never creates a surface, so it needs no window system extensions
+	std::vector<const char*> extensions;
+	if ( !isHeadless )
+	{
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions = glfwGetRequiredInstanceExtensions( &glfwExtensionCount );
+		if ( glfwExtensions == nullptr )
+		{
+			DEBUG_LOG( LOG::FATAL, "GLFW cannot present with Vulkan on this machine!" );
+			CONSOLE_LOG( LOG::FATAL, "GLFW cannot present with Vulkan on this machine!" );
+			return false;
+		}
+		extensions.assign( glfwExtensions, glfwExtensions + glfwExtensionCount );
+	}
+
+	std::vector<const char*> layers;
+	const bool hasValidation = enableValidationLayers && HasLayer( g_validationLayerName );
+	if ( hasValidation )
+	{
+		layers.push_back( g_validationLayerName );
+		extensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
+	}
+	else if ( enableValidationLayers )
+	{
+		DEBUG_LOG( LOG::WARNING, "Vulkan validation layers are not installed, running without them" );
+		CONSOLE_LOG( LOG::WARNING, "Vulkan validation layers are not installed, running without them" );
+	}
+
+	VkInstanceCreateInfo instanceInfo = {};
+	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceInfo.pApplicationInfo = &applicationInfo;
+	instanceInfo.enabledExtensionCount = static_cast<uint32_t>( extensions.size() );
+	instanceInfo.ppEnabledExtensionNames = extensions.data();
+	instanceInfo.enabledLayerCount = static_cast<uint32_t>( layers.size() );
+	instanceInfo.ppEnabledLayerNames = layers.data();
+
+	if ( vkCreateInstance( &instanceInfo, nullptr, &m_instance ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan instance!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan instance!" );
+		return false;
+	}
+
+	if ( hasValidation )
+	{
+		VkDebugUtilsMessengerCreateInfoEXT messengerInfo = {};
+		messengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+		messengerInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+		messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+		messengerInfo.pfnUserCallback = OnValidationMessage;
+
+		PFN_vkCreateDebugUtilsMessengerEXT createMessenger =
+			reinterpret_cast<PFN_vkCreateDebugUtilsMessengerEXT>( vkGetInstanceProcAddr( m_instance, "vkCreateDebugUtilsMessengerEXT" ) );
+		if ( createMessenger )
+		{
+			createMessenger( m_instance, &messengerInfo, nullptr, &m_debugMessenger );
+		}
+	}
+
+	return true;
+}
+
+// Picks a device with a queue that can draw, and present to the surface if there is one. GPUs are preferred
+// over CPU implementations
+bool VulkanDevice::PickPhysicalDevice()
+{
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices( m_instance, &deviceCount, nullptr );
+	std::vector<VkPhysicalDevice> devices( deviceCount );
+	vkEnumeratePhysicalDevices( m_instance, &deviceCount, devices.data() );
+
+	int bestScore = -1;
+	for ( VkPhysicalDevice device : devices )
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties( device, &properties );
+
+		int score = 0;
+		switch ( properties.deviceType )
+		{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		score = 4;	break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	score = 3;	break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		score = 2;	break;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:				score = 1;	break;
+		default:										score = 0;	break;
+		}
+
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties( device, &familyCount, nullptr );
+		std::vector<VkQueueFamilyProperties> families( familyCount );
+		vkGetPhysicalDeviceQueueFamilyProperties( device, &familyCount, families.data() );
+
+		for ( uint32_t family = 0; family < familyCount; ++family )
+		{
+			if ( !( families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT ) )
+			{
+				continue;
+			}
+
+			VkBool32 canPresent = VK_TRUE;
+			if ( m_surface != VK_NULL_HANDLE )
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR( device, family, m_surface, &canPresent );
+			}
+
+			if ( !canPresent )
+			{
+				continue;
+			}
+
+			if ( score > bestScore )
+			{
+				bestScore = score;
+				m_physicalDevice = device;
+				m_queueFamily = family;
+			}
+			break;
+		}
+	}
+
+	if ( m_physicalDevice == VK_NULL_HANDLE )
+	{
+		DEBUG_LOG( LOG::FATAL, "No Vulkan device can draw" + std::string( m_surface != VK_NULL_HANDLE ? " and present!" : "!" ) );
+		CONSOLE_LOG( LOG::FATAL, "No Vulkan device can draw" + std::string( m_surface != VK_NULL_HANDLE ? " and present!" : "!" ) );
+		return false;
+	}
+
+	vkGetPhysicalDeviceProperties( m_physicalDevice, &m_properties );
+	vkGetPhysicalDeviceMemoryProperties( m_physicalDevice, &m_memoryProperties );
+	return true;
+}
+
+bool VulkanDevice::CreateDevice( const bool isHeadless )
+{
+	const float priority = 1.0f;
+
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex = m_queueFamily;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &priority;
+
+	std::vector<const char*> extensions;
+	if ( !isHeadless )
+	{
+		extensions.push_back( VK_KHR_SWAPCHAIN_EXTENSION_NAME );
+	}
+
+	VkPhysicalDeviceFeatures features = {};
+
+	VkDeviceCreateInfo deviceInfo = {};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+	deviceInfo.enabledExtensionCount = static_cast<uint32_t>( extensions.size() );
+	deviceInfo.ppEnabledExtensionNames = extensions.data();
+	deviceInfo.pEnabledFeatures = &features;
+
+	if ( vkCreateDevice( m_physicalDevice, &deviceInfo, nullptr, &m_device ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan device!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan device!" );
+		return false;
+	}
+
+	vkGetDeviceQueue( m_device, m_queueFamily, 0, &m_queue );
+	return true;
+}
+
+// Returns true if the instance offers the passed layer
+bool VulkanDevice::HasLayer( const char* layerName )
+{
+	uint32_t layerCount = 0;
+	vkEnumerateInstanceLayerProperties( &layerCount, nullptr );
+	std::vector<VkLayerProperties> layers( layerCount );
+	vkEnumerateInstanceLayerProperties( &layerCount, layers.data() );
+
+	for ( const VkLayerProperties& layer : layers )
+	{
+		if ( std::strcmp( layer.layerName, layerName ) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
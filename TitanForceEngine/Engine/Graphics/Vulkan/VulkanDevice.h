@@ -0,0 +1,147 @@
+#ifndef VULKANDEVICE_H
+#define VULKANDEVICE_H
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Window;
+
+// A buffer and the memory bound to it, mapped for as long as it lives if it was created host visible
+struct VulkanBuffer
+{
+	VkBuffer		buffer;
+	VkDeviceMemory	memory;
+	VkDeviceSize	size;
+	void*			mapped;
+
+	bool IsValid() const { return buffer != VK_NULL_HANDLE; }
+};
+
+// An image, the memory bound to it and a view of its whole first level
+struct VulkanImage
+{
+	VkImage			image;
+	VkDeviceMemory	memory;
+	VkImageView		view;
+	VkFormat		format;
+
+	bool IsValid() const { return image != VK_NULL_HANDLE; }
+};
+
+// Singleton owning the instance, the device and the single queue every command is submitted to
+// A windowed device also owns the window's surface, a headless one has no surface and never presents
+// CPU implementations such as Mesa's lavapipe are accepted when there is no GPU
+class VulkanDevice
+{
+
+	VulkanDevice( const VulkanDevice& ) = delete;
+	VulkanDevice& operator=( const VulkanDevice& ) = delete;
+	VulkanDevice( VulkanDevice&& ) = delete;
+	VulkanDevice& operator=( VulkanDevice&& ) = delete;
+
+public:
+
+	// Frames the CPU may record ahead of the GPU before it has to wait for the oldest one
+	static constexpr uint32_t m_frameCount = 2;
+
+	// Get Instance of Vulkan Device
+	static VulkanDevice* Get();
+
+	// Creates the instance, the window's surface unless the window is headless, and a device with a graphics queue
+	// that can present to that surface. Validation layers are only enabled when they are installed
+	bool OnCreate( const char* applicationName, const char* engineName, const int version, const bool enableValidationLayers, Window* window );
+
+	// Waits for the device to be idle and destroys everything, buffers and images created through it must be gone first
+	void OnDestroy();
+
+	bool IsCreated() const { return m_device != VK_NULL_HANDLE; }
+
+	VkInstance GetInstance() const { return m_instance; }
+	VkPhysicalDevice GetPhysicalDevice() const { return m_physicalDevice; }
+	VkDevice GetDevice() const { return m_device; }
+	VkSurfaceKHR GetSurface() const { return m_surface; }
+	VkQueue GetQueue() const { return m_queue; }
+	uint32_t GetQueueFamily() const { return m_queueFamily; }
+	const VkPhysicalDeviceProperties& GetProperties() const { return m_properties; }
+
+	// Returns the index of a memory type allowed by typeBits with every passed property, or UINT32_MAX if there is none
+	uint32_t FindMemoryType( const uint32_t typeBits, const VkMemoryPropertyFlags properties ) const;
+
+	// Creates a buffer with memory of the passed properties, host visible buffers are mapped straight away
+	// Returns an invalid buffer if either cannot be created
+	VulkanBuffer CreateBuffer( const VkDeviceSize size, const VkBufferUsageFlags usage, const VkMemoryPropertyFlags properties );
+	void DestroyBuffer( VulkanBuffer& buffer );
+
+	// Destroys the buffer once every frame that may still read it has finished, instead of straight away
+	void RetireBuffer( VulkanBuffer& buffer );
+
+	// Starts the passed frame, the renderer has waited for every frame m_frameCount or more before it
+	// Buffers and images retired that long ago are destroyed. Render thread only
+	void BeginFrame( const uint64_t frameIndex );
+
+	// Frame being recorded, as passed to BeginFrame
+	uint64_t GetFrameIndex() const { return m_frameIndex; }
+
+	// Creates a single level 2D image in device local memory, with a view of the passed aspect
+	VulkanImage CreateImage( const uint32_t width, const uint32_t height, const VkFormat format, const VkImageUsageFlags usage, const VkImageAspectFlags aspect );
+	void DestroyImage( VulkanImage& image );
+
+	// Destroys the image once every frame that may still sample it has finished, instead of straight away
+	void RetireImage( VulkanImage& image );
+
+	// Returns the most precise depth format the device supports as a depth attachment
+	VkFormat FindDepthFormat() const;
+
+private:
+
+	VulkanDevice();
+	~VulkanDevice();
+
+	static std::unique_ptr<VulkanDevice> g_vulkanDeviceInstance;
+	friend std::default_delete<VulkanDevice>;
+
+	VkInstance					m_instance;
+	VkDebugUtilsMessengerEXT	m_debugMessenger;
+	VkSurfaceKHR				m_surface;
+	VkPhysicalDevice			m_physicalDevice;
+	VkPhysicalDeviceProperties	m_properties;
+	VkPhysicalDeviceMemoryProperties	m_memoryProperties;
+	VkDevice					m_device;
+	VkQueue						m_queue;
+	uint32_t					m_queueFamily;
+
+	// Buffers waiting for the frames that may read them, with the frame they can be destroyed at
+	struct RetiredBuffer
+	{
+		VulkanBuffer	buffer;
+		uint64_t		releaseFrame;
+	};
+
+	struct RetiredImage
+	{
+		VulkanImage		image;
+		uint64_t		releaseFrame;
+	};
+
+	std::vector<RetiredBuffer>	m_retiredBuffers;
+	std::vector<RetiredImage>	m_retiredImages;
+	uint64_t					m_frameIndex;
+
+	bool CreateInstance( const char* applicationName, const char* engineName, const int version, const bool enableValidationLayers, const bool isHeadless );
+
+	// Picks a device with a queue that can draw, and present to the surface if there is one. GPUs are preferred
+	// over CPU implementations
+	bool PickPhysicalDevice();
+
+	bool CreateDevice( const bool isHeadless );
+
+	// Returns true if the instance offers the passed layer
+	static bool HasLayer( const char* layerName );
+
+};
+
+#endif // !VULKANDEVICE_H
@@ -1,10 +1,132 @@
 #include "VulkanRenderer.h"
+#include "VulkanSwapchain.h"
+#include "VulkanUploader.h"
+#include "3D/VulkanMesh.h"
+#include "Texture/VulkanTexture2D.h"
 
-VulkanRenderer::VulkanRenderer()
+#include "../../Devices/Window.h"
+#include "../../RenderCore/Model/Model.h"
+#include "../../Components/RenderComponent.h"
+#include "../../Components/TransformComponent.h"
+#include "../../RenderCore/Camera/Camera.h"
+#include "../../RenderCore/Culling/OcclusionCuller.h"
+#include "../../RenderCore/Culling/SceneCuller.h"
+#include "../../RenderCore/Extraction/DrawExtractor.h"
+#include "../../RenderCore/Material/Material.h"
+#include "../../RenderCore/Loading/AssetLoader.h"
+#include "../../Core/Engine.h"
+#include "../../Core/ThreadPool.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+// Builds linking shaderc_combined compile changed GLSL at run time, the rest only load SPIR-V compiled ahead of time
+// Defaults to whether the header can be found, define VULKAN_SHADERC as 0 to build without it anyway
+#ifndef VULKAN_SHADERC
+#if __has_include( <shaderc/shaderc.h> )
+#define VULKAN_SHADERC 1
+#else
+#define VULKAN_SHADERC 0
+#endif
+#endif // !VULKAN_SHADERC
+
+#if VULKAN_SHADERC
+#include <shaderc/shaderc.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace
+{
+	// Vulkan's clip space has Y pointing down and depth from 0 to 1, GLM's projections are made for OpenGL
+	const glm::mat4 g_clipCorrection(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, -1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.5f, 0.0f,
+		0.0f, 0.0f, 0.5f, 1.0f
+	);
+
+	std::string FormatPassTimes( const float milliseconds[] )
+	{
+		std::string text;
+		for ( int pass = 0; pass < static_cast<int>( ERenderPass::TOTAL ); ++pass )
+		{
+			text += std::string( pass > 0 ? ", " : "" ) + g_renderPassNames[pass] + " " + std::to_string( milliseconds[pass] ) + " ms";
+		}
+		return text;
+	}
+
+#if VULKAN_SHADERC
+	// Compiles the passed GLSL source to SPIR-V, logging the compiler's errors if it fails
+	bool CompileShader( const std::string& filePath, const std::string& source, const VkShaderStageFlagBits stage, std::vector<uint32_t>& code )
+	{
+		const shaderc_shader_kind kind = stage == VK_SHADER_STAGE_VERTEX_BIT ? shaderc_vertex_shader : shaderc_fragment_shader;
+
+		shaderc_compiler_t compiler = shaderc_compiler_initialize();
+		shaderc_compile_options_t options = shaderc_compile_options_initialize();
+		shaderc_compile_options_set_target_env( options, shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_0 );
+		shaderc_compile_options_set_optimization_level( options, shaderc_optimization_level_performance );
+
+		shaderc_compilation_result_t result = shaderc_compile_into_spv( compiler, source.data(), source.size(), kind, filePath.c_str(), "main", options );
+
+		const bool isCompiled = shaderc_result_get_compilation_status( result ) == shaderc_compilation_status_success;
+		if ( isCompiled )
+		{
+			const size_t size = shaderc_result_get_length( result );
+			code.resize( size / sizeof( uint32_t ) );
+			std::memcpy( code.data(), shaderc_result_get_bytes( result ), size );
+		}
+		else
+		{
+			DEBUG_LOG( LOG::FATAL, "Failed to compile shader: " + filePath + "\n" + shaderc_result_get_error_message( result ) );
+			CONSOLE_LOG( LOG::FATAL, "Failed to compile shader: " + filePath + "\n" + shaderc_result_get_error_message( result ) );
+		}
+
+		shaderc_result_release( result );
+		shaderc_compile_options_release( options );
+		shaderc_compiler_release( compiler );
+
+		return isCompiled;
+	}
+#endif
+}
+
+VulkanRenderer::VulkanRenderer() :
+	IRenderer(),
+	m_sceneCuller( nullptr ),
+	m_drawExtractor( nullptr ),
+	m_swapchain( nullptr ),
+	m_renderPass( VK_NULL_HANDLE ),
+	m_pipelineLayout( VK_NULL_HANDLE ),
+	m_vertexShader( VK_NULL_HANDLE ),
+	m_fragmentShader( VK_NULL_HANDLE ),
+	m_pipelines(),
+	m_frames(),
+	m_frame( 0 ),
+	m_recorders(),
+	m_imageIndex( 0 ),
+	m_hasImage( false ),
+	m_lastImageIndex( 0 ),
+	m_hasLastImage( false ),
+	m_viewProjection( 1.0f ),
+	m_frameIndex( 0 ),
+	m_frameStats(),
+	m_timestampPeriod( 0.0f ),
+	m_timestampMask( 0 ),
+	m_gpuMilliseconds(),
+	m_gpuFrameIndex( 0 ),
+	m_hasGpuTimes( false )
 {}
 
 VulkanRenderer::~VulkanRenderer()
-{}
+{
+	OnDestroy();
+}
 
 bool VulkanRenderer::OnCreate(
 	const char * applicationName,
@@ -13,29 +135,1047 @@ bool VulkanRenderer::OnCreate(
 	bool enableValidationLayers,
 	Window * window )
 {
-	return false;
+	m_window = window;
+
+	if ( !VulkanDevice::Get()->OnCreate( applicationName, engineName, version, enableValidationLayers, window ) )
+	{
+		return false;
+	}
+
+	if ( !VulkanUploader::Get()->OnCreate() ||
+		!VulkanTexture2D::CreateSharedResources() )
+	{
+		return false;
+	}
+
+	m_swapchain = new VulkanSwapchain();
+	if ( !m_swapchain->OnCreate( m_window ) ||
+		!CreateRenderPass() ||
+		!m_swapchain->CreateFramebuffers( m_renderPass ) )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan swapchain!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan swapchain!" );
+		return false;
+	}
+
+	if ( !LoadShaderModule( "MeshVertex", VK_SHADER_STAGE_VERTEX_BIT, m_vertexShader ) ||
+		!LoadShaderModule( "MeshFragment", VK_SHADER_STAGE_FRAGMENT_BIT, m_fragmentShader ) ||
+		!CreatePipelineLayout() ||
+		!CreateFrameResources() )
+	{
+		return false;
+	}
+
+	m_sceneCuller = new SceneCuller();
+	m_drawExtractor = new DrawExtractor();
+
+	DEBUG_LOG( LOG::WARNING, "Vulkan renderer ignores scene lights, every model is lit by a single fixed light" );
+	CONSOLE_LOG( LOG::WARNING, "Vulkan renderer ignores scene lights, every model is lit by a single fixed light" );
+
+	return true;
 }
 
 void VulkanRenderer::OnDestroy()
-{}
+{
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	if ( !vulkanDevice->IsCreated() )
+	{
+		return;
+	}
+
+	const VkDevice device = vulkanDevice->GetDevice();
+	vkDeviceWaitIdle( device );
+
+	if ( m_sceneCuller )
+	{
+		delete m_sceneCuller;
+		m_sceneCuller = nullptr;
+	}
+
+	if ( m_drawExtractor )
+	{
+		delete m_drawExtractor;
+		m_drawExtractor = nullptr;
+	}
+
+	// Destroying a pool frees every command buffer allocated from it
+	for ( SliceRecorder& recorder : m_recorders )
+	{
+		for ( uint32_t frame = 0; frame < VulkanDevice::m_frameCount; ++frame )
+		{
+			vkDestroyCommandPool( device, recorder.commandPools[frame], nullptr );
+		}
+	}
+	m_recorders.clear();
+
+	for ( FrameResources& frame : m_frames )
+	{
+		vkDestroyCommandPool( device, frame.commandPool, nullptr );
+		vkDestroyFence( device, frame.fence, nullptr );
+		vkDestroySemaphore( device, frame.imageAvailable, nullptr );
+		vkDestroySemaphore( device, frame.renderFinished, nullptr );
+		vkDestroyQueryPool( device, frame.timestampPool, nullptr );
+		frame = FrameResources{};
+	}
+
+	for ( auto& pipeline : m_pipelines )
+	{
+		vkDestroyPipeline( device, pipeline.second, nullptr );
+	}
+	m_pipelines.clear();
+
+	vkDestroyPipelineLayout( device, m_pipelineLayout, nullptr );
+	vkDestroyShaderModule( device, m_vertexShader, nullptr );
+	vkDestroyShaderModule( device, m_fragmentShader, nullptr );
+	m_pipelineLayout = VK_NULL_HANDLE;
+	m_vertexShader = VK_NULL_HANDLE;
+	m_fragmentShader = VK_NULL_HANDLE;
+
+	// Textures still alive keep their images until the device goes, their descriptor sets go with the pool
+	VulkanTexture2D::DestroySharedResources();
+
+	if ( m_swapchain )
+	{
+		m_swapchain->OnDestroy();
+		delete m_swapchain;
+		m_swapchain = nullptr;
+	}
+
+	vkDestroyRenderPass( device, m_renderPass, nullptr );
+	m_renderPass = VK_NULL_HANDLE;
+
+	// Staging buffers still in flight are freed before the device goes
+	VulkanUploader::Get()->OnDestroy();
+	vulkanDevice->OnDestroy();
+}
 
 void VulkanRenderer::RenderScene( IScene * scene )
-{}
+{
+	const auto frameStart = std::chrono::steady_clock::now();
+	m_frameStats = {};
+	m_frameStats.frameIndex = m_frameIndex;
+	m_frameStats.resolutionScale = 1.0f;
+
+	// The frame last recorded with these command buffers has to finish before they are reset
+	vkWaitForFences( VulkanDevice::Get()->GetDevice(), 1, &m_frames[m_frame].fence, VK_TRUE, UINT64_MAX );
+	VulkanDevice::Get()->BeginFrame( m_frameIndex );
+	ReadTimestamps();
+
+	BeginScene( scene );
+
+	RunPass( ERenderPass::Clear, &VulkanRenderer::Begin );
+	RunPass( ERenderPass::Opaque, &VulkanRenderer::Present );
+	RunPass( ERenderPass::Present, &VulkanRenderer::End );
+
+	EndScene();
+
+	const std::chrono::duration<float, std::milli> frameTime = std::chrono::steady_clock::now() - frameStart;
+	UpdateStats( frameTime.count() );
+}
+
+// Runs the passed pass, timing it on the CPU
+void VulkanRenderer::RunPass( const ERenderPass pass, void ( VulkanRenderer::*function )() )
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	( this->*function )();
+
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	m_frameStats.cpuMilliseconds[static_cast<int>( pass )] = elapsed.count();
+}
+
+// Gathers the finished frame's counters into m_stats, and logs them every m_statsLogInterval frames
+void VulkanRenderer::UpdateStats( const float cpuFrameMilliseconds )
+{
+	m_frameStats.uploadedBytes += VulkanUploader::Get()->TakeUploadedBytes();
+	m_frameStats.cpuFrameMilliseconds = cpuFrameMilliseconds;
+
+	for ( int pass = 0; pass < static_cast<int>( ERenderPass::TOTAL ); ++pass )
+	{
+		m_frameStats.gpuMilliseconds[pass] = m_hasGpuTimes ? m_gpuMilliseconds[pass] : -1.0f;
+	}
+	m_frameStats.gpuFrameIndex = m_gpuFrameIndex;
+
+	m_stats = m_frameStats;
+
+	if ( ++m_frameIndex % m_statsLogInterval == 0 )
+	{
+		DEBUG_LOG( LOG::INFO, "Occlusion culled " + std::to_string( m_sceneCuller->GetOccludedModelCount() ) + " models behind " + std::to_string( m_sceneCuller->GetOcclusionCuller().GetOccluderTriangleCount() ) + " occluder triangles" );
+		CONSOLE_LOG( LOG::INFO, "Occlusion culled " + std::to_string( m_sceneCuller->GetOccludedModelCount() ) + " models behind " + std::to_string( m_sceneCuller->GetOcclusionCuller().GetOccluderTriangleCount() ) + " occluder triangles" );
+
+		DEBUG_LOG( LOG::INFO, std::to_string( m_stats.drawCalls ) + " draw calls in " + std::to_string( m_recorders.size() ) + " command buffers, " + std::to_string( m_stats.triangles ) + " triangles, " + std::to_string( m_stats.uploadedBytes ) + " bytes uploaded" );
+		CONSOLE_LOG( LOG::INFO, std::to_string( m_stats.drawCalls ) + " draw calls in " + std::to_string( m_recorders.size() ) + " command buffers, " + std::to_string( m_stats.triangles ) + " triangles, " + std::to_string( m_stats.uploadedBytes ) + " bytes uploaded" );
+
+		DEBUG_LOG( LOG::INFO, "CPU frame " + std::to_string( m_stats.cpuFrameMilliseconds ) + " ms: " + FormatPassTimes( m_stats.cpuMilliseconds ) );
+		CONSOLE_LOG( LOG::INFO, "CPU frame " + std::to_string( m_stats.cpuFrameMilliseconds ) + " ms: " + FormatPassTimes( m_stats.cpuMilliseconds ) );
+
+		DEBUG_LOG( LOG::INFO, "GPU frame " + std::to_string( m_stats.gpuFrameIndex ) + ": " + FormatPassTimes( m_stats.gpuMilliseconds ) );
+		CONSOLE_LOG( LOG::INFO, "GPU frame " + std::to_string( m_stats.gpuFrameIndex ) + ": " + FormatPassTimes( m_stats.gpuMilliseconds ) );
+	}
+}
+
+// Reads the timestamps of the frame that last used the current frame's resources, once its fence has been waited on
+// Results are never waited for, the fence already guarantees the frame has finished
+void VulkanRenderer::ReadTimestamps()
+{
+	FrameResources& frame = m_frames[m_frame];
+	if ( !frame.hasTimestamps )
+	{
+		return;
+	}
+	frame.hasTimestamps = false;
+
+	uint64_t timestamps[m_timestampCount] = {};
+	if ( vkGetQueryPoolResults(
+		VulkanDevice::Get()->GetDevice(),
+		frame.timestampPool,
+		0,
+		m_timestampCount,
+		sizeof( timestamps ),
+		timestamps,
+		sizeof( uint64_t ),
+		VK_QUERY_RESULT_64_BIT ) != VK_SUCCESS )
+	{
+		return;
+	}
+
+	// The clear is the render pass's load op and the slices are its only contents, so the whole pass is timed as Opaque
+	// There is no depth pre-pass, and presenting records no commands of its own
+	const uint64_t ticks = ( timestamps[1] - timestamps[0] ) & m_timestampMask;
+	for ( float& milliseconds : m_gpuMilliseconds )
+	{
+		milliseconds = 0.0f;
+	}
+	m_gpuMilliseconds[static_cast<int>( ERenderPass::Opaque )] = static_cast<float>( static_cast<double>( ticks ) * m_timestampPeriod / 1000000.0 );
+	m_gpuFrameIndex = frame.timestampFrameIndex;
+	m_hasGpuTimes = true;
+}
 
 void VulkanRenderer::BeginScene( IScene * scene )
-{}
+{
+
+	if ( scene == nullptr )
+	{
+		return;
+	}
+
+	// Meshes whose copies finished become drawable, then newly loaded assets queue their copies, which are
+	// submitted ahead of the frame that may draw them
+	VulkanUploader* uploader = VulkanUploader::Get();
+	uploader->ProcessCompleted();
+	AssetLoader::Get()->ProcessUploads( m_uploadBudgetMilliseconds );
+	uploader->Submit();
+
+	m_models.clear();
+
+	auto registry = ECS::Parser<RenderComponent, TransformComponent>( scene->m_world );
+	for ( auto c : registry.GetComponents() )
+	{
+		RenderComponent* r = std::get<RenderComponent*>( c );
+
+		SubmitModel( r->GetModel() );
+	}
+
+	auto cameraRegistry = ECS::Parser<CameraComponent, TransformComponent>( scene->m_world );
+	m_camera = std::get<CameraComponent*>( cameraRegistry.GetComponents().front() );
+
+	// Lights are not culled, the shaders have no clustered lighting to read them
+	m_sceneCuller->CullOccludedModels( m_models, *m_camera, Engine::Get()->GetThreadPool() );
+
+	m_viewProjection = g_clipCorrection * m_camera->GetPerspective() * m_camera->GetView();
+
+}
 
 void VulkanRenderer::EndScene()
 {}
 
 void VulkanRenderer::Begin()
-{}
+{
+	m_hasImage = false;
+	if ( m_camera == nullptr )
+	{
+		return;
+	}
+
+	FrameResources& frame = m_frames[m_frame];
+	if ( !m_swapchain->AcquireNextImage( frame.imageAvailable, m_imageIndex ) )
+	{
+		// Drawn again from the next frame, at the window's new size
+		RecreateSwapchain();
+		return;
+	}
+
+	const VkDevice device = VulkanDevice::Get()->GetDevice();
+	vkResetFences( device, 1, &frame.fence );
+	vkResetCommandPool( device, frame.commandPool, 0 );
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer( frame.commandBuffer, &beginInfo );
+
+	// Queries have to be reset outside of a render pass before they are written again
+	if ( frame.timestampPool != VK_NULL_HANDLE )
+	{
+		vkCmdResetQueryPool( frame.commandBuffer, frame.timestampPool, 0, m_timestampCount );
+		vkCmdWriteTimestamp( frame.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestampPool, 0 );
+	}
+
+	VkClearValue clearValues[2] = {};
+	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = m_renderPass;
+	renderPassInfo.framebuffer = m_swapchain->GetFramebuffer( m_imageIndex );
+	renderPassInfo.renderArea.extent = m_swapchain->GetExtent();
+	renderPassInfo.clearValueCount = 2;
+	renderPassInfo.pClearValues = clearValues;
+
+	// Every draw is recorded into the slices' secondary command buffers, see Present
+	vkCmdBeginRenderPass( frame.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+
+	m_hasImage = true;
+}
 
 void VulkanRenderer::Present()
-{}
+{
+	if ( !m_hasImage )
+	{
+		return;
+	}
+
+	// Pixels one unit covers at a distance of one unit
+	const float projectionScale = m_camera->GetPerspective()[1][1] * 0.5f * static_cast<float>( m_swapchain->GetExtent().height );
+
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	m_drawExtractor->Extract( m_models, m_camera->GetView(), m_viewProjection, m_camera->GetCameraPosition(), projectionScale, threadPool );
+
+	// Slice boundaries only depend on the model count, so which thread records a slice does not change the frame
+	const size_t sliceSize = ( m_models.size() + m_recorders.size() - 1 ) / m_recorders.size();
+	auto record = [this, sliceSize]( size_t begin, size_t end )
+	{
+		for ( size_t slice = begin; slice < end; ++slice )
+		{
+			const size_t first = std::min( slice * sliceSize, m_models.size() );
+			RecordSlice( m_recorders[slice], first, std::min( first + sliceSize, m_models.size() ) );
+		}
+	};
+
+	if ( threadPool )
+	{
+		threadPool->ParallelFor( m_recorders.size(), 1, record );
+	}
+	else
+	{
+		record( 0, m_recorders.size() );
+	}
+
+	std::vector<VkCommandBuffer> commandBuffers;
+	commandBuffers.reserve( m_recorders.size() );
+	for ( SliceRecorder& recorder : m_recorders )
+	{
+		commandBuffers.push_back( recorder.commandBuffers[m_frame] );
+
+		m_frameStats.drawCalls += recorder.drawCalls;
+		m_frameStats.triangles += recorder.triangles;
+		m_frameStats.programBinds += recorder.pipelineBinds;
+		m_frameStats.vertexArrayBinds += recorder.meshBinds;
+		m_frameStats.textureBinds += recorder.textureBinds;
+		m_frameStats.uniformUploads += recorder.drawCalls;
+
+		// Pipelines are only created here, while no slice is reading m_pipelines, and drawn with from the next frame
+		for ( const VertexLayout& layout : recorder.missingLayouts )
+		{
+			if ( m_pipelines.find( layout.GetId() ) == m_pipelines.end() )
+			{
+				m_pipelines[layout.GetId()] = CreatePipeline( layout );
+			}
+		}
+	}
+
+	vkCmdExecuteCommands( m_frames[m_frame].commandBuffer, static_cast<uint32_t>( commandBuffers.size() ), commandBuffers.data() );
+}
+
+// Records the draws of the models in [begin, end) into the recorder's command buffer for the current frame
+// Every model has already been extracted, see DrawExtractor::Extract
+void VulkanRenderer::RecordSlice( SliceRecorder& recorder, const size_t begin, const size_t end )
+{
+	recorder.missingLayouts.clear();
+	recorder.drawCalls = 0;
+	recorder.triangles = 0;
+	recorder.pipelineBinds = 0;
+	recorder.meshBinds = 0;
+	recorder.textureBinds = 0;
+
+	const VkCommandBuffer commandBuffer = recorder.commandBuffers[m_frame];
+	vkResetCommandPool( VulkanDevice::Get()->GetDevice(), recorder.commandPools[m_frame], 0 );
+
+	VkCommandBufferInheritanceInfo inheritanceInfo = {};
+	inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.renderPass = m_renderPass;
+	inheritanceInfo.subpass = 0;
+	inheritanceInfo.framebuffer = m_swapchain->GetFramebuffer( m_imageIndex );
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &inheritanceInfo;
+	vkBeginCommandBuffer( commandBuffer, &beginInfo );
+
+	// Dynamic state is not inherited from the primary command buffer
+	const VkExtent2D extent = m_swapchain->GetExtent();
+	VkViewport viewport = {};
+	viewport.width = static_cast<float>( extent.width );
+	viewport.height = static_cast<float>( extent.height );
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport( commandBuffer, 0, 1, &viewport );
+
+	VkRect2D scissor = {};
+	scissor.extent = extent;
+	vkCmdSetScissor( commandBuffer, 0, 1, &scissor );
+
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	const VulkanMeshBuffer* boundBuffer = nullptr;
+	VkDescriptorSet boundSet = VK_NULL_HANDLE;
+
+	for ( size_t i = begin; i < end; ++i )
+	{
+		const DrawExtractor::ExtractedDraw& extracted = m_drawExtractor->GetDraw( i );
+		if ( !extracted.isResident )
+		{
+			continue;
+		}
+
+		const Model* model = m_models[i];
+		const VulkanMesh* mesh = static_cast<const VulkanMesh*>( model->GetMesh() );
+		const SubMesh* subMesh = mesh->GetSubMesh();
+
+		auto pipeline = m_pipelines.find( subMesh->layout.GetId() );
+		if ( pipeline == m_pipelines.end() )
+		{
+			recorder.missingLayouts.push_back( subMesh->layout );
+			continue;
+		}
+		if ( pipeline->second == VK_NULL_HANDLE )
+		{
+			continue;
+		}
+
+		const uint32_t lod = extracted.lod;
+
+		if ( pipeline->second != boundPipeline )
+		{
+			vkCmdBindPipeline( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->second );
+			boundPipeline = pipeline->second;
+			recorder.pipelineBinds++;
+		}
+
+		if ( mesh->GetBuffer() != boundBuffer )
+		{
+			mesh->Bind( commandBuffer );
+			boundBuffer = mesh->GetBuffer();
+			recorder.meshBinds++;
+		}
+
+		// Models without a texture sample the white placeholder, so they keep their material's diffuse colour
+		const VulkanTexture2D* texture = static_cast<const VulkanTexture2D*>( model->GetTexture() );
+		const VkDescriptorSet descriptorSet = texture ? texture->GetDescriptorSet() : VulkanTexture2D::GetPlaceholderSet();
+		if ( descriptorSet != boundSet )
+		{
+			vkCmdBindDescriptorSets( commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &descriptorSet, 0, nullptr );
+			boundSet = descriptorSet;
+			recorder.textureBinds++;
+		}
+
+		const ObjectUniforms& object = m_drawExtractor->GetObject( i );
+
+		DrawConstants constants;
+		constants.modelViewProjection = object.modelViewProjection;
+		constants.normalMatrix[0] = object.normalMatrix[0];
+		constants.normalMatrix[1] = object.normalMatrix[1];
+		constants.normalMatrix[2] = object.normalMatrix[2];
+
+		// Each range is drawn with its own material, only the diffuse constant changes between them
+		const MeshLod& level = subMesh->lods[lod];
+		for ( uint32_t r = level.firstRange; r < level.firstRange + level.rangeCount; ++r )
+		{
+			const MeshRange& range = subMesh->ranges[r];
+			if ( range.indexCount == 0 )
+			{
+				continue;
+			}
+
+			const Material* material = model->GetRangeMaterial( range.materialIndex );
+			constants.diffuse = glm::vec4( material->diffuse, 1.0f - material->transparency );
+			vkCmdPushConstants( commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof( DrawConstants ), &constants );
+
+			mesh->Draw( commandBuffer, range );
+
+			recorder.drawCalls++;
+			recorder.triangles += range.indexCount / 3;
+		}
+	}
+
+	vkEndCommandBuffer( commandBuffer );
+}
 
 void VulkanRenderer::End()
-{}
+{
+	if ( !m_hasImage )
+	{
+		return;
+	}
+
+	FrameResources& frame = m_frames[m_frame];
+	vkCmdEndRenderPass( frame.commandBuffer );
+	if ( frame.timestampPool != VK_NULL_HANDLE )
+	{
+		vkCmdWriteTimestamp( frame.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 1 );
+	}
+	vkEndCommandBuffer( frame.commandBuffer );
+
+	// A headless swapchain's images are never acquired or presented, so there is nothing to wait for or signal
+	const bool isHeadless = m_swapchain->IsHeadless();
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = isHeadless ? 0 : 1;
+	submitInfo.pWaitSemaphores = &frame.imageAvailable;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &frame.commandBuffer;
+	submitInfo.signalSemaphoreCount = isHeadless ? 0 : 1;
+	submitInfo.pSignalSemaphores = &frame.renderFinished;
+
+	if ( vkQueueSubmit( VulkanDevice::Get()->GetQueue(), 1, &submitInfo, frame.fence ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to submit Vulkan frame!" );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to submit Vulkan frame!" );
+		return;
+	}
+
+	frame.hasTimestamps = frame.timestampPool != VK_NULL_HANDLE;
+	frame.timestampFrameIndex = m_frameIndex;
+
+	if ( !m_swapchain->Present( frame.renderFinished, m_imageIndex ) )
+	{
+		RecreateSwapchain();
+	}
+
+	m_lastImageIndex = m_imageIndex;
+	m_hasLastImage = true;
+	m_frame = ( m_frame + 1 ) % VulkanDevice::m_frameCount;
+}
 
 void VulkanRenderer::SubmitModel( Model* model )
-{}
+{
+	m_models.push_back( model );
+}
+
+// Returns true while VulkanUploader still holds batches that have not been handed back
+bool VulkanRenderer::HasPendingUploads()
+{
+	return VulkanUploader::Get()->GetPendingCount() > 0;
+}
+
+// Reads the last finished frame back and writes it to the passed path as a binary PPM
+// Only a headless swapchain keeps its images after they are drawn, returns false otherwise
+bool VulkanRenderer::SaveFrame( const std::string& filePath )
+{
+	if ( m_swapchain == nullptr || !m_swapchain->IsHeadless() || !m_hasLastImage )
+	{
+		return false;
+	}
+
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	const VkDevice device = vulkanDevice->GetDevice();
+	const VkExtent2D extent = m_swapchain->GetExtent();
+	const VkDeviceSize size = static_cast<VkDeviceSize>( extent.width ) * extent.height * 4;
+
+	VulkanBuffer readback = vulkanDevice->CreateBuffer(
+		size,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+	);
+	if ( !readback.IsValid() )
+	{
+		return false;
+	}
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = vulkanDevice->GetQueueFamily();
+
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	if ( vkCreateCommandPool( device, &poolInfo, nullptr, &commandPool ) != VK_SUCCESS )
+	{
+		vulkanDevice->DestroyBuffer( readback );
+		return false;
+	}
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = commandPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	if ( vkAllocateCommandBuffers( device, &allocateInfo, &commandBuffer ) != VK_SUCCESS )
+	{
+		vkDestroyCommandPool( device, commandPool, nullptr );
+		vulkanDevice->DestroyBuffer( readback );
+		return false;
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer( commandBuffer, &beginInfo );
+
+	// The render pass left the image ready to be copied from
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { extent.width, extent.height, 1 };
+	vkCmdCopyImageToBuffer( commandBuffer, m_swapchain->GetImage( m_lastImageIndex ), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &region );
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier( commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+	vkEndCommandBuffer( commandBuffer );
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+
+	// Headless runs save frames every dumpInterval frames, stalling on them is fine
+	const bool isCopied = vkQueueSubmit( vulkanDevice->GetQueue(), 1, &submitInfo, VK_NULL_HANDLE ) == VK_SUCCESS &&
+		vkQueueWaitIdle( vulkanDevice->GetQueue() ) == VK_SUCCESS;
+
+	vkDestroyCommandPool( device, commandPool, nullptr );
+
+	if ( !isCopied )
+	{
+		vulkanDevice->DestroyBuffer( readback );
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( filePath ).parent_path(), error );
+
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Cannot write frame: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Cannot write frame: " + filePath );
+		vulkanDevice->DestroyBuffer( readback );
+		return false;
+	}
+
+	file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+
+	// Images are stored top row first like PPM, only the alpha of each RGBA pixel is dropped
+	const unsigned char* pixels = static_cast<const unsigned char*>( readback.mapped );
+	std::vector<unsigned char> row( static_cast<size_t>( extent.width ) * 3 );
+	for ( uint32_t y = 0; y < extent.height; ++y )
+	{
+		const unsigned char* source = pixels + static_cast<size_t>( y ) * extent.width * 4;
+		for ( uint32_t x = 0; x < extent.width; ++x )
+		{
+			std::memcpy( &row[x * 3], &source[x * 4], 3 );
+		}
+		file.write( reinterpret_cast<const char*>( row.data() ), static_cast<std::streamsize>( row.size() ) );
+	}
+
+	vulkanDevice->DestroyBuffer( readback );
+	return file.good();
+}
+
+bool VulkanRenderer::CreateRenderPass()
+{
+	VkAttachmentDescription attachments[2] = {};
+
+	VkAttachmentDescription& colour = attachments[0];
+	colour.format = m_swapchain->GetColourFormat();
+	colour.samples = VK_SAMPLE_COUNT_1_BIT;
+	colour.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colour.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colour.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colour.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colour.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colour.finalLayout = m_swapchain->GetFinalLayout();
+
+	VkAttachmentDescription& depth = attachments[1];
+	depth.format = m_swapchain->GetDepthFormat();
+	depth.samples = VK_SAMPLE_COUNT_1_BIT;
+	depth.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depth.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depth.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depth.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference colourReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colourReference;
+	subpass.pDepthStencilAttachment = &depthReference;
+
+	// Every frame shares the depth buffer, so a frame's depth writes wait for the previous frame's to finish
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	// Headless frames are copied from once the render pass has finished, see SaveFrame
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 2;
+	renderPassInfo.pAttachments = attachments;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = m_swapchain->IsHeadless() ? 2 : 1;
+	renderPassInfo.pDependencies = dependencies;
+
+	return vkCreateRenderPass( VulkanDevice::Get()->GetDevice(), &renderPassInfo, nullptr, &m_renderPass ) == VK_SUCCESS;
+}
+
+bool VulkanRenderer::CreatePipelineLayout()
+{
+	VkPushConstantRange pushConstants = {};
+	pushConstants.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstants.offset = 0;
+	pushConstants.size = sizeof( DrawConstants );
+
+	// Set 0 is the drawn model's texture, see VulkanTexture2D
+	const VkDescriptorSetLayout setLayout = VulkanTexture2D::GetDescriptorSetLayout();
+
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstants;
+
+	if ( vkCreatePipelineLayout( VulkanDevice::Get()->GetDevice(), &layoutInfo, nullptr, &m_pipelineLayout ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan pipeline layout!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan pipeline layout!" );
+		return false;
+	}
+
+	return true;
+}
+
+// Creates the command buffers of every frame in flight, and one recorder per thread that can record a slice
+bool VulkanRenderer::CreateFrameResources()
+{
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	const VkDevice device = vulkanDevice->GetDevice();
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = vulkanDevice->GetQueueFamily();
+
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandBufferCount = 1;
+
+	// Signalled, so the first frame using them does not wait
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	// Queues without timestamp bits get no query pools, and their frames report no GPU times
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties( vulkanDevice->GetPhysicalDevice(), &familyCount, nullptr );
+	std::vector<VkQueueFamilyProperties> families( familyCount );
+	vkGetPhysicalDeviceQueueFamilyProperties( vulkanDevice->GetPhysicalDevice(), &familyCount, families.data() );
+
+	const uint32_t timestampBits = vulkanDevice->GetQueueFamily() < familyCount ? families[vulkanDevice->GetQueueFamily()].timestampValidBits : 0;
+	const bool hasTimestamps = timestampBits > 0 && vulkanDevice->GetProperties().limits.timestampPeriod > 0.0f;
+	m_timestampPeriod = hasTimestamps ? vulkanDevice->GetProperties().limits.timestampPeriod : 0.0f;
+	m_timestampMask = timestampBits >= 64 ? UINT64_MAX : ( static_cast<uint64_t>( 1 ) << timestampBits ) - 1;
+
+	VkQueryPoolCreateInfo queryPoolInfo = {};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = m_timestampCount;
+
+	for ( FrameResources& frame : m_frames )
+	{
+		if ( vkCreateCommandPool( device, &poolInfo, nullptr, &frame.commandPool ) != VK_SUCCESS ||
+			vkCreateFence( device, &fenceInfo, nullptr, &frame.fence ) != VK_SUCCESS ||
+			vkCreateSemaphore( device, &semaphoreInfo, nullptr, &frame.imageAvailable ) != VK_SUCCESS ||
+			vkCreateSemaphore( device, &semaphoreInfo, nullptr, &frame.renderFinished ) != VK_SUCCESS ||
+			( hasTimestamps && vkCreateQueryPool( device, &queryPoolInfo, nullptr, &frame.timestampPool ) != VK_SUCCESS ) )
+		{
+			DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan frame resources!" );
+			CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan frame resources!" );
+			return false;
+		}
+
+		allocateInfo.commandPool = frame.commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		vkAllocateCommandBuffers( device, &allocateInfo, &frame.commandBuffer );
+	}
+
+	// As many slices as threads, the render thread records one while it waits for the workers
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	m_recorders.resize( threadPool ? threadPool->GetWorkerCount() + 1 : 1, SliceRecorder{} );
+
+	for ( SliceRecorder& recorder : m_recorders )
+	{
+		for ( uint32_t frame = 0; frame < VulkanDevice::m_frameCount; ++frame )
+		{
+			if ( vkCreateCommandPool( device, &poolInfo, nullptr, &recorder.commandPools[frame] ) != VK_SUCCESS )
+			{
+				DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan slice command pool!" );
+				CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan slice command pool!" );
+				return false;
+			}
+
+			allocateInfo.commandPool = recorder.commandPools[frame];
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			vkAllocateCommandBuffers( device, &allocateInfo, &recorder.commandBuffers[frame] );
+		}
+	}
+
+	return true;
+}
+
+// Loads the named shader from Resources/Shaders/Vulkan. Its GLSL source is compiled to SPIR-V first if there is no
+// compiled copy or the source is newer, and the compiled copy is written next to the source for the next run
+bool VulkanRenderer::LoadShaderModule( const std::string& name, const VkShaderStageFlagBits stage, VkShaderModule& shaderModule )
+{
+	const std::string sourcePath = "./Resources/Shaders/Vulkan/" + name + ".glsl";
+	const std::string filePath = "./Resources/Shaders/Vulkan/" + name + ".spv";
+
+	// A missing file has the earliest time there is, so a source without a compiled copy is always newer
+	std::error_code error;
+	const bool hasSource = std::filesystem::exists( sourcePath, error );
+	const bool isStale = hasSource &&
+		std::filesystem::last_write_time( sourcePath, error ) > std::filesystem::last_write_time( filePath, error );
+
+	// SPIR-V is read as 32 bit words
+	std::vector<uint32_t> code;
+
+#if VULKAN_SHADERC
+	if ( isStale )
+	{
+		std::ifstream sourceFile( sourcePath, std::ios::binary );
+		if ( !sourceFile.is_open() )
+		{
+			DEBUG_LOG( LOG::FATAL, "Cannot open shader source: " + sourcePath );
+			CONSOLE_LOG( LOG::FATAL, "Cannot open shader source: " + sourcePath );
+			return false;
+		}
+
+		const std::string source( ( std::istreambuf_iterator<char>( sourceFile ) ), std::istreambuf_iterator<char>() );
+		if ( !CompileShader( sourcePath, source, stage, code ) )
+		{
+			return false;
+		}
+
+		// Only saves compiling again on the next run, so failing to write it is not an error
+		std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+		file.write( reinterpret_cast<const char*>( code.data() ), static_cast<std::streamsize>( code.size() * sizeof( uint32_t ) ) );
+		if ( !file.good() )
+		{
+			DEBUG_LOG( LOG::WARNING, "Cannot write SPIR-V shader: " + filePath );
+			CONSOLE_LOG( LOG::WARNING, "Cannot write SPIR-V shader: " + filePath );
+		}
+	}
+	else
+#else
+	if ( isStale )
+	{
+		// Without shaderc the compiled copy is used as it is, see the command at the top of the source
+		DEBUG_LOG( LOG::WARNING, "Built without shaderc, " + filePath + " is older than its source or missing, compile it ahead of time" );
+		CONSOLE_LOG( LOG::WARNING, "Built without shaderc, " + filePath + " is older than its source or missing, compile it ahead of time" );
+	}
+#endif
+	{
+		std::ifstream file( filePath, std::ios::binary | std::ios::ate );
+		if ( !file.is_open() )
+		{
+			DEBUG_LOG( LOG::FATAL, "Cannot open SPIR-V shader: " + filePath );
+			CONSOLE_LOG( LOG::FATAL, "Cannot open SPIR-V shader: " + filePath );
+			return false;
+		}
+
+		const size_t size = static_cast<size_t>( file.tellg() );
+		code.resize( ( size + sizeof( uint32_t ) - 1 ) / sizeof( uint32_t ) );
+		file.seekg( 0 );
+		file.read( reinterpret_cast<char*>( code.data() ), static_cast<std::streamsize>( size ) );
+	}
+
+	VkShaderModuleCreateInfo moduleInfo = {};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size() * sizeof( uint32_t );
+	moduleInfo.pCode = code.data();
+
+	if ( vkCreateShaderModule( VulkanDevice::Get()->GetDevice(), &moduleInfo, nullptr, &shaderModule ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create shader module: " + filePath );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create shader module: " + filePath );
+		return false;
+	}
+
+	return true;
+}
+
+// Creates the pipeline drawing meshes of the passed layout, or returns VK_NULL_HANDLE if the shaders cannot read it
+VkPipeline VulkanRenderer::CreatePipeline( const VertexLayout& layout )
+{
+	const VertexAttributeDesc& position = layout.GetAttribute( EVertexAttribute::Position );
+	const VertexAttributeDesc& normal = layout.GetAttribute( EVertexAttribute::Normal );
+	const VertexAttributeDesc& texCoords = layout.GetAttribute( EVertexAttribute::TexCoords );
+	const bool hasTexCoords = texCoords.format == EVertexFormat::Half2 || texCoords.format == EVertexFormat::Float2;
+	if ( position.format != EVertexFormat::Float3 || normal.format != EVertexFormat::Octahedral16 || !hasTexCoords )
+	{
+		DEBUG_LOG( LOG::WARNING, "Vulkan meshes need float3 positions, octahedral normals and texture coordinates, skipping vertex layout " + std::to_string( layout.GetId() ) );
+		CONSOLE_LOG( LOG::WARNING, "Vulkan meshes need float3 positions, octahedral normals and texture coordinates, skipping vertex layout " + std::to_string( layout.GetId() ) );
+		return VK_NULL_HANDLE;
+	}
+
+	VkPipelineShaderStageCreateInfo stages[2] = {};
+	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	stages[0].module = m_vertexShader;
+	stages[0].pName = "main";
+	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[1].module = m_fragmentShader;
+	stages[1].pName = "main";
+
+	// One binding per stream, as bound by VulkanMesh::Bind
+	VkVertexInputBindingDescription bindings[VertexLayout::m_maxStreams] = {};
+	for ( uint32_t stream = 0; stream < VertexLayout::m_maxStreams; ++stream )
+	{
+		bindings[stream].binding = stream;
+		bindings[stream].stride = layout.strides[stream];
+		bindings[stream].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	}
+
+	VkVertexInputAttributeDescription attributes[3] = {};
+	attributes[0] = { 0, position.stream, VK_FORMAT_R32G32B32_SFLOAT, position.offset };
+	attributes[1] = { 1, normal.stream, VK_FORMAT_R16G16_SNORM, normal.offset };
+	attributes[2] = { 2, texCoords.stream, texCoords.format == EVertexFormat::Half2 ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32_SFLOAT, texCoords.offset };
+
+	VkPipelineVertexInputStateCreateInfo vertexInput = {};
+	vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInput.vertexBindingDescriptionCount = VertexLayout::m_maxStreams;
+	vertexInput.pVertexBindingDescriptions = bindings;
+	vertexInput.vertexAttributeDescriptionCount = 3;
+	vertexInput.pVertexAttributeDescriptions = attributes;
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	// Set by every slice, so pipelines survive the swapchain being resized
+	VkPipelineViewportStateCreateInfo viewportState = {};
+	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+
+	const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	// The clip space correction flips Y, which keeps OpenGL's counter clockwise front faces
+	VkPipelineRasterizationStateCreateInfo rasterization = {};
+	rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisample = {};
+	multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+	VkPipelineColorBlendAttachmentState blendAttachment = {};
+	blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	VkPipelineColorBlendStateCreateInfo colourBlend = {};
+	colourBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colourBlend.attachmentCount = 1;
+	colourBlend.pAttachments = &blendAttachment;
+
+	VkGraphicsPipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 2;
+	pipelineInfo.pStages = stages;
+	pipelineInfo.pVertexInputState = &vertexInput;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterization;
+	pipelineInfo.pMultisampleState = &multisample;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colourBlend;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = m_pipelineLayout;
+	pipelineInfo.renderPass = m_renderPass;
+	pipelineInfo.subpass = 0;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if ( vkCreateGraphicsPipelines( VulkanDevice::Get()->GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to create Vulkan pipeline for vertex layout " + std::to_string( layout.GetId() ) );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to create Vulkan pipeline for vertex layout " + std::to_string( layout.GetId() ) );
+		return VK_NULL_HANDLE;
+	}
+
+	return pipeline;
+}
+
+// Recreates the swapchain after the window's surface changed
+bool VulkanRenderer::RecreateSwapchain()
+{
+	// Also finishes every frame in flight, so nothing still reads the old images
+	vkDeviceWaitIdle( VulkanDevice::Get()->GetDevice() );
+	m_hasLastImage = false;
+
+	if ( !m_swapchain->Recreate( m_renderPass ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to recreate Vulkan swapchain!" );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to recreate Vulkan swapchain!" );
+		return false;
+	}
+
+	return true;
+}
@@ -2,7 +2,25 @@
 #define VULKANRENDERER_H
 
 #include "../../RenderCore/Renderer.h"
+#include "../../RenderCore/3D/VertexLayout.h"
+#include "VulkanDevice.h"
 
+#include <glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class DrawExtractor;
+class SceneCuller;
+class VulkanSwapchain;
+
+// Renderer drawing through Vulkan, recording the frame's draws on every thread at once
+// The frame's models are split into one slice per thread, each slice is recorded on the thread pool into a secondary
+// command buffer from a command pool of its own, and the primary command buffer executes them in slice order
+// VulkanDevice::m_frameCount frames are in flight, each with its own command buffers, fence and semaphores
+// Scene lights are not supported, every model is lit by the fixed light in MeshFragment.glsl and lights are never culled
 class VulkanRenderer : public IRenderer
 {
 
@@ -22,8 +40,109 @@ public:
 
 	virtual void RenderScene( IScene* scene ) override final;
 
+	// Reads the last finished frame back and writes it to the passed path as a binary PPM
+	// Only a headless swapchain keeps its images after they are drawn, returns false otherwise
+	virtual bool SaveFrame( const std::string& filePath ) override final;
+
+	// Returns true while VulkanUploader still holds batches that have not been handed back
+	virtual bool HasPendingUploads() override final;
+
 private:
 
+	// Time each frame may spend creating GPU resources for assets that finished loading
+	static constexpr float m_uploadBudgetMilliseconds = 2.0f;
+
+	// Frames between logging the frame's RenderStats
+	static constexpr uint64_t m_statsLogInterval = 600;
+
+	// Timestamps of each frame in flight, written before its render pass begins and after it ends
+	static constexpr uint32_t m_timestampCount = 2;
+
+	// Pushed for every draw, see Resources/Shaders/Vulkan/MeshVertex.glsl
+	// 128 bytes is the least push constant space every device has
+	struct DrawConstants
+	{
+		glm::mat4	modelViewProjection;
+		glm::vec4	normalMatrix[3];	// Rows of a mat3, as DrawExtractor writes them
+		glm::vec4	diffuse;			// w: opacity
+	};
+
+	static_assert( sizeof( DrawConstants ) == 128, "DrawConstants must fit the guaranteed push constant space" );
+
+	// Command buffers of a single frame in flight, reused once its fence has been signalled
+	struct FrameResources
+	{
+		VkCommandPool		commandPool;
+		VkCommandBuffer		commandBuffer;
+		VkFence				fence;
+		VkSemaphore			imageAvailable;
+		VkSemaphore			renderFinished;
+
+		// Null if the queue cannot write timestamps
+		VkQueryPool			timestampPool;
+		uint64_t			timestampFrameIndex;	// Frame the timestamps were written by
+		bool				hasTimestamps;			// Submitted and not read back yet
+	};
+
+	// Records one slice of the frame's models, with a command pool per frame in flight
+	// Only the thread recording the slice touches its pool, so recording needs no locks
+	struct SliceRecorder
+	{
+		VkCommandPool				commandPools[VulkanDevice::m_frameCount];
+		VkCommandBuffer				commandBuffers[VulkanDevice::m_frameCount];
+
+		// Layouts of the models the slice skipped because no pipeline draws them yet
+		std::vector<VertexLayout>	missingLayouts;
+
+		uint32_t					drawCalls;
+		uint64_t					triangles;
+		uint32_t					pipelineBinds;
+		uint32_t					meshBinds;
+		uint32_t					textureBinds;
+	};
+
+	SceneCuller*				m_sceneCuller;
+	DrawExtractor*				m_drawExtractor;
+	VulkanSwapchain*			m_swapchain;
+
+	VkRenderPass				m_renderPass;
+	VkPipelineLayout			m_pipelineLayout;
+	VkShaderModule				m_vertexShader;
+	VkShaderModule				m_fragmentShader;
+
+	// Pipeline drawing each vertex layout, by VertexLayout::GetId. Layouts the shaders cannot read map to VK_NULL_HANDLE
+	// Only changed on the render thread while no slice is being recorded
+	std::unordered_map<uint32_t, VkPipeline>	m_pipelines;
+
+	FrameResources				m_frames[VulkanDevice::m_frameCount];
+	uint32_t					m_frame;				// Frame in flight being recorded
+	std::vector<SliceRecorder>	m_recorders;
+
+	// Swapchain image of the frame being recorded, if one could be acquired
+	uint32_t					m_imageIndex;
+	bool						m_hasImage;
+
+	// Image of the last submitted frame, read back by SaveFrame
+	uint32_t					m_lastImageIndex;
+	bool						m_hasLastImage;
+
+	// Camera's view projection with Vulkan's flipped Y and half depth range applied
+	glm::mat4					m_viewProjection;
+
+	uint64_t					m_frameIndex;
+
+	// Counters and timings of the frame being recorded, copied into m_stats once it is finished
+	RenderStats					m_frameStats;
+
+	// Nanoseconds per timestamp tick and the bits of a timestamp the queue writes, 0 if it writes none
+	float						m_timestampPeriod;
+	uint64_t					m_timestampMask;
+
+	// GPU times of the last frame whose timestamps were read back, see ReadTimestamps
+	float						m_gpuMilliseconds[static_cast<int>( ERenderPass::TOTAL )];
+	uint64_t					m_gpuFrameIndex;
+	bool						m_hasGpuTimes;
+
 	virtual void BeginScene( IScene* scene ) override final;
 	virtual void EndScene() override final;
 
@@ -33,6 +152,33 @@ private:
 
 	virtual void SubmitModel( Model* model ) override final;
 
+	// Runs the passed pass, timing it on the CPU
+	void RunPass( const ERenderPass pass, void ( VulkanRenderer::*function )() );
+
+	// Gathers the finished frame's counters into m_stats, and logs them every m_statsLogInterval frames
+	void UpdateStats( const float cpuFrameMilliseconds );
+
+	// Reads the timestamps of the frame that last used the current frame's resources, once its fence has been waited on
+	void ReadTimestamps();
+
+	bool CreateRenderPass();
+	bool CreatePipelineLayout();
+	bool CreateFrameResources();
+
+	// Loads the named shader from Resources/Shaders/Vulkan. Its GLSL source is compiled to SPIR-V first if there is no
+	// compiled copy or the source is newer, and the compiled copy is written next to the source for the next run
+	// Builds without shaderc only load the compiled copy, see VULKAN_SHADERC
+	bool LoadShaderModule( const std::string& name, const VkShaderStageFlagBits stage, VkShaderModule& shaderModule );
+
+	// Creates the pipeline drawing meshes of the passed layout, or returns VK_NULL_HANDLE if the shaders cannot read it
+	VkPipeline CreatePipeline( const VertexLayout& layout );
+
+	// Records the draws of the models in [begin, end) into the recorder's command buffer for the current frame
+	void RecordSlice( SliceRecorder& recorder, const size_t begin, const size_t end );
+
+	// Recreates the swapchain after the window's surface changed
+	bool RecreateSwapchain();
+
 };
 
 
@@ -0,0 +1,312 @@
+#include "VulkanSwapchain.h"
+
+#include "../../Devices/Window.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <string>
+
+VulkanSwapchain::VulkanSwapchain() :
+	m_window( nullptr ),
+	m_isHeadless( false ),
+	m_swapchain( VK_NULL_HANDLE ),
+	m_colourFormat( VK_FORMAT_UNDEFINED ),
+	m_extent(),
+	m_images(),
+	m_imageViews(),
+	m_headlessImages(),
+	m_nextHeadlessImage( 0 ),
+	m_depth(),
+	m_framebuffers()
+{}
+
+VulkanSwapchain::~VulkanSwapchain()
+{
+	OnDestroy();
+}
+
+// Creates the images at the window's size, and the framebuffers drawing into them with the passed render pass
+// The render pass must be created with GetColourFormat and GetDepthFormat, which are known once OnCreate returns
+bool VulkanSwapchain::OnCreate( Window* window )
+{
+	m_window = window;
+	m_isHeadless = window->IsHeadless();
+
+	const bool hasImages = m_isHeadless ? CreateHeadlessImages() : CreateSwapchain();
+	if ( !hasImages || !CreateDepth() )
+	{
+		return false;
+	}
+
+	DEBUG_LOG( LOG::INFO, "Created " + std::string( m_isHeadless ? "headless " : "" ) + "swapchain of " + std::to_string( m_images.size() ) + " images at " + std::to_string( m_extent.width ) + "x" + std::to_string( m_extent.height ) );
+	CONSOLE_LOG( LOG::INFO, "Created " + std::string( m_isHeadless ? "headless " : "" ) + "swapchain of " + std::to_string( m_images.size() ) + " images at " + std::to_string( m_extent.width ) + "x" + std::to_string( m_extent.height ) );
+
+	return true;
+}
+
+bool VulkanSwapchain::CreateFramebuffers( const VkRenderPass renderPass )
+{
+	const VkDevice device = VulkanDevice::Get()->GetDevice();
+
+	m_framebuffers.resize( m_imageViews.size(), VK_NULL_HANDLE );
+	for ( size_t i = 0; i < m_imageViews.size(); ++i )
+	{
+		const VkImageView attachments[] = { m_imageViews[i], m_depth.view };
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = 2;
+		framebufferInfo.pAttachments = attachments;
+		framebufferInfo.width = m_extent.width;
+		framebufferInfo.height = m_extent.height;
+		framebufferInfo.layers = 1;
+
+		if ( vkCreateFramebuffer( device, &framebufferInfo, nullptr, &m_framebuffers[i] ) != VK_SUCCESS )
+		{
+			DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan framebuffer!" );
+			CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan framebuffer!" );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void VulkanSwapchain::OnDestroy()
+{
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	if ( !vulkanDevice->IsCreated() )
+	{
+		return;
+	}
+	const VkDevice device = vulkanDevice->GetDevice();
+
+	for ( VkFramebuffer framebuffer : m_framebuffers )
+	{
+		vkDestroyFramebuffer( device, framebuffer, nullptr );
+	}
+	m_framebuffers.clear();
+
+	vulkanDevice->DestroyImage( m_depth );
+
+	// Headless views belong to their images
+	if ( m_isHeadless )
+	{
+		for ( VulkanImage& image : m_headlessImages )
+		{
+			vulkanDevice->DestroyImage( image );
+		}
+		m_headlessImages.clear();
+	}
+	else
+	{
+		for ( VkImageView view : m_imageViews )
+		{
+			vkDestroyImageView( device, view, nullptr );
+		}
+	}
+	m_imageViews.clear();
+	m_images.clear();
+
+	if ( m_swapchain != VK_NULL_HANDLE )
+	{
+		vkDestroySwapchainKHR( device, m_swapchain, nullptr );
+		m_swapchain = VK_NULL_HANDLE;
+	}
+}
+
+// Creates everything again at the window's current size, after the surface changed. The device must be idle
+bool VulkanSwapchain::Recreate( const VkRenderPass renderPass )
+{
+	OnDestroy();
+	return OnCreate( m_window ) && CreateFramebuffers( renderPass );
+}
+
+// Picks the image the next frame draws into, signalling imageAvailable once it can be drawn into
+// A headless swapchain takes its images in turn and signals nothing. Returns false if the swapchain is out of date
+bool VulkanSwapchain::AcquireNextImage( const VkSemaphore imageAvailable, uint32_t& imageIndex )
+{
+	if ( m_isHeadless )
+	{
+		imageIndex = m_nextHeadlessImage;
+		m_nextHeadlessImage = ( m_nextHeadlessImage + 1 ) % GetImageCount();
+		return true;
+	}
+
+	const VkResult result = vkAcquireNextImageKHR( VulkanDevice::Get()->GetDevice(), m_swapchain, UINT64_MAX, imageAvailable, VK_NULL_HANDLE, &imageIndex );
+	return result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR;
+}
+
+// Presents the passed image once renderFinished is signalled, a headless swapchain keeps the image instead
+// Returns false if the swapchain is out of date
+bool VulkanSwapchain::Present( const VkSemaphore renderFinished, const uint32_t imageIndex )
+{
+	if ( m_isHeadless )
+	{
+		return true;
+	}
+
+	VkPresentInfoKHR presentInfo = {};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pWaitSemaphores = &renderFinished;
+	presentInfo.swapchainCount = 1;
+	presentInfo.pSwapchains = &m_swapchain;
+	presentInfo.pImageIndices = &imageIndex;
+
+	const VkResult result = vkQueuePresentKHR( VulkanDevice::Get()->GetQueue(), &presentInfo );
+	return result == VK_SUCCESS;
+}
+
+bool VulkanSwapchain::CreateSwapchain()
+{
+	VulkanDevice* vulkanDevice = VulkanDevice::Get();
+	const VkPhysicalDevice physicalDevice = vulkanDevice->GetPhysicalDevice();
+	const VkSurfaceKHR surface = vulkanDevice->GetSurface();
+
+	VkSurfaceCapabilitiesKHR capabilities;
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR( physicalDevice, surface, &capabilities );
+
+	uint32_t formatCount = 0;
+	vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, surface, &formatCount, nullptr );
+	std::vector<VkSurfaceFormatKHR> formats( formatCount );
+	vkGetPhysicalDeviceSurfaceFormatsKHR( physicalDevice, surface, &formatCount, formats.data() );
+	if ( formats.empty() )
+	{
+		DEBUG_LOG( LOG::FATAL, "Vulkan surface has no formats!" );
+		CONSOLE_LOG( LOG::FATAL, "Vulkan surface has no formats!" );
+		return false;
+	}
+
+	// Linear like the GL window's default framebuffer, so both backends shade the same
+	VkSurfaceFormatKHR surfaceFormat = formats[0];
+	for ( const VkSurfaceFormatKHR& format : formats )
+	{
+		if ( ( format.format == VK_FORMAT_B8G8R8A8_UNORM || format.format == VK_FORMAT_R8G8B8A8_UNORM ) &&
+			format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR )
+		{
+			surfaceFormat = format;
+			break;
+		}
+	}
+	m_colourFormat = surfaceFormat.format;
+
+	// The surface sets the size unless it leaves it to the swapchain
+	if ( capabilities.currentExtent.width != UINT32_MAX )
+	{
+		m_extent = capabilities.currentExtent;
+	}
+	else
+	{
+		m_extent.width = std::clamp( static_cast<uint32_t>( m_window->GetWidth() ), capabilities.minImageExtent.width, capabilities.maxImageExtent.width );
+		m_extent.height = std::clamp( static_cast<uint32_t>( m_window->GetHeight() ), capabilities.minImageExtent.height, capabilities.maxImageExtent.height );
+	}
+
+	// One more than the minimum, so acquiring rarely waits for the presentation engine
+	uint32_t imageCount = capabilities.minImageCount + 1;
+	if ( capabilities.maxImageCount > 0 )
+	{
+		imageCount = std::min( imageCount, capabilities.maxImageCount );
+	}
+
+	VkSwapchainCreateInfoKHR swapchainInfo = {};
+	swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	swapchainInfo.surface = surface;
+	swapchainInfo.minImageCount = imageCount;
+	swapchainInfo.imageFormat = surfaceFormat.format;
+	swapchainInfo.imageColorSpace = surfaceFormat.colorSpace;
+	swapchainInfo.imageExtent = m_extent;
+	swapchainInfo.imageArrayLayers = 1;
+	swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	swapchainInfo.preTransform = capabilities.currentTransform;
+	swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	swapchainInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;	// Always supported, the engine limits its frame rate itself
+	swapchainInfo.clipped = VK_TRUE;
+
+	const VkDevice device = vulkanDevice->GetDevice();
+	if ( vkCreateSwapchainKHR( device, &swapchainInfo, nullptr, &m_swapchain ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan swapchain!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan swapchain!" );
+		return false;
+	}
+
+	vkGetSwapchainImagesKHR( device, m_swapchain, &imageCount, nullptr );
+	m_images.resize( imageCount );
+	vkGetSwapchainImagesKHR( device, m_swapchain, &imageCount, m_images.data() );
+
+	m_imageViews.resize( imageCount, VK_NULL_HANDLE );
+	for ( uint32_t i = 0; i < imageCount; ++i )
+	{
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = m_images[i];
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = m_colourFormat;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if ( vkCreateImageView( device, &viewInfo, nullptr, &m_imageViews[i] ) != VK_SUCCESS )
+		{
+			DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan swapchain image view!" );
+			CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan swapchain image view!" );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool VulkanSwapchain::CreateHeadlessImages()
+{
+	m_colourFormat = m_headlessFormat;
+	m_extent.width = static_cast<uint32_t>( m_window->GetWidth() );
+	m_extent.height = static_cast<uint32_t>( m_window->GetHeight() );
+	m_nextHeadlessImage = 0;
+
+	// One image per frame in flight, so a frame never draws into an image an earlier one is still drawing into
+	for ( uint32_t i = 0; i < VulkanDevice::m_frameCount; ++i )
+	{
+		VulkanImage image = VulkanDevice::Get()->CreateImage(
+			m_extent.width,
+			m_extent.height,
+			m_colourFormat,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_IMAGE_ASPECT_COLOR_BIT
+		);
+		if ( !image.IsValid() )
+		{
+			DEBUG_LOG( LOG::FATAL, "Failed to create headless Vulkan image!" );
+			CONSOLE_LOG( LOG::FATAL, "Failed to create headless Vulkan image!" );
+			return false;
+		}
+
+		m_headlessImages.push_back( image );
+		m_images.push_back( image.image );
+		m_imageViews.push_back( image.view );
+	}
+
+	return true;
+}
+
+bool VulkanSwapchain::CreateDepth()
+{
+	const VkFormat depthFormat = VulkanDevice::Get()->FindDepthFormat();
+	if ( depthFormat != VK_FORMAT_UNDEFINED )
+	{
+		m_depth = VulkanDevice::Get()->CreateImage( m_extent.width, m_extent.height, depthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT );
+	}
+
+	if ( !m_depth.IsValid() )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan depth buffer!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan depth buffer!" );
+		return false;
+	}
+
+	return true;
+}
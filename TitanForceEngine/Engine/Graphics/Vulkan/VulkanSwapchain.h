@@ -0,0 +1,84 @@
+#ifndef VULKANSWAPCHAIN_H
+#define VULKANSWAPCHAIN_H
+
+#include "VulkanDevice.h"
+
+#include <cstdint>
+#include <vector>
+
+class Window;
+
+// Images frames are drawn into, a swapchain presenting to the window's surface or, for a headless window, images of its
+// own that are never presented and stay readable once a frame has finished, see VulkanRenderer::SaveFrame
+// Every image shares a single depth buffer, frames drawing into it are ordered by the render pass
+class VulkanSwapchain
+{
+
+	VulkanSwapchain( const VulkanSwapchain& ) = delete;
+	VulkanSwapchain& operator=( const VulkanSwapchain& ) = delete;
+	VulkanSwapchain( VulkanSwapchain&& ) = delete;
+	VulkanSwapchain& operator=( VulkanSwapchain&& ) = delete;
+
+public:
+
+	// Format of a headless swapchain's images, read back as is by SaveFrame
+	static constexpr VkFormat m_headlessFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+	VulkanSwapchain();
+	~VulkanSwapchain();
+
+	// Creates the images at the window's size, and the framebuffers drawing into them with the passed render pass
+	// The render pass must be created with GetColourFormat and GetDepthFormat, which are known once OnCreate returns
+	bool OnCreate( Window* window );
+	bool CreateFramebuffers( const VkRenderPass renderPass );
+	void OnDestroy();
+
+	// Creates everything again at the window's current size, after the surface changed. The device must be idle
+	bool Recreate( const VkRenderPass renderPass );
+
+	// Picks the image the next frame draws into, signalling imageAvailable once it can be drawn into
+	// A headless swapchain takes its images in turn and signals nothing. Returns false if the swapchain is out of date
+	bool AcquireNextImage( const VkSemaphore imageAvailable, uint32_t& imageIndex );
+
+	// Presents the passed image once renderFinished is signalled, a headless swapchain keeps the image instead
+	// Returns false if the swapchain is out of date
+	bool Present( const VkSemaphore renderFinished, const uint32_t imageIndex );
+
+	bool IsHeadless() const { return m_isHeadless; }
+
+	VkFormat GetColourFormat() const { return m_colourFormat; }
+	VkFormat GetDepthFormat() const { return m_depth.format; }
+	VkExtent2D GetExtent() const { return m_extent; }
+
+	uint32_t GetImageCount() const { return static_cast<uint32_t>( m_images.size() ); }
+	VkImage GetImage( const uint32_t imageIndex ) const { return m_images[imageIndex]; }
+	VkFramebuffer GetFramebuffer( const uint32_t imageIndex ) const { return m_framebuffers[imageIndex]; }
+
+	// Layout images are left in at the end of a frame, for the render pass
+	VkImageLayout GetFinalLayout() const { return m_isHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+
+private:
+
+	Window*						m_window;
+	bool						m_isHeadless;
+
+	VkSwapchainKHR				m_swapchain;
+	VkFormat					m_colourFormat;
+	VkExtent2D					m_extent;
+
+	// Owned by the swapchain, or by m_headlessImages when headless
+	std::vector<VkImage>		m_images;
+	std::vector<VkImageView>	m_imageViews;
+	std::vector<VulkanImage>	m_headlessImages;
+	uint32_t					m_nextHeadlessImage;
+
+	VulkanImage					m_depth;
+	std::vector<VkFramebuffer>	m_framebuffers;
+
+	bool CreateSwapchain();
+	bool CreateHeadlessImages();
+	bool CreateDepth();
+
+};
+
+#endif // !VULKANSWAPCHAIN_H
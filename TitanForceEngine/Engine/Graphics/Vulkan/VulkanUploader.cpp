@@ -0,0 +1,349 @@
+#include "VulkanUploader.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+std::unique_ptr<VulkanUploader> VulkanUploader::g_vulkanUploaderInstance( nullptr );
+
+VulkanUploader::VulkanUploader() :
+	m_commandPool( VK_NULL_HANDLE ),
+	m_recording(),
+	m_isRecording( false ),
+	m_inFlight(),
+	m_freeBatches(),
+	m_uploadedBytes( 0 )
+{}
+
+VulkanUploader::~VulkanUploader()
+{
+	OnDestroy();
+}
+
+// Get Instance of Vulkan Uploader
+VulkanUploader* VulkanUploader::Get()
+{
+	if ( g_vulkanUploaderInstance == nullptr )
+	{
+		g_vulkanUploaderInstance.reset( new VulkanUploader );
+	}
+	return g_vulkanUploaderInstance.get();
+}
+
+// Creates the command pool batches are recorded from, the device must already be created
+bool VulkanUploader::OnCreate()
+{
+	VulkanDevice* device = VulkanDevice::Get();
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = device->GetQueueFamily();
+
+	if ( vkCreateCommandPool( device->GetDevice(), &poolInfo, nullptr, &m_commandPool ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::FATAL, "Failed to create Vulkan upload command pool!" );
+		CONSOLE_LOG( LOG::FATAL, "Failed to create Vulkan upload command pool!" );
+		return false;
+	}
+
+	return true;
+}
+
+// Waits for the batches in flight and drops every queued copy without telling its owner
+void VulkanUploader::OnDestroy()
+{
+	VulkanDevice* device = VulkanDevice::Get();
+	if ( m_commandPool == VK_NULL_HANDLE || !device->IsCreated() )
+	{
+		return;
+	}
+
+	vkQueueWaitIdle( device->GetQueue() );
+
+	if ( m_isRecording )
+	{
+		vkEndCommandBuffer( m_recording.commandBuffer );
+		m_freeBatches.push_back( m_recording );
+		m_isRecording = false;
+	}
+	for ( Batch& batch : m_inFlight )
+	{
+		m_freeBatches.push_back( batch );
+	}
+	m_inFlight.clear();
+
+	for ( Batch& batch : m_freeBatches )
+	{
+		FinishBatch( batch, false );
+		vkDestroyFence( device->GetDevice(), batch.fence, nullptr );
+	}
+	m_freeBatches.clear();
+
+	// Frees every command buffer allocated from it
+	vkDestroyCommandPool( device->GetDevice(), m_commandPool, nullptr );
+	m_commandPool = VK_NULL_HANDLE;
+}
+
+// Copies the passed bytes into a staging buffer and queues their copy into the destination at the passed offset
+// Returns false if no staging buffer could be created
+bool VulkanUploader::WriteBuffer( const VkBuffer destination, const VkDeviceSize offset, const void* data, const size_t size )
+{
+	if ( size == 0 )
+	{
+		return true;
+	}
+
+	const VulkanBuffer staging = Stage( data, size );
+	if ( !staging.IsValid() )
+	{
+		return false;
+	}
+
+	VkBufferCopy region = {};
+	region.srcOffset = 0;
+	region.dstOffset = offset;
+	region.size = size;
+	vkCmdCopyBuffer( m_recording.commandBuffer, staging.buffer, destination, 1, &region );
+
+	return true;
+}
+
+// Copies the passed tightly packed pixels into a staging buffer and queues their copy into the whole image
+// The image's previous contents are discarded, and it is left ready to be sampled by fragment shaders
+// Returns false if no staging buffer could be created
+bool VulkanUploader::WriteImage( const VulkanImage& destination, const uint32_t width, const uint32_t height, const void* data, const size_t size )
+{
+	const VulkanBuffer staging = Stage( data, size );
+	if ( !staging.IsValid() )
+	{
+		return false;
+	}
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = destination.image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier( m_recording.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { width, height, 1 };
+	vkCmdCopyBufferToImage( m_recording.commandBuffer, staging.buffer, destination.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+
+	// Images are only ever sampled, so the layout transition also makes the copy visible to draws submitted later
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier( m_recording.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier );
+
+	return true;
+}
+
+// Calls complete once every copy queued so far has finished, from ProcessCompleted
+void VulkanUploader::OnComplete( const void* owner, CompleteFunction complete )
+{
+	if ( BeginBatch() )
+	{
+		m_recording.completions.push_back( Completion{ owner, std::move( complete ) } );
+	}
+}
+
+// Drops every completion the passed owner is waiting for, the copies themselves still finish
+void VulkanUploader::Cancel( const void* owner )
+{
+	auto removeOwner = [owner]( Batch& batch )
+	{
+		batch.completions.erase(
+			std::remove_if( batch.completions.begin(), batch.completions.end(),
+				[owner]( const Completion& completion ) { return completion.owner == owner; } ),
+			batch.completions.end()
+		);
+	};
+
+	if ( m_isRecording )
+	{
+		removeOwner( m_recording );
+	}
+	for ( Batch& batch : m_inFlight )
+	{
+		removeOwner( batch );
+	}
+}
+
+// Submits the copies queued since the last call, they can be read by anything submitted after them
+void VulkanUploader::Submit()
+{
+	if ( !m_isRecording )
+	{
+		return;
+	}
+
+	// Draws submitted later on the same queue read the copied buffers as vertices and indices, images have already
+	// been transitioned by WriteImage
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(
+		m_recording.commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr
+	);
+	vkEndCommandBuffer( m_recording.commandBuffer );
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_recording.commandBuffer;
+
+	vkResetFences( VulkanDevice::Get()->GetDevice(), 1, &m_recording.fence );
+	if ( vkQueueSubmit( VulkanDevice::Get()->GetQueue(), 1, &submitInfo, m_recording.fence ) != VK_SUCCESS )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Failed to submit Vulkan uploads!" );
+		CONSOLE_LOG( LOG::ERRORLOG, "Failed to submit Vulkan uploads!" );
+	}
+
+	m_inFlight.push_back( m_recording );
+	m_recording = Batch{};
+	m_isRecording = false;
+}
+
+// Frees the staging buffers of finished batches and hands them back to their owners
+void VulkanUploader::ProcessCompleted()
+{
+	const VkDevice device = VulkanDevice::Get()->GetDevice();
+
+	// Batches finish in the order they were submitted
+	while ( !m_inFlight.empty() && vkGetFenceStatus( device, m_inFlight.front().fence ) == VK_SUCCESS )
+	{
+		Batch batch = m_inFlight.front();
+		m_inFlight.pop_front();
+
+		FinishBatch( batch, true );
+		m_freeBatches.push_back( batch );
+	}
+}
+
+// Returns the bytes copied into staging buffers since the last call
+size_t VulkanUploader::TakeUploadedBytes()
+{
+	const size_t uploadedBytes = m_uploadedBytes;
+	m_uploadedBytes = 0;
+	return uploadedBytes;
+}
+
+// Returns the number of batches queued or submitted that have not been handed back yet
+size_t VulkanUploader::GetPendingCount() const
+{
+	return m_inFlight.size() + ( m_isRecording ? 1 : 0 );
+}
+
+// Starts recording a batch if none is being recorded
+bool VulkanUploader::BeginBatch()
+{
+	if ( m_isRecording )
+	{
+		return true;
+	}
+
+	const VkDevice device = VulkanDevice::Get()->GetDevice();
+
+	if ( !m_freeBatches.empty() )
+	{
+		m_recording = m_freeBatches.back();
+		m_freeBatches.pop_back();
+		vkResetCommandBuffer( m_recording.commandBuffer, 0 );
+	}
+	else
+	{
+		m_recording = Batch{};
+
+		VkCommandBufferAllocateInfo allocateInfo = {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = m_commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = 1;
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if ( vkAllocateCommandBuffers( device, &allocateInfo, &m_recording.commandBuffer ) != VK_SUCCESS ||
+			vkCreateFence( device, &fenceInfo, nullptr, &m_recording.fence ) != VK_SUCCESS )
+		{
+			DEBUG_LOG( LOG::ERRORLOG, "Failed to create a Vulkan upload batch!" );
+			CONSOLE_LOG( LOG::ERRORLOG, "Failed to create a Vulkan upload batch!" );
+			return false;
+		}
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer( m_recording.commandBuffer, &beginInfo );
+
+	m_isRecording = true;
+	return true;
+}
+
+// Frees the batch's staging buffers and calls its completions
+void VulkanUploader::FinishBatch( Batch& batch, const bool notifyOwners )
+{
+	for ( VulkanBuffer& staging : batch.stagingBuffers )
+	{
+		VulkanDevice::Get()->DestroyBuffer( staging );
+	}
+	batch.stagingBuffers.clear();
+
+	if ( notifyOwners )
+	{
+		for ( Completion& completion : batch.completions )
+		{
+			completion.complete();
+		}
+	}
+	batch.completions.clear();
+}
+
+// Copies the passed bytes into a new staging buffer kept by the recording batch, returns an invalid buffer on failure
+VulkanBuffer VulkanUploader::Stage( const void* data, const size_t size )
+{
+	if ( !BeginBatch() )
+	{
+		return VulkanBuffer{};
+	}
+
+	VulkanBuffer staging = VulkanDevice::Get()->CreateBuffer(
+		size,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+	);
+	if ( !staging.IsValid() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Failed to create a staging buffer of " + std::to_string( size ) + " bytes" );
+		CONSOLE_LOG( LOG::WARNING, "Failed to create a staging buffer of " + std::to_string( size ) + " bytes" );
+		return VulkanBuffer{};
+	}
+
+	std::memcpy( staging.mapped, data, size );
+	m_recording.stagingBuffers.push_back( staging );
+	m_uploadedBytes += size;
+
+	return staging;
+}
@@ -0,0 +1,110 @@
+#ifndef VULKANUPLOADER_H
+#define VULKANUPLOADER_H
+
+#include "VulkanDevice.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Singleton copying data into device local buffers and images through host visible staging buffers, render thread only
+// Copies queued during a frame are recorded into a single command buffer and submitted together, each batch is fenced
+// and its staging buffers are only freed, and its owners told, once the GPU has finished with it
+class VulkanUploader
+{
+
+	VulkanUploader( const VulkanUploader& ) = delete;
+	VulkanUploader& operator=( const VulkanUploader& ) = delete;
+	VulkanUploader( VulkanUploader&& ) = delete;
+	VulkanUploader& operator=( VulkanUploader&& ) = delete;
+
+public:
+
+	// Runs on the render thread once every copy queued before it has finished
+	using CompleteFunction = std::function<void()>;
+
+	// Get Instance of Vulkan Uploader
+	static VulkanUploader* Get();
+
+	// Creates the command pool batches are recorded from, the device must already be created
+	bool OnCreate();
+
+	// Waits for the batches in flight and drops every queued copy without telling its owner
+	void OnDestroy();
+
+	// Copies the passed bytes into a staging buffer and queues their copy into the destination at the passed offset
+	// Returns false if no staging buffer could be created
+	bool WriteBuffer( const VkBuffer destination, const VkDeviceSize offset, const void* data, const size_t size );
+
+	// Copies the passed tightly packed pixels into a staging buffer and queues their copy into the whole image
+	// The image's previous contents are discarded, and it is left ready to be sampled by fragment shaders
+	// Returns false if no staging buffer could be created
+	bool WriteImage( const VulkanImage& destination, const uint32_t width, const uint32_t height, const void* data, const size_t size );
+
+	// Calls complete once every copy queued so far has finished, from ProcessCompleted
+	void OnComplete( const void* owner, CompleteFunction complete );
+
+	// Drops every completion the passed owner is waiting for, the copies themselves still finish
+	void Cancel( const void* owner );
+
+	// Submits the copies queued since the last call, they can be read by anything submitted after them
+	void Submit();
+
+	// Frees the staging buffers of finished batches and hands them back to their owners
+	void ProcessCompleted();
+
+	// Returns the bytes copied into staging buffers since the last call
+	size_t TakeUploadedBytes();
+
+	// Returns the number of batches queued or submitted that have not been handed back yet
+	size_t GetPendingCount() const;
+
+private:
+
+	VulkanUploader();
+	~VulkanUploader();
+
+	static std::unique_ptr<VulkanUploader> g_vulkanUploaderInstance;
+	friend std::default_delete<VulkanUploader>;
+
+	struct Completion
+	{
+		const void*			owner;
+		CompleteFunction	complete;
+	};
+
+	struct Batch
+	{
+		VkCommandBuffer				commandBuffer;
+		VkFence						fence;
+		std::vector<VulkanBuffer>	stagingBuffers;
+		std::vector<Completion>		completions;
+	};
+
+	VkCommandPool			m_commandPool;
+
+	// Batch copies are currently recorded into, and the submitted ones oldest first
+	Batch					m_recording;
+	bool					m_isRecording;
+	std::deque<Batch>		m_inFlight;
+
+	// Batches whose fence signalled, reused instead of allocating new command buffers and fences
+	std::vector<Batch>		m_freeBatches;
+
+	size_t					m_uploadedBytes;
+
+	// Starts recording a batch if none is being recorded
+	bool BeginBatch();
+
+	// Frees the batch's staging buffers and calls its completions
+	void FinishBatch( Batch& batch, const bool notifyOwners );
+
+	// Copies the passed bytes into a new staging buffer kept by the recording batch, returns an invalid buffer on failure
+	VulkanBuffer Stage( const void* data, const size_t size );
+
+};
+
+#endif // !VULKANUPLOADER_H
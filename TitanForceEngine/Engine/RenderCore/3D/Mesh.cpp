@@ -1,30 +1,49 @@
 #include "Mesh.h"
 
-#include "MeshLoader.h"
+#include "../Loading/AssetLoader.h"
+#include "../../Core/MappedFile.h"
+
+SubMesh::SubMesh() :
+	layout( VertexLayouts::Standard ),
+	vertexCount( 0 ),
+	indexCount( 0 ),
+	indexSize( sizeof( uint32_t ) ),
+	lodCount( 0 ),
+	lods(),
+	ranges(),
+	boundsMin( 0.0f ),
+	boundsMax( 0.0f ),
+	vertexStreams(),
+	indexStream(),
+	mappedFile( nullptr )
+{}
+
+SubMesh::~SubMesh()
+{
+	if ( mappedFile )
+	{
+		delete mappedFile;
+		mappedFile = nullptr;
+	}
+}
 
 IMesh::IMesh( const char * objFileName ) :
-	m_subMesh( MeshLoader::LoadMesh( objFileName ) )
+	m_subMesh( nullptr ),
+	m_isReady( false )
 {
-	// ObjLoader will statically load in the passed obj file name
-	// Storing the result inside of m_subMesh
+	// Loaded on a worker thread, then finalized through OnSubMeshLoaded
+	AssetLoader::Get()->LoadMesh( this, objFileName );
 }
 
 IMesh::~IMesh()
 {
-	if ( m_subMesh )
-	{
-		if ( m_subMesh->vertexList.size() > 0 )
-		{
-			m_subMesh->vertexList.clear();
-		}
-
-		if ( m_subMesh->meshIndices.size() > 0 )
-		{
-			m_subMesh->meshIndices.clear();
-		}
-
-		delete m_subMesh;
-		m_subMesh = nullptr;
-	}
+	AssetLoader::Get()->Cancel( this );
+	m_subMesh.reset();
+}
 
+// Called on the render thread by the AssetLoader once the sub mesh has been loaded
+void IMesh::OnSubMeshLoaded( const std::shared_ptr<SubMesh>& subMesh )
+{
+	m_subMesh = subMesh;
+	GenerateBuffers();
 }
@@ -1,41 +1,126 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include "VertexLayout.h"
+
 #include <glm.hpp>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
-// A simple vertex layout
+class MappedFile;
+
+// Full precision vertex used while loading and processing meshes, see VertexLayout for how it is stored on the GPU
 struct Vertex
 {
 	glm::vec3 position;
 	glm::vec3 normal;
 	glm::vec2 texCoords;
 	glm::vec3 colour;
+
+	bool operator==( const Vertex& other ) const
+	{
+		return position == other.position &&
+			normal == other.normal &&
+			texCoords == other.texCoords &&
+			colour == other.colour;
+	}
+};
+
+// Read only view over packed mesh bytes
+struct MeshBlob
+{
+	const unsigned char*	data;
+	size_t					size;
+};
+
+// Range of a sub mesh's index buffer drawing one level of detail, every level indexes the same vertices
+struct MeshLod
+{
+	uint32_t	firstIndex;
+	uint32_t	indexCount;
+	float		error;		// Furthest the level's surface may be from the full detail surface, in mesh units
+	uint32_t	firstRange;	// Of the level's entries in SubMesh::ranges, which cover its indices back to back
+	uint32_t	rangeCount;
+};
+
+// Range of a level of detail's indices whose faces came from one OBJ shape and share one of its materials
+struct MeshRange
+{
+	uint32_t	firstIndex;
+	uint32_t	indexCount;
+	uint32_t	materialIndex;	// Entry of the OBJ's material list, SubMesh::m_noMaterial if the faces have none
 };
 
 struct SubMesh
 {
+	// Levels of detail stored per sub mesh, including the full detail level 0
+	static constexpr uint32_t m_maxLods = 5;
+
+	// MeshRange::materialIndex of faces without a material
+	static constexpr uint32_t m_noMaterial = 0xFFFFFFFF;
+
+	SubMesh();
+	~SubMesh();
+
+	// Full precision vertices and indices, only available when the mesh was parsed from its source file
 	std::vector<Vertex>			vertexList;
-	std::vector<int>			meshIndices;
+	std::vector<unsigned int>	meshIndices;
+
+	VertexLayout				layout;
+	uint32_t					vertexCount;
+	uint32_t					indexCount;		// Of every level of detail together
+	uint32_t					indexSize;		// Bytes per index, 2 or 4
+	uint32_t					lodCount;
+	std::array<MeshLod, m_maxLods>	lods;		// Coarser with every level, each one's indices follow the previous one's
+	std::vector<MeshRange>		ranges;		// Of every level in turn, each level's ranges are simplified from the previous level's
+	glm::vec3					boundsMin;
+	glm::vec3					boundsMax;
+
+	// GPU ready vertex streams, packed with the layout above, and index buffer
+	std::array<MeshBlob, VertexLayout::m_maxStreams>	vertexStreams;
+	MeshBlob					indexStream;
+
+	// Storage the blobs point into, either packed here or inside of a memory mapped cooked mesh file
+	std::array<std::vector<unsigned char>, VertexLayout::m_maxStreams>	packedVertices;
+	std::vector<unsigned char>	packedIndices;
+	MappedFile*					mappedFile;
 };
 
 class IMesh
 {
+	friend class AssetLoader;
 
 public:
 
+	// Queues the passed obj file to be loaded asynchronously, the mesh draws nothing until it has been loaded
 	explicit IMesh( const char* objFileName );
 
 	virtual ~IMesh();
 
+	// Returns true once the mesh has been loaded and its buffers generated
+	bool IsReady() const { return m_isReady; }
+
+	// Null until the mesh has been loaded
+	const SubMesh* GetSubMesh() const { return m_subMesh.get(); }
+
 	virtual void Render() = 0;
 
+	// Draws only vertex positions, for depth only passes
+	virtual void RenderDepthOnly() = 0;
+
 protected:
 
-	SubMesh*		m_subMesh;
+	// Shared between every mesh loaded from the same file
+	std::shared_ptr<SubMesh>	m_subMesh;
+	bool						m_isReady;
 
+	// Creates the GPU buffers for m_subMesh, setting m_isReady once they can be drawn, which may be on a later frame
 	virtual void GenerateBuffers() = 0;
 
+	// Called on the render thread by the AssetLoader once the sub mesh has been loaded
+	void OnSubMeshLoaded( const std::shared_ptr<SubMesh>& subMesh );
+
 };
 
 
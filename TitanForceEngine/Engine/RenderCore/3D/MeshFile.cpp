@@ -0,0 +1,217 @@
+#include "MeshFile.h"
+
+#include "../../Core/MappedFile.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	uint64_t AlignOffset( const uint64_t offset )
+	{
+		return ( offset + MeshFile::m_blobAlignment - 1 ) & ~( MeshFile::m_blobAlignment - 1 );
+	}
+
+	void WritePadding( std::ofstream& file, const uint64_t offset )
+	{
+		static const char zeros[MeshFile::m_blobAlignment] = {};
+		const uint64_t padding = AlignOffset( offset ) - offset;
+		file.write( zeros, static_cast<std::streamsize>( padding ) );
+	}
+
+	bool BlobInFile( const uint64_t offset, const uint64_t size, const size_t fileSize )
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+}
+
+// Writes the packed streams of the passed sub mesh, returns false if the file cannot be written
+bool MeshFile::Write( const std::string& filePath, const SubMesh& subMesh, const SourceStamp& source )
+{
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( filePath ).parent_path(), error );
+
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Cannot write cooked mesh: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Cannot write cooked mesh: " + filePath );
+		return false;
+	}
+
+	Header header = {};
+	header.magic = m_magic;
+	header.version = m_version;
+	header.source = source;
+	for ( size_t a = 0; a < subMesh.layout.attributes.size(); ++a )
+	{
+		header.attributeFormats[a] = static_cast<uint32_t>( subMesh.layout.attributes[a].format );
+	}
+	header.vertexCount = subMesh.vertexCount;
+	header.indexCount = subMesh.indexCount;
+	header.indexSize = subMesh.indexSize;
+	header.subMeshCount = static_cast<uint32_t>( subMesh.ranges.size() );
+	header.lodCount = subMesh.lodCount;
+	for ( uint32_t l = 0; l < subMesh.lodCount; ++l )
+	{
+		header.lods[l] = subMesh.lods[l];
+	}
+	for ( int i = 0; i < 3; ++i )
+	{
+		header.boundsMin[i] = subMesh.boundsMin[i];
+		header.boundsMax[i] = subMesh.boundsMax[i];
+	}
+
+	uint64_t offset = sizeof( Header ) + sizeof( SubMeshEntry ) * header.subMeshCount;
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		offset = AlignOffset( offset );
+		header.vertexStreamOffsets[s] = offset;
+		header.vertexStreamSizes[s] = subMesh.vertexStreams[s].size;
+		offset += subMesh.vertexStreams[s].size;
+	}
+	offset = AlignOffset( offset );
+	header.indexOffset = offset;
+	header.indexBytes = subMesh.indexStream.size;
+
+	file.write( reinterpret_cast<const char*>( &header ), sizeof( Header ) );
+
+	// Every range indexes the shared vertex streams directly
+	for ( const MeshRange& range : subMesh.ranges )
+	{
+		SubMeshEntry entry = {};
+		entry.firstIndex = range.firstIndex;
+		entry.indexCount = range.indexCount;
+		entry.baseVertex = 0;
+		entry.materialIndex = range.materialIndex;
+		file.write( reinterpret_cast<const char*>( &entry ), sizeof( SubMeshEntry ) );
+	}
+	offset = sizeof( Header ) + sizeof( SubMeshEntry ) * header.subMeshCount;
+
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		WritePadding( file, offset );
+		offset = AlignOffset( offset );
+		file.write( reinterpret_cast<const char*>( subMesh.vertexStreams[s].data ), static_cast<std::streamsize>( subMesh.vertexStreams[s].size ) );
+		offset += subMesh.vertexStreams[s].size;
+	}
+
+	WritePadding( file, offset );
+	file.write( reinterpret_cast<const char*>( subMesh.indexStream.data ), static_cast<std::streamsize>( subMesh.indexStream.size ) );
+
+	if ( !file.good() )
+	{
+		file.close();
+		std::filesystem::remove( filePath, error );
+		DEBUG_LOG( LOG::WARNING, "Failed writing cooked mesh: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Failed writing cooked mesh: " + filePath );
+		return false;
+	}
+
+	return true;
+}
+
+// Maps the cooked mesh at the passed path, the returned sub mesh points straight into the mapped file
+// Returns null if the file is missing, corrupt, from another version or was cooked from a different source
+SubMesh* MeshFile::Read( const std::string& filePath, const SourceStamp& source )
+{
+	MappedFile* mappedFile = new MappedFile();
+	if ( !mappedFile->Open( filePath ) )
+	{
+		delete mappedFile;
+		return nullptr;
+	}
+
+	const size_t fileSize = mappedFile->GetSize();
+	if ( fileSize < sizeof( Header ) )
+	{
+		delete mappedFile;
+		return nullptr;
+	}
+
+	const Header* header = reinterpret_cast<const Header*>( mappedFile->GetData() );
+	if ( header->magic != m_magic ||
+		header->version != m_version ||
+		header->source != source )
+		// Stale cooked files are ignored, the caller cooks a new one from source
+	{
+		delete mappedFile;
+		return nullptr;
+	}
+
+	const VertexLayout layout = MakeVertexLayout(
+		static_cast<EVertexFormat>( header->attributeFormats[static_cast<int>( EVertexAttribute::Position )] ),
+		static_cast<EVertexFormat>( header->attributeFormats[static_cast<int>( EVertexAttribute::Normal )] ),
+		static_cast<EVertexFormat>( header->attributeFormats[static_cast<int>( EVertexAttribute::TexCoords )] ),
+		static_cast<EVertexFormat>( header->attributeFormats[static_cast<int>( EVertexAttribute::Colour )] )
+	);
+
+	bool valid = ( header->indexSize == 2 || header->indexSize == 4 ) &&
+		BlobInFile( header->indexOffset, header->indexBytes, fileSize ) &&
+		header->indexBytes == static_cast<uint64_t>( header->indexCount ) * header->indexSize &&
+		header->lodCount > 0 && header->lodCount <= SubMesh::m_maxLods &&
+		BlobInFile( sizeof( Header ), static_cast<uint64_t>( header->subMeshCount ) * sizeof( SubMeshEntry ), fileSize );
+
+	// Every level's ranges have to cover its indices back to back
+	const SubMeshEntry* entries = reinterpret_cast<const SubMeshEntry*>( mappedFile->GetData() + sizeof( Header ) );
+	for ( uint32_t l = 0; valid && l < header->lodCount; ++l )
+	{
+		const MeshLod& lod = header->lods[l];
+		valid = lod.firstIndex <= header->indexCount &&
+			lod.indexCount <= header->indexCount - lod.firstIndex &&
+			lod.firstRange <= header->subMeshCount &&
+			lod.rangeCount <= header->subMeshCount - lod.firstRange;
+
+		uint64_t next = lod.firstIndex;
+		for ( uint32_t e = lod.firstRange; valid && e < lod.firstRange + lod.rangeCount; ++e )
+		{
+			valid = entries[e].baseVertex == 0 && entries[e].firstIndex == next;
+			next += entries[e].indexCount;
+		}
+		valid = valid && next == static_cast<uint64_t>( lod.firstIndex ) + lod.indexCount;
+	}
+
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		valid = valid && BlobInFile( header->vertexStreamOffsets[s], header->vertexStreamSizes[s], fileSize ) &&
+			header->vertexStreamSizes[s] == static_cast<uint64_t>( header->vertexCount ) * layout.strides[s];
+	}
+
+	if ( !valid )
+	{
+		DEBUG_LOG( LOG::WARNING, "Corrupt cooked mesh: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Corrupt cooked mesh: " + filePath );
+		delete mappedFile;
+		return nullptr;
+	}
+
+	SubMesh* subMesh = new SubMesh();
+	subMesh->layout = layout;
+	subMesh->vertexCount = header->vertexCount;
+	subMesh->indexCount = header->indexCount;
+	subMesh->indexSize = header->indexSize;
+	subMesh->lodCount = header->lodCount;
+	for ( uint32_t l = 0; l < header->lodCount; ++l )
+	{
+		subMesh->lods[l] = header->lods[l];
+	}
+	subMesh->ranges.reserve( header->subMeshCount );
+	for ( uint32_t e = 0; e < header->subMeshCount; ++e )
+	{
+		subMesh->ranges.push_back( MeshRange{ entries[e].firstIndex, entries[e].indexCount, entries[e].materialIndex } );
+	}
+	subMesh->boundsMin = glm::vec3( header->boundsMin[0], header->boundsMin[1], header->boundsMin[2] );
+	subMesh->boundsMax = glm::vec3( header->boundsMax[0], header->boundsMax[1], header->boundsMax[2] );
+
+	const unsigned char* base = mappedFile->GetData();
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		subMesh->vertexStreams[s] = { base + header->vertexStreamOffsets[s], static_cast<size_t>( header->vertexStreamSizes[s] ) };
+	}
+	subMesh->indexStream = { base + header->indexOffset, static_cast<size_t>( header->indexBytes ) };
+	subMesh->mappedFile = mappedFile;
+
+	return subMesh;
+}
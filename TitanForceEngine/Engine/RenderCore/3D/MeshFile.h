@@ -0,0 +1,69 @@
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include "Mesh.h"
+#include "../../Core/SourceStamp.h"
+
+#include <cstdint>
+#include <string>
+
+// Cooked, memory mappable binary mesh container
+//
+// [Header][SubMeshEntry * subMeshCount][vertex stream 0][vertex stream 1][indices]
+// Every blob starts on a m_blobAlignment boundary and is read in place from the mapped file
+// The index blob holds every level of detail back to back, the header stores each level's range and the entries
+// split every level into the ranges of its materials, see MeshLod::firstRange
+class MeshFile
+{
+
+	MeshFile() = delete;	// Static class, no constructor needed
+	MeshFile( const MeshFile& ) = delete;
+	MeshFile& operator=( const MeshFile& ) = delete;
+	MeshFile( MeshFile&& ) = delete;
+	MeshFile& operator=( MeshFile&& ) = delete;
+
+public:
+
+	static constexpr uint32_t m_magic = 0x48534D54;	// "TMSH"
+	static constexpr uint32_t m_version = 4;
+	static constexpr uint64_t m_blobAlignment = 16;
+
+	struct Header
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		SourceStamp	source;
+		uint32_t	attributeFormats[static_cast<int>( EVertexAttribute::TOTAL )];
+		uint32_t	vertexCount;
+		uint32_t	indexCount;
+		uint32_t	indexSize;
+		uint32_t	subMeshCount;
+		uint32_t	lodCount;
+		MeshLod		lods[SubMesh::m_maxLods];
+		float		boundsMin[3];
+		float		boundsMax[3];
+		uint64_t	vertexStreamOffsets[VertexLayout::m_maxStreams];
+		uint64_t	vertexStreamSizes[VertexLayout::m_maxStreams];
+		uint64_t	indexOffset;
+		uint64_t	indexBytes;
+	};
+
+	// Range of the index buffer drawn as one part of the mesh, one per MeshRange of every level
+	struct SubMeshEntry
+	{
+		uint32_t	firstIndex;
+		uint32_t	indexCount;
+		uint32_t	baseVertex;
+		uint32_t	materialIndex;
+	};
+
+	// Writes the packed streams of the passed sub mesh, returns false if the file cannot be written
+	static bool Write( const std::string& filePath, const SubMesh& subMesh, const SourceStamp& source );
+
+	// Maps the cooked mesh at the passed path, the returned sub mesh points straight into the mapped file
+	// Returns null if the file is missing, corrupt, from another version or was cooked from a different source
+	static SubMesh* Read( const std::string& filePath, const SourceStamp& source );
+
+};
+
+#endif // !MESHFILE_H
@@ -1,18 +1,113 @@
 #include "MeshLoader.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 
 #include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
 
+#include <algorithm>
 #include <fstream>
+#include <cstring>
+#include <functional>
+#include <limits>
 #include <sstream>
+#include <unordered_map>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
-// Loads Obj from the passed obj file name, if the file does not exist or is unreadable, this function returns null
-SubMesh * MeshLoader::LoadMesh( const std::string & fileName )
+namespace
 {
+	void HashCombine( size_t& hash, const float value )
+	{
+		hash ^= std::hash<float>()( value ) + 0x9e3779b9 + ( hash << 6 ) + ( hash >> 2 );
+	}
+
+	// Hashes every component of a vertex, so identical face corners can be welded together
+	struct VertexHasher
+	{
+		size_t operator()( const Vertex& v ) const
+		{
+			size_t hash = 0;
+			HashCombine( hash, v.position.x );
+			HashCombine( hash, v.position.y );
+			HashCombine( hash, v.position.z );
+			HashCombine( hash, v.normal.x );
+			HashCombine( hash, v.normal.y );
+			HashCombine( hash, v.normal.z );
+			HashCombine( hash, v.texCoords.x );
+			HashCombine( hash, v.texCoords.y );
+			return hash;
+		}
+	};
+}
+
+// Loads Obj from the passed obj file name, throws std::runtime_error if the file does not exist or is unreadable
+SubMesh * MeshLoader::LoadMesh( const std::string & fileName, const VertexLayout& layout )
+{
+	const std::string sourceFilePath = GetSourceFilePath( fileName );
+	const std::string cookedFilePath = GetCookedFilePath( fileName );
+
+	SourceStamp source = {};
+	const bool hasSource = SourceStamp::Read( sourceFilePath, source );
+
+	if ( hasSource )
+	{
+		SubMesh* cooked = MeshFile::Read( cookedFilePath, source );
+		if ( cooked && cooked->layout.GetId() == layout.GetId() )
+		{
+			DEBUG_LOG( LOG::INFO, "Mapped cooked mesh: " + cookedFilePath );
+			CONSOLE_LOG( LOG::INFO, "Mapped cooked mesh: " + cookedFilePath );
+			return cooked;
+		}
+		delete cooked;
+	}
+
+	SubMesh* subMesh = LoadObj( sourceFilePath, layout );
+
+	if ( hasSource )
+		// Cooking for the next run, a failed write only costs the next run another OBJ parse
+	{
+		MeshFile::Write( cookedFilePath, *subMesh, source );
+	}
+
+	return subMesh;
+}
+
+// Parses the passed OBJ file and writes its cooked binary, returns false if the file is missing or cannot be written
+// Throws std::runtime_error if the OBJ cannot be parsed
+bool MeshLoader::CookMesh( const std::string& fileName, const VertexLayout& layout )
+{
+	const std::string sourceFilePath = GetSourceFilePath( fileName );
 
-	std::string relativeFilePath = "./Resources/Models/" + fileName;
+	SourceStamp source = {};
+	if ( !SourceStamp::Read( sourceFilePath, source ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot cook missing OBJ file: " + sourceFilePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot cook missing OBJ file: " + sourceFilePath );
+		return false;
+	}
+
+	SubMesh* subMesh = LoadObj( sourceFilePath, layout );
+	const bool result = MeshFile::Write( GetCookedFilePath( fileName ), *subMesh, source );
+	delete subMesh;
+	return result;
+}
+
+std::string MeshLoader::GetSourceFilePath( const std::string& fileName )
+{
+	return "./Resources/Models/" + fileName;
+}
+
+std::string MeshLoader::GetCookedFilePath( const std::string& fileName )
+{
+	return "./Resources/Models/Cooked/" + fileName + ".tmsh";
+}
+
+// Parses, welds and optimizes the OBJ file at the passed path, throws std::runtime_error if it cannot be parsed
+// Faces are kept in one MeshRange per shape and material, in the order they first appear in the file
+SubMesh* MeshLoader::LoadObj( const std::string& relativeFilePath, const VertexLayout& layout )
+{
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
@@ -30,33 +125,255 @@ SubMesh * MeshLoader::LoadMesh( const std::string & fileName )
 
 	SubMesh* subMesh = new SubMesh();
 
+	// Welding identical face corners into a single vertex, referenced by index
+	std::unordered_map<Vertex, unsigned int, VertexHasher> uniqueVertices;
+	size_t cornerCount = 0;
+
+	// Faces of one shape sharing a material, optimized on their own so they stay one contiguous range
+	struct FaceGroup
+	{
+		uint32_t					materialIndex;
+		std::vector<unsigned int>	indices;
+	};
+	std::vector<FaceGroup> groups;
+
 	for ( const auto& shape : shapes )
 	{
-		for ( auto index : shape.mesh.indices )
+		cornerCount += shape.mesh.indices.size();
+		uniqueVertices.reserve( cornerCount );
+		const size_t firstGroup = groups.size();
+
+		for ( size_t i = 0; i + 2 < shape.mesh.indices.size(); i += 3 )
 		{
-			Vertex v;
-			v.position.x = attrib.vertices[3 * index.vertex_index + 0];
-			v.position.y = attrib.vertices[3 * index.vertex_index + 1];
-			v.position.z = attrib.vertices[3 * index.vertex_index + 2];
+			unsigned int triangle[3];
+			for ( size_t k = 0; k < 3; ++k )
+			{
+				const tinyobj::index_t& index = shape.mesh.indices[i + k];
+
+				Vertex v;
+				v.position.x = attrib.vertices[3 * index.vertex_index + 0];
+				v.position.y = attrib.vertices[3 * index.vertex_index + 1];
+				v.position.z = attrib.vertices[3 * index.vertex_index + 2];
+
+				v.normal = glm::vec3( 0.0f );
+				if ( index.normal_index >= 0 )
+				{
+					v.normal.x = attrib.normals[3 * index.normal_index + 0];
+					v.normal.y = attrib.normals[3 * index.normal_index + 1];
+					v.normal.z = attrib.normals[3 * index.normal_index + 2];
+				}
 
-			v.normal.x = attrib.normals[3 * index.normal_index + 0];
-			v.normal.y = attrib.normals[3 * index.normal_index + 1];
-			v.normal.z = attrib.normals[3 * index.normal_index + 2];
+				v.texCoords = glm::vec2( 0.0f );
+				if ( index.texcoord_index >= 0 )
+				{
+					v.texCoords.x = attrib.texcoords[2 * index.texcoord_index + 0];
+					v.texCoords.y = attrib.texcoords[2 * index.texcoord_index + 1];
+				}
 
-			v.texCoords.x = attrib.texcoords[2 * index.texcoord_index + 0];
-			v.texCoords.y = attrib.texcoords[2 * index.texcoord_index + 0];
+				v.colour = glm::vec3( 1.0f );
+				if ( attrib.colors.size() == attrib.vertices.size() )
+				{
+					v.colour.x = attrib.colors[3 * index.vertex_index + 0];
+					v.colour.y = attrib.colors[3 * index.vertex_index + 1];
+					v.colour.z = attrib.colors[3 * index.vertex_index + 2];
+				}
 
-			v.colour = glm::vec3( 1.0f );
+				auto result = uniqueVertices.emplace( v, static_cast<unsigned int>( subMesh->vertexList.size() ) );
+				if ( result.second )
+				{
+					subMesh->vertexList.push_back( v );
+				}
+				triangle[k] = result.first->second;
+			}
 
-			subMesh->vertexList.push_back( v );
+			if ( triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2] )
+				// Triangles that collapsed to a line cover no pixels
+			{
+				continue;
+			}
+
+			// Shapes are triangulated while parsing, so every face is one triangle
+			const size_t face = i / 3;
+			const int materialId = face < shape.mesh.material_ids.size() ? shape.mesh.material_ids[face] : -1;
+			const uint32_t materialIndex = materialId >= 0 ? static_cast<uint32_t>( materialId ) : SubMesh::m_noMaterial;
+
+			auto group = std::find_if( groups.begin() + firstGroup, groups.end(),
+				[materialIndex]( const FaceGroup& g ) { return g.materialIndex == materialIndex; } );
+			if ( group == groups.end() )
+			{
+				groups.push_back( FaceGroup{ materialIndex, {} } );
+				group = groups.end() - 1;
+			}
+			group->indices.insert( group->indices.end(), triangle, triangle + 3 );
 		}
 	}
 
+	for ( const FaceGroup& group : groups )
+	{
+		subMesh->meshIndices.insert( subMesh->meshIndices.end(), group.indices.begin(), group.indices.end() );
+	}
+	const float acmrBefore = MeshOptimizer::CalculateACMR( subMesh->meshIndices, subMesh->vertexList.size() );
+	subMesh->meshIndices.clear();
+
+	for ( FaceGroup& group : groups )
+	{
+		MeshOptimizer::OptimizeVertexCache( group.indices, subMesh->vertexList.size() );
+		MeshOptimizer::OptimizeOverdraw( group.indices, subMesh->vertexList );
+
+		subMesh->ranges.push_back( MeshRange{
+			static_cast<uint32_t>( subMesh->meshIndices.size() ),
+			static_cast<uint32_t>( group.indices.size() ),
+			group.materialIndex
+		} );
+		subMesh->meshIndices.insert( subMesh->meshIndices.end(), group.indices.begin(), group.indices.end() );
+	}
+
+	const float acmrAfter = MeshOptimizer::CalculateACMR( subMesh->meshIndices, subMesh->vertexList.size() );
+
+	// Simplified from the cache optimized indices, vertices are reordered afterwards so every level is covered
+	GenerateLods( subMesh );
+	MeshOptimizer::OptimizeVertexFetch( subMesh->meshIndices, subMesh->vertexList );
+
+	PackSubMesh( subMesh, layout );
+
+	DEBUG_LOG( LOG::INFO, "Loaded OBJ file: " + relativeFilePath + " Corners: " + std::to_string( cornerCount ) + " Vertices: " + std::to_string( subMesh->vertexList.size() ) + " Ranges: " + std::to_string( subMesh->ranges.size() ) + " ACMR: " + std::to_string( acmrBefore ) + " -> " + std::to_string( acmrAfter ) );
+	CONSOLE_LOG( LOG::INFO, "Loaded OBJ file: " + relativeFilePath + " Corners: " + std::to_string( cornerCount ) + " Vertices: " + std::to_string( subMesh->vertexList.size() ) + " Ranges: " + std::to_string( subMesh->ranges.size() ) + " ACMR: " + std::to_string( acmrBefore ) + " -> " + std::to_string( acmrAfter ) );
+
 	return subMesh;
 
 
 }
 
+// Builds the chain of simplified levels of detail from the full detail indices, storing them back to back in meshIndices
+// Every MeshRange is simplified on its own, each level's ranges are appended to ranges
+void MeshLoader::GenerateLods( SubMesh* subMesh )
+{
+	glm::vec3 boundsMin( std::numeric_limits<float>::max() );
+	glm::vec3 boundsMax( -std::numeric_limits<float>::max() );
+	for ( const Vertex& v : subMesh->vertexList )
+	{
+		boundsMin = glm::min( boundsMin, v.position );
+		boundsMax = glm::max( boundsMax, v.position );
+	}
+	const float radius = subMesh->vertexList.empty() ? 0.0f : glm::length( boundsMax - boundsMin ) * 0.5f;
+	const float maxError = radius * m_lodMaxRelativeError;
+
+	subMesh->lodCount = 1;
+	subMesh->lods[0] = { 0, static_cast<uint32_t>( subMesh->meshIndices.size() ), 0.0f, 0, static_cast<uint32_t>( subMesh->ranges.size() ) };
+
+	std::vector<unsigned int> lodIndices;
+	std::vector<MeshRange> lodRanges;
+	while ( subMesh->lodCount < SubMesh::m_maxLods )
+	{
+		const MeshLod previous = subMesh->lods[subMesh->lodCount - 1];
+		const uint32_t firstIndex = static_cast<uint32_t>( subMesh->meshIndices.size() );
+		lodIndices.clear();
+		lodRanges.clear();
+
+		// Ranges are simplified on their own, so no face ever changes material. The edges a range shares with its
+		// neighbours are open borders inside of it, which the simplifier never moves, so neighbouring ranges stay joined
+		float stepError = 0.0f;
+		for ( uint32_t r = 0; r < previous.rangeCount; ++r )
+		{
+			const MeshRange range = subMesh->ranges[previous.firstRange + r];
+			const auto rangeBegin = subMesh->meshIndices.begin() + range.firstIndex;
+			const std::vector<unsigned int> rangeIndices( rangeBegin, rangeBegin + range.indexCount );
+			const size_t targetIndexCount = static_cast<size_t>( range.indexCount / 3 * m_lodTriangleRatio ) * 3;
+
+			// Each level is simplified from the previous one, so its error is at most the sum of every step's error
+			float rangeError = 0.0f;
+			std::vector<unsigned int> simplified = MeshSimplifier::Simplify( rangeIndices, subMesh->vertexList, targetIndexCount, maxError - previous.error, &rangeError );
+			if ( simplified.empty() || simplified.size() >= rangeIndices.size() )
+				// Ranges out of error budget, or that would vanish, are kept as they are
+			{
+				simplified = rangeIndices;
+				rangeError = 0.0f;
+			}
+			else
+			{
+				MeshOptimizer::OptimizeVertexCache( simplified, subMesh->vertexList.size() );
+			}
+
+			lodRanges.push_back( MeshRange{
+				firstIndex + static_cast<uint32_t>( lodIndices.size() ),
+				static_cast<uint32_t>( simplified.size() ),
+				range.materialIndex
+			} );
+			lodIndices.insert( lodIndices.end(), simplified.begin(), simplified.end() );
+			stepError = std::max( stepError, rangeError );
+		}
+
+		if ( lodIndices.empty() ||
+			lodIndices.size() > static_cast<size_t>( previous.indexCount * m_lodMinReduction ) )
+			// Out of error budget or only locked vertices left
+		{
+			break;
+		}
+
+		MeshLod& lod = subMesh->lods[subMesh->lodCount++];
+		lod.firstIndex = firstIndex;
+		lod.indexCount = static_cast<uint32_t>( lodIndices.size() );
+		lod.error = previous.error + stepError;
+		lod.firstRange = static_cast<uint32_t>( subMesh->ranges.size() );
+		lod.rangeCount = static_cast<uint32_t>( lodRanges.size() );
+		subMesh->meshIndices.insert( subMesh->meshIndices.end(), lodIndices.begin(), lodIndices.end() );
+		subMesh->ranges.insert( subMesh->ranges.end(), lodRanges.begin(), lodRanges.end() );
+	}
+
+	std::string lodSummary = std::to_string( subMesh->lods[0].indexCount / 3 );
+	for ( uint32_t l = 1; l < subMesh->lodCount; ++l )
+	{
+		lodSummary += " -> " + std::to_string( subMesh->lods[l].indexCount / 3 );
+	}
+	DEBUG_LOG( LOG::INFO, "Generated " + std::to_string( subMesh->lodCount ) + " LODs, triangles: " + lodSummary );
+	CONSOLE_LOG( LOG::INFO, "Generated " + std::to_string( subMesh->lodCount ) + " LODs, triangles: " + lodSummary );
+}
+
+// Packs the vertices and indices of the passed sub mesh into GPU ready streams
+void MeshLoader::PackSubMesh( SubMesh* subMesh, const VertexLayout& layout )
+{
+	subMesh->layout = layout;
+	subMesh->vertexCount = static_cast<uint32_t>( subMesh->vertexList.size() );
+	subMesh->indexCount = static_cast<uint32_t>( subMesh->meshIndices.size() );
+
+	subMesh->boundsMin = glm::vec3( std::numeric_limits<float>::max() );
+	subMesh->boundsMax = glm::vec3( -std::numeric_limits<float>::max() );
+	for ( const Vertex& v : subMesh->vertexList )
+	{
+		subMesh->boundsMin = glm::min( subMesh->boundsMin, v.position );
+		subMesh->boundsMax = glm::max( subMesh->boundsMax, v.position );
+	}
+	if ( subMesh->vertexList.empty() )
+	{
+		subMesh->boundsMin = subMesh->boundsMax = glm::vec3( 0.0f );
+	}
+
+	VertexPacker::Pack( subMesh->vertexList, subMesh->layout, subMesh->packedVertices );
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		subMesh->vertexStreams[s] = { subMesh->packedVertices[s].data(), subMesh->packedVertices[s].size() };
+	}
+
+	if ( subMesh->vertexCount <= std::numeric_limits<uint16_t>::max() )
+		// Halving the index buffer when every vertex fits into a 16 bit index
+	{
+		subMesh->indexSize = sizeof( uint16_t );
+		subMesh->packedIndices.resize( subMesh->indexCount * sizeof( uint16_t ) );
+		uint16_t* indices = reinterpret_cast<uint16_t*>( subMesh->packedIndices.data() );
+		for ( uint32_t i = 0; i < subMesh->indexCount; ++i )
+		{
+			indices[i] = static_cast<uint16_t>( subMesh->meshIndices[i] );
+		}
+	}
+	else
+	{
+		subMesh->indexSize = sizeof( uint32_t );
+		subMesh->packedIndices.resize( subMesh->indexCount * sizeof( uint32_t ) );
+		std::memcpy( subMesh->packedIndices.data(), subMesh->meshIndices.data(), subMesh->packedIndices.size() );
+	}
+	subMesh->indexStream = { subMesh->packedIndices.data(), subMesh->packedIndices.size() };
+}
+
 //Texture2D * Loader::LoadTexture2D( const std::string & fileName )
 //{
 //
@@ -18,8 +18,26 @@ class MeshLoader
 
 public:
 
-	// Loads  from the passed  file name, if the file does not exist or is unreadable, this function returns null
-	static SubMesh* LoadMesh( const std::string& fileName );
+	// Each level of detail aims for this fraction of the previous level's triangles
+	static constexpr float m_lodTriangleRatio = 0.5f;
+
+	// A level that keeps more than this fraction of the previous level's triangles is not worth storing, the chain ends there
+	static constexpr float m_lodMinReduction = 0.8f;
+
+	// Largest error the coarsest level may have, relative to the radius of the mesh's bounds
+	static constexpr float m_lodMaxRelativeError = 0.05f;
+
+	// Loads  from the passed  file name, throws std::runtime_error if the file does not exist or is unreadable
+	// Vertices are packed for the GPU using the passed vertex layout
+	// Maps the cooked binary of the mesh when it is up to date, otherwise parses the OBJ and cooks it for the next run
+	static SubMesh* LoadMesh( const std::string& fileName, const VertexLayout& layout = VertexLayouts::Standard );
+
+	// Parses the passed OBJ file and writes its cooked binary, returns false if the file is missing or cannot be written
+	// Throws std::runtime_error if the OBJ cannot be parsed
+	static bool CookMesh( const std::string& fileName, const VertexLayout& layout = VertexLayouts::Standard );
+
+	static std::string GetSourceFilePath( const std::string& fileName );
+	static std::string GetCookedFilePath( const std::string& fileName );
 
 	/* 
 		Loads Texture2D reference: return nullptr if loading fails
@@ -28,6 +46,19 @@ public:
 	*/
 	// static Texture2D* LoadTexture2D( const std::string& fileName );
 
+private:
+
+	// Parses, welds and optimizes the OBJ file at the passed path, throws std::runtime_error if it cannot be parsed
+	// Faces are kept in one MeshRange per shape and material, in the order they first appear in the file
+	static SubMesh* LoadObj( const std::string& filePath, const VertexLayout& layout );
+
+	// Builds the chain of simplified levels of detail from the full detail indices, storing them back to back in meshIndices
+	// Every MeshRange is simplified on its own, each level's ranges are appended to ranges
+	static void GenerateLods( SubMesh* subMesh );
+
+	// Packs the vertices and indices of the passed sub mesh into GPU ready streams
+	static void PackSubMesh( SubMesh* subMesh, const VertexLayout& layout );
+
 };
 
 
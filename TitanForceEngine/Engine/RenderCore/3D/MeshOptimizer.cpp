@@ -0,0 +1,306 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Tuning values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	constexpr float g_cacheDecayPower = 1.5f;
+	constexpr float g_lastTriangleScore = 0.75f;
+	constexpr float g_valenceBoostScale = 2.0f;
+	constexpr float g_valenceBoostPower = 0.5f;
+
+	float CalculateVertexScore( const int cachePosition, const unsigned int activeTriangles )
+	{
+		if ( activeTriangles == 0 )
+			// No triangles left to draw with this vertex
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if ( cachePosition >= 0 )
+		{
+			if ( cachePosition < 3 )
+				// Used by the last triangle, a fixed score stops the algorithm from favouring strips over fans
+			{
+				score = g_lastTriangleScore;
+			}
+			else
+			{
+				const float scaler = 1.0f / static_cast<float>( MeshOptimizer::m_cacheSize - 3 );
+				score = std::pow( 1.0f - static_cast<float>( cachePosition - 3 ) * scaler, g_cacheDecayPower );
+			}
+		}
+
+		// Bonus for vertices with few triangles left, so lone triangles are not left stranded
+		score += g_valenceBoostScale * std::pow( static_cast<float>( activeTriangles ), -g_valenceBoostPower );
+		return score;
+	}
+}
+
+// Reorders triangles for post-transform vertex cache locality (Forsyth's linear-speed algorithm)
+void MeshOptimizer::OptimizeVertexCache( std::vector<unsigned int>& indices, const size_t vertexCount )
+{
+	const size_t triangleCount = indices.size() / 3;
+	if ( triangleCount == 0 || vertexCount == 0 )
+	{
+		return;
+	}
+
+	// Building vertex to triangle adjacency
+	std::vector<unsigned int> activeTriangles( vertexCount, 0 );
+	for ( unsigned int index : indices )
+	{
+		activeTriangles[index]++;
+	}
+
+	std::vector<unsigned int> adjacencyOffsets( vertexCount + 1, 0 );
+	for ( size_t v = 0; v < vertexCount; ++v )
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + activeTriangles[v];
+	}
+
+	std::vector<unsigned int> adjacency( indices.size() );
+	std::vector<unsigned int> fill( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+	for ( size_t t = 0; t < triangleCount; ++t )
+	{
+		for ( size_t k = 0; k < 3; ++k )
+		{
+			const unsigned int v = indices[t * 3 + k];
+			adjacency[fill[v]++] = static_cast<unsigned int>( t );
+		}
+	}
+
+	std::vector<float> vertexScores( vertexCount );
+	for ( size_t v = 0; v < vertexCount; ++v )
+	{
+		vertexScores[v] = CalculateVertexScore( -1, activeTriangles[v] );
+	}
+
+	std::vector<bool> triangleEmitted( triangleCount, false );
+
+	std::vector<unsigned int> result;
+	result.reserve( indices.size() );
+
+	// Cache holds three extra entries for the triangle being added before it is trimmed back down
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> newCache;
+	cache.reserve( m_cacheSize + 3 );
+	newCache.reserve( m_cacheSize + 3 );
+
+	size_t scanCursor = 0;
+	int bestTriangle = -1;
+
+	for ( size_t emitted = 0; emitted < triangleCount; ++emitted )
+	{
+		if ( bestTriangle < 0 )
+			// Nothing in the cache is worth continuing from, picking the next triangle that has not been drawn
+		{
+			while ( triangleEmitted[scanCursor] )
+			{
+				scanCursor++;
+			}
+			bestTriangle = static_cast<int>( scanCursor );
+		}
+
+		const unsigned int triangle = static_cast<unsigned int>( bestTriangle );
+		triangleEmitted[triangle] = true;
+
+		newCache.clear();
+		for ( size_t k = 0; k < 3; ++k )
+		{
+			const unsigned int v = indices[triangle * 3 + k];
+			result.push_back( v );
+			newCache.push_back( v );
+
+			// Removing the triangle from this vertex's list of triangles still to draw
+			const unsigned int begin = adjacencyOffsets[v];
+			const unsigned int end = begin + activeTriangles[v];
+			for ( unsigned int a = begin; a < end; ++a )
+			{
+				if ( adjacency[a] == triangle )
+				{
+					std::swap( adjacency[a], adjacency[end - 1] );
+					break;
+				}
+			}
+			activeTriangles[v]--;
+		}
+
+		for ( unsigned int v : cache )
+		{
+			if ( v != newCache[0] && v != newCache[1] && v != newCache[2] )
+			{
+				newCache.push_back( v );
+			}
+		}
+
+		// Vertices pushed out of the cache lose their cache score
+		for ( size_t c = m_cacheSize; c < newCache.size(); ++c )
+		{
+			const unsigned int v = newCache[c];
+			vertexScores[v] = CalculateVertexScore( -1, activeTriangles[v] );
+		}
+
+		if ( newCache.size() > static_cast<size_t>( m_cacheSize ) )
+		{
+			newCache.resize( m_cacheSize );
+		}
+		cache.swap( newCache );
+
+		for ( size_t c = 0; c < cache.size(); ++c )
+		{
+			const unsigned int v = cache[c];
+			vertexScores[v] = CalculateVertexScore( static_cast<int>( c ), activeTriangles[v] );
+		}
+
+		// Only triangles touching the cache can have changed score, the best of them is drawn next
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for ( unsigned int v : cache )
+		{
+			const unsigned int begin = adjacencyOffsets[v];
+			const unsigned int end = begin + activeTriangles[v];
+			for ( unsigned int a = begin; a < end; ++a )
+			{
+				const unsigned int t = adjacency[a];
+				const float score =
+					vertexScores[indices[t * 3 + 0]] +
+					vertexScores[indices[t * 3 + 1]] +
+					vertexScores[indices[t * 3 + 2]];
+
+				if ( score > bestScore )
+				{
+					bestScore = score;
+					bestTriangle = static_cast<int>( t );
+				}
+			}
+		}
+	}
+
+	indices.swap( result );
+}
+
+// Reorders clusters of triangles so outward facing clusters are drawn first, reducing overdraw from most view directions
+void MeshOptimizer::OptimizeOverdraw( std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices )
+{
+	const size_t triangleCount = indices.size() / 3;
+	if ( triangleCount <= static_cast<size_t>( m_overdrawClusterSize ) )
+	{
+		return;
+	}
+
+	glm::vec3 meshCentroid( 0.0f );
+	for ( const Vertex& v : vertices )
+	{
+		meshCentroid += v.position;
+	}
+	meshCentroid /= static_cast<float>( vertices.size() );
+
+	struct Cluster
+	{
+		size_t	firstTriangle;
+		size_t	triangleCount;
+		float	sortKey;
+	};
+
+	std::vector<Cluster> clusters;
+	clusters.reserve( triangleCount / m_overdrawClusterSize + 1 );
+
+	// Clusters are runs of consecutive triangles, so the vertex cache order inside of each run is kept
+	for ( size_t first = 0; first < triangleCount; first += m_overdrawClusterSize )
+	{
+		const size_t count = std::min( static_cast<size_t>( m_overdrawClusterSize ), triangleCount - first );
+
+		glm::vec3 centroid( 0.0f );
+		glm::vec3 normal( 0.0f );
+		float area = 0.0f;
+
+		for ( size_t t = first; t < first + count; ++t )
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+			// Area weighted, so slivers do not pull the cluster's centroid and normal around
+			const glm::vec3 faceNormal = glm::cross( p1 - p0, p2 - p0 );
+			const float faceArea = glm::length( faceNormal );
+
+			centroid += ( p0 + p1 + p2 ) * ( faceArea / 3.0f );
+			normal += faceNormal;
+			area += faceArea;
+		}
+
+		float sortKey = 0.0f;
+		const float normalLength = glm::length( normal );
+		if ( area > 0.0f && normalLength > 0.0f )
+		{
+			centroid /= area;
+			sortKey = glm::dot( centroid - meshCentroid, normal / normalLength );
+		}
+
+		clusters.push_back( { first, count, sortKey } );
+	}
+
+	std::stable_sort( clusters.begin(), clusters.end(),
+		[]( const Cluster& a, const Cluster& b ) { return a.sortKey > b.sortKey; } );
+
+	std::vector<unsigned int> result;
+	result.reserve( indices.size() );
+	for ( const Cluster& c : clusters )
+	{
+		result.insert( result.end(), indices.begin() + c.firstTriangle * 3, indices.begin() + ( c.firstTriangle + c.triangleCount ) * 3 );
+	}
+
+	indices.swap( result );
+}
+
+// Reorders vertices in the order they are first referenced by the index buffer, improving vertex fetch locality
+void MeshOptimizer::OptimizeVertexFetch( std::vector<unsigned int>& indices, std::vector<Vertex>& vertices )
+{
+	constexpr unsigned int unassigned = ~0u;
+	std::vector<unsigned int> remap( vertices.size(), unassigned );
+	std::vector<Vertex> result;
+	result.reserve( vertices.size() );
+
+	for ( unsigned int& index : indices )
+	{
+		if ( remap[index] == unassigned )
+		{
+			remap[index] = static_cast<unsigned int>( result.size() );
+			result.push_back( vertices[index] );
+		}
+		index = remap[index];
+	}
+
+	// Vertices no index refers to are dropped
+	vertices.swap( result );
+}
+
+// Returns the average number of vertex shader invocations per triangle for the passed index buffer
+float MeshOptimizer::CalculateACMR( const std::vector<unsigned int>& indices, const size_t vertexCount )
+{
+	const size_t triangleCount = indices.size() / 3;
+	if ( triangleCount == 0 )
+	{
+		return 0.0f;
+	}
+
+	// Simulating a FIFO cache, which is how most hardware behaves
+	std::vector<size_t> insertedAt( vertexCount, 0 );
+	size_t time = m_cacheSize + 1;
+	size_t misses = 0;
+
+	for ( unsigned int index : indices )
+	{
+		if ( time - insertedAt[index] > static_cast<size_t>( m_cacheSize ) )
+		{
+			insertedAt[index] = time++;
+			misses++;
+		}
+	}
+
+	return static_cast<float>( misses ) / static_cast<float>( triangleCount );
+}
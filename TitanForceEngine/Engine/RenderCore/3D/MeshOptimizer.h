@@ -0,0 +1,39 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include "Mesh.h"
+
+#include <vector>
+
+class MeshOptimizer
+{
+
+	MeshOptimizer() = delete;	// Static class, no constructor needed
+	MeshOptimizer( const MeshOptimizer& ) = delete;
+	MeshOptimizer& operator=( const MeshOptimizer& ) = delete;
+	MeshOptimizer( MeshOptimizer&& ) = delete;
+	MeshOptimizer& operator=( MeshOptimizer&& ) = delete;
+
+public:
+
+	// Size of the simulated post-transform vertex cache
+	static constexpr int m_cacheSize = 32;
+
+	// Number of consecutive triangles reordered as one unit by the overdraw pass
+	static constexpr int m_overdrawClusterSize = 64;
+
+	// Reorders triangles for post-transform vertex cache locality (Forsyth's linear-speed algorithm)
+	static void OptimizeVertexCache( std::vector<unsigned int>& indices, const size_t vertexCount );
+
+	// Reorders clusters of triangles so outward facing clusters are drawn first, reducing overdraw from most view directions
+	static void OptimizeOverdraw( std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices );
+
+	// Reorders vertices in the order they are first referenced by the index buffer, improving vertex fetch locality
+	static void OptimizeVertexFetch( std::vector<unsigned int>& indices, std::vector<Vertex>& vertices );
+
+	// Returns the average number of vertex shader invocations per triangle for the passed index buffer
+	static float CalculateACMR( const std::vector<unsigned int>& indices, const size_t vertexCount );
+
+};
+
+#endif // !MESHOPTIMIZER_H
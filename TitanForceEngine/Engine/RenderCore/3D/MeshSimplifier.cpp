@@ -0,0 +1,415 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	// Sum of squared distances to a set of planes, stored as the 10 unique entries of a symmetric 4x4 matrix
+	// Planes are weighted by the area of their triangle, weight is the total so the error can be averaged
+	struct Quadric
+	{
+		double a00, a01, a02, a03;
+		double a11, a12, a13;
+		double a22, a23;
+		double a33;
+		double weight;
+
+		Quadric& operator+=( const Quadric& other )
+		{
+			a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+			a11 += other.a11; a12 += other.a12; a13 += other.a13;
+			a22 += other.a22; a23 += other.a23;
+			a33 += other.a33;
+			weight += other.weight;
+			return *this;
+		}
+	};
+
+	Quadric operator+( Quadric a, const Quadric& b )
+	{
+		a += b;
+		return a;
+	}
+
+	// Quadric of the plane dot( normal, p ) + distance = 0
+	Quadric MakePlaneQuadric( const glm::dvec3& normal, const double distance, const double weight )
+	{
+		Quadric q;
+		q.a00 = normal.x * normal.x * weight;
+		q.a01 = normal.x * normal.y * weight;
+		q.a02 = normal.x * normal.z * weight;
+		q.a03 = normal.x * distance * weight;
+		q.a11 = normal.y * normal.y * weight;
+		q.a12 = normal.y * normal.z * weight;
+		q.a13 = normal.y * distance * weight;
+		q.a22 = normal.z * normal.z * weight;
+		q.a23 = normal.z * distance * weight;
+		q.a33 = distance * distance * weight;
+		q.weight = weight;
+		return q;
+	}
+
+	// Area weighted mean of the squared distances from the passed point to the quadric's planes
+	double EvaluateQuadric( const Quadric& q, const glm::vec3& point )
+	{
+		const double x = point.x;
+		const double y = point.y;
+		const double z = point.z;
+		const double error =
+			q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x +
+			q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y +
+			q.a22 * z * z + 2.0 * q.a23 * z +
+			q.a33;
+		return q.weight > 0.0 ? std::max( error, 0.0 ) / q.weight : 0.0;
+	}
+
+	struct PositionHasher
+	{
+		size_t operator()( const glm::vec3& p ) const
+		{
+			size_t hash = std::hash<float>()( p.x );
+			hash ^= std::hash<float>()( p.y ) + 0x9e3779b9 + ( hash << 6 ) + ( hash >> 2 );
+			hash ^= std::hash<float>()( p.z ) + 0x9e3779b9 + ( hash << 6 ) + ( hash >> 2 );
+			return hash;
+		}
+	};
+
+	uint64_t EdgeKey( const unsigned int from, const unsigned int to )
+	{
+		return ( static_cast<uint64_t>( from ) << 32 ) | to;
+	}
+
+	// Moves every vertex at the position of from onto a neighbour at the position of to
+	struct Collapse
+	{
+		unsigned int	from;
+		unsigned int	to;
+		double			error;
+	};
+}
+
+// Collapses edges, cheapest first, until at most targetIndexCount indices are left or the next collapse would
+// move the surface further than targetError, in mesh units
+// Vertices on open borders are never moved, vertices on attribute seams only move along their seam
+// Returns the simplified indices, resultError receives the largest error introduced
+std::vector<unsigned int> MeshSimplifier::Simplify(
+	const std::vector<unsigned int>& indices,
+	const std::vector<Vertex>& vertices,
+	const size_t targetIndexCount,
+	const float targetError,
+	float* resultError )
+{
+	std::vector<unsigned int> result( indices );
+	double maxError = 0.0;
+
+	const size_t vertexCount = vertices.size();
+	if ( result.size() <= targetIndexCount || vertexCount == 0 )
+	{
+		if ( resultError )
+		{
+			*resultError = 0.0f;
+		}
+		return result;
+	}
+
+	// Vertices split only by their normal or texture coordinates share a position, they are collapsed together
+	// positions maps each vertex to the first vertex at its position, which stands in for all of them below
+	// wedges links the vertices at each position into a ring
+	std::vector<unsigned int> positions( vertexCount );
+	std::vector<unsigned int> wedges( vertexCount );
+	{
+		std::unordered_map<glm::vec3, unsigned int, PositionHasher> firstAtPosition;
+		firstAtPosition.reserve( vertexCount );
+		for ( unsigned int v = 0; v < vertexCount; ++v )
+		{
+			const unsigned int first = firstAtPosition.emplace( vertices[v].position, v ).first->second;
+			positions[v] = first;
+			if ( first == v )
+			{
+				wedges[v] = v;
+			}
+			else
+			{
+				wedges[v] = wedges[first];
+				wedges[first] = v;
+			}
+		}
+	}
+
+	// An edge without a twin running the other way lies on an open border, its ends are locked in place
+	std::vector<unsigned char> locked( vertexCount, 0 );
+	{
+		std::unordered_set<uint64_t> edges;
+		edges.reserve( result.size() );
+		for ( size_t i = 0; i < result.size(); i += 3 )
+		{
+			for ( size_t k = 0; k < 3; ++k )
+			{
+				edges.insert( EdgeKey( positions[result[i + k]], positions[result[i + ( k + 1 ) % 3]] ) );
+			}
+		}
+
+		for ( size_t i = 0; i < result.size(); i += 3 )
+		{
+			for ( size_t k = 0; k < 3; ++k )
+			{
+				const unsigned int a = positions[result[i + k]];
+				const unsigned int b = positions[result[i + ( k + 1 ) % 3]];
+				if ( edges.find( EdgeKey( b, a ) ) == edges.end() )
+				{
+					locked[a] = 1;
+					locked[b] = 1;
+				}
+			}
+		}
+	}
+
+	// Every position starts with the planes of the triangles around it
+	std::vector<Quadric> quadrics( vertexCount, Quadric{} );
+	for ( size_t i = 0; i < result.size(); i += 3 )
+	{
+		const glm::dvec3 p0( vertices[result[i + 0]].position );
+		const glm::dvec3 p1( vertices[result[i + 1]].position );
+		const glm::dvec3 p2( vertices[result[i + 2]].position );
+
+		glm::dvec3 normal = glm::cross( p1 - p0, p2 - p0 );
+		const double length = glm::length( normal );
+		if ( length <= 0.0 )
+		{
+			continue;
+		}
+		normal /= length;
+
+		const Quadric plane = MakePlaneQuadric( normal, -glm::dot( normal, p0 ), length * 0.5 );
+		for ( size_t k = 0; k < 3; ++k )
+		{
+			quadrics[positions[result[i + k]]] += plane;
+		}
+	}
+
+	const double errorLimit = targetError > 0.0f ? static_cast<double>( targetError ) * targetError : 0.0;
+
+	std::vector<unsigned int> adjacencyOffsets( vertexCount + 1 );
+	std::vector<unsigned int> adjacency;
+	std::vector<unsigned int> fill;
+	std::vector<Collapse> collapses;
+	std::vector<unsigned char> touched( vertexCount );
+	std::vector<unsigned int> remap( vertexCount );
+	std::vector<std::pair<unsigned int, unsigned int>> partners;
+
+	// Each pass collapses a batch of edges that do not share any triangles, then rebuilds the triangle list
+	while ( result.size() > targetIndexCount )
+	{
+		const size_t triangleCount = result.size() / 3;
+
+		// Triangles around each position
+		std::fill( adjacencyOffsets.begin(), adjacencyOffsets.end(), 0 );
+		for ( unsigned int index : result )
+		{
+			adjacencyOffsets[positions[index] + 1]++;
+		}
+		for ( size_t v = 0; v < vertexCount; ++v )
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+
+		adjacency.resize( result.size() );
+		fill.assign( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+		for ( size_t t = 0; t < triangleCount; ++t )
+		{
+			for ( size_t k = 0; k < 3; ++k )
+			{
+				adjacency[fill[positions[result[t * 3 + k]]]++] = static_cast<unsigned int>( t );
+			}
+		}
+
+		// Both directions of every edge, priced by the merged quadric's error at the position collapsed onto
+		collapses.clear();
+		for ( size_t i = 0; i < result.size(); i += 3 )
+		{
+			for ( size_t k = 0; k < 3; ++k )
+			{
+				const unsigned int a = positions[result[i + k]];
+				const unsigned int b = positions[result[i + ( k + 1 ) % 3]];
+				if ( a >= b )
+					// Interior edges are seen once from each side, border edges only join locked positions
+				{
+					continue;
+				}
+
+				const Quadric merged = quadrics[a] + quadrics[b];
+				if ( !locked[a] )
+				{
+					collapses.push_back( { a, b, EvaluateQuadric( merged, vertices[b].position ) } );
+				}
+				if ( !locked[b] )
+				{
+					collapses.push_back( { b, a, EvaluateQuadric( merged, vertices[a].position ) } );
+				}
+			}
+		}
+
+		std::sort( collapses.begin(), collapses.end(),
+			[]( const Collapse& a, const Collapse& b ) { return a.error < b.error; } );
+
+		// Collapsing an edge removes two triangles, stopping at the goal keeps the result from undershooting the target
+		const size_t collapseGoal = std::max<size_t>( ( result.size() - targetIndexCount ) / 6, 1 );
+		size_t collapseCount = 0;
+
+		std::fill( touched.begin(), touched.end(), 0 );
+		for ( unsigned int v = 0; v < vertexCount; ++v )
+		{
+			remap[v] = v;
+		}
+
+		for ( const Collapse& collapse : collapses )
+		{
+			if ( collapse.error > errorLimit )
+			{
+				break;
+			}
+
+			if ( touched[collapse.from] || touched[collapse.to] )
+				// Triangles around it already changed this pass, it is priced again next pass
+			{
+				continue;
+			}
+
+			const unsigned int* first = adjacency.data() + adjacencyOffsets[collapse.from];
+			const unsigned int* last = adjacency.data() + adjacencyOffsets[collapse.from + 1];
+
+			// Every vertex at from needs a neighbour at to to move onto, a vertex on a seam without one would tear the seam
+			bool isValid = true;
+			partners.clear();
+			unsigned int wedge = collapse.from;
+			do
+			{
+				unsigned int partner = wedge;
+				for ( const unsigned int* t = first; t != last && partner == wedge; ++t )
+				{
+					for ( size_t k = 0; k < 3; ++k )
+					{
+						if ( result[*t * 3 + k] != wedge )
+						{
+							continue;
+						}
+
+						for ( size_t o = 1; o < 3; ++o )
+						{
+							const unsigned int other = result[*t * 3 + ( k + o ) % 3];
+							if ( positions[other] == collapse.to )
+							{
+								partner = other;
+							}
+						}
+					}
+				}
+
+				if ( partner != wedge )
+				{
+					partners.emplace_back( wedge, partner );
+				}
+				else
+				{
+					// Vertices no triangle references are left behind, anything else blocks the collapse
+					for ( const unsigned int* t = first; t != last && isValid; ++t )
+					{
+						isValid = result[*t * 3 + 0] != wedge && result[*t * 3 + 1] != wedge && result[*t * 3 + 2] != wedge;
+					}
+				}
+
+				wedge = wedges[wedge];
+			} while ( wedge != collapse.from && isValid );
+
+			if ( !isValid || partners.empty() )
+			{
+				continue;
+			}
+
+			// Triangles that survive the collapse must keep facing the same way
+			const glm::vec3 target = vertices[collapse.to].position;
+			for ( const unsigned int* t = first; t != last && isValid; ++t )
+			{
+				glm::vec3 before[3];
+				glm::vec3 after[3];
+				bool isRemoved = false;
+				for ( size_t k = 0; k < 3; ++k )
+				{
+					const unsigned int position = positions[result[*t * 3 + k]];
+					isRemoved = isRemoved || position == collapse.to;
+					before[k] = vertices[position].position;
+					after[k] = position == collapse.from ? target : before[k];
+				}
+
+				if ( isRemoved )
+				{
+					continue;
+				}
+
+				const glm::vec3 normalBefore = glm::cross( before[1] - before[0], before[2] - before[0] );
+				const glm::vec3 normalAfter = glm::cross( after[1] - after[0], after[2] - after[0] );
+				isValid = glm::dot( normalBefore, normalAfter ) > m_flipThreshold * glm::length( normalBefore ) * glm::length( normalAfter );
+			}
+
+			if ( !isValid )
+			{
+				continue;
+			}
+
+			for ( const auto& partner : partners )
+			{
+				remap[partner.first] = partner.second;
+			}
+			quadrics[collapse.to] += quadrics[collapse.from];
+			maxError = std::max( maxError, collapse.error );
+
+			for ( const unsigned int* t = first; t != last; ++t )
+			{
+				for ( size_t k = 0; k < 3; ++k )
+				{
+					touched[positions[result[*t * 3 + k]]] = 1;
+				}
+			}
+
+			if ( ++collapseCount >= collapseGoal )
+			{
+				break;
+			}
+		}
+
+		if ( collapseCount == 0 )
+			// Everything left is locked, flips or costs more than targetError
+		{
+			break;
+		}
+
+		// Triangles that lost an edge to a collapse cover no pixels and are dropped
+		size_t write = 0;
+		for ( size_t i = 0; i < result.size(); i += 3 )
+		{
+			const unsigned int a = remap[result[i + 0]];
+			const unsigned int b = remap[result[i + 1]];
+			const unsigned int c = remap[result[i + 2]];
+			if ( positions[a] == positions[b] || positions[b] == positions[c] || positions[a] == positions[c] )
+			{
+				continue;
+			}
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize( write );
+	}
+
+	if ( resultError )
+	{
+		*resultError = static_cast<float>( std::sqrt( maxError ) );
+	}
+	return result;
+}
@@ -0,0 +1,39 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include "Mesh.h"
+
+#include <vector>
+
+// Reduces triangle lists with quadric error edge collapse (Garland and Heckbert), used to build mesh LOD chains
+// Vertices are only ever collapsed onto one of their neighbours, never moved or added, so every simplified
+// triangle list still indexes the vertex buffer it was simplified from
+class MeshSimplifier
+{
+
+	MeshSimplifier() = delete;	// Static class, no constructor needed
+	MeshSimplifier( const MeshSimplifier& ) = delete;
+	MeshSimplifier& operator=( const MeshSimplifier& ) = delete;
+	MeshSimplifier( MeshSimplifier&& ) = delete;
+	MeshSimplifier& operator=( MeshSimplifier&& ) = delete;
+
+public:
+
+	// Smallest cosine allowed between a triangle's normal before and after a collapse, stops collapses folding the surface over
+	static constexpr float m_flipThreshold = 0.25f;
+
+	// Collapses edges, cheapest first, until at most targetIndexCount indices are left or the next collapse would
+	// move the surface further than targetError, in mesh units
+	// Vertices on open borders are never moved, vertices on attribute seams only move along their seam
+	// Returns the simplified indices, resultError receives the largest error introduced
+	static std::vector<unsigned int> Simplify(
+		const std::vector<unsigned int>& indices,
+		const std::vector<Vertex>& vertices,
+		const size_t targetIndexCount,
+		const float targetError,
+		float* resultError = nullptr
+	);
+
+};
+
+#endif // !MESHSIMPLIFIER_H
@@ -0,0 +1,111 @@
+#include "VertexLayout.h"
+
+#include "Mesh.h"
+
+#include <gtc/packing.hpp>
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Folds a unit vector onto an octahedron and unwraps it into the [-1, 1] square
+	glm::vec2 EncodeOctahedral( const glm::vec3& n )
+	{
+		const float l1 = std::abs( n.x ) + std::abs( n.y ) + std::abs( n.z );
+		if ( l1 <= 0.0f )
+		{
+			return glm::vec2( 0.0f, 0.0f );
+		}
+
+		glm::vec2 p( n.x / l1, n.y / l1 );
+		if ( n.z < 0.0f )
+			// The lower half of the octahedron is folded over the diagonals
+		{
+			const float x = ( 1.0f - std::abs( p.y ) ) * ( p.x >= 0.0f ? 1.0f : -1.0f );
+			const float y = ( 1.0f - std::abs( p.x ) ) * ( p.y >= 0.0f ? 1.0f : -1.0f );
+			p = glm::vec2( x, y );
+		}
+		return p;
+	}
+
+	uint32_t PackAttribute( const EVertexFormat format, const glm::vec3& value )
+	{
+		switch ( format )
+		{
+		case EVertexFormat::Octahedral16:
+			return glm::packSnorm2x16( EncodeOctahedral( value ) );
+		case EVertexFormat::Snorm10_10_10_2:
+			return glm::packSnorm3x10_1x2( glm::vec4( value, 0.0f ) );
+		case EVertexFormat::Unorm8x4:
+			return glm::packUnorm4x8( glm::vec4( value, 1.0f ) );
+		default:
+			return 0;
+		}
+	}
+
+	void WriteAttribute( unsigned char* destination, const EVertexFormat format, const glm::vec3& value )
+	{
+		switch ( format )
+		{
+		case EVertexFormat::Float2:
+			std::memcpy( destination, &value.x, sizeof( float ) * 2 );
+			break;
+		case EVertexFormat::Float3:
+			std::memcpy( destination, &value.x, sizeof( float ) * 3 );
+			break;
+		case EVertexFormat::Half2:
+		{
+			const uint32_t packed = glm::packHalf2x16( glm::vec2( value.x, value.y ) );
+			std::memcpy( destination, &packed, sizeof( packed ) );
+			break;
+		}
+		case EVertexFormat::Octahedral16:
+		case EVertexFormat::Snorm10_10_10_2:
+		case EVertexFormat::Unorm8x4:
+		{
+			const uint32_t packed = PackAttribute( format, value );
+			std::memcpy( destination, &packed, sizeof( packed ) );
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+// Packs the passed vertices into one byte stream per layout stream
+void VertexPacker::Pack(
+	const std::vector<Vertex>& vertices,
+	const VertexLayout& layout,
+	std::array<std::vector<unsigned char>, VertexLayout::m_maxStreams>& streams )
+{
+	for ( uint32_t s = 0; s < VertexLayout::m_maxStreams; ++s )
+	{
+		streams[s].assign( vertices.size() * layout.strides[s], 0 );
+	}
+
+	for ( size_t i = 0; i < vertices.size(); ++i )
+	{
+		const Vertex& v = vertices[i];
+		const glm::vec3 values[] =
+		{
+			v.position,
+			v.normal,
+			glm::vec3( v.texCoords.x, v.texCoords.y, 0.0f ),
+			v.colour
+		};
+
+		for ( size_t a = 0; a < layout.attributes.size(); ++a )
+		{
+			const VertexAttributeDesc& attribute = layout.attributes[a];
+			if ( attribute.format == EVertexFormat::None )
+			{
+				continue;
+			}
+
+			unsigned char* destination = streams[attribute.stream].data() + i * layout.strides[attribute.stream] + attribute.offset;
+			WriteAttribute( destination, attribute.format, values[a] );
+		}
+	}
+}
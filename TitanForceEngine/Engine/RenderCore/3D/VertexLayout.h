@@ -0,0 +1,157 @@
+#ifndef VERTEXLAYOUT_H
+#define VERTEXLAYOUT_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct Vertex;
+
+// Vertex attributes, the value of each is the attribute location used by the shaders
+enum class EVertexAttribute
+{
+	Position,
+	Normal,
+	TexCoords,
+	Colour,
+	TOTAL
+};
+
+// How a single attribute is stored inside of a vertex stream
+enum class EVertexFormat
+{
+	None,				// Attribute is not stored
+	Float2,
+	Float3,
+	Half2,				// Two 16 bit floats
+	Octahedral16,		// Unit vector folded onto an octahedron, stored as two 16 bit signed normalized values
+	Snorm10_10_10_2,	// Three 10 bit signed normalized values and a 2 bit w
+	Unorm8x4			// Four 8 bit unsigned normalized values
+};
+
+// Returns the size in bytes of a single attribute stored in the passed format
+constexpr uint32_t GetVertexFormatSize( const EVertexFormat format )
+{
+	switch ( format )
+	{
+	case EVertexFormat::Float2:				return 8;
+	case EVertexFormat::Float3:				return 12;
+	case EVertexFormat::Half2:				return 4;
+	case EVertexFormat::Octahedral16:		return 4;
+	case EVertexFormat::Snorm10_10_10_2:	return 4;
+	case EVertexFormat::Unorm8x4:			return 4;
+	default:								return 0;
+	}
+}
+
+struct VertexAttributeDesc
+{
+	EVertexFormat	format;
+	uint32_t		stream;
+	uint32_t		offset;
+};
+
+// Describes how vertices are packed into streams. Positions always live alone in stream 0, so depth only passes
+// fetch nothing else, every other attribute is interleaved in stream 1
+struct VertexLayout
+{
+	static constexpr uint32_t m_positionStream = 0;
+	static constexpr uint32_t m_attributeStream = 1;
+	static constexpr uint32_t m_maxStreams = 2;
+
+	std::array<VertexAttributeDesc, static_cast<size_t>( EVertexAttribute::TOTAL )>	attributes;
+	std::array<uint32_t, m_maxStreams>	strides;
+
+	constexpr const VertexAttributeDesc& GetAttribute( const EVertexAttribute attribute ) const
+	{
+		return attributes[static_cast<size_t>( attribute )];
+	}
+
+	constexpr bool HasAttribute( const EVertexAttribute attribute ) const
+	{
+		return GetAttribute( attribute ).format != EVertexFormat::None;
+	}
+
+	// Returns the bytes used by a single vertex across every stream
+	constexpr uint32_t GetVertexSize() const
+	{
+		return strides[m_positionStream] + strides[m_attributeStream];
+	}
+
+	// Identifies the layout, meshes with equal ids can share vertex array state
+	constexpr uint32_t GetId() const
+	{
+		uint32_t id = 0;
+		for ( size_t i = 0; i < attributes.size(); ++i )
+		{
+			id = id * 8 + static_cast<uint32_t>( attributes[i].format );
+		}
+		return id;
+	}
+};
+
+// Builds a vertex layout at compile time from the format of each attribute, EVertexFormat::None leaves an attribute out
+constexpr VertexLayout MakeVertexLayout(
+	const EVertexFormat position,
+	const EVertexFormat normal,
+	const EVertexFormat texCoords,
+	const EVertexFormat colour )
+{
+	VertexLayout layout = {};
+	const EVertexFormat formats[] = { position, normal, texCoords, colour };
+
+	for ( size_t i = 0; i < layout.attributes.size(); ++i )
+	{
+		const uint32_t stream = ( i == static_cast<size_t>( EVertexAttribute::Position ) ) ?
+			VertexLayout::m_positionStream :
+			VertexLayout::m_attributeStream;
+
+		layout.attributes[i] = { formats[i], stream, layout.strides[stream] };
+		layout.strides[stream] += GetVertexFormatSize( formats[i] );
+	}
+
+	return layout;
+}
+
+namespace VertexLayouts
+{
+	// Default layout for engine meshes: 12 byte position stream and 8 byte attribute stream
+	constexpr VertexLayout Standard = MakeVertexLayout(
+		EVertexFormat::Float3,
+		EVertexFormat::Octahedral16,
+		EVertexFormat::Half2,
+		EVertexFormat::None
+	);
+
+	// Standard layout with vertex colours
+	constexpr VertexLayout Coloured = MakeVertexLayout(
+		EVertexFormat::Float3,
+		EVertexFormat::Octahedral16,
+		EVertexFormat::Half2,
+		EVertexFormat::Unorm8x4
+	);
+
+	static_assert( Standard.GetVertexSize() == 20, "Standard vertex layout is expected to be 20 bytes" );
+}
+
+class VertexPacker
+{
+
+	VertexPacker() = delete;	// Static class, no constructor needed
+	VertexPacker( const VertexPacker& ) = delete;
+	VertexPacker& operator=( const VertexPacker& ) = delete;
+	VertexPacker( VertexPacker&& ) = delete;
+	VertexPacker& operator=( VertexPacker&& ) = delete;
+
+public:
+
+	// Packs the passed vertices into one byte stream per layout stream
+	static void Pack(
+		const std::vector<Vertex>& vertices,
+		const VertexLayout& layout,
+		std::array<std::vector<unsigned char>, VertexLayout::m_maxStreams>& streams
+	);
+
+};
+
+#endif // !VERTEXLAYOUT_H
@@ -0,0 +1,52 @@
+#include "DrawCommandList.h"
+
+#include <algorithm>
+#include <tuple>
+
+// Draws sharing a program, texture and arena are next to each other, sorted front to back inside of them
+// so nearer draws fill the depth buffer first and hidden fragments behind them fail the depth test early
+// No two draws share a sequence and range, so the order is the same however the models were split between lists
+bool DrawCommand::operator<( const DrawCommand& other ) const
+{
+	return std::make_tuple( program, texture, arena, depth, sequence, range ) <
+		std::make_tuple( other.program, other.texture, other.arena, other.depth, other.sequence, other.range );
+}
+
+// Returns true if both draws bind the same program, texture and arena, so they can be issued as one multi draw
+bool DrawCommand::SharesState( const DrawCommand& other ) const
+{
+	return program == other.program && texture == other.texture && arena == other.arena;
+}
+
+DrawCommandList::DrawCommandList() :
+	m_draws(),
+	m_pendingPrograms()
+{}
+
+DrawCommandList::~DrawCommandList()
+{}
+
+// Empties the list, keeping its storage
+void DrawCommandList::Reset()
+{
+	m_draws.clear();
+	m_pendingPrograms.clear();
+}
+
+// Appends a draw
+void DrawCommandList::Record( const DrawCommand& command )
+{
+	m_draws.push_back( command );
+}
+
+// Keeps a program that is not linked yet, so the render thread can advance it once recording is done
+void DrawCommandList::AddPendingProgram( ShaderLinker* linker )
+{
+	m_pendingPrograms.push_back( linker );
+}
+
+// Sorts the recorded draws into the order they are replayed in
+void DrawCommandList::Sort()
+{
+	std::sort( m_draws.begin(), m_draws.end() );
+}
@@ -0,0 +1,72 @@
+#ifndef DRAWCOMMANDLIST_H
+#define DRAWCOMMANDLIST_H
+
+#include <cstdint>
+#include <vector>
+
+class ShaderLinker;
+
+// A draw recorded on a worker thread, holding everything the render thread needs to issue it without reading the model
+// State is held as keys each renderer picks for itself, draws only have to compare equal when they bind the same objects
+struct DrawCommand
+{
+	uint32_t	program;			// See ShaderLinker::GetShaderProgramId
+	uint32_t	texture;			// Texture, or texture array, the draw binds
+	uint32_t	layer;				// Of the model's texture inside of that array
+	uintptr_t	arena;				// Vertex and index buffers the draw binds
+	uint32_t	material;			// Entry of MaterialTable, of the range the draw covers
+	float		depth;				// View depth of the model's bounds centre
+	uint32_t	sequence;			// Index of the model in the frame's models and in DrawExtractor
+	uint32_t	range;				// Entry of SubMesh::ranges, a model draws each range of its LOD on its own
+	uint32_t	firstIndex;			// Of the range, inside of the arena's index buffer
+	uint32_t	indexCount;
+	int32_t		baseVertex;
+	int32_t		drawIndexLocation;	// Of the program's drawIndex uniform, for renderers that cannot read the draw id
+
+	// Draws sharing a program, texture and arena are next to each other, sorted front to back inside of them
+	// No two draws share a sequence and range, so the order is the same however the models were split between lists
+	bool operator<( const DrawCommand& other ) const;
+
+	// Returns true if both draws bind the same program, texture and arena, so they can be issued as one multi draw
+	bool SharesState( const DrawCommand& other ) const;
+};
+
+// Linear buffer of draws, filled by a single worker thread and replayed on the render thread
+// Their object data is not copied, each draw points at its model's record in DrawExtractor
+// Lists are kept across frames and only cleared, so once they have grown recording a frame allocates nothing
+class DrawCommandList
+{
+
+	DrawCommandList( const DrawCommandList& ) = delete;
+	DrawCommandList& operator=( const DrawCommandList& ) = delete;
+	DrawCommandList( DrawCommandList&& ) = delete;
+	DrawCommandList& operator=( DrawCommandList&& ) = delete;
+
+public:
+
+	DrawCommandList();
+	~DrawCommandList();
+
+	// Empties the list, keeping its storage
+	void Reset();
+
+	// Appends a draw
+	void Record( const DrawCommand& command );
+
+	// Keeps a program that is not linked yet, so the render thread can advance it once recording is done
+	void AddPendingProgram( ShaderLinker* linker );
+
+	// Sorts the recorded draws into the order they are replayed in
+	void Sort();
+
+	const std::vector<DrawCommand>& GetDraws() const { return m_draws; }
+	const std::vector<ShaderLinker*>& GetPendingPrograms() const { return m_pendingPrograms; }
+
+private:
+
+	std::vector<DrawCommand>	m_draws;
+	std::vector<ShaderLinker*>	m_pendingPrograms;
+
+};
+
+#endif // !DRAWCOMMANDLIST_H
@@ -0,0 +1,174 @@
+#include "DrawRecorder.h"
+
+#include "../Model/Model.h"
+#include "../Shader/ShaderLinker.h"
+#include "../Material/Material.h"
+#include "../3D/Mesh.h"
+#include "../../Core/ThreadPool.h"
+
+#include <algorithm>
+
+DrawRecorder::DrawRecorder() :
+	m_lists(),
+	m_listCount( 0 ),
+	m_draws()
+{}
+
+DrawRecorder::~DrawRecorder()
+{
+	for ( DrawCommandList* list : m_lists )
+	{
+		delete list;
+	}
+	m_lists.clear();
+}
+
+// Records the draws of every model whose mesh is resident and whose program is linked
+// Programs still compiling are polled on the calling thread once the lists are recorded, and drawn from the frame after they are linked
+void DrawRecorder::Record( const std::vector<Model*>& models, const DrawExtractor& extractor, const FillFunction& fill, ThreadPool* threadPool )
+{
+	// Each list always holds the same models, so which thread records it does not change the frame
+	m_listCount = ( models.size() + m_recordRangeSize - 1 ) / m_recordRangeSize;
+	while ( m_lists.size() < m_listCount )
+	{
+		m_lists.push_back( new DrawCommandList() );
+	}
+
+	auto record = [this, &models, &extractor, &fill]( size_t begin, size_t end )
+	{
+		for ( size_t list = begin; list < end; ++list )
+		{
+			const size_t first = list * m_recordRangeSize;
+			RecordList( *m_lists[list], models, first, std::min( first + m_recordRangeSize, models.size() ), extractor, fill );
+		}
+	};
+
+	if ( threadPool )
+	{
+		threadPool->ParallelFor( m_listCount, 1, record );
+	}
+	else
+	{
+		record( 0, m_listCount );
+	}
+
+	// Checking a program's status may be a graphics API call the workers cannot make
+	for ( size_t list = 0; list < m_listCount; ++list )
+	{
+		for ( ShaderLinker* linker : m_lists[list]->GetPendingPrograms() )
+		{
+			linker->IsReady();
+		}
+	}
+}
+
+// Merges the recorded lists into the order draws are replayed in, taking the smallest head each time
+void DrawRecorder::Merge()
+{
+	m_draws.clear();
+
+	struct ListHead
+	{
+		const DrawCommandList*	list;
+		size_t					next;
+	};
+
+	auto isAfter = []( const ListHead& a, const ListHead& b )
+	{
+		return b.list->GetDraws()[b.next] < a.list->GetDraws()[a.next];
+	};
+
+	std::vector<ListHead> heads;
+	heads.reserve( m_listCount );
+	size_t drawCount = 0;
+	for ( size_t list = 0; list < m_listCount; ++list )
+	{
+		const DrawCommandList* commandList = m_lists[list];
+		if ( !commandList->GetDraws().empty() )
+		{
+			heads.push_back( ListHead{ commandList, 0 } );
+			drawCount += commandList->GetDraws().size();
+		}
+	}
+	std::make_heap( heads.begin(), heads.end(), isAfter );
+	m_draws.reserve( drawCount );
+
+	while ( !heads.empty() )
+	{
+		std::pop_heap( heads.begin(), heads.end(), isAfter );
+		ListHead& head = heads.back();
+
+		m_draws.push_back( &head.list->GetDraws()[head.next] );
+
+		if ( ++head.next < head.list->GetDraws().size() )
+		{
+			std::push_heap( heads.begin(), heads.end(), isAfter );
+		}
+		else
+		{
+			heads.pop_back();
+		}
+	}
+}
+
+// Records the range draws of the models in [begin, end) into the passed list and sorts it
+void DrawRecorder::RecordList(
+	DrawCommandList& list,
+	const std::vector<Model*>& models,
+	const size_t begin,
+	const size_t end,
+	const DrawExtractor& extractor,
+	const FillFunction& fill )
+{
+	list.Reset();
+
+	for ( size_t i = begin; i < end; ++i )
+	{
+		// Meshes still uploading were skipped by extraction until they are resident
+		const DrawExtractor::ExtractedDraw& extracted = extractor.GetDraw( i );
+		if ( !extracted.isResident )
+		{
+			continue;
+		}
+
+		const Model* model = models[i];
+
+		// Programs still compiling are drawn from the frame after they are linked
+		ShaderLinker* linker = model->GetShaderLinker();
+		if ( linker->GetState() != EProgramState::Ready )
+		{
+			if ( linker->GetState() != EProgramState::Failed )
+			{
+				list.AddPendingProgram( linker );
+			}
+			continue;
+		}
+
+		DrawCommand command = {};
+		command.program = linker->GetShaderProgramId();
+		command.depth = extracted.depth;
+		command.sequence = static_cast<uint32_t>( i );
+		fill( *model, command );
+
+		// Ranges of one model share everything but their indices and material
+		const SubMesh* subMesh = model->GetMesh()->GetSubMesh();
+		const MeshLod& lod = subMesh->lods[extracted.lod];
+		const uint32_t meshFirstIndex = command.firstIndex;
+		for ( uint32_t r = lod.firstRange; r < lod.firstRange + lod.rangeCount; ++r )
+		{
+			const MeshRange& range = subMesh->ranges[r];
+			if ( range.indexCount == 0 )
+			{
+				continue;
+			}
+
+			command.range = r;
+			command.material = model->GetRangeMaterial( range.materialIndex )->index;
+			command.firstIndex = meshFirstIndex + range.firstIndex;
+			command.indexCount = range.indexCount;
+			list.Record( command );
+		}
+	}
+
+	list.Sort();
+}
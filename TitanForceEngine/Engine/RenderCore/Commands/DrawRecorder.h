@@ -0,0 +1,70 @@
+#ifndef DRAWRECORDER_H
+#define DRAWRECORDER_H
+
+#include "DrawCommandList.h"
+#include "../Extraction/DrawExtractor.h"
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class Model;
+class ThreadPool;
+
+// Turns the frame's extracted models into draws in the order every renderer replays them in
+// The models are split into fixed ranges, each range is recorded into a command list of its own on the worker threads
+// and sorted there, then the render thread merges the sorted lists. Only filling in the renderer's buffers and
+// texture keys is left to the renderer, see FillFunction
+class DrawRecorder
+{
+
+	DrawRecorder( const DrawRecorder& ) = delete;
+	DrawRecorder& operator=( const DrawRecorder& ) = delete;
+	DrawRecorder( DrawRecorder&& ) = delete;
+	DrawRecorder& operator=( DrawRecorder&& ) = delete;
+
+public:
+
+	// Models recorded into each command list, lists are recorded on the worker threads and merged in a fixed order
+	static constexpr size_t m_recordRangeSize = 256;
+
+	// Sets the texture, layer, arena, base vertex and draw index location of a model's draws, on a worker thread
+	// firstIndex is set to where the mesh's indices start inside of the arena's index buffer, each range is offset from it
+	// The program, depth and sequence are already set, and the model's mesh is resident
+	using FillFunction = std::function<void( const Model& model, DrawCommand& command )>;
+
+	DrawRecorder();
+	~DrawRecorder();
+
+	// Records one draw per range of the selected LOD of every model whose mesh is resident and whose program is linked
+	// Each range is drawn with its own material, see Model::GetRangeMaterial
+	// Programs still compiling are polled on the calling thread once the lists are recorded, and drawn from the frame after they are linked
+	void Record( const std::vector<Model*>& models, const DrawExtractor& extractor, const FillFunction& fill, ThreadPool* threadPool );
+
+	// Merges the recorded lists into the order draws are replayed in, taking the smallest head each time
+	void Merge();
+
+	// Draws of the last Merge in replay order, they point into the command lists until the next Record
+	const std::vector<const DrawCommand*>& GetDraws() const { return m_draws; }
+
+private:
+
+	// One list per m_recordRangeSize models, only grown so recording reuses their storage
+	std::vector<DrawCommandList*>	m_lists;
+	size_t							m_listCount;	// Lists recorded this frame
+
+	// Rebuilt every frame, kept as a member so its storage is reused
+	std::vector<const DrawCommand*>	m_draws;
+
+	// Records the range draws of the models in [begin, end) into the passed list and sorts it
+	static void RecordList(
+		DrawCommandList& list,
+		const std::vector<Model*>& models,
+		const size_t begin,
+		const size_t end,
+		const DrawExtractor& extractor,
+		const FillFunction& fill );
+
+};
+
+#endif // !DRAWRECORDER_H
@@ -0,0 +1,430 @@
+#include "OcclusionCuller.h"
+
+#include "../3D/Mesh.h"
+#include "../../Core/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define OCCLUSION_CULLER_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// Returns the pixel holding the passed coordinate, clamped to [-1, size] first so far off screen points cannot overflow
+	int ToPixel( const float coordinate, const int size )
+	{
+		return static_cast<int>( std::floor( std::clamp( coordinate, -1.0f, static_cast<float>( size ) ) ) );
+	}
+}
+
+OcclusionCuller::OcclusionCuller() :
+	m_viewProjection( 1.0f ),
+	m_triangles(),
+	m_levels()
+{
+	int width = m_width;
+	int height = m_height;
+	while ( true )
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.farthest.resize( static_cast<size_t>( width ) * height, 1.0f );
+		if ( !m_levels.empty() )
+		{
+			level.nearest.resize( static_cast<size_t>( width ) * height, 1.0f );
+		}
+		m_levels.push_back( std::move( level ) );
+
+		if ( width == 1 && height == 1 )
+		{
+			break;
+		}
+		width = std::max( width / 2, 1 );
+		height = std::max( height / 2, 1 );
+	}
+}
+
+OcclusionCuller::~OcclusionCuller()
+{}
+
+// Clears the depth buffer and the queued occluders, everything until the next call uses the passed camera
+void OcclusionCuller::BeginFrame( const glm::mat4& viewProjection )
+{
+	m_viewProjection = viewProjection;
+	m_triangles.clear();
+	std::fill( m_levels[0].farthest.begin(), m_levels[0].farthest.end(), 1.0f );
+}
+
+// Queues the triangles of the passed level of detail for rasterization
+// Returns false if the sub mesh's positions are not stored as Float3 and cannot be read
+bool OcclusionCuller::AddOccluder( const SubMesh& subMesh, const uint32_t lod, const glm::mat4& transform )
+{
+	const VertexAttributeDesc& position = subMesh.layout.GetAttribute( EVertexAttribute::Position );
+	if ( position.format != EVertexFormat::Float3 || lod >= subMesh.lodCount )
+	{
+		return false;
+	}
+
+	const unsigned char* vertices = subMesh.vertexStreams[position.stream].data + position.offset;
+	const uint32_t stride = subMesh.layout.strides[position.stream];
+	const unsigned char* indices = subMesh.indexStream.data;
+	const glm::mat4 transformToClip = m_viewProjection * transform;
+
+	auto transformVertex = [&]( const uint32_t i )
+	{
+		uint32_t index = 0;
+		if ( subMesh.indexSize == sizeof( uint16_t ) )
+		{
+			uint16_t shortIndex = 0;
+			std::memcpy( &shortIndex, indices + static_cast<size_t>( i ) * sizeof( uint16_t ), sizeof( uint16_t ) );
+			index = shortIndex;
+		}
+		else
+		{
+			std::memcpy( &index, indices + static_cast<size_t>( i ) * sizeof( uint32_t ), sizeof( uint32_t ) );
+		}
+
+		float point[3];
+		std::memcpy( point, vertices + static_cast<size_t>( index ) * stride, sizeof( point ) );
+		return transformToClip * glm::vec4( point[0], point[1], point[2], 1.0f );
+	};
+
+	const MeshLod& range = subMesh.lods[lod];
+	for ( uint32_t i = range.firstIndex; i + 2 < range.firstIndex + range.indexCount; i += 3 )
+	{
+		AddTriangle( transformVertex( i ), transformVertex( i + 1 ), transformVertex( i + 2 ) );
+	}
+
+	return true;
+}
+
+// Rasterizes every queued occluder and builds the depth hierarchy, on the passed thread pool when there is one
+void OcclusionCuller::Rasterize( ThreadPool* threadPool )
+{
+	const size_t bandCount = ( m_height + m_bandHeight - 1 ) / m_bandHeight;
+	auto rasterize = [this]( size_t begin, size_t end )
+	{
+		for ( size_t band = begin; band < end; ++band )
+		{
+			const int firstRow = static_cast<int>( band ) * m_bandHeight;
+			RasterizeBand( firstRow, std::min( firstRow + m_bandHeight, m_height ) );
+		}
+	};
+
+	if ( threadPool && !m_triangles.empty() )
+	{
+		threadPool->ParallelFor( bandCount, 1, rasterize );
+	}
+	else
+	{
+		rasterize( 0, bandCount );
+	}
+
+	BuildHierarchy();
+}
+
+// Returns false if the passed bounds are outside of the view frustum or hidden behind the rasterized occluders
+// Safe to call from several threads at once once Rasterize has returned
+bool OcclusionCuller::IsVisible( const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& transform ) const
+{
+	const glm::mat4 transformToClip = m_viewProjection * transform;
+
+	float minX = FLT_MAX;
+	float minY = FLT_MAX;
+	float maxX = -FLT_MAX;
+	float maxY = -FLT_MAX;
+	float nearest = FLT_MAX;
+	int cornersBehind = 0;
+	for ( int corner = 0; corner < 8; ++corner )
+	{
+		const glm::vec4 clip = transformToClip * glm::vec4(
+			( corner & 1 ) ? boundsMax.x : boundsMin.x,
+			( corner & 2 ) ? boundsMax.y : boundsMin.y,
+			( corner & 4 ) ? boundsMax.z : boundsMin.z,
+			1.0f
+		);
+		if ( clip.w < m_minClipW )
+		{
+			cornersBehind++;
+			continue;
+		}
+
+		const float inverseW = 1.0f / clip.w;
+		const float x = ( clip.x * inverseW * 0.5f + 0.5f ) * m_width;
+		const float y = ( clip.y * inverseW * 0.5f + 0.5f ) * m_height;
+		minX = std::min( minX, x );
+		minY = std::min( minY, y );
+		maxX = std::max( maxX, x );
+		maxY = std::max( maxY, y );
+		nearest = std::min( nearest, clip.z * inverseW * 0.5f + 0.5f );
+	}
+
+	if ( cornersBehind > 0 )
+		// Bounds entirely behind the camera are never visible, bounds reaching behind it have an unbounded screen rectangle
+	{
+		return cornersBehind < 8;
+	}
+
+	if ( maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height || nearest > 1.0f )
+		// Outside of the view frustum
+	{
+		return false;
+	}
+
+	const int rect[4] = {
+		std::max( ToPixel( minX, m_width ), 0 ),
+		std::max( ToPixel( minY, m_height ), 0 ),
+		std::min( ToPixel( maxX, m_width ), m_width - 1 ),
+		std::min( ToPixel( maxY, m_height ), m_height - 1 )
+	};
+
+	// Starting on the finest level where the rectangle covers at most 2x2 texels
+	int level = 0;
+	while ( level + 1 < static_cast<int>( m_levels.size() ) &&
+		( ( rect[2] >> level ) - ( rect[0] >> level ) > 1 || ( rect[3] >> level ) - ( rect[1] >> level ) > 1 ) )
+	{
+		++level;
+	}
+
+	for ( int y = rect[1] >> level; y <= rect[3] >> level; ++y )
+	{
+		for ( int x = rect[0] >> level; x <= rect[2] >> level; ++x )
+		{
+			if ( !IsOccluded( level, x, y, rect, nearest, 0 ) )
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Builds the triangle's equations from clip space corners, skipping it if it crosses the near plane or covers no pixel
+void OcclusionCuller::AddTriangle( const glm::vec4& a, const glm::vec4& b, const glm::vec4& c )
+{
+	if ( a.w < m_minClipW || b.w < m_minClipW || c.w < m_minClipW )
+		// Not clipped, dropping an occluder triangle only ever makes culling less aggressive
+	{
+		return;
+	}
+
+	const glm::vec4* corners[3] = { &a, &b, &c };
+	float x[3];
+	float y[3];
+	float z[3];
+	for ( int k = 0; k < 3; ++k )
+	{
+		const float inverseW = 1.0f / corners[k]->w;
+		x[k] = ( corners[k]->x * inverseW * 0.5f + 0.5f ) * m_width;
+		y[k] = ( corners[k]->y * inverseW * 0.5f + 0.5f ) * m_height;
+		z[k] = corners[k]->z * inverseW * 0.5f + 0.5f;
+	}
+
+	float area = ( x[1] - x[0] ) * ( y[2] - y[0] ) - ( x[2] - x[0] ) * ( y[1] - y[0] );
+	if ( std::abs( area ) < 1e-6f || std::min( { z[0], z[1], z[2] } ) > 1.0f )
+	{
+		return;
+	}
+
+	// Both windings occlude, back facing triangles are turned around so their edges are positive inside as well
+	if ( area < 0.0f )
+	{
+		std::swap( x[1], x[2] );
+		std::swap( y[1], y[2] );
+		std::swap( z[1], z[2] );
+		area = -area;
+	}
+
+	RasterTriangle triangle;
+	triangle.minX = std::max( ToPixel( std::min( { x[0], x[1], x[2] } ), m_width ), 0 );
+	triangle.minY = std::max( ToPixel( std::min( { y[0], y[1], y[2] } ), m_height ), 0 );
+	triangle.maxX = std::min( ToPixel( std::max( { x[0], x[1], x[2] } ), m_width ), m_width - 1 );
+	triangle.maxY = std::min( ToPixel( std::max( { y[0], y[1], y[2] } ), m_height ), m_height - 1 );
+	if ( triangle.minX > triangle.maxX || triangle.minY > triangle.maxY )
+	{
+		return;
+	}
+
+	for ( int i = 0; i < 3; ++i )
+	{
+		const int j = ( i + 1 ) % 3;
+		triangle.edgeA[i] = y[i] - y[j];
+		triangle.edgeB[i] = x[j] - x[i];
+		triangle.edgeC[i] = x[i] * y[j] - x[j] * y[i];
+	}
+
+	// NDC depth is linear in screen space, so it is interpolated with a plane equation
+	triangle.depthA = ( ( z[1] - z[0] ) * ( y[2] - y[0] ) - ( z[2] - z[0] ) * ( y[1] - y[0] ) ) / area;
+	triangle.depthB = ( ( z[2] - z[0] ) * ( x[1] - x[0] ) - ( z[1] - z[0] ) * ( x[2] - x[0] ) ) / area;
+	triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+
+	m_triangles.push_back( triangle );
+}
+
+// Rasterizes every triangle into the rows [firstRow, lastRow) of the depth buffer
+void OcclusionCuller::RasterizeBand( const int firstRow, const int lastRow )
+{
+	float* depth = m_levels[0].farthest.data();
+
+	for ( const RasterTriangle& triangle : m_triangles )
+	{
+		const int rowBegin = std::max( triangle.minY, firstRow );
+		const int rowEnd = std::min( triangle.maxY + 1, lastRow );
+		if ( rowBegin >= rowEnd )
+		{
+			continue;
+		}
+
+#ifdef OCCLUSION_CULLER_SSE
+		// Four pixels of a row per register, m_width is a multiple of four so groups never cross a row
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 pixelCentres = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+		const __m128 edgeA0 = _mm_set1_ps( triangle.edgeA[0] );
+		const __m128 edgeA1 = _mm_set1_ps( triangle.edgeA[1] );
+		const __m128 edgeA2 = _mm_set1_ps( triangle.edgeA[2] );
+		const __m128 depthA = _mm_set1_ps( triangle.depthA );
+		const int columnBegin = triangle.minX & ~3;
+#endif
+
+		for ( int y = rowBegin; y < rowEnd; ++y )
+		{
+			const float centreY = static_cast<float>( y ) + 0.5f;
+			const float edgeRow[3] = {
+				triangle.edgeB[0] * centreY + triangle.edgeC[0],
+				triangle.edgeB[1] * centreY + triangle.edgeC[1],
+				triangle.edgeB[2] * centreY + triangle.edgeC[2]
+			};
+			const float depthRow = triangle.depthB * centreY + triangle.depthC;
+			float* row = depth + static_cast<size_t>( y ) * m_width;
+
+#ifdef OCCLUSION_CULLER_SSE
+			const __m128 edgeRow0 = _mm_set1_ps( edgeRow[0] );
+			const __m128 edgeRow1 = _mm_set1_ps( edgeRow[1] );
+			const __m128 edgeRow2 = _mm_set1_ps( edgeRow[2] );
+			const __m128 depthRowSplat = _mm_set1_ps( depthRow );
+
+			for ( int x = columnBegin; x <= triangle.maxX; x += 4 )
+			{
+				const __m128 centreX = _mm_add_ps( _mm_set1_ps( static_cast<float>( x ) ), pixelCentres );
+				const __m128 inside = _mm_and_ps(
+					_mm_and_ps(
+						_mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( edgeA0, centreX ), edgeRow0 ), zero ),
+						_mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( edgeA1, centreX ), edgeRow1 ), zero ) ),
+					_mm_cmpge_ps( _mm_add_ps( _mm_mul_ps( edgeA2, centreX ), edgeRow2 ), zero ) );
+				if ( _mm_movemask_ps( inside ) == 0 )
+				{
+					continue;
+				}
+
+				const __m128 current = _mm_loadu_ps( row + x );
+				const __m128 nearer = _mm_min_ps( current, _mm_add_ps( _mm_mul_ps( depthA, centreX ), depthRowSplat ) );
+				_mm_storeu_ps( row + x, _mm_or_ps( _mm_and_ps( inside, nearer ), _mm_andnot_ps( inside, current ) ) );
+			}
+#else
+			for ( int x = triangle.minX; x <= triangle.maxX; ++x )
+			{
+				const float centreX = static_cast<float>( x ) + 0.5f;
+				if ( triangle.edgeA[0] * centreX + edgeRow[0] >= 0.0f &&
+					triangle.edgeA[1] * centreX + edgeRow[1] >= 0.0f &&
+					triangle.edgeA[2] * centreX + edgeRow[2] >= 0.0f )
+				{
+					row[x] = std::min( row[x], triangle.depthA * centreX + depthRow );
+				}
+			}
+#endif
+		}
+	}
+}
+
+void OcclusionCuller::BuildHierarchy()
+{
+	for ( size_t l = 1; l < m_levels.size(); ++l )
+	{
+		const Level& source = m_levels[l - 1];
+		Level& destination = m_levels[l];
+
+		// Level 0 only stores the depth buffer, it is its own nearest depth
+		const float* sourceNearest = ( l == 1 ) ? source.farthest.data() : source.nearest.data();
+		const float* sourceFarthest = source.farthest.data();
+
+		for ( int y = 0; y < destination.height; ++y )
+		{
+			const size_t row0 = static_cast<size_t>( std::min( y * 2, source.height - 1 ) ) * source.width;
+			const size_t row1 = static_cast<size_t>( std::min( y * 2 + 1, source.height - 1 ) ) * source.width;
+			float* nearest = destination.nearest.data() + static_cast<size_t>( y ) * destination.width;
+			float* farthest = destination.farthest.data() + static_cast<size_t>( y ) * destination.width;
+
+			int x = 0;
+#ifdef OCCLUSION_CULLER_SSE
+			// Four output texels per step, from eight source texels of each row
+			for ( ; x + 4 <= destination.width && source.width == destination.width * 2; x += 4 )
+			{
+				const size_t column = static_cast<size_t>( x ) * 2;
+
+				const __m128 farLeft = _mm_max_ps( _mm_loadu_ps( sourceFarthest + row0 + column ), _mm_loadu_ps( sourceFarthest + row1 + column ) );
+				const __m128 farRight = _mm_max_ps( _mm_loadu_ps( sourceFarthest + row0 + column + 4 ), _mm_loadu_ps( sourceFarthest + row1 + column + 4 ) );
+				_mm_storeu_ps( farthest + x, _mm_max_ps(
+					_mm_shuffle_ps( farLeft, farRight, _MM_SHUFFLE( 2, 0, 2, 0 ) ),
+					_mm_shuffle_ps( farLeft, farRight, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ) );
+
+				const __m128 nearLeft = _mm_min_ps( _mm_loadu_ps( sourceNearest + row0 + column ), _mm_loadu_ps( sourceNearest + row1 + column ) );
+				const __m128 nearRight = _mm_min_ps( _mm_loadu_ps( sourceNearest + row0 + column + 4 ), _mm_loadu_ps( sourceNearest + row1 + column + 4 ) );
+				_mm_storeu_ps( nearest + x, _mm_min_ps(
+					_mm_shuffle_ps( nearLeft, nearRight, _MM_SHUFFLE( 2, 0, 2, 0 ) ),
+					_mm_shuffle_ps( nearLeft, nearRight, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ) );
+			}
+#endif
+			for ( ; x < destination.width; ++x )
+			{
+				const size_t x0 = static_cast<size_t>( std::min( x * 2, source.width - 1 ) );
+				const size_t x1 = static_cast<size_t>( std::min( x * 2 + 1, source.width - 1 ) );
+				farthest[x] = std::max( {
+					sourceFarthest[row0 + x0], sourceFarthest[row0 + x1],
+					sourceFarthest[row1 + x0], sourceFarthest[row1 + x1] } );
+				nearest[x] = std::min( {
+					sourceNearest[row0 + x0], sourceNearest[row0 + x1],
+					sourceNearest[row1 + x0], sourceNearest[row1 + x1] } );
+			}
+		}
+	}
+}
+
+// Returns true if the nearest depth is behind everything in the texel's part of the rectangle of level 0 pixels
+// by more than m_depthEpsilon
+bool OcclusionCuller::IsOccluded( const int level, const int x, const int y, const int rect[4], const float nearest, const int descent ) const
+{
+	const Level& texels = m_levels[level];
+	const size_t texel = static_cast<size_t>( y ) * texels.width + x;
+	if ( nearest > texels.farthest[texel] + m_depthEpsilon )
+	{
+		return true;
+	}
+
+	if ( level == 0 || descent >= m_maxTestDescent || nearest <= texels.nearest[texel] + m_depthEpsilon )
+		// Finer texels are never nearer than this one's nearest depth, so none of them can hide the bounds either
+	{
+		return false;
+	}
+
+	// Only the finer texels the rectangle overlaps, at most 2x2
+	const int child = level - 1;
+	for ( int cy = std::max( y * 2, rect[1] >> child ); cy <= std::min( y * 2 + 1, rect[3] >> child ); ++cy )
+	{
+		for ( int cx = std::max( x * 2, rect[0] >> child ); cx <= std::min( x * 2 + 1, rect[2] >> child ); ++cx )
+		{
+			if ( !IsOccluded( child, cx, cy, rect, nearest, descent + 1 ) )
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
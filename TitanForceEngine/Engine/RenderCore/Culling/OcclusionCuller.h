@@ -0,0 +1,106 @@
+#ifndef OCCLUSIONCULLER_H
+#define OCCLUSIONCULLER_H
+
+#include <glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct SubMesh;
+class ThreadPool;
+
+// Software occlusion culling against a small depth buffer rasterized on the CPU
+//
+// A few large occluders are rasterized into an m_width x m_height depth buffer, split into bands of rows that are
+// filled on the worker threads. A hierarchy of the nearest and farthest depth of every 2x2 block is built on top, and
+// bounds are tested against it without any GPU readback, so results only depend on the scene and camera
+// Depth is NDC depth mapped to [0, 1], smaller is nearer
+class OcclusionCuller
+{
+
+	OcclusionCuller( const OcclusionCuller& ) = delete;
+	OcclusionCuller& operator=( const OcclusionCuller& ) = delete;
+	OcclusionCuller( OcclusionCuller&& ) = delete;
+	OcclusionCuller& operator=( OcclusionCuller&& ) = delete;
+
+public:
+
+	static constexpr int m_width = 256;
+	static constexpr int m_height = 128;
+
+	// Rows of the depth buffer rasterized as one job, each band is only ever written by one thread
+	static constexpr int m_bandHeight = 8;
+
+	// Levels below the first one covering the tested bounds with 2x2 texels that a test may descend into
+	static constexpr int m_maxTestDescent = 3;
+
+	OcclusionCuller();
+	~OcclusionCuller();
+
+	// Clears the depth buffer and the queued occluders, everything until the next call uses the passed camera
+	void BeginFrame( const glm::mat4& viewProjection );
+
+	// Queues the triangles of the passed level of detail for rasterization
+	// Returns false if the sub mesh's positions are not stored as Float3 and cannot be read
+	bool AddOccluder( const SubMesh& subMesh, const uint32_t lod, const glm::mat4& transform );
+
+	// Rasterizes every queued occluder and builds the depth hierarchy, on the passed thread pool when there is one
+	void Rasterize( ThreadPool* threadPool );
+
+	// Returns false if the passed bounds are outside of the view frustum or hidden behind the rasterized occluders
+	// Safe to call from several threads at once once Rasterize has returned
+	bool IsVisible( const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& transform ) const;
+
+	size_t GetOccluderTriangleCount() const { return m_triangles.size(); }
+
+private:
+
+	// Clip space w below which a point counts as behind the camera
+	static constexpr float m_minClipW = 1e-4f;
+
+	// Bounds are only hidden when they are at least this much farther than the occluders, so a surface lying on
+	// an occluder's depth, such as a face on the near side of its own bounds, is never hidden by rounding
+	static constexpr float m_depthEpsilon = 1e-5f;
+
+	// Edge and depth plane equations of a triangle in depth buffer pixels, edges are >= 0 inside
+	struct RasterTriangle
+	{
+		float	edgeA[3];
+		float	edgeB[3];
+		float	edgeC[3];
+		float	depthA;
+		float	depthB;
+		float	depthC;
+		int		minX;
+		int		minY;
+		int		maxX;
+		int		maxY;
+	};
+
+	struct Level
+	{
+		int					width;
+		int					height;
+		std::vector<float>	nearest;	// Unused on level 0, where both are the depth buffer itself
+		std::vector<float>	farthest;
+	};
+
+	glm::mat4					m_viewProjection;
+	std::vector<RasterTriangle>	m_triangles;
+	std::vector<Level>			m_levels;
+
+	// Builds the triangle's equations from clip space corners, skipping it if it crosses the near plane or covers no pixel
+	void AddTriangle( const glm::vec4& a, const glm::vec4& b, const glm::vec4& c );
+
+	// Rasterizes every triangle into the rows [firstRow, lastRow) of the depth buffer
+	void RasterizeBand( const int firstRow, const int lastRow );
+
+	void BuildHierarchy();
+
+	// Returns true if the nearest depth is behind everything in the texel's part of the rectangle of level 0 pixels
+	// by more than m_depthEpsilon
+	bool IsOccluded( const int level, const int x, const int y, const int rect[4], const float nearest, const int descent ) const;
+
+};
+
+#endif // !OCCLUSIONCULLER_H
@@ -0,0 +1,194 @@
+#include "SceneCuller.h"
+#include "OcclusionCuller.h"
+
+#include "../Camera/Camera.h"
+#include "../Lighting/LightCuller.h"
+#include "../Lighting/LightSource.h"
+#include "../Model/Model.h"
+#include "../3D/Mesh.h"
+#include "../../AppCore/Scene.h"
+#include "../../Components/TransformComponent.h"
+#include "../../Core/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+
+SceneCuller::SceneCuller() :
+	m_occlusionCuller( new OcclusionCuller() ),
+	m_occludedModelCount( 0 ),
+	m_lightCuller( new LightCuller() ),
+	m_occluders(),
+	m_modelVisibility()
+{}
+
+SceneCuller::~SceneCuller()
+{
+	if ( m_occlusionCuller )
+	{
+		delete m_occlusionCuller;
+		m_occlusionCuller = nullptr;
+	}
+
+	if ( m_lightCuller )
+	{
+		delete m_lightCuller;
+		m_lightCuller = nullptr;
+	}
+}
+
+// Removes models hidden behind the largest models on screen from the passed list, see OcclusionCuller
+// Models still loading have no bounds yet and are kept, only resident models with a linked program are occluders
+// Occluders are always kept, they cannot be hidden behind themselves
+void SceneCuller::CullOccludedModels( std::vector<Model*>& models, const CameraComponent& camera, ThreadPool* threadPool )
+{
+	const glm::vec3 cameraPosition = camera.GetCameraPosition();
+	const float projectionScale = camera.GetPerspective()[1][1] * 0.5f * static_cast<float>( OcclusionCuller::m_height );
+
+	m_occlusionCuller->BeginFrame( camera.GetPerspective() * camera.GetView() );
+
+	// Models covering the most of the depth buffer hide the most behind them
+	m_occluders.clear();
+	for ( size_t i = 0; i < models.size(); ++i )
+	{
+		const Model* model = models[i];
+		if ( model == nullptr ||
+			model->GetMesh() == nullptr ||
+			!model->GetMesh()->IsReady() ||
+			model->GetShaderLinker() == nullptr ||
+			!model->GetShaderLinker()->IsReady() )
+			// Models that are not drawn yet must not hide anything behind them
+		{
+			continue;
+		}
+		const SubMesh* subMesh = model->GetMesh()->GetSubMesh();
+		if ( subMesh->lods[0].indexCount / 3 > m_maxOccluderTriangles )
+		{
+			continue;
+		}
+
+		const float screenRadius = GetScreenRadius( *subMesh, model->GetTransform()->GetTransform(), cameraPosition, projectionScale );
+		if ( screenRadius >= m_minOccluderScreenRadius )
+		{
+			m_occluders.emplace_back( screenRadius, i );
+		}
+	}
+
+	const size_t occluderCount = std::min( m_occluders.size(), m_maxOccluders );
+	std::partial_sort( m_occluders.begin(), m_occluders.begin() + occluderCount, m_occluders.end(),
+		[]( const std::pair<float, size_t>& a, const std::pair<float, size_t>& b ) { return a.first > b.first; } );
+
+	for ( size_t i = 0; i < occluderCount; ++i )
+	{
+		const Model* model = models[m_occluders[i].second];
+		m_occlusionCuller->AddOccluder( *model->GetMesh()->GetSubMesh(), 0, model->GetTransform()->GetTransform() );
+	}
+
+	m_occlusionCuller->Rasterize( threadPool );
+
+	m_modelVisibility.assign( models.size(), 1 );
+	auto test = [this, &models]( size_t begin, size_t end )
+	{
+		for ( size_t i = begin; i < end; ++i )
+		{
+			const Model* model = models[i];
+			const SubMesh* subMesh = ( model && model->GetMesh() ) ? model->GetMesh()->GetSubMesh() : nullptr;
+			if ( subMesh )
+			{
+				m_modelVisibility[i] = m_occlusionCuller->IsVisible( subMesh->boundsMin, subMesh->boundsMax, model->GetTransform()->GetTransform() ) ? 1 : 0;
+			}
+		}
+	};
+
+	if ( threadPool )
+	{
+		threadPool->ParallelFor( models.size(), m_testRangeSize, test );
+	}
+	else
+	{
+		test( 0, models.size() );
+	}
+
+	// An occluder's front faces lie on its own bounds, so testing it against itself could hide it
+	for ( size_t i = 0; i < occluderCount; ++i )
+	{
+		m_modelVisibility[m_occluders[i].second] = 1;
+	}
+
+	size_t visibleCount = 0;
+	for ( size_t i = 0; i < models.size(); ++i )
+	{
+		if ( m_modelVisibility[i] )
+		{
+			models[visibleCount++] = models[i];
+		}
+	}
+	m_occludedModelCount = models.size() - visibleCount;
+	models.resize( visibleCount );
+}
+
+// Gathers the scene's lights in view space and assigns them to clusters, see LightCuller
+void SceneCuller::CullLights( IScene* scene, const CameraComponent& camera, ThreadPool* threadPool )
+{
+	const glm::vec2 clippingPlanes = camera.GetClippingPlanes();
+	const glm::mat4 view = camera.GetView();
+
+	m_lightCuller->BeginFrame( camera.GetPerspective(), clippingPlanes.x, clippingPlanes.y );
+
+	auto lightRegistry = ECS::Parser<LightSourceComponent, TransformComponent>( scene->m_world );
+	for ( auto c : lightRegistry.GetComponents() )
+	{
+		LightSourceComponent* light = std::get<LightSourceComponent*>( c );
+		TransformComponent* transform = std::get<TransformComponent*>( c );
+
+		const glm::vec3 viewPosition = glm::vec3( view * transform->GetTransform()[3] );
+		if ( !m_lightCuller->AddLight( viewPosition, light->GetRadius(), light->GetColour(), *light->GetAmbient(), *light->GetDiffuse() ) )
+		{
+			break;
+		}
+	}
+
+	m_lightCuller->Build( threadPool );
+}
+
+// Returns the radius in pixels of the passed sub mesh's bounds on screen, or FLT_MAX if the camera is inside of them
+// projectionScale is the number of pixels one unit covers at a distance of one unit
+float SceneCuller::GetScreenRadius( const SubMesh& subMesh, const glm::mat4& transform, const glm::vec3& cameraPosition, const float projectionScale )
+{
+	const glm::vec3 center = glm::vec3( transform * glm::vec4( ( subMesh.boundsMin + subMesh.boundsMax ) * 0.5f, 1.0f ) );
+	const float scale = std::max( {
+		glm::length( glm::vec3( transform[0] ) ),
+		glm::length( glm::vec3( transform[1] ) ),
+		glm::length( glm::vec3( transform[2] ) )
+	} );
+	const float radius = glm::length( subMesh.boundsMax - subMesh.boundsMin ) * 0.5f * scale;
+
+	const float distance = glm::length( center - cameraPosition ) - radius;
+	if ( distance <= 0.0f )
+	{
+		return FLT_MAX;
+	}
+
+	return radius * projectionScale / distance;
+}
+
+// Picks the coarsest LOD whose error, scaled by the sub mesh's radius in pixels on screen, stays under m_lodPixelError
+uint32_t SceneCuller::SelectLod( const SubMesh& subMesh, const float screenRadius, const uint32_t currentLod )
+{
+	const float localRadius = glm::length( subMesh.boundsMax - subMesh.boundsMin ) * 0.5f;
+	if ( subMesh.lodCount <= 1 || localRadius <= 0.0f || screenRadius == FLT_MAX )
+	{
+		return 0;
+	}
+
+	// A LOD's error covers the same fraction of the bounds' radius on screen as it does in the mesh
+	for ( uint32_t lod = subMesh.lodCount - 1; lod > 0; --lod )
+	{
+		const float threshold = lod > currentLod ? m_lodPixelError * ( 1.0f - m_lodHysteresis ) : m_lodPixelError;
+		if ( subMesh.lods[lod].error / localRadius * screenRadius <= threshold )
+		{
+			return lod;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+#ifndef SCENECULLER_H
+#define SCENECULLER_H
+
+#include <glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class CameraComponent;
+class IScene;
+class LightCuller;
+class Model;
+class OcclusionCuller;
+class ThreadPool;
+struct SubMesh;
+
+// Decides what a frame draws independently of the graphics API, shared by every renderer so they all cull the same way
+// Hidden models are removed with OcclusionCuller, lights are clustered with LightCuller and LODs are picked from
+// each model's size on screen
+class SceneCuller
+{
+
+	SceneCuller( const SceneCuller& ) = delete;
+	SceneCuller& operator=( const SceneCuller& ) = delete;
+	SceneCuller( SceneCuller&& ) = delete;
+	SceneCuller& operator=( SceneCuller&& ) = delete;
+
+public:
+
+	// Furthest, in pixels, a LOD's surface may be drawn from the full detail surface
+	static constexpr float m_lodPixelError = 1.0f;
+
+	// A model only moves to a coarser LOD once that LOD's error is this fraction below m_lodPixelError
+	// so models sitting at a switching distance do not flicker between two LODs
+	static constexpr float m_lodHysteresis = 0.25f;
+
+	// Models drawn into the occlusion depth buffer each frame, picked by how much of it they cover
+	static constexpr size_t m_maxOccluders = 16;
+	static constexpr float m_minOccluderScreenRadius = 8.0f;	// In occlusion depth buffer pixels
+
+	// Occluders are rasterized at full detail, since simplified levels may bulge past the real surface and hide what
+	// is in front of it. Meshes with more triangles than this are too costly to rasterize and are never occluders
+	static constexpr uint32_t m_maxOccluderTriangles = 4096;
+
+	// Models tested for visibility per worker range
+	static constexpr size_t m_testRangeSize = 64;
+
+	SceneCuller();
+	~SceneCuller();
+
+	// Removes models hidden behind the largest models on screen from the passed list, see OcclusionCuller
+	// Models still loading have no bounds yet and are kept, only resident models with a linked program are occluders
+	// Occluders are always kept, they cannot be hidden behind themselves
+	void CullOccludedModels( std::vector<Model*>& models, const CameraComponent& camera, ThreadPool* threadPool );
+
+	// Gathers the scene's lights in view space and assigns them to clusters, see LightCuller
+	void CullLights( IScene* scene, const CameraComponent& camera, ThreadPool* threadPool );
+
+	// Models removed by the last CullOccludedModels
+	size_t GetOccludedModelCount() const { return m_occludedModelCount; }
+
+	const OcclusionCuller& GetOcclusionCuller() const { return *m_occlusionCuller; }
+	const LightCuller& GetLightCuller() const { return *m_lightCuller; }
+
+	// Returns the radius in pixels of the passed sub mesh's bounds on screen, or FLT_MAX if the camera is inside of them
+	// projectionScale is the number of pixels one unit covers at a distance of one unit
+	static float GetScreenRadius( const SubMesh& subMesh, const glm::mat4& transform, const glm::vec3& cameraPosition, const float projectionScale );
+
+	// Picks the coarsest LOD whose error, scaled by the sub mesh's radius in pixels on screen, stays under m_lodPixelError
+	static uint32_t SelectLod( const SubMesh& subMesh, const float screenRadius, const uint32_t currentLod );
+
+private:
+
+	OcclusionCuller*		m_occlusionCuller;
+	size_t					m_occludedModelCount;
+
+	LightCuller*			m_lightCuller;
+
+	// Rebuilt every frame, kept as members so their storage is reused
+	std::vector<std::pair<float, size_t>>	m_occluders;	// Screen radius and model index of each occluder
+	std::vector<unsigned char>				m_modelVisibility;
+
+};
+
+#endif // !SCENECULLER_H
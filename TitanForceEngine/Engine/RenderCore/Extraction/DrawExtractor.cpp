@@ -0,0 +1,117 @@
+#include "DrawExtractor.h"
+
+#include "../Culling/SceneCuller.h"
+#include "../Material/Material.h"
+#include "../Model/Model.h"
+#include "../3D/Mesh.h"
+#include "../../Components/TransformComponent.h"
+#include "../../Core/ThreadPool.h"
+
+#include <cmath>
+
+DrawExtractor::DrawExtractor() :
+	m_objects(),
+	m_draws()
+{}
+
+DrawExtractor::~DrawExtractor()
+{}
+
+// Writes the record of every model whose mesh is resident and picks its LOD, see SceneCuller::SelectLod
+// viewProjection is the renderer's own, so records hold the model view projection its shaders expect
+// Only indices.x, the model's material, is set, the rest of indices is up to the renderer
+void DrawExtractor::Extract(
+	const std::vector<Model*>& models,
+	const glm::mat4& view,
+	const glm::mat4& viewProjection,
+	const glm::vec3& cameraPosition,
+	const float projectionScale,
+	ThreadPool* threadPool )
+{
+	m_objects.resize( models.size() );
+	m_draws.resize( models.size() );
+
+	// Every model is written by exactly one range, so ranges need no locks
+	auto extract = [this, &models, &view, &viewProjection, &cameraPosition, projectionScale]( size_t begin, size_t end )
+	{
+		ExtractRange( models, begin, end, view, viewProjection, cameraPosition, projectionScale );
+	};
+
+	if ( threadPool )
+	{
+		threadPool->ParallelFor( models.size(), m_extractRangeSize, extract );
+	}
+	else
+	{
+		extract( 0, models.size() );
+	}
+}
+
+// Extracts the models in [begin, end)
+void DrawExtractor::ExtractRange(
+	const std::vector<Model*>& models,
+	const size_t begin,
+	const size_t end,
+	const glm::mat4& view,
+	const glm::mat4& viewProjection,
+	const glm::vec3& cameraPosition,
+	const float projectionScale )
+{
+	for ( size_t i = begin; i < end; ++i )
+	{
+		Model* model = models[i];
+		ExtractedDraw& draw = m_draws[i];
+		if ( model == nullptr ||
+			model->GetMesh() == nullptr ||
+			!model->GetMesh()->IsReady() )
+			// Meshes still uploading are skipped until they are resident
+		{
+			draw.isResident = false;
+			continue;
+		}
+
+		const SubMesh* subMesh = model->GetMesh()->GetSubMesh();
+		const glm::mat4 transform = model->GetTransform()->GetTransform();
+		const float screenRadius = SceneCuller::GetScreenRadius( *subMesh, transform, cameraPosition, projectionScale );
+		draw.lod = SceneCuller::SelectLod( *subMesh, screenRadius, model->GetLod() );
+		draw.isResident = true;
+		model->SetLod( draw.lod );
+
+		const glm::vec4 centre = transform * glm::vec4( ( subMesh->boundsMin + subMesh->boundsMax ) * 0.5f, 1.0f );
+		draw.depth = -( view * centre ).z;
+
+		// Both matrices are stored as rows, an affine transform's last row is always 0 0 0 1 so it is left out
+		const glm::mat3 normalMatrix = GetNormalMatrix( transform );
+		ObjectUniforms& object = m_objects[i];
+		object.modelViewProjection = viewProjection * transform;
+		for ( int row = 0; row < 3; ++row )
+		{
+			object.modelMatrix[row] = glm::vec4( transform[0][row], transform[1][row], transform[2][row], transform[3][row] );
+			object.normalMatrix[row] = glm::vec4( normalMatrix[0][row], normalMatrix[1][row], normalMatrix[2][row], 0.0f );
+		}
+		object.indices = glm::uvec4( model->GetMaterial()->index, 0, 0, 0 );
+	}
+}
+
+// Returns the inverse transpose of the transform's upper 3x3
+// A rotation with a uniform scale s is only divided by s squared instead of being inverted
+glm::mat3 DrawExtractor::GetNormalMatrix( const glm::mat4& transform )
+{
+	const glm::mat3 axes( transform );
+	const float lengthSquared = glm::dot( axes[0], axes[0] );
+	const float tolerance = m_uniformScaleTolerance * lengthSquared;
+
+	const bool isUniform = lengthSquared > 0.0f &&
+		std::abs( glm::dot( axes[1], axes[1] ) - lengthSquared ) <= tolerance &&
+		std::abs( glm::dot( axes[2], axes[2] ) - lengthSquared ) <= tolerance &&
+		std::abs( glm::dot( axes[0], axes[1] ) ) <= tolerance &&
+		std::abs( glm::dot( axes[0], axes[2] ) ) <= tolerance &&
+		std::abs( glm::dot( axes[1], axes[2] ) ) <= tolerance;
+
+	if ( isUniform )
+	{
+		return axes * ( 1.0f / lengthSquared );
+	}
+
+	return glm::transpose( glm::inverse( axes ) );
+}
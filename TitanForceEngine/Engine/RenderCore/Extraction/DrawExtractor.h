@@ -0,0 +1,84 @@
+#ifndef DRAWEXTRACTOR_H
+#define DRAWEXTRACTOR_H
+
+#include "../Shader/UniformBlocks.h"
+
+#include <glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+class ThreadPool;
+
+// Extraction pass run once per frame after culling, shared by every renderer
+// Walks the frame's models on the worker threads and writes each one's ObjectUniforms into one contiguous array, in the
+// same order as the models, next to the LOD and view depth recording needs. Renderers only copy the records they draw
+// into their streamed object data, nothing per draw is computed while recording or on the render thread
+class DrawExtractor
+{
+
+	DrawExtractor( const DrawExtractor& ) = delete;
+	DrawExtractor& operator=( const DrawExtractor& ) = delete;
+	DrawExtractor( DrawExtractor&& ) = delete;
+	DrawExtractor& operator=( DrawExtractor&& ) = delete;
+
+public:
+
+	// Models extracted per worker range
+	static constexpr size_t m_extractRangeSize = 64;
+
+	// Relative difference under which a transform's axes count as equally long and perpendicular
+	static constexpr float m_uniformScaleTolerance = 1e-4f;
+
+	// What recording needs to know about a model besides its record
+	struct ExtractedDraw
+	{
+		float		depth;			// View depth of the model's bounds centre, for sorting front to back
+		uint32_t	lod;
+		bool		isResident;		// False for models without a mesh or whose mesh is still uploading, they have no record
+	};
+
+	DrawExtractor();
+	~DrawExtractor();
+
+	// Writes the record of every model whose mesh is resident and picks its LOD, see SceneCuller::SelectLod
+	// viewProjection is the renderer's own, so records hold the model view projection its shaders expect
+	// Only indices.x, the model's material, is set, the rest of indices is up to the renderer
+	// Renderers drawing a model's ranges on their own replace it with each range's material
+	void Extract(
+		const std::vector<Model*>& models,
+		const glm::mat4& view,
+		const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition,
+		const float projectionScale,
+		ThreadPool* threadPool );
+
+	// Record and draw of the model at the passed index of the last extracted models
+	const ObjectUniforms& GetObject( const size_t model ) const { return m_objects[model]; }
+	const ExtractedDraw& GetDraw( const size_t model ) const { return m_draws[model]; }
+
+	// Returns the inverse transpose of the transform's upper 3x3
+	// A rotation with a uniform scale s is only divided by s squared instead of being inverted
+	static glm::mat3 GetNormalMatrix( const glm::mat4& transform );
+
+private:
+
+	// Grown to the model count and kept, so extracting a frame allocates nothing once it has
+	std::vector<ObjectUniforms>	m_objects;
+	std::vector<ExtractedDraw>	m_draws;
+
+	// Extracts the models in [begin, end)
+	void ExtractRange(
+		const std::vector<Model*>& models,
+		const size_t begin,
+		const size_t end,
+		const glm::mat4& view,
+		const glm::mat4& viewProjection,
+		const glm::vec3& cameraPosition,
+		const float projectionScale );
+
+};
+
+#endif // !DRAWEXTRACTOR_H
@@ -0,0 +1,205 @@
+#include "LightCuller.h"
+
+#include "../../Core/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Returns true if the sphere reaches into the box
+	bool SphereIntersectsBox( const glm::vec3& center, const float radius, const glm::vec3& boxMin, const glm::vec3& boxMax )
+	{
+		float distanceSquared = 0.0f;
+		for ( int axis = 0; axis < 3; ++axis )
+		{
+			const float closest = std::clamp( center[axis], boxMin[axis], boxMax[axis] );
+			const float delta = center[axis] - closest;
+			distanceSquared += delta * delta;
+		}
+
+		return distanceSquared <= radius * radius;
+	}
+}
+
+LightCuller::LightCuller() :
+	m_projection( 0.0f ),
+	m_nearPlane( 0.0f ),
+	m_farPlane( 0.0f ),
+	m_sliceScale( 0.0f ),
+	m_sliceBias( 0.0f ),
+	m_clusterBounds( m_clusterCount ),
+	m_lights(),
+	m_sliceCandidates( static_cast<size_t>( m_clusterCountZ ) * m_maxLights ),
+	m_clusterLightCounts( m_clusterCount, 0 ),
+	m_clusterLightSlots( static_cast<size_t>( m_clusterCount ) * m_maxLightsPerCluster ),
+	m_clusters( m_clusterCount ),
+	m_lightIndices(),
+	m_droppedReferenceCount( 0 )
+{
+	m_lights.reserve( m_maxLights );
+}
+
+LightCuller::~LightCuller()
+{}
+
+// Clears the submitted lights, the cluster bounds are only rebuilt when the projection or clipping planes change
+void LightCuller::BeginFrame( const glm::mat4& projection, const float nearPlane, const float farPlane )
+{
+	m_lights.clear();
+
+	if ( projection != m_projection || nearPlane != m_nearPlane || farPlane != m_farPlane )
+	{
+		m_projection = projection;
+		m_nearPlane = nearPlane;
+		m_farPlane = farPlane;
+		BuildClusterBounds();
+	}
+}
+
+// Submits a point light, returns false once m_maxLights lights have been submitted this frame
+bool LightCuller::AddLight( const glm::vec3& viewPosition, const float radius, const glm::vec3& colour, const float ambient, const float diffuse )
+{
+	if ( m_lights.size() >= m_maxLights )
+	{
+		return false;
+	}
+
+	LightUniforms light;
+	light.positionRadius = glm::vec4( viewPosition, radius );
+	light.diffuse = glm::vec4( colour * diffuse, 0.0f );
+	light.ambient = glm::vec4( colour * ambient, 0.0f );
+	m_lights.push_back( light );
+
+	return true;
+}
+
+// Assigns every submitted light to the clusters it reaches, on the passed thread pool when there is one
+void LightCuller::Build( ThreadPool* threadPool )
+{
+	auto build = [this]( size_t begin, size_t end )
+	{
+		for ( size_t slice = begin; slice < end; ++slice )
+		{
+			BuildSlice( static_cast<uint32_t>( slice ) );
+		}
+	};
+
+	if ( threadPool && !m_lights.empty() )
+	{
+		threadPool->ParallelFor( m_clusterCountZ, 1, build );
+	}
+	else
+	{
+		build( 0, m_clusterCountZ );
+	}
+
+	// Packing the lists in cluster order keeps the result the same however the slices were split between threads
+	m_lightIndices.clear();
+	m_droppedReferenceCount = 0;
+	for ( uint32_t cluster = 0; cluster < m_clusterCount; ++cluster )
+	{
+		const uint32_t count = std::min( m_clusterLightCounts[cluster], m_maxLightsPerCluster );
+		const uint32_t* slots = m_clusterLightSlots.data() + static_cast<size_t>( cluster ) * m_maxLightsPerCluster;
+
+		m_clusters[cluster].offset = static_cast<uint32_t>( m_lightIndices.size() );
+		m_clusters[cluster].count = count;
+		m_lightIndices.insert( m_lightIndices.end(), slots, slots + count );
+		m_droppedReferenceCount += m_clusterLightCounts[cluster] - count;
+	}
+}
+
+// Rebuilds the view space bounds of every cluster from the current projection
+void LightCuller::BuildClusterBounds()
+{
+	const float logRatio = std::log( m_farPlane / m_nearPlane );
+	m_sliceScale = static_cast<float>( m_clusterCountZ ) / logRatio;
+	m_sliceBias = -static_cast<float>( m_clusterCountZ ) * std::log( m_nearPlane ) / logRatio;
+
+	// At a view depth d, NDC x maps to view x = d * ( ndc + m[2][0] ) / m[0][0], and the same for y
+	auto toView = [this]( const float ndc, const float depth, const int axis )
+	{
+		return depth * ( ndc + m_projection[2][axis] ) / m_projection[axis][axis];
+	};
+
+	for ( uint32_t z = 0; z < m_clusterCountZ; ++z )
+	{
+		const float nearDepth = GetSliceDepth( z );
+		const float farDepth = GetSliceDepth( z + 1 );
+
+		for ( uint32_t y = 0; y < m_clusterCountY; ++y )
+		{
+			const float ndcBottom = -1.0f + 2.0f * static_cast<float>( y ) / static_cast<float>( m_clusterCountY );
+			const float ndcTop = -1.0f + 2.0f * static_cast<float>( y + 1 ) / static_cast<float>( m_clusterCountY );
+
+			for ( uint32_t x = 0; x < m_clusterCountX; ++x )
+			{
+				const float ndcLeft = -1.0f + 2.0f * static_cast<float>( x ) / static_cast<float>( m_clusterCountX );
+				const float ndcRight = -1.0f + 2.0f * static_cast<float>( x + 1 ) / static_cast<float>( m_clusterCountX );
+
+				// The tile's sides are planes through the eye, so its widest point is on the near or far face
+				const float xs[4] = {
+					toView( ndcLeft, nearDepth, 0 ), toView( ndcRight, nearDepth, 0 ),
+					toView( ndcLeft, farDepth, 0 ), toView( ndcRight, farDepth, 0 )
+				};
+				const float ys[4] = {
+					toView( ndcBottom, nearDepth, 1 ), toView( ndcTop, nearDepth, 1 ),
+					toView( ndcBottom, farDepth, 1 ), toView( ndcTop, farDepth, 1 )
+				};
+
+				Bounds& bounds = m_clusterBounds[x + m_clusterCountX * ( y + m_clusterCountY * z )];
+				bounds.min = glm::vec3( *std::min_element( xs, xs + 4 ), *std::min_element( ys, ys + 4 ), -farDepth );
+				bounds.max = glm::vec3( *std::max_element( xs, xs + 4 ), *std::max_element( ys, ys + 4 ), -nearDepth );
+			}
+		}
+	}
+}
+
+// Returns the view depth at which the passed slice starts, slice m_clusterCountZ starts at the far plane
+float LightCuller::GetSliceDepth( const uint32_t slice ) const
+{
+	return m_nearPlane * std::pow( m_farPlane / m_nearPlane, static_cast<float>( slice ) / static_cast<float>( m_clusterCountZ ) );
+}
+
+// Assigns lights to every cluster of the passed slice
+void LightCuller::BuildSlice( const uint32_t slice )
+{
+	const float nearDepth = GetSliceDepth( slice );
+	const float farDepth = GetSliceDepth( slice + 1 );
+
+	// Lights out of the slice's depth range cannot reach any of its clusters
+	uint32_t* candidates = m_sliceCandidates.data() + static_cast<size_t>( slice ) * m_maxLights;
+	uint32_t candidateCount = 0;
+	for ( uint32_t i = 0; i < static_cast<uint32_t>( m_lights.size() ); ++i )
+	{
+		const glm::vec4& light = m_lights[i].positionRadius;
+		if ( -light.z + light.w >= nearDepth && -light.z - light.w <= farDepth )
+		{
+			candidates[candidateCount++] = i;
+		}
+	}
+
+	const uint32_t firstCluster = slice * m_clusterCountX * m_clusterCountY;
+	for ( uint32_t cluster = firstCluster; cluster < firstCluster + m_clusterCountX * m_clusterCountY; ++cluster )
+	{
+		const Bounds& bounds = m_clusterBounds[cluster];
+		uint32_t* slots = m_clusterLightSlots.data() + static_cast<size_t>( cluster ) * m_maxLightsPerCluster;
+		uint32_t count = 0;
+
+		for ( uint32_t c = 0; c < candidateCount; ++c )
+		{
+			const glm::vec4& light = m_lights[candidates[c]].positionRadius;
+			if ( SphereIntersectsBox( glm::vec3( light ), light.w, bounds.min, bounds.max ) )
+			{
+				// Full clusters still count the light, so Build can report how many references were dropped
+				if ( count < m_maxLightsPerCluster )
+				{
+					slots[count] = candidates[c];
+				}
+				++count;
+			}
+		}
+
+		m_clusterLightCounts[cluster] = count;
+	}
+}
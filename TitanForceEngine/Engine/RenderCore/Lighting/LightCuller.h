@@ -0,0 +1,100 @@
+#ifndef LIGHTCULLER_H
+#define LIGHTCULLER_H
+
+#include "../Shader/UniformBlocks.h"
+
+#include <glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Clustered light culling for forward shading
+//
+// The view frustum is split into m_clusterCountX x m_clusterCountY tiles on screen and m_clusterCountZ slices in depth,
+// slices grow exponentially with distance so clusters stay roughly cube shaped. Every frame the lights are assigned
+// to the clusters their range touches, one slice per job on the worker threads, and packed into a compact index list
+// A fragment finds its cluster from its pixel and view depth and only shades with that cluster's lights
+// Everything is in view space, where the camera looks down -z
+class LightCuller
+{
+
+	LightCuller( const LightCuller& ) = delete;
+	LightCuller& operator=( const LightCuller& ) = delete;
+	LightCuller( LightCuller&& ) = delete;
+	LightCuller& operator=( LightCuller&& ) = delete;
+
+public:
+
+	static constexpr uint32_t m_clusterCountX = 16;
+	static constexpr uint32_t m_clusterCountY = 9;
+	static constexpr uint32_t m_clusterCountZ = 24;
+	static constexpr uint32_t m_clusterCount = m_clusterCountX * m_clusterCountY * m_clusterCountZ;
+
+	// Lights past these limits are dropped, the furthest down the submitted order first
+	static constexpr uint32_t m_maxLights = 1024;
+	static constexpr uint32_t m_maxLightsPerCluster = 64;
+
+	LightCuller();
+	~LightCuller();
+
+	// Clears the submitted lights, the cluster bounds are only rebuilt when the projection or clipping planes change
+	void BeginFrame( const glm::mat4& projection, const float nearPlane, const float farPlane );
+
+	// Submits a point light, returns false once m_maxLights lights have been submitted this frame
+	bool AddLight( const glm::vec3& viewPosition, const float radius, const glm::vec3& colour, const float ambient, const float diffuse );
+
+	// Assigns every submitted light to the clusters it reaches, on the passed thread pool when there is one
+	void Build( ThreadPool* threadPool );
+
+	const std::vector<LightUniforms>& GetLights() const { return m_lights; }
+	const std::vector<ClusterUniforms>& GetClusters() const { return m_clusters; }
+	const std::vector<uint32_t>& GetLightIndices() const { return m_lightIndices; }
+
+	// Scale and bias turning the log of a view depth into its slice, slice = log( depth ) * scale + bias
+	float GetSliceScale() const { return m_sliceScale; }
+	float GetSliceBias() const { return m_sliceBias; }
+
+	// Cluster light references dropped last Build because a cluster was full
+	size_t GetDroppedReferenceCount() const { return m_droppedReferenceCount; }
+
+private:
+
+	struct Bounds
+	{
+		glm::vec3	min;
+		glm::vec3	max;
+	};
+
+	glm::mat4						m_projection;
+	float							m_nearPlane;
+	float							m_farPlane;
+	float							m_sliceScale;
+	float							m_sliceBias;
+
+	std::vector<Bounds>				m_clusterBounds;
+
+	std::vector<LightUniforms>		m_lights;
+
+	// Written by Build's jobs, each slice only ever touches its own clusters and m_maxLights candidates
+	std::vector<uint32_t>			m_sliceCandidates;
+	std::vector<uint32_t>			m_clusterLightCounts;
+	std::vector<uint32_t>			m_clusterLightSlots;	// m_maxLightsPerCluster per cluster
+
+	std::vector<ClusterUniforms>	m_clusters;
+	std::vector<uint32_t>			m_lightIndices;
+	size_t							m_droppedReferenceCount;
+
+	// Rebuilds the view space bounds of every cluster from the current projection
+	void BuildClusterBounds();
+
+	// Returns the view depth at which the passed slice starts, slice m_clusterCountZ starts at the far plane
+	float GetSliceDepth( const uint32_t slice ) const;
+
+	// Assigns lights to every cluster of the passed slice
+	void BuildSlice( const uint32_t slice );
+
+};
+
+#endif // !LIGHTCULLER_H
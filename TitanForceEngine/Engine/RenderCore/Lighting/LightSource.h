@@ -16,14 +16,16 @@ public:
 		Component( ID ),
 		m_ambient( 0.2f ),
 		m_diffuse( 0.8f ),
-		m_colour( glm::vec3( 1.0f, 1.0f, 1.0f ) )
+		m_colour( glm::vec3( 1.0f, 1.0f, 1.0f ) ),
+		m_radius( 10.0f )
 	{}
 
-	LightSourceComponent( float ambient, float diffuse, glm::vec3 colour ) :
+	LightSourceComponent( float ambient, float diffuse, glm::vec3 colour, float radius = 10.0f ) :
 		Component( ID ),
 		m_ambient( ambient ),
 		m_diffuse( diffuse ),
-		m_colour( colour )
+		m_colour( colour ),
+		m_radius( radius )
 	{}
 
 	~LightSourceComponent() {}
@@ -32,11 +34,16 @@ public:
 	float* GetDiffuse() { return &m_diffuse; }
 	glm::vec3 GetColour() { return m_colour; }
 
+	// Distance from the light's position past which it lights nothing, its light fades out smoothly up to it
+	float GetRadius() const { return m_radius; }
+	void SetRadius( float radius ) { m_radius = radius; }
+
 private:
 
 	float		m_ambient;
 	float		m_diffuse;
 	glm::vec3	m_colour;
+	float		m_radius;
 
 };
 
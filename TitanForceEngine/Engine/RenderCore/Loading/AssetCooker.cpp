@@ -0,0 +1,136 @@
+#include "AssetCooker.h"
+#include "../3D/MeshLoader.h"
+#include "../Texture/TextureCooker.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace
+{
+	// Images stb_image decodes, see TextureCooker::CookTexture
+	const std::vector<const char*> g_textureExtensions = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+
+	const std::vector<const char*> g_meshExtensions = { ".obj" };
+}
+
+// Cooks every texture and mesh, returns false if any of them could not be cooked
+// Meshes are cooked with the standard vertex layout, meshes loaded with another one are still cooked on first load
+bool AssetCooker::CookAll()
+{
+	// Both run even if the first fails, so a single run reports every asset that cannot be cooked
+	const bool texturesCooked = CookTextures();
+	const bool meshesCooked = CookMeshes();
+	return texturesCooked && meshesCooked;
+}
+
+// Cooks every image under Resources/Textures into Resources/Textures/Cooked, returns false if any failed
+bool AssetCooker::CookTextures()
+{
+	return CookFolder(
+		TextureCooker::GetSourceFilePath( "" ),
+		g_textureExtensions,
+		[]( const std::string& fileName ) { return TextureCooker::CookTexture( fileName ); }
+	);
+}
+
+// Cooks every OBJ under Resources/Models into Resources/Models/Cooked, returns false if any failed
+bool AssetCooker::CookMeshes()
+{
+	return CookFolder(
+		MeshLoader::GetSourceFilePath( "" ),
+		g_meshExtensions,
+		[]( const std::string& fileName )
+		{
+			try
+			{
+				return MeshLoader::CookMesh( fileName );
+			}
+			catch ( const std::runtime_error& error )
+			{
+				DEBUG_LOG( LOG::ERRORLOG, "Cannot cook mesh " + fileName + ": " + error.what() );
+				CONSOLE_LOG( LOG::ERRORLOG, "Cannot cook mesh " + fileName + ": " + error.what() );
+				return false;
+			}
+		}
+	);
+}
+
+// Returns true if the passed file name ends in the passed extension, ignoring case
+bool AssetCooker::HasExtension( const std::string& fileName, const char* extension )
+{
+	const size_t length = std::strlen( extension );
+	if ( fileName.size() < length )
+	{
+		return false;
+	}
+
+	return std::equal( extension, extension + length, fileName.end() - length,
+		[]( const char a, const char b ) { return std::tolower( static_cast<unsigned char>( a ) ) == std::tolower( static_cast<unsigned char>( b ) ); } );
+}
+
+// Calls cook with the name of every file under the passed folder, relative to it, that has one of the passed extensions
+// Files in the folder's Cooked subfolder are skipped. Returns false if any call did
+bool AssetCooker::CookFolder(
+	const std::string& folder,
+	const std::vector<const char*>& extensions,
+	const std::function<bool( const std::string& )>& cook )
+{
+	std::error_code error;
+	if ( !std::filesystem::is_directory( folder, error ) )
+	{
+		DEBUG_LOG( LOG::WARNING, "Nothing to cook, missing folder: " + folder );
+		CONSOLE_LOG( LOG::WARNING, "Nothing to cook, missing folder: " + folder );
+		return true;
+	}
+
+	const std::filesystem::path cookedFolder = std::filesystem::path( folder ) / "Cooked";
+
+	bool hasCookedAll = true;
+	size_t cookedCount = 0;
+	for ( auto entry = std::filesystem::recursive_directory_iterator( folder, error ); !error && entry != std::filesystem::recursive_directory_iterator(); entry.increment( error ) )
+	{
+		if ( entry->path() == cookedFolder )
+		{
+			entry.disable_recursion_pending();
+			continue;
+		}
+
+		if ( !entry->is_regular_file() )
+		{
+			continue;
+		}
+
+		const std::string fileName = entry->path().lexically_relative( folder ).generic_string();
+		if ( std::none_of( extensions.begin(), extensions.end(), [&fileName]( const char* extension ) { return HasExtension( fileName, extension ); } ) )
+		{
+			continue;
+		}
+
+		if ( cook( fileName ) )
+		{
+			DEBUG_LOG( LOG::INFO, "Cooked: " + fileName );
+			CONSOLE_LOG( LOG::INFO, "Cooked: " + fileName );
+			++cookedCount;
+		}
+		else
+		{
+			hasCookedAll = false;
+		}
+	}
+
+	if ( error )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot list folder " + folder + ": " + error.message() );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot list folder " + folder + ": " + error.message() );
+		hasCookedAll = false;
+	}
+
+	DEBUG_LOG( LOG::INFO, "Cooked " + std::to_string( cookedCount ) + " files from " + folder );
+	CONSOLE_LOG( LOG::INFO, "Cooked " + std::to_string( cookedCount ) + " files from " + folder );
+	return hasCookedAll;
+}
@@ -0,0 +1,45 @@
+#ifndef ASSETCOOKER_H
+#define ASSETCOOKER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Cooks every source texture and OBJ in the resource folders ahead of time, on the CPU alone
+// Needs no window or graphics context, so cooked files can be built on machines without a GPU, see main's --cook
+class AssetCooker
+{
+
+	AssetCooker() = delete;	// Static class, no constructor needed
+	AssetCooker( const AssetCooker& ) = delete;
+	AssetCooker& operator=( const AssetCooker& ) = delete;
+	AssetCooker( AssetCooker&& ) = delete;
+	AssetCooker& operator=( AssetCooker&& ) = delete;
+
+public:
+
+	// Cooks every texture and mesh, returns false if any of them could not be cooked
+	// Meshes are cooked with the standard vertex layout, meshes loaded with another one are still cooked on first load
+	static bool CookAll();
+
+	// Cooks every image under Resources/Textures into Resources/Textures/Cooked, returns false if any failed
+	static bool CookTextures();
+
+	// Cooks every OBJ under Resources/Models into Resources/Models/Cooked, returns false if any failed
+	static bool CookMeshes();
+
+private:
+
+	// Returns true if the passed file name ends in the passed extension, ignoring case
+	static bool HasExtension( const std::string& fileName, const char* extension );
+
+	// Calls cook with the name of every file under the passed folder, relative to it, that has one of the passed extensions
+	// Files in the folder's Cooked subfolder are skipped. Returns false if any call did
+	static bool CookFolder(
+		const std::string& folder,
+		const std::vector<const char*>& extensions,
+		const std::function<bool( const std::string& )>& cook );
+
+};
+
+#endif // !ASSETCOOKER_H
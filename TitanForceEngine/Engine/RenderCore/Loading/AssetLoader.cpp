@@ -0,0 +1,211 @@
+#include "AssetLoader.h"
+
+#include "../3D/Mesh.h"
+#include "../3D/MeshLoader.h"
+#include "../Texture/Texture2D.h"
+#include "../../Core/Engine.h"
+#include "../../Core/ThreadPool.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+
+std::unique_ptr<AssetLoader> AssetLoader::g_assetLoaderInstance( nullptr );
+
+AssetLoader::AssetLoader()
+{}
+
+AssetLoader::~AssetLoader()
+{}
+
+// Get Instance of Asset Loader
+AssetLoader* AssetLoader::Get()
+{
+	if ( g_assetLoaderInstance == nullptr )
+	{
+		g_assetLoaderInstance.reset( new AssetLoader );
+	}
+	return g_assetLoaderInstance.get();
+}
+
+// Queues the passed mesh's OBJ to be loaded on a worker thread, the mesh draws nothing until it is finalized
+void AssetLoader::LoadMesh( IMesh* mesh, const std::string& fileName )
+{
+	Load(
+		"Mesh:" + fileName,
+		mesh,
+		[fileName]() -> std::shared_ptr<void>
+		{
+			return std::shared_ptr<SubMesh>( MeshLoader::LoadMesh( fileName ) );
+		},
+		[mesh]( const std::shared_ptr<void>& data )
+		{
+			mesh->OnSubMeshLoaded( std::static_pointer_cast<SubMesh>( data ) );
+		}
+	);
+}
+
+// Queues the passed texture's image to be decoded on a worker thread, the texture keeps its placeholder until it is finalized
+void AssetLoader::LoadTexture( Texture2D* texture, const std::string& fileName )
+{
+	Load(
+		"Texture:" + fileName,
+		texture,
+		[fileName]() -> std::shared_ptr<void>
+		{
+			return Texture2D::Decode( fileName );
+		},
+		[texture]( const std::shared_ptr<void>& data )
+		{
+			texture->Upload( std::static_pointer_cast<TextureData>( data ) );
+		}
+	);
+}
+
+// Drops every queued load for the passed mesh or texture, must be called before it is destroyed
+void AssetLoader::Cancel( const void* owner )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	for ( auto& inFlight : m_inFlight )
+	{
+		std::vector<Waiter>& waiters = inFlight.second;
+		waiters.erase(
+			std::remove_if( waiters.begin(), waiters.end(), [owner]( const Waiter& w ) { return w.owner == owner; } ),
+			waiters.end()
+		);
+	}
+
+	m_ready.erase(
+		std::remove_if( m_ready.begin(), m_ready.end(), [owner]( const ReadyAsset& r ) { return r.waiter.owner == owner; } ),
+		m_ready.end()
+	);
+}
+
+// Finalizes loaded assets, creating their GPU resources, until the passed budget is spent. Render thread only
+void AssetLoader::ProcessUploads( const float budgetMilliseconds )
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	while ( true )
+	{
+		ReadyAsset asset;
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			if ( m_ready.empty() )
+			{
+				return;
+			}
+			asset = std::move( m_ready.front() );
+			m_ready.pop_front();
+		}
+
+		asset.waiter.finalize( asset.data );
+
+		const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if ( elapsed.count() >= budgetMilliseconds )
+			// Whatever is left waits for the next frame, at least one asset is finalized every call
+		{
+			return;
+		}
+	}
+}
+
+// Blocks until every queued asset has been loaded and finalized. Render thread only
+void AssetLoader::Flush()
+{
+	while ( true )
+	{
+		{
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_assetReady.wait( lock, [this]() { return !m_ready.empty() || m_inFlight.empty(); } );
+			if ( m_ready.empty() && m_inFlight.empty() )
+			{
+				return;
+			}
+		}
+
+		ProcessUploads( std::numeric_limits<float>::max() );
+	}
+}
+
+// Returns the number of assets still loading or waiting to be finalized
+size_t AssetLoader::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+	return m_inFlight.size() + m_ready.size();
+}
+
+// Loads the asset with the passed key once, every owner waiting on it is finalized with the same data
+void AssetLoader::Load( const std::string& key, const void* owner, LoadFunction load, FinalizeFunction finalize )
+{
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		auto loaded = m_loaded.find( key );
+		if ( loaded != m_loaded.end() )
+		{
+			if ( std::shared_ptr<void> data = loaded->second.lock() )
+				// Still alive from an earlier load, it only needs finalizing for this owner
+			{
+				m_ready.push_back( { data, { owner, std::move( finalize ) } } );
+				m_assetReady.notify_all();
+				return;
+			}
+			m_loaded.erase( loaded );
+		}
+
+		auto inFlight = m_inFlight.find( key );
+		if ( inFlight != m_inFlight.end() )
+			// Already being loaded by a worker, waiting on that result
+		{
+			inFlight->second.push_back( { owner, std::move( finalize ) } );
+			return;
+		}
+
+		m_inFlight[key].push_back( { owner, std::move( finalize ) } );
+	}
+
+	auto job = [this, key, load]()
+	{
+		std::shared_ptr<void> data;
+		try
+		{
+			data = load();
+		}
+		catch ( const std::exception& e )
+		{
+			DEBUG_LOG( LOG::ERRORLOG, "Failed to load asset: " + key + " Error: " + e.what() );
+			CONSOLE_LOG( LOG::ERRORLOG, "Failed to load asset: " + key + " Error: " + e.what() );
+		}
+
+		std::lock_guard<std::mutex> lock( m_mutex );
+		std::vector<Waiter> waiters = std::move( m_inFlight[key] );
+		m_inFlight.erase( key );
+
+		if ( data )
+			// Failed loads leave every waiting owner with its placeholder
+		{
+			m_loaded[key] = data;
+			for ( Waiter& waiter : waiters )
+			{
+				m_ready.push_back( { data, std::move( waiter ) } );
+			}
+		}
+		m_assetReady.notify_all();
+	};
+
+	ThreadPool* threadPool = Engine::Get()->GetThreadPool();
+	if ( threadPool )
+	{
+		threadPool->Submit( job );
+	}
+	else
+		// No workers to hand the load to, the engine has not been initialized
+	{
+		job();
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class IMesh;
+class Texture2D;
+
+// Singleton that parses and decodes assets on the engine's worker threads, then hands them to the render thread
+// Assets requested more than once while loading, or while still alive, are only loaded once
+class AssetLoader
+{
+
+	AssetLoader( const AssetLoader& ) = delete;
+	AssetLoader& operator=( const AssetLoader& ) = delete;
+	AssetLoader( AssetLoader&& ) = delete;
+	AssetLoader& operator=( AssetLoader&& ) = delete;
+
+public:
+
+	// Get Instance of Asset Loader
+	static AssetLoader* Get();
+
+	// Queues the passed mesh's OBJ to be loaded on a worker thread, the mesh draws nothing until it is finalized
+	void LoadMesh( IMesh* mesh, const std::string& fileName );
+
+	// Queues the passed texture's image to be decoded on a worker thread, the texture keeps its placeholder until it is finalized
+	void LoadTexture( Texture2D* texture, const std::string& fileName );
+
+	// Drops every queued load for the passed mesh or texture, must be called before it is destroyed
+	void Cancel( const void* owner );
+
+	// Finalizes loaded assets, creating their GPU resources, until the passed budget is spent. Render thread only
+	void ProcessUploads( const float budgetMilliseconds );
+
+	// Blocks until every queued asset has been loaded and finalized. Render thread only
+	void Flush();
+
+	// Returns the number of assets still loading or waiting to be finalized
+	size_t GetPendingCount();
+
+private:
+
+	using LoadFunction = std::function<std::shared_ptr<void>()>;
+	using FinalizeFunction = std::function<void( const std::shared_ptr<void>& )>;
+
+	struct Waiter
+	{
+		const void*			owner;
+		FinalizeFunction	finalize;
+	};
+
+	struct ReadyAsset
+	{
+		std::shared_ptr<void>	data;
+		Waiter					waiter;
+	};
+
+	AssetLoader();
+	~AssetLoader();
+
+	static std::unique_ptr<AssetLoader> g_assetLoaderInstance;
+	friend std::default_delete<AssetLoader>;
+
+	std::mutex													m_mutex;
+	std::condition_variable										m_assetReady;
+	std::unordered_map<std::string, std::vector<Waiter>>		m_inFlight;
+	std::unordered_map<std::string, std::weak_ptr<void>>		m_loaded;
+	std::deque<ReadyAsset>										m_ready;
+
+	// Loads the asset with the passed key once, every owner waiting on it is finalized with the same data
+	void Load( const std::string& key, const void* owner, LoadFunction load, FinalizeFunction finalize );
+
+};
+
+#endif // !ASSETLOADER_H
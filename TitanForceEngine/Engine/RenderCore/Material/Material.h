@@ -3,17 +3,28 @@
 
 #include <glm.hpp>
 
+#include <cstdint>
+#include <string>
+
 
 struct Material
 {
-	const char*		name;
+	std::string		name;
 	float			shininess;
 	float			transparency;
 	glm::vec3		ambience;
 	glm::vec3		diffuse;
 	glm::vec3		specular;
+
+	// Texture maps, as file names inside of the texture folder, empty when the material has none
+	std::string		ambientMap;
+	std::string		diffuseMap;
+	std::string		specularMap;
+	std::string		bumpMap;
+
+	// Entry of the material in MaterialTable and in the GPU's material buffer
+	uint32_t		index;
 };
 
 
 #endif // !MATERIAL_H
-
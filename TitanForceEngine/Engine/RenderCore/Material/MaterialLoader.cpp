@@ -1,7 +1,160 @@
 #include "MaterialLoader.h"
+#include "MaterialTable.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	glm::vec3 ReadColour( std::istringstream& line )
+	{
+		glm::vec3 colour( 0.0f, 0.0f, 0.0f );
+		line >> colour.x >> colour.y >> colour.z;
+		return colour;
+	}
+
+	// Texture maps may carry options before the file name and a path relative to the MTL file,
+	// only the name itself is kept as textures are always loaded from the texture folder
+	std::string ReadMap( std::istringstream& line )
+	{
+		std::string token, fileName;
+		while ( line >> token )
+		{
+			fileName = token;
+		}
+
+		const size_t separator = fileName.find_last_of( "/\\" );
+		return separator == std::string::npos ? fileName : fileName.substr( separator + 1 );
+	}
+}
 
 // Loads Material from the passed material file name, if the file does not exist or is unreadable, this function returns null
-Material* MaterialLoader::LoadMaterial( const std::string & materialFileName )
+// The first material of the MTL file is used, it is owned by MaterialTable and shared with every other user of the same values
+const Material* MaterialLoader::LoadMaterial( const std::string & materialFileName )
 {
-    return nullptr;
+	const std::vector<const Material*> materials = LoadMaterials( materialFileName );
+	return materials.empty() ? nullptr : materials.front();
+}
+
+// Loads every material of the passed MTL file, in the order the file declares them, empty if it cannot be read
+// They are owned by MaterialTable and shared with every other user of the same values
+std::vector<const Material*> MaterialLoader::LoadMaterials( const std::string& materialFileName )
+{
+	if ( materialFileName.empty() )
+	{
+		return {};
+	}
+
+	MaterialTable* table = MaterialTable::Get();
+	if ( const std::vector<const Material*>* loaded = table->FindFile( materialFileName ) )
+	{
+		return *loaded;
+	}
+
+	std::vector<Material> materials;
+	if ( !ParseMtl( GetSourceFilePath( materialFileName ), materials ) || materials.empty() )
+	{
+		return {};
+	}
+
+	std::vector<const Material*> stored;
+	stored.reserve( materials.size() );
+	for ( const Material& material : materials )
+	{
+		stored.push_back( table->Add( material ) );
+	}
+
+	table->AddFile( materialFileName, stored );
+	return stored;
+}
+
+std::string MaterialLoader::GetSourceFilePath( const std::string& fileName )
+{
+	return "./Resources/Models/" + fileName;
+}
+
+// Parses every newmtl block of the MTL file at the passed path, returns false if it cannot be opened
+bool MaterialLoader::ParseMtl( const std::string& relativeFilePath, std::vector<Material>& materials )
+{
+	std::ifstream file( relativeFilePath );
+	if ( !file.is_open() )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot open MTL file: " + relativeFilePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot open MTL file: " + relativeFilePath );
+		return false;
+	}
+
+	std::string text;
+	while ( std::getline( file, text ) )
+	{
+		std::istringstream line( text );
+		std::string keyword;
+		if ( !( line >> keyword ) || keyword[0] == '#' )
+		{
+			continue;
+		}
+
+		if ( keyword == "newmtl" )
+		{
+			// Values a material does not set keep the default material's
+			Material material = *MaterialTable::Get()->GetDefault();
+			line >> material.name;
+			materials.push_back( material );
+			continue;
+		}
+
+		if ( materials.empty() )
+			// Statements before the first newmtl have no material to apply to
+		{
+			continue;
+		}
+
+		Material& material = materials.back();
+		if ( keyword == "Ns" )
+		{
+			line >> material.shininess;
+		}
+		else if ( keyword == "d" )
+		{
+			float dissolve = 1.0f;
+			line >> dissolve;
+			material.transparency = 1.0f - dissolve;
+		}
+		else if ( keyword == "Tr" )
+		{
+			line >> material.transparency;
+		}
+		else if ( keyword == "Ka" )
+		{
+			material.ambience = ReadColour( line );
+		}
+		else if ( keyword == "Kd" )
+		{
+			material.diffuse = ReadColour( line );
+		}
+		else if ( keyword == "Ks" )
+		{
+			material.specular = ReadColour( line );
+		}
+		else if ( keyword == "map_Ka" )
+		{
+			material.ambientMap = ReadMap( line );
+		}
+		else if ( keyword == "map_Kd" )
+		{
+			material.diffuseMap = ReadMap( line );
+		}
+		else if ( keyword == "map_Ks" )
+		{
+			material.specularMap = ReadMap( line );
+		}
+		else if ( keyword == "map_Bump" || keyword == "map_bump" || keyword == "bump" )
+		{
+			material.bumpMap = ReadMap( line );
+		}
+	}
+
+	return true;
 }
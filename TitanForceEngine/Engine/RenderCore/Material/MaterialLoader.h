@@ -4,6 +4,7 @@
 #include "Material.h"
 
 #include <string>
+#include <vector>
 
 class MaterialLoader
 {
@@ -17,9 +18,20 @@ class MaterialLoader
 public:
 
 	// Loads Material from the passed material file name, if the file does not exist or is unreadable, this function returns null
-	static Material* LoadMaterial( const std::string & materialFileName );
+	// The first material of the MTL file is used, it is owned by MaterialTable and shared with every other user of the same values
+	static const Material* LoadMaterial( const std::string & materialFileName );
+
+	// Loads every material of the passed MTL file, in the order the file declares them, empty if it cannot be read
+	// They are owned by MaterialTable and shared with every other user of the same values
+	static std::vector<const Material*> LoadMaterials( const std::string& materialFileName );
+
+private:
+
+	static std::string GetSourceFilePath( const std::string& fileName );
+
+	// Parses every newmtl block of the MTL file at the passed path, returns false if it cannot be opened
+	static bool ParseMtl( const std::string& relativeFilePath, std::vector<Material>& materials );
 
 };
 
 #endif // !MATERIALLOADER_H
-
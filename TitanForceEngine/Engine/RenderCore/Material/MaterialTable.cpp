@@ -0,0 +1,88 @@
+#include "MaterialTable.h"
+
+std::unique_ptr<MaterialTable> MaterialTable::g_materialTableInstance( nullptr );
+
+MaterialTable::MaterialTable() :
+	m_materials(),
+	m_files(),
+	m_version( 0 )
+{
+	// The grey the Phong shader always lit models with before materials were loaded
+	Material material;
+	material.name = "Default";
+	material.shininess = 14.0f;
+	material.transparency = 0.0f;
+	material.ambience = glm::vec3( 0.06f, 0.06f, 0.06f );
+	material.diffuse = glm::vec3( 0.6f, 0.6f, 0.6f );
+	material.specular = glm::vec3( 0.6f, 0.6f, 0.6f );
+	Add( material );
+}
+
+MaterialTable::~MaterialTable()
+{}
+
+// Get Instance of Material Table
+MaterialTable* MaterialTable::Get()
+{
+	if ( g_materialTableInstance == nullptr )
+	{
+		g_materialTableInstance.reset( new MaterialTable );
+	}
+	return g_materialTableInstance.get();
+}
+
+// Returns the stored material with the same values as the passed one, storing a copy first if there is none
+// Names are not compared, materials that only differ by name share an entry
+const Material* MaterialTable::Add( const Material& material )
+{
+	for ( const std::unique_ptr<Material>& stored : m_materials )
+	{
+		if ( IsSame( *stored, material ) )
+		{
+			return stored.get();
+		}
+	}
+
+	m_materials.push_back( std::make_unique<Material>( material ) );
+	m_materials.back()->index = static_cast<uint32_t>( m_materials.size() - 1 );
+	++m_version;
+
+	return m_materials.back().get();
+}
+
+// Returns the material a file was loaded into before, or null if it has not been loaded
+const std::vector<const Material*>* MaterialTable::FindFile( const std::string& fileName ) const
+{
+	auto file = m_files.find( fileName );
+	return file != m_files.end() ? &file->second : nullptr;
+}
+
+void MaterialTable::AddFile( const std::string& fileName, const std::vector<const Material*>& materials )
+{
+	m_files[fileName] = materials;
+}
+
+// Writes every material, in index order, into the passed array of GetCount() entries
+void MaterialTable::WriteUniforms( MaterialUniforms* uniforms ) const
+{
+	for ( size_t i = 0; i < m_materials.size(); ++i )
+	{
+		const Material& material = *m_materials[i];
+		uniforms[i].ambient = glm::vec4( material.ambience, 0.0f );
+		uniforms[i].diffuse = glm::vec4( material.diffuse, 1.0f - material.transparency );
+		uniforms[i].specular = glm::vec4( material.specular, material.shininess );
+	}
+}
+
+bool MaterialTable::IsSame( const Material& a, const Material& b )
+{
+	return a.shininess == b.shininess &&
+		a.transparency == b.transparency &&
+		a.ambience == b.ambience &&
+		a.diffuse == b.diffuse &&
+		a.specular == b.specular &&
+		a.ambientMap == b.ambientMap &&
+		a.diffuseMap == b.diffuseMap &&
+		a.specularMap == b.specularMap &&
+		a.bumpMap == b.bumpMap;
+}
@@ -0,0 +1,63 @@
+#ifndef MATERIALTABLE_H
+#define MATERIALTABLE_H
+
+#include "Material.h"
+#include "../Shader/UniformBlocks.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Singleton owning every material in use, each stored once however many models or files it is loaded by
+// Renderers keep the whole table in one GPU buffer and draws only carry their material's index into it,
+// so drawing with many different materials costs no more uniform updates than drawing with one
+class MaterialTable
+{
+
+	MaterialTable( const MaterialTable& ) = delete;
+	MaterialTable& operator=( const MaterialTable& ) = delete;
+	MaterialTable( MaterialTable&& ) = delete;
+	MaterialTable& operator=( MaterialTable&& ) = delete;
+
+public:
+
+	// Get Instance of Material Table
+	static MaterialTable* Get();
+
+	// Returns the stored material with the same values as the passed one, storing a copy first if there is none
+	// Names are not compared, materials that only differ by name share an entry
+	const Material* Add( const Material& material );
+
+	// Material used by models without one, always entry 0
+	const Material* GetDefault() const { return m_materials.front().get(); }
+
+	// Returns the materials a file was loaded into before, in file order, or null if it has not been loaded
+	const std::vector<const Material*>* FindFile( const std::string& fileName ) const;
+	void AddFile( const std::string& fileName, const std::vector<const Material*>& materials );
+
+	size_t GetCount() const { return m_materials.size(); }
+
+	// Changes whenever a material is added, so renderers know when their copy of the table is stale
+	uint64_t GetVersion() const { return m_version; }
+
+	// Writes every material, in index order, into the passed array of GetCount() entries
+	void WriteUniforms( MaterialUniforms* uniforms ) const;
+
+private:
+
+	MaterialTable();
+	~MaterialTable();
+
+	static std::unique_ptr<MaterialTable> g_materialTableInstance;
+	friend std::default_delete<MaterialTable>;
+
+	std::vector<std::unique_ptr<Material>>					m_materials;
+	std::unordered_map<std::string, std::vector<const Material*>>	m_files;
+	uint64_t												m_version;
+
+	static bool IsSame( const Material& a, const Material& b );
+
+};
+
+#endif // !MATERIALTABLE_H
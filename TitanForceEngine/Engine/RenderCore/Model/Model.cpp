@@ -1,16 +1,20 @@
 #include "Model.h"
 
 #include "../Material/MaterialLoader.h"
+#include "../Material/MaterialTable.h"
 
 #if GRAPHICS_API == GRAPHICS_OPENGL
 #include "../../Graphics/OpenGL/3D/OpenGLMesh.h"
 #include "../../Graphics/OpenGL/Texture/OpenGLTexture2D.h"
-#include <gtc/type_ptr.hpp>
+#include "../../Graphics/OpenGL/OpenGLStateCache.h"
 #elif GRAPHICS_API == GRAPHICS_VULKAN
 #include "../../Graphics/Vulkan/3D/VulkanMesh.h"
+#include "../../Graphics/Vulkan/Texture/VulkanTexture2D.h"
+#elif GRAPHICS_API == GRAPHICS_NULL
+#include "../../Graphics/Null/3D/NullMesh.h"
+#include "../../Graphics/Null/Texture/NullTexture2D.h"
 #endif
 
-#include "../Camera/Camera.h"
 
 Model::Model(
 	const char * objFileName,
@@ -20,25 +24,41 @@ Model::Model(
 	TransformComponent * transformComponent )
 {
 
+	m_materials = MaterialLoader::LoadMaterials( materialFileName ? materialFileName : "" );
+	m_material = m_materials.empty() ? MaterialTable::Get()->GetDefault() : m_materials.front();
+
+	// Without a texture of its own the model is drawn with its material's diffuse map
+	const std::string textureName = ( textureFileName && textureFileName[0] != '\0' ) ? textureFileName : m_material->diffuseMap;
+
 #if GRAPHICS_API == GRAPHICS_OPENGL
 
 	m_mesh = new OpenGLMesh( objFileName );
 
-	m_texture = new OpenGLTexture2D( textureFileName );
+	m_texture = new OpenGLTexture2D( textureName.c_str() );
 
 #elif GRAPHICS_API == GRAPHICS_VULKAN
 
 	m_mesh = new VulkanMesh( objFileName );
 
+	m_texture = new VulkanTexture2D( textureName.c_str() );
+
+#elif GRAPHICS_API == GRAPHICS_NULL
+
+	m_mesh = new NullMesh( objFileName );
+
+	m_texture = new NullTexture2D( textureName.c_str() );
+
 #else
 
 	m_mesh = nullptr;
 
+	m_texture = nullptr;
+
 #endif
 
-	m_material = MaterialLoader::LoadMaterial( materialFileName );
 	m_shaderLinker = shaderLinker;
 	m_transform = transformComponent;
+	m_lod = 0;
 
 }
 
@@ -50,28 +70,20 @@ bool Model::OnCreate()
 	return false;
 }
 
-void Model::Render( CameraComponent * camera )
+// Draws the model on its own, its frame uniforms and object data must already be bound by the renderer
+void Model::Render()
 {
 #if GRAPHICS_API == GRAPHICS_OPENGL
 
-	glUseProgram( m_shaderLinker->GetShaderProgramId() );
-
-	glm::mat4 transform = m_transform->GetTransform();
-
-	glUniformMatrix4fv( m_shaderLinker->GetUniformId( EShaderType::Vertex, "viewMatrix" ), 1, GL_FALSE, glm::value_ptr( camera->GetView() ) );
-	glUniformMatrix4fv( m_shaderLinker->GetUniformId( EShaderType::Vertex, "projectionMatrix" ), 1, GL_FALSE, glm::value_ptr( camera->GetPerspective() ) );
-	glUniformMatrix4fv( m_shaderLinker->GetUniformId( EShaderType::Vertex, "modelMatrix" ), 1, GL_FALSE, glm::value_ptr( transform ) );
-	
-	glm::mat3 normals = glm::transpose( glm::inverse( transform ) );
-	glUniformMatrix3fv( m_shaderLinker->GetUniformId( EShaderType::Vertex, "normalMatrix" ), 1, GL_FALSE, glm::value_ptr( normals ) );
-
-	glUniform3fv( m_shaderLinker->GetUniformId( EShaderType::Vertex, "lightPos" ), 1, glm::value_ptr( glm::vec3( 0.0f, 0.0f, 10.0f ) ) );
-
-	if ( m_material )
+	if ( !m_shaderLinker->IsReady() )
+		// Still compiling on the driver's threads
 	{
-		// Handle Material Uniforms
+		return;
 	}
 
+	// The material is read from the material buffer through the index in the model's object data
+	OpenGLStateCache::Get()->UseProgram( m_shaderLinker->GetShaderProgramId() );
+
 	if ( m_texture )
 	{
 		m_texture->Bind();
@@ -87,7 +99,11 @@ void Model::Render( CameraComponent * camera )
 
 #elif GRAPHICS_API == GRAPHICS_VULKAN
 
-	m_mesh = new VulkanMesh( objFileName );
+	// Draws are recorded into command buffers by VulkanRenderer, models are not drawn on their own
+
+#elif GRAPHICS_API == GRAPHICS_NULL
+
+	// Nothing is drawn, NullRenderer records the model's draw instead
 
 #else
 
@@ -104,11 +120,8 @@ void Model::OnDestroy()
 		delete m_mesh;
 		m_mesh = nullptr;
 	}
-	if ( m_material )
-	{
-		delete m_material;
-		m_material = nullptr;
-	}
+	// The material is owned by MaterialTable
+	m_material = nullptr;
 	if ( m_shaderLinker )
 	{
 		delete m_shaderLinker;
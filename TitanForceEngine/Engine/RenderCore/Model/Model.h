@@ -7,8 +7,10 @@
 #include "../Texture/Texture.h"
 #include "../../Components/TransformComponent.h"
 
+#include <cstdint>
+#include <vector>
+
 class IMesh;
-class CameraComponent;
 
 class Model
 {
@@ -25,7 +27,31 @@ public:
 	~Model();
 
 	bool OnCreate();
-	void Render( CameraComponent* camera );
+
+	// Draws the model on its own, its frame uniforms and object data must already be bound by the renderer
+	void Render();
+
+	TransformComponent* GetTransform() const { return m_transform; }
+
+	// Used by renderers that batch the draws of many models together instead of calling Render
+	IMesh* GetMesh() const { return m_mesh; }
+	ShaderLinker* GetShaderLinker() const { return m_shaderLinker; }
+	ITexture* GetTexture() const { return m_texture; }
+
+	// Never null, models without a material file use MaterialTable's default material
+	const Material* GetMaterial() const { return m_material; }
+
+	// Material of a MeshRange, looked up by the index of the OBJ material its faces use
+	// The model's MTL file is expected to be the one the OBJ uses, declaring its materials in the same order
+	// Ranges without a material, or with one the file does not declare, use GetMaterial
+	const Material* GetRangeMaterial( const uint32_t materialIndex ) const
+	{
+		return materialIndex < m_materials.size() ? m_materials[materialIndex] : m_material;
+	}
+
+	// Level of detail the model was last drawn with, renderers keep it so LOD changes can lag behind distance changes
+	uint32_t GetLod() const { return m_lod; }
+	void SetLod( const uint32_t lod ) { m_lod = lod; }
 
 private:
 
@@ -33,10 +59,12 @@ private:
 	// Replace a single mesh reference with a dynamic array of meshes
 	// OBJLoader Will need to support loading multiple meshes
 	IMesh*				m_mesh;	
-	Material*			m_material;
+	const Material*		m_material;	// Owned by MaterialTable
+	std::vector<const Material*>	m_materials;	// Every material of the model's MTL file, in file order
 	ShaderLinker*		m_shaderLinker;
 	ITexture*			m_texture;
 	TransformComponent*	m_transform;
+	uint32_t			m_lod;
 
 	void OnDestroy();
 
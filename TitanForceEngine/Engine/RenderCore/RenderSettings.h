@@ -0,0 +1,20 @@
+#ifndef RENDERSETTINGS_H
+#define RENDERSETTINGS_H
+
+// Renderer options, read by the renderer every frame so they can be changed while the app runs, see Engine::SetRenderSettings
+struct RenderSettings
+{
+	bool	depthPrepass;	// Lays down depth before shading, so hidden fragments are rejected instead of shaded
+
+	// Draws the scene at a fraction of the window's size and upscales it, giving resolution up to hold the target
+	// frame rate, see ResolutionController. The scale stays between the two limits, which apply to width and height
+	// Always off in headless runs, whose frame dumps and frame times have to come from a fixed resolution
+	bool	dynamicResolution;
+	float	minResolutionScale;
+	float	maxResolutionScale;
+
+	// Smallest scale either limit can be set to, see Engine::SetRenderSettings
+	static constexpr float m_lowestResolutionScale = 0.1f;
+};
+
+#endif // !RENDERSETTINGS_H
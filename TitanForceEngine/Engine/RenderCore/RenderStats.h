@@ -0,0 +1,48 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <cstdint>
+
+// Passes every frame is split into, each one timed on the CPU and on the GPU
+enum class ERenderPass
+{
+	Clear,
+	DepthPrepass,	// Skipped by renderers without one and while RenderSettings turns it off
+	Opaque,
+	Present,
+	TOTAL
+};
+
+// Names of the ERenderPass passes, in the same order as the enum
+constexpr const char* g_renderPassNames[static_cast<int>( ERenderPass::TOTAL )] =
+{
+	"Clear",
+	"DepthPrepass",
+	"Opaque",
+	"Present"
+};
+
+// Counters and timings of a single frame, see IRenderer::GetStats
+// A frame whose GPU time is well above its CPU time is GPU bound, and the other way around
+struct RenderStats
+{
+	uint64_t	frameIndex;
+	uint32_t	drawCalls;			// A multi draw counts as a single call
+	uint64_t	triangles;
+	uint32_t	programBinds;
+	uint32_t	textureBinds;
+	uint32_t	vertexArrayBinds;
+	uint32_t	uniformUploads;		// Uniforms set and uniform or storage block ranges bound
+	uint64_t	uploadedBytes;		// Streamed per frame data, material tables and asset uploads
+	float		resolutionScale;	// Of the window's width and height the frame was drawn at
+
+	float		cpuFrameMilliseconds;	// Of the whole frame, culling and draw preparation included
+	float		cpuMilliseconds[static_cast<int>( ERenderPass::TOTAL )];
+
+	// GPU timings are read back a few frames late so they never stall, these belong to frame gpuFrameIndex
+	// and are negative until the first results have come back
+	uint64_t	gpuFrameIndex;
+	float		gpuMilliseconds[static_cast<int>( ERenderPass::TOTAL )];
+};
+
+#endif // !RENDERSTATS_H
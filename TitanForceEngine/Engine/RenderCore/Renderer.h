@@ -2,6 +2,9 @@
 #define RENDERER_H
 
 #include "../AppCore/Scene.h"
+#include "RenderStats.h"
+
+#include <string>
 
 class Window;
 class IScene;
@@ -16,7 +19,8 @@ public:
 
 	IRenderer() :
 		m_window( nullptr ),
-		m_camera( nullptr )
+		m_camera( nullptr ),
+		m_stats()
 	{}
 
 	virtual ~IRenderer() {}
@@ -32,10 +36,20 @@ public:
 
 	virtual void RenderScene( IScene* scene ) = 0;
 
+	// Writes the last finished frame to the passed path as a binary PPM, returns false if the renderer cannot read it back
+	virtual bool SaveFrame( const std::string& filePath ) = 0;
+
+	// Counters and timings of the last frame RenderScene finished, with the GPU timings of an earlier one
+	const RenderStats& GetStats() const { return m_stats; }
+
+	// Returns true while assets the AssetLoader finalized are still being copied to the GPU
+	virtual bool HasPendingUploads() = 0;
+
 protected:
 
 	Window*				m_window;
 	CameraComponent*	m_camera;
+	RenderStats			m_stats;
 
 	virtual void BeginScene( IScene* scene ) = 0;
 	virtual void EndScene() = 0;
@@ -47,8 +61,8 @@ protected:
 	virtual void SubmitModel( Model* model ) = 0;
 
 
-	// TODO:
-	// Replace this model array with a queue of commands, these command will be created inside of the BeginScene functionality
+	// Models submitted during BeginScene, turned into draws once culled
+	// OpenGLRenderer records them into command lists on the worker threads, see DrawRecorder
 	std::vector<Model*> m_models;
 };
 
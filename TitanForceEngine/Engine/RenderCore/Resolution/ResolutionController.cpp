@@ -0,0 +1,83 @@
+#include "ResolutionController.h"
+
+#include "../RenderSettings.h"
+#include "../RenderStats.h"
+
+#include <algorithm>
+#include <cmath>
+
+ResolutionController::ResolutionController() :
+	m_scale( 1.0f ),
+	m_history(),
+	m_measuredFrameIndex( 0 ),
+	m_hasMeasured( false )
+{}
+
+ResolutionController::~ResolutionController()
+{}
+
+// Remembers the scale the finished frame was drawn at and moves the scale towards what its measured times afford
+// targetMilliseconds is the frame time the engine paces itself to, see EngineClock::SetFPS
+void ResolutionController::Update( const RenderStats& stats, const RenderSettings& settings, const float targetMilliseconds )
+{
+	m_history[stats.frameIndex % m_historySize] = FrameScale{ stats.frameIndex, stats.resolutionScale };
+
+	if ( !settings.dynamicResolution )
+	{
+		m_scale = 1.0f;
+		return;
+	}
+
+	const float maxScale = settings.maxResolutionScale;
+	const float minScale = std::min( settings.minResolutionScale, maxScale );
+
+	// GPU times are negative until the first results have come back
+	float gpuMilliseconds = 0.0f;
+	bool hasGpuTimes = true;
+	for ( const float milliseconds : stats.gpuMilliseconds )
+	{
+		hasGpuTimes = hasGpuTimes && milliseconds >= 0.0f;
+		gpuMilliseconds += milliseconds;
+	}
+
+	float measuredScale = 0.0f;
+	const bool isMeasured = m_hasMeasured && stats.gpuFrameIndex <= m_measuredFrameIndex;
+	if ( hasGpuTimes && !isMeasured && FindScale( stats.gpuFrameIndex, measuredScale ) && targetMilliseconds > 0.0f )
+	{
+		m_measuredFrameIndex = stats.gpuFrameIndex;
+		m_hasMeasured = true;
+
+		const float budget = targetMilliseconds * m_budgetFraction;
+		const float affordableScale = measuredScale * std::sqrt( budget / std::max( gpuMilliseconds, 0.001f ) );
+
+		if ( affordableScale < m_scale )
+		{
+			m_scale = affordableScale;
+		}
+		else if ( stats.cpuFrameMilliseconds <= budget )
+		{
+			m_scale = std::min( affordableScale, m_scale + m_maxRaiseStep );
+		}
+	}
+
+	m_scale = std::max( minScale, std::min( m_scale, maxScale ) );
+}
+
+// Returns the passed size scaled by GetScale, at least one pixel
+int ResolutionController::GetScaledSize( const int size ) const
+{
+	return std::max( 1, static_cast<int>( static_cast<float>( size ) * m_scale + 0.5f ) );
+}
+
+// Returns true and sets the scale the passed frame was drawn at if it is still remembered
+bool ResolutionController::FindScale( const uint64_t frameIndex, float& scale ) const
+{
+	const FrameScale& frame = m_history[frameIndex % m_historySize];
+	if ( frame.frameIndex != frameIndex || frame.scale <= 0.0f )
+	{
+		return false;
+	}
+
+	scale = frame.scale;
+	return true;
+}
@@ -0,0 +1,67 @@
+#ifndef RESOLUTIONCONTROLLER_H
+#define RESOLUTIONCONTROLLER_H
+
+#include <cstdint>
+
+struct RenderSettings;
+struct RenderStats;
+
+// Picks the fraction of the window's width and height the next frame is drawn at, from measured frame times
+// Pixel cost grows with the square of the scale, so the scale a frame could have afforded is its own scale times the
+// square root of the budget over its GPU time. Drops are taken at once so load spikes cost resolution instead of frames,
+// rises are limited to m_maxRaiseStep per measurement so the scale does not oscillate
+// A frame whose CPU time is over budget misses the target at any resolution, so the scale is not raised while it is
+class ResolutionController
+{
+
+	ResolutionController( const ResolutionController& ) = delete;
+	ResolutionController& operator=( const ResolutionController& ) = delete;
+	ResolutionController( ResolutionController&& ) = delete;
+	ResolutionController& operator=( ResolutionController&& ) = delete;
+
+public:
+
+	// Fraction of the target frame time frames are fitted into, the rest absorbs noise between measurements
+	static constexpr float m_budgetFraction = 0.9f;
+
+	// Largest rise of the scale per measured frame
+	static constexpr float m_maxRaiseStep = 0.05f;
+
+	// Frames whose scale is remembered, GPU times come back this many frames late at most
+	static constexpr uint32_t m_historySize = 8;
+
+	ResolutionController();
+	~ResolutionController();
+
+	// Remembers the scale the finished frame was drawn at and moves the scale towards what its measured times afford
+	// targetMilliseconds is the frame time the engine paces itself to, see EngineClock::SetFPS
+	void Update( const RenderStats& stats, const RenderSettings& settings, const float targetMilliseconds );
+
+	// Scale the next frame is drawn at, 1 while dynamic resolution is turned off
+	float GetScale() const { return m_scale; }
+
+	// Returns the passed size scaled by GetScale, at least one pixel
+	int GetScaledSize( const int size ) const;
+
+private:
+
+	struct FrameScale
+	{
+		uint64_t	frameIndex;
+		float		scale;
+	};
+
+	float			m_scale;
+
+	FrameScale		m_history[m_historySize];
+
+	// GPU times of a frame are reported until the next frame's come back, each frame is only measured once
+	uint64_t		m_measuredFrameIndex;
+	bool			m_hasMeasured;
+
+	// Returns true and sets the scale the passed frame was drawn at if it is still remembered
+	bool FindScale( const uint64_t frameIndex, float& scale ) const;
+
+};
+
+#endif // !RESOLUTIONCONTROLLER_H
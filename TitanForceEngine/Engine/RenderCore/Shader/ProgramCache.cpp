@@ -0,0 +1,179 @@
+#include "ProgramCache.h"
+
+#include "../../Graphics/Graphics.h"
+
+#if GRAPHICS_API == GRAPHICS_OPENGL
+#include <glad/glad.h>
+#endif
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// FNV-1a hash of the passed bytes, pass the previous result as hash to combine several hashes
+uint64_t ProgramCache::Hash( const void* data, const size_t size, const uint64_t hash )
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>( data );
+	uint64_t result = hash;
+	for ( size_t i = 0; i < size; ++i )
+	{
+		result = ( result ^ bytes[i] ) * 1099511628211ull;
+	}
+	return result;
+}
+
+std::string ProgramCache::GetCacheFilePath( const std::string& programName )
+{
+	return "./Resources/Shaders/Cache/" + programName + ".tprg";
+}
+
+#if GRAPHICS_API == GRAPHICS_OPENGL
+
+// Returns true if the driver can return program binaries at all
+bool ProgramCache::IsSupported()
+{
+	GLint formatCount = 0;
+	glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount );
+	return formatCount > 0;
+}
+
+// Loads the cached binary of the named program into the passed program object
+// Returns false if there is no entry for the passed source hash and this driver, or the driver rejects it
+bool ProgramCache::Load( const std::string& programName, const uint64_t sourceHash, const unsigned int program )
+{
+	if ( !IsSupported() )
+	{
+		return false;
+	}
+
+	const std::string filePath = GetCacheFilePath( programName );
+	std::ifstream file( filePath, std::ios::binary );
+	if ( !file.is_open() )
+	{
+		return false;
+	}
+
+	Header header = {};
+	file.read( reinterpret_cast<char*>( &header ), sizeof( Header ) );
+	if ( !file ||
+		header.magic != m_magic ||
+		header.version != m_version ||
+		header.key != MakeKey( sourceHash ) ||
+		header.binarySize == 0 )
+		// Edited shaders and driver updates both land here, the program is linked from source and the entry replaced
+	{
+		return false;
+	}
+
+	std::vector<char> binary( header.binarySize );
+	file.read( binary.data(), static_cast<std::streamsize>( binary.size() ) );
+	if ( !file )
+	{
+		DEBUG_LOG( LOG::WARNING, "Program binary cache entry is truncated: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Program binary cache entry is truncated: " + filePath );
+		return false;
+	}
+
+	glProgramBinary( program, header.binaryFormat, binary.data(), static_cast<GLsizei>( binary.size() ) );
+
+	// Drivers may still reject a binary they created, for example after a change they do not report in their version
+	GLint linkResult = 0;
+	glGetProgramiv( program, GL_LINK_STATUS, &linkResult );
+	if ( !linkResult )
+	{
+		DEBUG_LOG( LOG::WARNING, "Driver rejected cached program binary: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Driver rejected cached program binary: " + filePath );
+		return false;
+	}
+
+	return true;
+}
+
+// Writes the binary of the passed linked program, replacing the named program's previous entry
+void ProgramCache::Save( const std::string& programName, const uint64_t sourceHash, const unsigned int program )
+{
+	if ( !IsSupported() )
+	{
+		return;
+	}
+
+	GLint binarySize = 0;
+	glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &binarySize );
+	if ( binarySize <= 0 )
+	{
+		return;
+	}
+
+	std::vector<char> binary( static_cast<size_t>( binarySize ) );
+	GLenum binaryFormat = 0;
+	GLsizei writtenSize = 0;
+	glGetProgramBinary( program, binarySize, &writtenSize, &binaryFormat, binary.data() );
+	if ( writtenSize <= 0 )
+	{
+		return;
+	}
+
+	const std::string filePath = GetCacheFilePath( programName );
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( filePath ).parent_path(), error );
+
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Cannot write program binary cache entry: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Cannot write program binary cache entry: " + filePath );
+		return;
+	}
+
+	Header header = {};
+	header.magic = m_magic;
+	header.version = m_version;
+	header.key = MakeKey( sourceHash );
+	header.binaryFormat = static_cast<uint32_t>( binaryFormat );
+	header.binarySize = static_cast<uint32_t>( writtenSize );
+
+	file.write( reinterpret_cast<const char*>( &header ), sizeof( Header ) );
+	file.write( binary.data(), writtenSize );
+}
+
+// Combines the source hash with the driver's identity, binaries are only valid on the driver that created them
+uint64_t ProgramCache::MakeKey( const uint64_t sourceHash )
+{
+	uint64_t key = Hash( &sourceHash, sizeof( sourceHash ) );
+
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for ( const GLenum name : driverStrings )
+	{
+		const char* value = reinterpret_cast<const char*>( glGetString( name ) );
+		if ( value )
+		{
+			key = Hash( value, std::char_traits<char>::length( value ), key );
+		}
+	}
+
+	return key;
+}
+
+#elif GRAPHICS_API == GRAPHICS_VULKAN || GRAPHICS_API == GRAPHICS_NULL
+
+bool ProgramCache::IsSupported()
+{
+	return false;
+}
+
+bool ProgramCache::Load( const std::string& programName, const uint64_t sourceHash, const unsigned int program )
+{
+	return false;
+}
+
+void ProgramCache::Save( const std::string& programName, const uint64_t sourceHash, const unsigned int program )
+{}
+
+uint64_t ProgramCache::MakeKey( const uint64_t sourceHash )
+{
+	return sourceHash;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On disk cache of linked program binaries, so warm starts skip compiling and linking shaders entirely
+//
+// [Header][driver program binary]
+// Entries are keyed by a hash of every stage's source and the driver's vendor, renderer and version, a driver update
+// or edited shader misses the cache and the program is linked from source again
+class ProgramCache
+{
+
+	ProgramCache() = delete;	// Static class, no constructor needed
+	ProgramCache( const ProgramCache& ) = delete;
+	ProgramCache& operator=( const ProgramCache& ) = delete;
+	ProgramCache( ProgramCache&& ) = delete;
+	ProgramCache& operator=( ProgramCache&& ) = delete;
+
+public:
+
+	static constexpr uint32_t m_magic = 0x47525054;	// "TPRG"
+	static constexpr uint32_t m_version = 1;
+
+	struct Header
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint64_t	key;
+		uint32_t	binaryFormat;
+		uint32_t	binarySize;
+	};
+
+	// FNV-1a hash of the passed bytes, pass the previous result as hash to combine several hashes
+	static uint64_t Hash( const void* data, const size_t size, const uint64_t hash = 14695981039346656037ull );
+
+	// Returns true if the driver can return program binaries at all
+	static bool IsSupported();
+
+	// Loads the cached binary of the named program into the passed program object
+	// Returns false if there is no entry for the passed source hash and this driver, or the driver rejects it
+	static bool Load( const std::string& programName, const uint64_t sourceHash, const unsigned int program );
+
+	// Writes the binary of the passed linked program, replacing the named program's previous entry
+	static void Save( const std::string& programName, const uint64_t sourceHash, const unsigned int program );
+
+private:
+
+	// Combines the source hash with the driver's identity, binaries are only valid on the driver that created them
+	static uint64_t MakeKey( const uint64_t sourceHash );
+
+	static std::string GetCacheFilePath( const std::string& programName );
+
+};
+
+#endif // !PROGRAMCACHE_H
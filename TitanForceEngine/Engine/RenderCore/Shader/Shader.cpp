@@ -2,9 +2,9 @@
 
 #include "../../Graphics/Graphics.h"
 
-#if GARPHICS_API == GRAPHICS_OPENGL
+#if GRAPHICS_API == GRAPHICS_OPENGL
 #include <glad/glad.h>
-#elif GARPHICS_API == GRAPHICS_VULKAN
+#elif GRAPHICS_API == GRAPHICS_VULKAN
 
 #endif
 
@@ -16,30 +16,27 @@
 
 Shader::Shader( const EShaderType & shaderType, const std::string& fileName ) :
 	m_type( shaderType ),
+	m_id( 0 ),
 	m_fileName( fileName )
 {
+	// Compiling is left to the linker, programs loaded from the binary cache never need it
 	m_shaderSource = ReadShaderFromFile( m_fileName );
-	m_id = CompileShader();
 }
 
 Shader::~Shader()
 {}
 
-// Returns the location id for this shader
-unsigned int Shader::GetShaderId() const
+// Submits the source to the driver, which may compile it on its own threads. Returns the new shader object's id
+unsigned int Shader::Compile()
 {
+	m_id = CompileShader();
 	return m_id;
 }
 
-unsigned int Shader::GetUniformId( const std::string& uniformName )
+// Returns the location id for this shader, 0 until it has been compiled
+unsigned int Shader::GetShaderId() const
 {
-	// TODO:
-		// Make this faster than a map look up in this method
-	if ( m_uniformMap.find( uniformName ) != m_uniformMap.end() )
-	{
-		return m_uniformMap[uniformName];
-	}
-	return 0;
+	return m_id;
 }
 
 const std::string & Shader::GetFileName() const
@@ -76,7 +73,7 @@ std::string Shader::ReadShaderFromFile( const std::string& fileName )
 	return shaderCode;
 }
 
-#if GARPHICS_API == GRAPHICS_OPENGL
+#if GRAPHICS_API == GRAPHICS_OPENGL
 
 unsigned int Shader::CompileShader()
 {
@@ -104,7 +101,6 @@ unsigned int Shader::CompileShader()
 		break;
 	}
 
-	GLint compileResult = 0;
 	GLuint shader = glCreateShader( shaderType );
 	const char* shaderCodePtr = m_shaderSource.c_str();
 	const int shaderCodeSize = m_shaderSource.size();
@@ -112,69 +108,47 @@ unsigned int Shader::CompileShader()
 	glShaderSource( shader, 1, &shaderCodePtr, &shaderCodeSize );
 	glCompileShader( shader );
 
+	// The status is not queried here, doing so would wait for the driver to finish compiling
+	return shader;
+}
+
+// Returns true if the shader compiled, logging the driver's errors otherwise. Waits for compilation to finish
+bool Shader::CheckCompileStatus() const
+{
+	if ( m_id == 0 )
+	{
+		return false;
+	}
 
-	glGetShaderiv( shader, GL_COMPILE_STATUS, &compileResult );
+	GLint compileResult = 0;
+	glGetShaderiv( m_id, GL_COMPILE_STATUS, &compileResult );
 
 	if ( !compileResult )
 	{
 		GLint infoLogLength = 0;
-		glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &infoLogLength );
-		std::vector<char> shaderLog( infoLogLength );
-		glGetShaderInfoLog( shader, infoLogLength, NULL, &shaderLog[0] );
-		std::string shaderString( shaderLog.begin(), shaderLog.end() );
+		glGetShaderiv( m_id, GL_INFO_LOG_LENGTH, &infoLogLength );
+		std::vector<char> shaderLog( infoLogLength + 1 );
+		glGetShaderInfoLog( m_id, infoLogLength, NULL, &shaderLog[0] );
+		std::string shaderString( shaderLog.data() );
 		DEBUG_LOG( LOG::ERRORLOG, "Error Compiling shader " + m_fileName + " Error: \n" + shaderString );
 		CONSOLE_LOG( LOG::ERRORLOG, "Error Compiling shader " + m_fileName + " Error: \n" + shaderString );
-		return 0;
+		return false;
 	}
 
-	return shader;
+	return true;
 }
 
-void Shader::SetUpUniformLocations( unsigned int programId )
-{
-	int count;
-	GLsizei actualLen;
-	GLint size;
-	GLenum type;
-	char *name;
-	int maxUniformListLength;
-	unsigned int loc;
-
-	glGetProgramiv( programId, GL_ACTIVE_UNIFORMS, &count );
-	DEBUG_LOG( LOG::INFO, "Shader: " + m_fileName +  " Active Uniform Count: " + std::to_string( count ) );
-	CONSOLE_LOG( LOG::INFO, "Shader: " + m_fileName + " Active Uniform Count: " + std::to_string( count ) );
-
-	/// get the length of the longest named uniform 
-	glGetProgramiv( programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformListLength );
-
-	/// Create a little buffer to hold the uniform's name - old C memory call just for fun 
-	name = (char *)malloc( sizeof( char ) * maxUniformListLength );
-
-
-	for ( int i = 0; i < count; ++i )
-	{
-		/// Get the name of the ith uniform
-		glGetActiveUniform( programId, i, maxUniformListLength, &actualLen, &size, &type, name );
-		/// Get the (unsigned int) loc for this uniform
-		loc = glGetUniformLocation( programId, name );
-		std::string uniformName = name;
-		m_uniformMap[uniformName] = loc;
-
-		DEBUG_LOG( LOG::INFO, "Uniform: " + uniformName + " \t\t Location: " + std::to_string( m_uniformMap[uniformName] ) );
-		CONSOLE_LOG( LOG::INFO, "Uniform: " + uniformName + " \t\t Location: " + std::to_string( m_uniformMap[uniformName] ) );
-	}
-	free( name );
-}
-
-#elif GARPHICS_API == GRAPHICS_VULKAN
+#elif GRAPHICS_API == GRAPHICS_VULKAN || GRAPHICS_API == GRAPHICS_NULL
 
 unsigned int Shader::CompileShader()
 {
 	return 0;
 }
 
-void Shader::SetUpUniformLocations( unsigned int programId )
-{}
+bool Shader::CheckCompileStatus() const
+{
+	return false;
+}
 
 #endif
 
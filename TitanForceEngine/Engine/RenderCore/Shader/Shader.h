@@ -1,7 +1,6 @@
 #ifndef SHADER_H
 #define SHADER_H
 
-#include <map>
 #include <string>
 
 enum class EShaderType
@@ -15,8 +14,6 @@ enum class EShaderType
 
 class Shader
 {
-	using UniformMap = std::map<std::string, unsigned int>;
-
 	Shader( const Shader& ) = delete;
 	Shader& operator=( const Shader& ) = delete;
 	Shader( Shader&& ) = delete;
@@ -24,32 +21,35 @@ class Shader
 
 public:
 
+	// Reads the shader's source, it is only compiled once a linker needs it, see Compile
 	Shader(const EShaderType& shaderType, const std::string& fileName);
 	~Shader();
 
-	// Returns the location id for this shader
+	// Submits the source to the driver, which may compile it on its own threads. Returns the new shader object's id
+	unsigned int Compile();
+
+	// Returns true if the shader compiled, logging the driver's errors otherwise. Waits for compilation to finish
+	bool CheckCompileStatus() const;
+
+	// Returns the location id for this shader, 0 until it has been compiled
 	unsigned int GetShaderId() const;
 
-	// Returns the location id for the passed uniform name on this shader
-	unsigned int GetUniformId( const std::string& uniformName );
+	const std::string& GetSource() const { return m_shaderSource; }
 
 	const std::string& GetFileName() const;
 
 	const EShaderType& GetType() const;
 
-	void SetUpUniformLocations( unsigned int programId );
-
 private:
 
 	EShaderType		m_type;
 	unsigned int	m_id;
-	UniformMap		m_uniformMap;
 	std::string		m_fileName;
 	std::string		m_shaderSource;
 
 	std::string ReadShaderFromFile( const std::string& fileName );
 	unsigned int CompileShader();
-	
+
 
 };
 
@@ -1,10 +1,16 @@
 #include "ShaderLinker.h"
+#include "ProgramCache.h"
 
 #include "../../Graphics/Graphics.h"
 
 #if GRAPHICS_API == GRAPHICS_OPENGL
 #include <glad/glad.h>
-#elif GRAPHICS_API == GRAPHICS_VULKAN
+
+#include "../../Graphics/OpenGL/OpenGLStateCache.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 #endif
 
@@ -12,14 +18,24 @@
 
 #include <vector>
 
+bool ShaderLinker::m_parallelCompileSupported = false;
+
 ShaderLinker::ShaderLinker( const std::string& shaderName ) :
 	m_name( shaderName ),
 	m_id( 0 ),
-	m_shaderChain()
-{}
+	m_shaderChain(),
+	m_uniformTable(),
+	m_state( EProgramState::Unlinked ),
+	m_sourceHash( 0 ),
+	m_pendingShaders()
+{
+	m_uniformSlots.fill( UniformTable::m_invalidLocation );
+}
 
 ShaderLinker::~ShaderLinker()
 {
+	DeletePendingShaders();
+
 	for ( auto s : m_shaderChain )
 	{
 		if ( s )
@@ -56,17 +72,10 @@ void ShaderLinker::SubmitShader( Shader * shader )
 
 }
 
-// Return the uniform id for the passed uniform name from the shader inside of this linker with the passed shader type
-unsigned int ShaderLinker::GetUniformId( const EShaderType & shaderType, const std::string& uniformName ) const
+// Returns the location for the passed uniform name, hashing the name at runtime
+int ShaderLinker::GetUniformId( const std::string& uniformName ) const
 {
-	int type = (int)shaderType;
-	if ( m_shaderChain[type] == nullptr )
-	{
-		return 0;
-	}
-
-	return m_shaderChain[type]->GetUniformId( uniformName );
-
+	return m_uniformTable.Find( HashUniformName( uniformName.c_str() ) );
 }
 
 unsigned int ShaderLinker::GetShaderProgramId() const
@@ -75,8 +84,43 @@ unsigned int ShaderLinker::GetShaderProgramId() const
 }
 
 
+// Hashes the type and source of every submitted shader, programs are only loaded from the cache if this matches
+uint64_t ShaderLinker::HashSources() const
+{
+	uint64_t hash = ProgramCache::Hash( nullptr, 0 );
+	for ( auto s : m_shaderChain )
+	{
+		if ( s == nullptr )
+		{
+			continue;
+		}
+
+		const EShaderType type = s->GetType();
+		hash = ProgramCache::Hash( &type, sizeof( type ), hash );
+		hash = ProgramCache::Hash( s->GetSource().data(), s->GetSource().size(), hash );
+	}
+	return hash;
+}
+
+// Returns true once the program is linked and can be used, advancing its compilation if it is still in flight
+bool ShaderLinker::IsReady()
+{
+	if ( m_state == EProgramState::Compiling || m_state == EProgramState::Linking )
+	{
+		Poll();
+	}
+	return m_state == EProgramState::Ready;
+}
+
+// Lets programs compile on the driver's threads, set by the renderer once it knows the driver supports it
+void ShaderLinker::SetParallelCompileSupported( const bool isSupported )
+{
+	m_parallelCompileSupported = isSupported;
+}
+
 #if GRAPHICS_API == GRAPHICS_OPENGL
-// Links/ Binds all shaders submitted to this shader linker
+// Links/ Binds all shaders submitted to this shader linker, loading the program from the binary cache when it can
+// Compiling and linking are only submitted here, the program can be used once IsReady returns true
 void ShaderLinker::LinkShaders()
 {
 	if ( m_id != 0 )
@@ -84,14 +128,29 @@ void ShaderLinker::LinkShaders()
 		DEBUG_LOG( LOG::INFO, m_name + ": Deleting old program:" + std::to_string( m_id ) );
 		CONSOLE_LOG( LOG::INFO, m_name + ": Deleting old program:" + std::to_string( m_id ) );
 		GLuint oldProgram = m_id;
-		glDeleteProgram( oldProgram );
+		OpenGLStateCache::Get()->DeleteProgram( oldProgram );
+	}
+	DeletePendingShaders();
+
+	m_sourceHash = HashSources();
+
+	m_id = glCreateProgram();
+	if ( ProgramCache::Load( m_name, m_sourceHash, m_id ) )
+		// Warm start, nothing is compiled or linked
+	{
+		DEBUG_LOG( LOG::INFO, m_name + ": Loaded program from the binary cache" );
+		CONSOLE_LOG( LOG::INFO, m_name + ": Loaded program from the binary cache" );
+		SetUpUniformLocations();
+		SetUpUniformBlocks();
+		m_state = EProgramState::Ready;
+		return;
 	}
 
-	GLuint program = glCreateProgram();
-	m_id = program;
-	GLuint shader;
-	GLint linkResult;
+	// A rejected binary leaves the program in an undefined state, so linking from source starts on a new one
+	OpenGLStateCache::Get()->DeleteProgram( m_id );
+	m_id = glCreateProgram();
 
+	// Every stage is submitted before any status is queried, so the driver can compile them at the same time
 	for ( auto s : m_shaderChain )
 	{
 		if ( s == nullptr )
@@ -99,48 +158,241 @@ void ShaderLinker::LinkShaders()
 			continue;
 		}
 
-		shader = s->GetShaderId();
-		linkResult = 0;
+		const GLuint shader = s->Compile();
+		if ( shader != 0 )
+		{
+			glAttachShader( m_id, shader );
+			m_pendingShaders.push_back( shader );
+		}
+	}
+
+	m_state = EProgramState::Compiling;
+
+	// Without parallel compilation this finishes straight away, as it always has
+	Poll();
+
+}
+
+// Moves the program on to linking once every stage has compiled, and to ready once it has linked, without waiting
+void ShaderLinker::Poll()
+{
+	if ( m_state == EProgramState::Compiling )
+	{
+		for ( const GLuint shader : m_pendingShaders )
+		{
+			if ( !IsComplete( shader, false ) )
+			{
+				return;
+			}
+		}
+
+		bool compiled = !m_pendingShaders.empty();
+		for ( auto s : m_shaderChain )
+		{
+			if ( s && !s->CheckCompileStatus() )
+			{
+				compiled = false;
+			}
+		}
 
-		glAttachShader( program, shader );
+		if ( !compiled )
+		{
+			Fail();
+			return;
+		}
 
-		glLinkProgram( program );
+		// Lets the driver keep the binary around, so it can be written to the cache after linking
+		glProgramParameteri( m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+		glLinkProgram( m_id );
+		m_state = EProgramState::Linking;
+	}
 
-		glGetProgramiv( program, GL_LINK_STATUS, &linkResult );
+	if ( m_state == EProgramState::Linking )
+	{
+		if ( !IsComplete( m_id, true ) )
+		{
+			return;
+		}
 
+		GLint linkResult = 0;
+		glGetProgramiv( m_id, GL_LINK_STATUS, &linkResult );
 		if ( !linkResult )
 		{
 			GLint infoLogLength = 0;
-			glGetProgramiv( program, GL_INFO_LOG_LENGTH, &infoLogLength );
-			std::vector<char> programLog( infoLogLength );
-			glGetProgramInfoLog( program, infoLogLength, NULL, &programLog[0] );
-			std::string programString( programLog.begin(), programLog.end() );
-			DEBUG_LOG( LOG::ERRORLOG, "Failed to link shader " + s->GetFileName() + ". Error: " + programString );
-			CONSOLE_LOG( LOG::ERRORLOG, "Failed to link shader " + s->GetFileName() + ". Error: " + programString );
-			glDeleteShader( shader );
-			glDeleteProgram( program );
+			glGetProgramiv( m_id, GL_INFO_LOG_LENGTH, &infoLogLength );
+			std::vector<char> programLog( infoLogLength + 1 );
+			glGetProgramInfoLog( m_id, infoLogLength, NULL, &programLog[0] );
+			std::string programString( programLog.data() );
+			DEBUG_LOG( LOG::ERRORLOG, "Failed to link shader program " + m_name + ". Error: " + programString );
+			CONSOLE_LOG( LOG::ERRORLOG, "Failed to link shader program " + m_name + ". Error: " + programString );
+			Fail();
 			return;
 		}
 
+		// The linked program keeps everything it needs, the shader objects are no longer used
+		DeletePendingShaders();
+		ProgramCache::Save( m_name, m_sourceHash, m_id );
+
+		SetUpUniformLocations();
+		SetUpUniformBlocks();
+		m_state = EProgramState::Ready;
+	}
+}
+
+// Returns true once the driver has finished compiling the passed shader, or linking the passed program
+bool ShaderLinker::IsComplete( const unsigned int object, const bool isProgram ) const
+{
+	if ( !m_parallelCompileSupported )
+		// Status queries wait for the driver instead
+	{
+		return true;
+	}
+
+	GLint isComplete = 0;
+	if ( isProgram )
+	{
+		glGetProgramiv( object, GL_COMPLETION_STATUS_KHR, &isComplete );
+	}
+	else
+	{
+		glGetShaderiv( object, GL_COMPLETION_STATUS_KHR, &isComplete );
+	}
+	return isComplete != 0;
+}
+
+// Deletes the program and any shader objects still attached to it, the program cannot be used
+void ShaderLinker::Fail()
+{
+	DeletePendingShaders();
+	OpenGLStateCache::Get()->DeleteProgram( m_id );
+	m_id = 0;
+	m_state = EProgramState::Failed;
+}
+
+void ShaderLinker::DeletePendingShaders()
+{
+	for ( const GLuint shader : m_pendingShaders )
+	{
+		if ( m_id != 0 )
+		{
+			glDetachShader( m_id, shader );
+		}
 		glDeleteShader( shader );
+	}
+	m_pendingShaders.clear();
+}
+
+// Reflects the active uniforms of the linked program into the uniform table and engine uniform slots
+void ShaderLinker::SetUpUniformLocations()
+{
+	m_uniformTable.Clear();
+	m_uniformSlots.fill( UniformTable::m_invalidLocation );
+
+	GLint count = 0;
+	GLint maxUniformNameLength = 0;
+	glGetProgramiv( m_id, GL_ACTIVE_UNIFORMS, &count );
+	glGetProgramiv( m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformNameLength );
+
+	DEBUG_LOG( LOG::INFO, "Shader: " + m_name + " Active Uniform Count: " + std::to_string( count ) );
+	CONSOLE_LOG( LOG::INFO, "Shader: " + m_name + " Active Uniform Count: " + std::to_string( count ) );
+
+	std::vector<char> name( maxUniformNameLength + 1 );
+
+	for ( GLint i = 0; i < count; ++i )
+	{
+		GLsizei nameLength = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform( m_id, i, static_cast<GLsizei>( name.size() ), &nameLength, &size, &type, name.data() );
+
+		const GLint location = glGetUniformLocation( m_id, name.data() );
+		if ( location == UniformTable::m_invalidLocation )
+			// Uniforms inside of blocks have no location of their own
+		{
+			continue;
+		}
+
+		if ( !m_uniformTable.Insert( HashUniformName( name.data() ), location ) )
+		{
+			DEBUG_LOG( LOG::WARNING, m_name + ": Uniform table is full, skipping uniform: " + std::string( name.data() ) );
+			CONSOLE_LOG( LOG::WARNING, m_name + ": Uniform table is full, skipping uniform: " + std::string( name.data() ) );
+			continue;
+		}
 
+		DEBUG_LOG( LOG::INFO, "Uniform: " + std::string( name.data() ) + " \t\t Location: " + std::to_string( location ) );
+		CONSOLE_LOG( LOG::INFO, "Uniform: " + std::string( name.data() ) + " \t\t Location: " + std::to_string( location ) );
 	}
 
-	// SetUpUniform Locations
-	for ( auto s : m_shaderChain )
+	// Pre-resolving the engine uniforms, so the draw path never has to search the table
+	for ( int i = 0; i < static_cast<int>( EUniform::TOTAL ); ++i )
 	{
-		if ( s == nullptr )
+		m_uniformSlots[i] = m_uniformTable.Find( HashUniformName( g_uniformNames[i] ) );
+	}
+}
+
+// Assigns every engine uniform and storage block used by the linked program its fixed binding point
+void ShaderLinker::SetUpUniformBlocks()
+{
+	// Bindings are assigned here rather than with layout( binding ) in the shaders, so they stay in one place
+	for ( int i = 0; i < static_cast<int>( EUniformBlock::TOTAL ); ++i )
+	{
+		const GLuint blockIndex = glGetUniformBlockIndex( m_id, g_uniformBlockNames[i] );
+		if ( blockIndex == GL_INVALID_INDEX )
 		{
 			continue;
 		}
 
-		s->SetUpUniformLocations(m_id);
+		glUniformBlockBinding( m_id, blockIndex, static_cast<GLuint>( i ) );
 	}
 
+	for ( int i = 0; i < static_cast<int>( EStorageBlock::TOTAL ); ++i )
+	{
+		const GLuint blockIndex = glGetProgramResourceIndex( m_id, GL_SHADER_STORAGE_BLOCK, g_storageBlockNames[i] );
+		if ( blockIndex == GL_INVALID_INDEX )
+		{
+			continue;
+		}
+
+		glShaderStorageBlockBinding( m_id, blockIndex, static_cast<GLuint>( i ) );
+	}
 }
 
-#elif GRAPHICS_API == GRAPHICS_VULKAN
-// Links/ Binds all shaders submitted to this shader linker
+#elif GRAPHICS_API == GRAPHICS_VULKAN || GRAPHICS_API == GRAPHICS_NULL
+// Nothing is compiled, the program only gets an id of its own so draws are grouped by program as on a real backend
+// VulkanRenderer builds its pipelines from SPIR-V itself, so its models are always ready to be drawn
 void ShaderLinker::LinkShaders()
+{
+	static unsigned int nextProgramId = 1;
+
+	if ( m_id == 0 )
+	{
+		m_id = nextProgramId++;
+	}
+	m_sourceHash = HashSources();
+	m_state = EProgramState::Ready;
+}
+
+void ShaderLinker::SetUpUniformLocations()
+{}
+
+void ShaderLinker::SetUpUniformBlocks()
+{}
+
+void ShaderLinker::Poll()
 {}
+
+bool ShaderLinker::IsComplete( const unsigned int object, const bool isProgram ) const
+{
+	return true;
+}
+
+void ShaderLinker::Fail()
+{
+	m_state = EProgramState::Failed;
+}
+
+void ShaderLinker::DeletePendingShaders()
+{
+	m_pendingShaders.clear();
+}
 #endif
\ No newline at end of file
@@ -2,9 +2,22 @@
 #define SHADERLINKER_H
 
 #include "Shader.h"
+#include "UniformTable.h"
+#include "UniformBlocks.h"
 
 #include <string>
 #include <array>
+#include <vector>
+
+// Where a program is in being built, compiling and linking may finish on the driver's threads over several frames
+enum class EProgramState
+{
+	Unlinked,
+	Compiling,
+	Linking,
+	Ready,
+	Failed
+};
 
 
 class ShaderLinker
@@ -24,20 +37,62 @@ public:
 	// Adds the passed shader to this linker, linking this shader to this program
 	void SubmitShader( Shader* shader );
 
-	// Return the uniform id for the passed uniform name from the shader inside of this linker with the passed shader type
-	unsigned int GetUniformId( const EShaderType& shaderType, const std::string& uniformName ) const;
+	// Returns the location of an engine uniform, resolved into its fixed slot when this program was linked
+	int GetUniformId( const EUniform uniform ) const { return m_uniformSlots[static_cast<int>( uniform )]; }
+
+	// Returns the location for the passed uniform name hash, see UNIFORM_ID, or -1 if this program has no such uniform
+	int GetUniformId( const uint32_t uniformHash ) const { return m_uniformTable.Find( uniformHash ); }
+
+	// Returns the location for the passed uniform name, hashing the name at runtime
+	int GetUniformId( const std::string& uniformName ) const;
 
 	unsigned int GetShaderProgramId() const;
 
-	// Links/ Binds all shaders submitted to this shader linker
+	// Links/ Binds all shaders submitted to this shader linker, loading the program from the binary cache when it can
+	// Compiling and linking are only submitted here, the program can be used once IsReady returns true
 	void LinkShaders();
 
+	// Returns true once the program is linked and can be used, advancing its compilation if it is still in flight
+	bool IsReady();
+
+	EProgramState GetState() const { return m_state; }
+
+	// Lets programs compile on the driver's threads, set by the renderer once it knows the driver supports it
+	static void SetParallelCompileSupported( const bool isSupported );
+
 private:
 
 	std::string				m_name;
 	unsigned int			m_id;
 	std::array<Shader*, m_uniqueShaderCount>	m_shaderChain;
+	UniformTable			m_uniformTable;
+	std::array<int, static_cast<int>( EUniform::TOTAL )>	m_uniformSlots;
+
+	EProgramState			m_state;
+	uint64_t				m_sourceHash;
+	std::vector<unsigned int>	m_pendingShaders;	// Compiled shader objects attached until the program has linked
+
+	static bool				m_parallelCompileSupported;
+
+	// Hashes the type and source of every submitted shader, programs are only loaded from the cache if this matches
+	uint64_t HashSources() const;
+
+	// Moves the program on to linking once every stage has compiled, and to ready once it has linked, without waiting
+	void Poll();
+
+	// Returns true once the driver has finished compiling the passed shader, or linking the passed program
+	bool IsComplete( const unsigned int object, const bool isProgram ) const;
+
+	// Deletes the program and any shader objects still attached to it, the program cannot be used
+	void Fail();
+
+	void DeletePendingShaders();
+
+	// Reflects the active uniforms of the linked program into the uniform table and engine uniform slots
+	void SetUpUniformLocations();
 
+	// Assigns every engine uniform and storage block used by the linked program its fixed binding point
+	void SetUpUniformBlocks();
 
 };
 
@@ -0,0 +1,90 @@
+#ifndef UNIFORMBLOCKS_H
+#define UNIFORMBLOCKS_H
+
+#include <glm.hpp>
+
+#include <cstdint>
+
+// Uniform blocks shared by the engine's shaders, the value of each is the binding point it is assigned when linking
+enum class EUniformBlock
+{
+	Frame,
+	TOTAL
+};
+
+// Names of the EUniformBlock blocks, in the same order as the enum
+constexpr const char* g_uniformBlockNames[static_cast<int>( EUniformBlock::TOTAL )] =
+{
+	"FrameData"
+};
+
+// Shader storage blocks shared by the engine's shaders, bound the same way as EUniformBlock
+enum class EStorageBlock
+{
+	Object,
+	Lights,
+	Clusters,
+	LightIndices,
+	Materials,
+	TOTAL
+};
+
+// Names of the EStorageBlock blocks, in the same order as the enum
+constexpr const char* g_storageBlockNames[static_cast<int>( EStorageBlock::TOTAL )] =
+{
+	"ObjectData",
+	"LightData",
+	"ClusterData",
+	"LightIndexData",
+	"MaterialData"
+};
+
+// std140 layout of the FrameData block, written once per frame
+struct FrameUniforms
+{
+	glm::mat4	projectionMatrix;
+	glm::mat4	viewMatrix;
+	glm::vec4	clusterScale;	// xy: clusters per pixel, zw: scale and bias turning log view depth into a slice
+	glm::uvec4	clusterCounts;	// xyz: clusters along each axis, w: lights this frame
+};
+
+// std430 layout of a single entry of the ObjectData array, one per draw and indexed by the draw's id
+// Written by DrawExtractor, the model and normal matrices are stored as rows and read as mat3x4 in the shaders
+struct ObjectUniforms
+{
+	glm::mat4	modelViewProjection;
+	glm::vec4	modelMatrix[3];		// Rows of the affine model matrix
+	glm::vec4	normalMatrix[3];	// Rows of the normal matrix, w: unused
+	glm::uvec4	indices;	// x: entry of MaterialData, y: layer of the bound texture array, zw: unused
+};
+
+// std430 layout of a single entry of the MaterialData array, one per entry of MaterialTable
+struct MaterialUniforms
+{
+	glm::vec4	ambient;
+	glm::vec4	diffuse;	// w: opacity
+	glm::vec4	specular;	// w: shininess
+};
+
+// std430 layout of a single entry of the LightData array, a point light in view space
+struct LightUniforms
+{
+	glm::vec4	positionRadius;	// xyz: position, w: range
+	glm::vec4	diffuse;		// Colour scaled by the diffuse intensity
+	glm::vec4	ambient;		// Colour scaled by the ambient intensity
+};
+
+// std430 layout of a single entry of the ClusterData array, the cluster's lights in LightIndexData
+struct ClusterUniforms
+{
+	uint32_t	offset;
+	uint32_t	count;
+};
+
+static_assert( sizeof( FrameUniforms ) == 160, "FrameUniforms must match the std140 layout of FrameData" );
+static_assert( sizeof( ObjectUniforms ) == 176, "ObjectUniforms must match the std430 layout of ObjectData" );
+static_assert( sizeof( MaterialUniforms ) == 48, "MaterialUniforms must match the std430 layout of MaterialData" );
+static_assert( sizeof( LightUniforms ) == 48, "LightUniforms must match the std430 layout of LightData" );
+static_assert( sizeof( ClusterUniforms ) == 8, "ClusterUniforms must match the std430 layout of ClusterData" );
+
+#endif // !UNIFORMBLOCKS_H
@@ -0,0 +1,108 @@
+#ifndef UNIFORMTABLE_H
+#define UNIFORMTABLE_H
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+// FNV-1a hash of a uniform name, usable at compile time and when reflecting a linked program
+constexpr uint32_t HashUniformName( const char* name, uint32_t hash = 2166136261u )
+{
+	return ( *name == '\0' ) ? hash : HashUniformName( name + 1, ( hash ^ static_cast<uint8_t>( *name ) ) * 16777619u );
+}
+
+// Forces the uniform name hash to be resolved at compile time
+#define UNIFORM_ID( name ) std::integral_constant<uint32_t, HashUniformName( name )>::value
+
+// Uniforms used by the engine's draw path, resolved into fixed slots when a program is linked
+enum class EUniform
+{
+	DrawIndex,
+	TOTAL
+};
+
+// Names of the EUniform slots, in the same order as the enum
+constexpr const char* g_uniformNames[static_cast<int>( EUniform::TOTAL )] =
+{
+	"drawIndex"
+};
+
+// Flat, open-addressed table of uniform name hashes to uniform locations for a single program
+class UniformTable
+{
+
+public:
+
+	static constexpr uint32_t m_capacity = 64;
+	static constexpr int m_invalidLocation = -1;
+
+	UniformTable()
+	{
+		Clear();
+	}
+
+	~UniformTable() {}
+
+	void Clear()
+	{
+		m_hashes.fill( 0 );
+		m_locations.fill( m_invalidLocation );
+		m_count = 0;
+	}
+
+	// Stores the location for the passed uniform name hash, returns false if the table is full
+	bool Insert( const uint32_t uniformHash, const int location )
+	{
+		if ( m_count >= m_capacity )
+		{
+			return false;
+		}
+
+		uint32_t slot = uniformHash & ( m_capacity - 1 );
+		while ( m_locations[slot] != m_invalidLocation && m_hashes[slot] != uniformHash )
+		{
+			slot = ( slot + 1 ) & ( m_capacity - 1 );
+		}
+
+		if ( m_locations[slot] == m_invalidLocation )
+		{
+			m_count++;
+		}
+
+		m_hashes[slot] = uniformHash;
+		m_locations[slot] = location;
+		return true;
+	}
+
+	// Returns the location stored for the passed uniform name hash, or -1 if the program has no such uniform
+	int Find( const uint32_t uniformHash ) const
+	{
+		uint32_t slot = uniformHash & ( m_capacity - 1 );
+		for ( uint32_t i = 0; i < m_capacity; ++i )
+		{
+			if ( m_locations[slot] == m_invalidLocation )
+			{
+				return m_invalidLocation;
+			}
+
+			if ( m_hashes[slot] == uniformHash )
+			{
+				return m_locations[slot];
+			}
+
+			slot = ( slot + 1 ) & ( m_capacity - 1 );
+		}
+		return m_invalidLocation;
+	}
+
+	uint32_t GetCount() const { return m_count; }
+
+private:
+
+	std::array<uint32_t, m_capacity>	m_hashes;
+	std::array<int, m_capacity>			m_locations;
+	uint32_t							m_count;
+
+};
+
+#endif // !UNIFORMTABLE_H
@@ -0,0 +1,278 @@
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	constexpr int g_pixelsPerBlock = BlockCompressor::m_blockDimension * BlockCompressor::m_blockDimension;
+	constexpr int g_powerIterations = 8;
+
+	uint16_t PackColour565( const float* colour )
+	{
+		const int r = std::clamp( static_cast<int>( colour[0] * ( 31.0f / 255.0f ) + 0.5f ), 0, 31 );
+		const int g = std::clamp( static_cast<int>( colour[1] * ( 63.0f / 255.0f ) + 0.5f ), 0, 63 );
+		const int b = std::clamp( static_cast<int>( colour[2] * ( 31.0f / 255.0f ) + 0.5f ), 0, 31 );
+		return static_cast<uint16_t>( ( r << 11 ) | ( g << 5 ) | b );
+	}
+
+	// Expands a 565 colour the same way the hardware does, replicating the top bits into the bottom ones
+	void UnpackColour565( const uint16_t packed, int* colour )
+	{
+		const int r = ( packed >> 11 ) & 31;
+		const int g = ( packed >> 5 ) & 63;
+		const int b = packed & 31;
+		colour[0] = ( r << 3 ) | ( r >> 2 );
+		colour[1] = ( g << 2 ) | ( g >> 4 );
+		colour[2] = ( b << 3 ) | ( b >> 2 );
+	}
+
+	void WriteLittleEndian16( unsigned char* output, const uint16_t value )
+	{
+		output[0] = static_cast<unsigned char>( value & 0xFF );
+		output[1] = static_cast<unsigned char>( value >> 8 );
+	}
+}
+
+// Returns the bytes used by a single block of the passed format
+size_t BlockCompressor::GetBlockSize( const ETextureFormat format )
+{
+	switch ( format )
+	{
+	case ETextureFormat::BC1:	return 8;
+	case ETextureFormat::BC3:	return 16;
+	default:					return 0;
+	}
+}
+
+// Returns the bytes needed to store an image of the passed size, partial blocks along the edges are padded out
+size_t BlockCompressor::GetCompressedSize( const ETextureFormat format, const int width, const int height )
+{
+	const size_t blocksWide = static_cast<size_t>( ( width + m_blockDimension - 1 ) / m_blockDimension );
+	const size_t blocksHigh = static_cast<size_t>( ( height + m_blockDimension - 1 ) / m_blockDimension );
+	return blocksWide * blocksHigh * GetBlockSize( format );
+}
+
+// Compresses an 8 bit RGBA image into the passed format, output is resized to fit
+void BlockCompressor::Compress(
+	const unsigned char* rgba,
+	const int width,
+	const int height,
+	const ETextureFormat format,
+	std::vector<unsigned char>& output )
+{
+	output.assign( GetCompressedSize( format, width, height ), 0 );
+
+	const size_t blockSize = GetBlockSize( format );
+	unsigned char* destination = output.data();
+	unsigned char block[g_pixelsPerBlock * 4];
+
+	for ( int by = 0; by < height; by += m_blockDimension )
+	{
+		for ( int bx = 0; bx < width; bx += m_blockDimension )
+		{
+			// Pixels past the edge of the image repeat the last row and column
+			for ( int py = 0; py < m_blockDimension; ++py )
+			{
+				const int y = std::min( by + py, height - 1 );
+				for ( int px = 0; px < m_blockDimension; ++px )
+				{
+					const int x = std::min( bx + px, width - 1 );
+					std::memcpy( &block[( py * m_blockDimension + px ) * 4], &rgba[( static_cast<size_t>( y ) * width + x ) * 4], 4 );
+				}
+			}
+
+			if ( format == ETextureFormat::BC3 )
+			{
+				EncodeAlphaBlock( block, destination );
+				EncodeColourBlock( block, destination + 8 );
+			}
+			else
+			{
+				EncodeColourBlock( block, destination );
+			}
+
+			destination += blockSize;
+		}
+	}
+}
+
+// Encodes the colour of 16 RGBA pixels as two 565 endpoints along their principal axis and 2 bit indices
+void BlockCompressor::EncodeColourBlock( const unsigned char* block, unsigned char* output )
+{
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for ( int i = 0; i < g_pixelsPerBlock; ++i )
+	{
+		for ( int c = 0; c < 3; ++c )
+		{
+			mean[c] += block[i * 4 + c];
+		}
+	}
+	for ( int c = 0; c < 3; ++c )
+	{
+		mean[c] /= static_cast<float>( g_pixelsPerBlock );
+	}
+
+	// Covariance of the block's colours: rr, rg, rb, gg, gb, bb
+	float covariance[6] = {};
+	for ( int i = 0; i < g_pixelsPerBlock; ++i )
+	{
+		const float r = block[i * 4 + 0] - mean[0];
+		const float g = block[i * 4 + 1] - mean[1];
+		const float b = block[i * 4 + 2] - mean[2];
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+
+	// Power iteration converges on the direction the colours are spread along the most
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for ( int i = 0; i < g_powerIterations; ++i )
+	{
+		const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+		const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+		const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+
+		const float largest = std::max( std::abs( x ), std::max( std::abs( y ), std::abs( z ) ) );
+		if ( largest <= 0.0f )
+			// Every pixel is the same colour, any axis will do
+		{
+			break;
+		}
+
+		axis[0] = x / largest;
+		axis[1] = y / largest;
+		axis[2] = z / largest;
+	}
+
+	int minPixel = 0;
+	int maxPixel = 0;
+	float minProjection = 0.0f;
+	float maxProjection = 0.0f;
+	for ( int i = 0; i < g_pixelsPerBlock; ++i )
+	{
+		const float projection = block[i * 4 + 0] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+		if ( i == 0 || projection < minProjection )
+		{
+			minProjection = projection;
+			minPixel = i;
+		}
+		if ( i == 0 || projection > maxProjection )
+		{
+			maxProjection = projection;
+			maxPixel = i;
+		}
+	}
+
+	// Pulling the endpoints in by 1/16th of their range, the extremes are then covered by the interpolated colours
+	float endpoints[2][3];
+	for ( int c = 0; c < 3; ++c )
+	{
+		const float high = block[maxPixel * 4 + c];
+		const float low = block[minPixel * 4 + c];
+		const float inset = ( high - low ) / 16.0f;
+		endpoints[0][c] = high - inset;
+		endpoints[1][c] = low + inset;
+	}
+
+	uint16_t colour0 = PackColour565( endpoints[0] );
+	uint16_t colour1 = PackColour565( endpoints[1] );
+
+	// colour0 must be the larger value, otherwise the block decodes in 3 colour mode with a transparent index
+	if ( colour0 < colour1 )
+	{
+		std::swap( colour0, colour1 );
+	}
+
+	uint32_t indices = 0;
+	if ( colour0 != colour1 )
+	{
+		int palette[4][3];
+		UnpackColour565( colour0, palette[0] );
+		UnpackColour565( colour1, palette[1] );
+		for ( int c = 0; c < 3; ++c )
+		{
+			palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+			palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+		}
+
+		for ( int i = 0; i < g_pixelsPerBlock; ++i )
+		{
+			uint32_t bestIndex = 0;
+			int bestError = 0;
+			for ( uint32_t p = 0; p < 4; ++p )
+			{
+				const int dr = block[i * 4 + 0] - palette[p][0];
+				const int dg = block[i * 4 + 1] - palette[p][1];
+				const int db = block[i * 4 + 2] - palette[p][2];
+				const int error = dr * dr + dg * dg + db * db;
+				if ( p == 0 || error < bestError )
+				{
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+			indices |= bestIndex << ( i * 2 );
+		}
+	}
+
+	WriteLittleEndian16( output + 0, colour0 );
+	WriteLittleEndian16( output + 2, colour1 );
+	output[4] = static_cast<unsigned char>( indices & 0xFF );
+	output[5] = static_cast<unsigned char>( ( indices >> 8 ) & 0xFF );
+	output[6] = static_cast<unsigned char>( ( indices >> 16 ) & 0xFF );
+	output[7] = static_cast<unsigned char>( ( indices >> 24 ) & 0xFF );
+}
+
+// Encodes the alpha of 16 RGBA pixels as two 8 bit endpoints and 3 bit indices
+void BlockCompressor::EncodeAlphaBlock( const unsigned char* block, unsigned char* output )
+{
+	int alpha0 = 0;
+	int alpha1 = 255;
+	for ( int i = 0; i < g_pixelsPerBlock; ++i )
+	{
+		alpha0 = std::max( alpha0, static_cast<int>( block[i * 4 + 3] ) );
+		alpha1 = std::min( alpha1, static_cast<int>( block[i * 4 + 3] ) );
+	}
+
+	uint64_t indices = 0;
+	if ( alpha0 != alpha1 )
+		// alpha0 > alpha1 selects the mode with six interpolated values between the endpoints
+	{
+		int palette[8];
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for ( int p = 2; p < 8; ++p )
+		{
+			palette[p] = ( ( 8 - p ) * alpha0 + ( p - 1 ) * alpha1 ) / 7;
+		}
+
+		for ( int i = 0; i < g_pixelsPerBlock; ++i )
+		{
+			const int alpha = block[i * 4 + 3];
+			uint64_t bestIndex = 0;
+			int bestError = 256;
+			for ( int p = 0; p < 8; ++p )
+			{
+				const int error = std::abs( alpha - palette[p] );
+				if ( error < bestError )
+				{
+					bestError = error;
+					bestIndex = static_cast<uint64_t>( p );
+				}
+			}
+			indices |= bestIndex << ( i * 3 );
+		}
+	}
+
+	output[0] = static_cast<unsigned char>( alpha0 );
+	output[1] = static_cast<unsigned char>( alpha1 );
+	for ( int b = 0; b < 6; ++b )
+	{
+		output[2 + b] = static_cast<unsigned char>( ( indices >> ( b * 8 ) ) & 0xFF );
+	}
+}
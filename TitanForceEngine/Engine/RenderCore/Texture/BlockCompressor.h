@@ -0,0 +1,50 @@
+#ifndef BLOCKCOMPRESSOR_H
+#define BLOCKCOMPRESSOR_H
+
+#include "Texture2D.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU encoder for the S3TC block formats, so textures can be cooked on machines without a GPU
+class BlockCompressor
+{
+
+	BlockCompressor() = delete;	// Static class, no constructor needed
+	BlockCompressor( const BlockCompressor& ) = delete;
+	BlockCompressor& operator=( const BlockCompressor& ) = delete;
+	BlockCompressor( BlockCompressor&& ) = delete;
+	BlockCompressor& operator=( BlockCompressor&& ) = delete;
+
+public:
+
+	// Width and height in pixels of a single compressed block
+	static constexpr int m_blockDimension = 4;
+
+	// Returns the bytes used by a single block of the passed format
+	static size_t GetBlockSize( const ETextureFormat format );
+
+	// Returns the bytes needed to store an image of the passed size, partial blocks along the edges are padded out
+	static size_t GetCompressedSize( const ETextureFormat format, const int width, const int height );
+
+	// Compresses an 8 bit RGBA image into the passed format, output is resized to fit
+	static void Compress(
+		const unsigned char* rgba,
+		const int width,
+		const int height,
+		const ETextureFormat format,
+		std::vector<unsigned char>& output
+	);
+
+private:
+
+	// Encodes the colour of 16 RGBA pixels as two 565 endpoints along their principal axis and 2 bit indices
+	static void EncodeColourBlock( const unsigned char* block, unsigned char* output );
+
+	// Encodes the alpha of 16 RGBA pixels as two 8 bit endpoints and 3 bit indices
+	static void EncodeAlphaBlock( const unsigned char* block, unsigned char* output );
+
+};
+
+#endif // !BLOCKCOMPRESSOR_H
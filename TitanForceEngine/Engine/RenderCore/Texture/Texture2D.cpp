@@ -1,5 +1,69 @@
 #include "Texture2D.h"
 
+#include "TextureCooker.h"
+#include "../Loading/AssetLoader.h"
+#include "../../Core/MappedFile.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+std::atomic<bool> Texture2D::m_blockCompressionSupported( false );
+
+TextureData::~TextureData()
+{
+	if ( pixels )
+	{
+		stbi_image_free( pixels );
+		pixels = nullptr;
+	}
+
+	if ( mappedFile )
+	{
+		delete mappedFile;
+		mappedFile = nullptr;
+	}
+}
+
 Texture2D::Texture2D( const char* fileName ) :
 	ITexture( fileName ), m_width( 0 ), m_height( 0 )
 {}
+
+Texture2D::~Texture2D()
+{
+	AssetLoader::Get()->Cancel( this );
+}
+
+// Decodes the passed texture file, safe to call from worker threads. Returns null if the file cannot be decoded
+std::shared_ptr<TextureData> Texture2D::Decode( const std::string& fileName )
+{
+	if ( m_blockCompressionSupported )
+	{
+		std::shared_ptr<TextureData> cooked = TextureCooker::LoadTexture( fileName );
+		if ( cooked )
+		{
+			return cooked;
+		}
+	}
+
+	std::string filePath = TextureCooker::GetSourceFilePath( fileName );
+
+	std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+	data->pixels = stbi_load( filePath.c_str(), &data->width, &data->height, &data->channels, 0 );
+
+	if ( data->pixels == nullptr )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Decoding texture... FAILED: " + filePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Decoding texture... FAILED: " + filePath );
+		return nullptr;
+	}
+
+	return data;
+}
+
+// Set by the renderer once it knows the GPU can sample BC1 and BC3 textures, cooked textures are only used if it can
+void Texture2D::SetBlockCompressionSupported( const bool supported )
+{
+	m_blockCompressionSupported = supported;
+}
@@ -3,26 +3,78 @@
 
 #include "Texture.h"
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+// How the pixels of a texture are stored
+enum class ETextureFormat
+{
+	Uncompressed,	// 8 bits per channel, decoded straight from the source image
+	BC1,			// 4x4 blocks of 8 bytes, RGB
+	BC3				// 4x4 blocks of 16 bytes, RGB with interpolated alpha
+};
+
+// One level of a cooked mip chain
+struct TextureMip
+{
+	const unsigned char*	data;
+	size_t					size;
+	int						width;
+	int						height;
+};
+
+// Decoded image, either uncompressed pixels with rows stored top to bottom or a block compressed mip chain
+struct TextureData
+{
+	TextureData() : format( ETextureFormat::Uncompressed ), width( 0 ), height( 0 ), channels( 0 ), pixels( nullptr ), mappedFile( nullptr ) {}
+	~TextureData();
+
+	ETextureFormat			format;
+	int						width;
+	int						height;
+	int						channels;
+	unsigned char*			pixels;		// Uncompressed only
+
+	std::vector<TextureMip>	mips;		// Block compressed only, points into mappedFile
+	MappedFile*				mappedFile;
+};
+
 class Texture2D : public ITexture
 {
 public:
 
 	explicit Texture2D( const char* fileName );
-	virtual ~Texture2D() {}
+	virtual ~Texture2D();
 
 	virtual void GenerateTexture() = 0;
 	virtual void Bind() = 0;
 	virtual void Unbind() = 0;
 
+	// Replaces the contents of this texture with the passed decoded image, render thread only
+	// The texture may keep its previous contents for a few frames while the image is copied to the GPU
+	virtual void Upload( const std::shared_ptr<TextureData>& data ) = 0;
+
+	// Decodes the passed texture file, safe to call from worker threads. Returns null if the file cannot be decoded
+	static std::shared_ptr<TextureData> Decode( const std::string& fileName );
+
+	// Set by the renderer once it knows the GPU can sample BC1 and BC3 textures, cooked textures are only used if it can
+	static void SetBlockCompressionSupported( const bool supported );
+
 protected:
 
 	int m_width;
 	int m_height;
 
-};
+private:
 
+	static std::atomic<bool> m_blockCompressionSupported;
 
+};
 
-#endif // !TEXTURE2D_H
 
 
+#endif // !TEXTURE2D_H
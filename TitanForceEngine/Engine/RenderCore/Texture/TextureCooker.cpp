@@ -0,0 +1,210 @@
+#include "TextureCooker.h"
+#include "TextureFile.h"
+#include "BlockCompressor.h"
+
+#include "../../Core/SourceStamp.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define TEXTURE_COOKER_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	float SrgbToLinear( const float value )
+	{
+		return ( value <= 0.04045f ) ? value / 12.92f : std::pow( ( value + 0.055f ) / 1.055f, 2.4f );
+	}
+
+	unsigned char LinearToSrgb( const float value )
+	{
+		const float clamped = std::clamp( value, 0.0f, 1.0f );
+		const float srgb = ( clamped <= 0.0031308f ) ? clamped * 12.92f : 1.055f * std::pow( clamped, 1.0f / 2.4f ) - 0.055f;
+		return static_cast<unsigned char>( srgb * 255.0f + 0.5f );
+	}
+
+	const std::array<float, 256>& GetSrgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []()
+		{
+			std::array<float, 256> result = {};
+			for ( size_t i = 0; i < result.size(); ++i )
+			{
+				result[i] = SrgbToLinear( static_cast<float>( i ) / 255.0f );
+			}
+			return result;
+		}();
+		return table;
+	}
+
+	// Halves a linear RGBA float image with a 2x2 box filter, odd edges reuse the last row and column
+	void Downsample( const std::vector<float>& source, const int width, const int height, std::vector<float>& destination, const int newWidth, const int newHeight )
+	{
+		destination.resize( static_cast<size_t>( newWidth ) * newHeight * 4 );
+
+#ifdef TEXTURE_COOKER_SSE
+		const __m128 quarter = _mm_set1_ps( 0.25f );
+#endif
+
+		for ( int y = 0; y < newHeight; ++y )
+		{
+			const float* row0 = &source[static_cast<size_t>( std::min( y * 2, height - 1 ) ) * width * 4];
+			const float* row1 = &source[static_cast<size_t>( std::min( y * 2 + 1, height - 1 ) ) * width * 4];
+			float* output = &destination[static_cast<size_t>( y ) * newWidth * 4];
+
+			for ( int x = 0; x < newWidth; ++x )
+			{
+				const int x0 = std::min( x * 2, width - 1 ) * 4;
+				const int x1 = std::min( x * 2 + 1, width - 1 ) * 4;
+
+#ifdef TEXTURE_COOKER_SSE
+				// One RGBA pixel per register, all four channels are filtered at once
+				const __m128 top = _mm_add_ps( _mm_loadu_ps( row0 + x0 ), _mm_loadu_ps( row0 + x1 ) );
+				const __m128 bottom = _mm_add_ps( _mm_loadu_ps( row1 + x0 ), _mm_loadu_ps( row1 + x1 ) );
+				_mm_storeu_ps( output + x * 4, _mm_mul_ps( _mm_add_ps( top, bottom ), quarter ) );
+#else
+				for ( int c = 0; c < 4; ++c )
+				{
+					output[x * 4 + c] = ( row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] ) * 0.25f;
+				}
+#endif
+			}
+		}
+	}
+}
+
+// Maps the cooked texture for the passed source image, cooking it first if it is missing or stale
+// Returns null if the image cannot be cooked, the caller falls back to decoding the source image
+std::shared_ptr<TextureData> TextureCooker::LoadTexture( const std::string& fileName )
+{
+	const std::string sourceFilePath = GetSourceFilePath( fileName );
+	const std::string cookedFilePath = GetCookedFilePath( fileName );
+
+	SourceStamp source = {};
+	if ( !SourceStamp::Read( sourceFilePath, source ) )
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<TextureData> cooked = TextureFile::Read( cookedFilePath, source );
+	if ( cooked )
+	{
+		DEBUG_LOG( LOG::INFO, "Mapped cooked texture: " + cookedFilePath );
+		CONSOLE_LOG( LOG::INFO, "Mapped cooked texture: " + cookedFilePath );
+		return cooked;
+	}
+
+	int width, height, channels;
+	if ( !stbi_info( sourceFilePath.c_str(), &width, &height, &channels ) || channels < 3 )
+		// Only colour images are block compressed, single and two channel data stays uncompressed
+	{
+		return nullptr;
+	}
+
+	if ( !CookTexture( fileName ) )
+	{
+		return nullptr;
+	}
+
+	return TextureFile::Read( cookedFilePath, source );
+}
+
+// Cooks the passed source image, returns false if it cannot be decoded, compressed or written
+bool TextureCooker::CookTexture( const std::string& fileName )
+{
+	const std::string sourceFilePath = GetSourceFilePath( fileName );
+
+	SourceStamp source = {};
+	if ( !SourceStamp::Read( sourceFilePath, source ) )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot cook missing texture: " + sourceFilePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot cook missing texture: " + sourceFilePath );
+		return false;
+	}
+
+	int width, height, channels;
+	unsigned char* pixels = stbi_load( sourceFilePath.c_str(), &width, &height, &channels, 4 );
+	if ( pixels == nullptr )
+	{
+		DEBUG_LOG( LOG::ERRORLOG, "Cannot cook texture, decoding failed: " + sourceFilePath );
+		CONSOLE_LOG( LOG::ERRORLOG, "Cannot cook texture, decoding failed: " + sourceFilePath );
+		return false;
+	}
+
+	DEBUG_LOG( LOG::INFO, "Cooking texture: " + sourceFilePath );
+	CONSOLE_LOG( LOG::INFO, "Cooking texture: " + sourceFilePath );
+
+	const size_t pixelCount = static_cast<size_t>( width ) * height;
+
+	bool hasAlpha = false;
+	for ( size_t i = 0; i < pixelCount && !hasAlpha; ++i )
+	{
+		hasAlpha = pixels[i * 4 + 3] != 255;
+	}
+	const ETextureFormat format = hasAlpha ? ETextureFormat::BC3 : ETextureFormat::BC1;
+
+	// Filtering happens in linear space, averaging sRGB values directly darkens every mip below the first
+	const std::array<float, 256>& srgbToLinear = GetSrgbToLinearTable();
+	std::vector<float> level( pixelCount * 4 );
+	for ( size_t i = 0; i < pixelCount; ++i )
+	{
+		level[i * 4 + 0] = srgbToLinear[pixels[i * 4 + 0]];
+		level[i * 4 + 1] = srgbToLinear[pixels[i * 4 + 1]];
+		level[i * 4 + 2] = srgbToLinear[pixels[i * 4 + 2]];
+		level[i * 4 + 3] = pixels[i * 4 + 3] / 255.0f;
+	}
+
+	std::vector<std::vector<unsigned char>> mips;
+	mips.emplace_back();
+	BlockCompressor::Compress( pixels, width, height, format, mips.back() );
+	stbi_image_free( pixels );
+
+	std::vector<float> nextLevel;
+	std::vector<unsigned char> encoded;
+	int levelWidth = width;
+	int levelHeight = height;
+
+	while ( ( levelWidth > 1 || levelHeight > 1 ) && mips.size() < TextureFile::m_maxMips )
+	{
+		const int nextWidth = std::max( 1, levelWidth / 2 );
+		const int nextHeight = std::max( 1, levelHeight / 2 );
+		Downsample( level, levelWidth, levelHeight, nextLevel, nextWidth, nextHeight );
+		level.swap( nextLevel );
+		levelWidth = nextWidth;
+		levelHeight = nextHeight;
+
+		const size_t levelPixels = static_cast<size_t>( levelWidth ) * levelHeight;
+		encoded.resize( levelPixels * 4 );
+		for ( size_t i = 0; i < levelPixels; ++i )
+		{
+			encoded[i * 4 + 0] = LinearToSrgb( level[i * 4 + 0] );
+			encoded[i * 4 + 1] = LinearToSrgb( level[i * 4 + 1] );
+			encoded[i * 4 + 2] = LinearToSrgb( level[i * 4 + 2] );
+			encoded[i * 4 + 3] = static_cast<unsigned char>( std::clamp( level[i * 4 + 3], 0.0f, 1.0f ) * 255.0f + 0.5f );
+		}
+
+		mips.emplace_back();
+		BlockCompressor::Compress( encoded.data(), levelWidth, levelHeight, format, mips.back() );
+	}
+
+	return TextureFile::Write( GetCookedFilePath( fileName ), format, width, height, channels, mips, source );
+}
+
+std::string TextureCooker::GetSourceFilePath( const std::string& fileName )
+{
+	return "./Resources/Textures/" + fileName;
+}
+
+std::string TextureCooker::GetCookedFilePath( const std::string& fileName )
+{
+	return "./Resources/Textures/Cooked/" + fileName + ".ttex";
+}
@@ -0,0 +1,33 @@
+#ifndef TEXTURECOOKER_H
+#define TEXTURECOOKER_H
+
+#include "Texture2D.h"
+
+#include <memory>
+#include <string>
+
+// Builds gamma correct mip chains for source images, block compresses them and stores them as cooked texture files
+class TextureCooker
+{
+
+	TextureCooker() = delete;	// Static class, no constructor needed
+	TextureCooker( const TextureCooker& ) = delete;
+	TextureCooker& operator=( const TextureCooker& ) = delete;
+	TextureCooker( TextureCooker&& ) = delete;
+	TextureCooker& operator=( TextureCooker&& ) = delete;
+
+public:
+
+	// Maps the cooked texture for the passed source image, cooking it first if it is missing or stale
+	// Returns null if the image cannot be cooked, the caller falls back to decoding the source image
+	static std::shared_ptr<TextureData> LoadTexture( const std::string& fileName );
+
+	// Cooks the passed source image, returns false if it cannot be decoded, compressed or written
+	static bool CookTexture( const std::string& fileName );
+
+	static std::string GetSourceFilePath( const std::string& fileName );
+	static std::string GetCookedFilePath( const std::string& fileName );
+
+};
+
+#endif // !TEXTURECOOKER_H
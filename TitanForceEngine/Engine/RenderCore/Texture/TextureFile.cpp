@@ -0,0 +1,172 @@
+#include "TextureFile.h"
+#include "BlockCompressor.h"
+
+#include "../../Core/MappedFile.h"
+
+#include "../../EntityComponentSystem/EntityComponentSystem/ECS/include/Utility/Debug.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	uint64_t AlignOffset( const uint64_t offset )
+	{
+		return ( offset + TextureFile::m_blobAlignment - 1 ) & ~( TextureFile::m_blobAlignment - 1 );
+	}
+
+	void WritePadding( std::ofstream& file, const uint64_t offset )
+	{
+		static const char zeros[TextureFile::m_blobAlignment] = {};
+		const uint64_t padding = AlignOffset( offset ) - offset;
+		file.write( zeros, static_cast<std::streamsize>( padding ) );
+	}
+
+	bool BlobInFile( const uint64_t offset, const uint64_t size, const size_t fileSize )
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+}
+
+// Writes the passed compressed mip chain, largest mip first. Returns false if the file cannot be written
+bool TextureFile::Write(
+	const std::string& filePath,
+	const ETextureFormat format,
+	const int width,
+	const int height,
+	const int channels,
+	const std::vector<std::vector<unsigned char>>& mips,
+	const SourceStamp& source )
+{
+	if ( mips.empty() || mips.size() > m_maxMips )
+	{
+		DEBUG_LOG( LOG::WARNING, "Cannot write cooked texture with " + std::to_string( mips.size() ) + " mips: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Cannot write cooked texture with " + std::to_string( mips.size() ) + " mips: " + filePath );
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories( std::filesystem::path( filePath ).parent_path(), error );
+
+	std::ofstream file( filePath, std::ios::binary | std::ios::trunc );
+	if ( !file.is_open() )
+	{
+		DEBUG_LOG( LOG::WARNING, "Cannot write cooked texture: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Cannot write cooked texture: " + filePath );
+		return false;
+	}
+
+	Header header = {};
+	header.magic = m_magic;
+	header.version = m_version;
+	header.source = source;
+	header.format = static_cast<uint32_t>( format );
+	header.width = static_cast<uint32_t>( width );
+	header.height = static_cast<uint32_t>( height );
+	header.channels = static_cast<uint32_t>( channels );
+	header.mipCount = static_cast<uint32_t>( mips.size() );
+
+	uint64_t offset = sizeof( Header );
+	for ( size_t m = 0; m < mips.size(); ++m )
+	{
+		offset = AlignOffset( offset );
+		header.mipOffsets[m] = offset;
+		header.mipSizes[m] = mips[m].size();
+		offset += mips[m].size();
+	}
+
+	file.write( reinterpret_cast<const char*>( &header ), sizeof( Header ) );
+	offset = sizeof( Header );
+
+	for ( const std::vector<unsigned char>& mip : mips )
+	{
+		WritePadding( file, offset );
+		offset = AlignOffset( offset );
+		file.write( reinterpret_cast<const char*>( mip.data() ), static_cast<std::streamsize>( mip.size() ) );
+		offset += mip.size();
+	}
+
+	if ( !file.good() )
+	{
+		file.close();
+		std::filesystem::remove( filePath, error );
+		DEBUG_LOG( LOG::WARNING, "Failed writing cooked texture: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Failed writing cooked texture: " + filePath );
+		return false;
+	}
+
+	return true;
+}
+
+// Maps the cooked texture at the passed path, the returned mips point straight into the mapped file
+// Returns null if the file is missing, corrupt, from another version or was cooked from a different source
+std::shared_ptr<TextureData> TextureFile::Read( const std::string& filePath, const SourceStamp& source )
+{
+	MappedFile* mappedFile = new MappedFile();
+	if ( !mappedFile->Open( filePath ) )
+	{
+		delete mappedFile;
+		return nullptr;
+	}
+
+	const size_t fileSize = mappedFile->GetSize();
+	if ( fileSize < sizeof( Header ) )
+	{
+		delete mappedFile;
+		return nullptr;
+	}
+
+	const Header* header = reinterpret_cast<const Header*>( mappedFile->GetData() );
+	if ( header->magic != m_magic ||
+		header->version != m_version ||
+		header->source != source )
+		// Stale cooked files are ignored, the caller cooks a new one from source
+	{
+		delete mappedFile;
+		return nullptr;
+	}
+
+	const ETextureFormat format = static_cast<ETextureFormat>( header->format );
+	bool valid = ( format == ETextureFormat::BC1 || format == ETextureFormat::BC3 ) &&
+		header->width > 0 && header->height > 0 &&
+		header->mipCount > 0 && header->mipCount <= m_maxMips;
+
+	int width = static_cast<int>( header->width );
+	int height = static_cast<int>( header->height );
+	for ( uint32_t m = 0; valid && m < header->mipCount; ++m )
+	{
+		valid = BlobInFile( header->mipOffsets[m], header->mipSizes[m], fileSize ) &&
+			header->mipSizes[m] == BlockCompressor::GetCompressedSize( format, width, height );
+
+		width = std::max( 1, width / 2 );
+		height = std::max( 1, height / 2 );
+	}
+
+	if ( !valid )
+	{
+		DEBUG_LOG( LOG::WARNING, "Corrupt cooked texture: " + filePath );
+		CONSOLE_LOG( LOG::WARNING, "Corrupt cooked texture: " + filePath );
+		delete mappedFile;
+		return nullptr;
+	}
+
+	std::shared_ptr<TextureData> data = std::make_shared<TextureData>();
+	data->format = format;
+	data->width = static_cast<int>( header->width );
+	data->height = static_cast<int>( header->height );
+	data->channels = static_cast<int>( header->channels );
+	data->mips.reserve( header->mipCount );
+
+	width = data->width;
+	height = data->height;
+	for ( uint32_t m = 0; m < header->mipCount; ++m )
+	{
+		data->mips.push_back( { mappedFile->GetData() + header->mipOffsets[m], static_cast<size_t>( header->mipSizes[m] ), width, height } );
+		width = std::max( 1, width / 2 );
+		height = std::max( 1, height / 2 );
+	}
+	data->mappedFile = mappedFile;
+
+	return data;
+}
@@ -0,0 +1,64 @@
+#ifndef TEXTUREFILE_H
+#define TEXTUREFILE_H
+
+#include "Texture2D.h"
+#include "../../Core/SourceStamp.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Cooked, memory mappable texture container holding a block compressed mip chain
+//
+// [Header][mip 0][mip 1]...[mip n]
+// Every mip starts on a m_blobAlignment boundary and is uploaded in place from the mapped file
+class TextureFile
+{
+
+	TextureFile() = delete;	// Static class, no constructor needed
+	TextureFile( const TextureFile& ) = delete;
+	TextureFile& operator=( const TextureFile& ) = delete;
+	TextureFile( TextureFile&& ) = delete;
+	TextureFile& operator=( TextureFile&& ) = delete;
+
+public:
+
+	static constexpr uint32_t m_magic = 0x58455454;	// "TTEX"
+	static constexpr uint32_t m_version = 1;
+	static constexpr uint64_t m_blobAlignment = 16;
+	static constexpr uint32_t m_maxMips = 16;		// Enough for a 32768 x 32768 texture
+
+	struct Header
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		SourceStamp	source;
+		uint32_t	format;
+		uint32_t	width;
+		uint32_t	height;
+		uint32_t	channels;
+		uint32_t	mipCount;
+		uint32_t	padding;
+		uint64_t	mipOffsets[m_maxMips];
+		uint64_t	mipSizes[m_maxMips];
+	};
+
+	// Writes the passed compressed mip chain, largest mip first. Returns false if the file cannot be written
+	static bool Write(
+		const std::string& filePath,
+		const ETextureFormat format,
+		const int width,
+		const int height,
+		const int channels,
+		const std::vector<std::vector<unsigned char>>& mips,
+		const SourceStamp& source
+	);
+
+	// Maps the cooked texture at the passed path, the returned mips point straight into the mapped file
+	// Returns null if the file is missing, corrupt, from another version or was cooked from a different source
+	static std::shared_ptr<TextureData> Read( const std::string& filePath, const SourceStamp& source );
+
+};
+
+#endif // !TEXTUREFILE_H
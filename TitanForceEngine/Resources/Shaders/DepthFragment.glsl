@@ -0,0 +1,5 @@
+#version 430
+
+/// Colour writes are masked off during the depth pre-pass, only the depth test and write are left
+void main() {
+}
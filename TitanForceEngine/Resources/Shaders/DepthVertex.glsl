@@ -0,0 +1,39 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : enable
+layout (location = 0) in vec3 position;
+
+/// Written to the depth buffer before the shaded draws, which have to compute the exact same position to pass GL_LEQUAL
+invariant gl_Position;
+
+/// Written once per frame, see UniformBlocks.h
+layout (std140) uniform FrameData {
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 clusterScale; /// xy: clusters per pixel, zw: scale and bias turning log view depth into a slice
+	uvec4 clusterCounts; /// xyz: clusters along each axis, w: lights this frame
+};
+
+/// Written once per draw, see DrawExtractor. Both matrices hold rows, so vectors are multiplied from the left
+struct ObjectUniforms {
+	mat4 modelViewProjection;
+	mat3x4 modelMatrix;
+	mat3x4 normalMatrix;
+	uvec4 indices; /// x: entry of MaterialData, y: layer of the bound texture array
+};
+
+/// One entry per draw of a multi draw, indexed by the draw's id
+layout (std430) readonly buffer ObjectData {
+	ObjectUniforms objects[];
+};
+
+#ifdef GL_ARB_shader_draw_parameters
+#define DRAW_INDEX gl_DrawIDARB
+#else
+/// Without shader draw parameters every draw is issued on its own, with its index set here
+uniform int drawIndex;
+#define DRAW_INDEX drawIndex
+#endif
+
+void main() {
+	gl_Position = objects[DRAW_INDEX].modelViewProjection * vec4(position, 1.0);
+}
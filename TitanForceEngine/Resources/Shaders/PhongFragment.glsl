@@ -1,23 +1,95 @@
-#version 410
+#version 430
 in  vec3 vertNormal;
-in  vec3 lightDir;
-in  vec3 eyeDir;
-in vec2 TexCoord;
+in  vec3 vertPos;
+flat in uint materialIndex;
 out vec4 fragColor;
 
+/// Written once per frame, see UniformBlocks.h
+layout (std140) uniform FrameData {
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 clusterScale; /// xy: clusters per pixel, zw: scale and bias turning log view depth into a slice
+	uvec4 clusterCounts; /// xyz: clusters along each axis, w: lights this frame
+};
+
+/// A point light in view space, see LightCuller.h
+struct LightUniforms {
+	vec4 positionRadius;
+	vec4 diffuse;
+	vec4 ambient;
+};
+
+layout (std430) readonly buffer LightData {
+	LightUniforms lights[];
+};
+
+/// Offset into lightIndices and number of lights of every cluster
+layout (std430) readonly buffer ClusterData {
+	uvec2 clusters[];
+};
+
+layout (std430) readonly buffer LightIndexData {
+	uint lightIndices[];
+};
+
+/// Every material in use, see MaterialTable.h
+struct MaterialUniforms {
+	vec4 ambient;
+	vec4 diffuse; /// w: opacity
+	vec4 specular; /// w: shininess
+};
+
+layout (std430) readonly buffer MaterialData {
+	MaterialUniforms materials[];
+};
+
+uint GetCluster() {
+	uvec3 cluster;
+	cluster.xy = uvec2(gl_FragCoord.xy * clusterScale.xy);
+	cluster.z = uint(max(log(-vertPos.z) * clusterScale.z + clusterScale.w, 0.0));
+	cluster = min(cluster, clusterCounts.xyz - uvec3(1));
+	return cluster.x + clusterCounts.x * (cluster.y + clusterCounts.y * cluster.z);
+}
 
 void main() { 
-	const vec4 ks = vec4(0.6, 0.6, 0.6, 0.0);
-	const vec4 kd = vec4(0.6, 0.6, 0.6, 0.0); /// const means it cannot be changed just like C++
-	const vec4 ka = 0.1 * kd;
-	
-	float diff = max(dot(vertNormal, lightDir), 0.0);
-	/// Reflection is based incedent which means a vector from the light source
-	/// not the direction to the light source
-	vec3 reflection = normalize(reflect(-lightDir, vertNormal));
-	float spec = max(dot(eyeDir, reflection), 0.0);
-	if(diff > 0.0){
-		spec = pow(spec,14.0);
+	MaterialUniforms material = materials[materialIndex];
+	vec3 ks = material.specular.rgb;
+	vec3 kd = material.diffuse.rgb;
+	vec3 ka = material.ambient.rgb;
+
+	vec3 normal = normalize(vertNormal);
+	vec3 eyeDir = -normalize(vertPos);
+	vec3 colour = vec3(0.0);
+
+	/// Only the lights whose range reaches this fragment's cluster are looked at
+	uvec2 cluster = clusters[GetCluster()];
+	for (uint i = 0; i < cluster.y; ++i) {
+		LightUniforms light = lights[lightIndices[cluster.x + i]];
+		vec3 toLight = light.positionRadius.xyz - vertPos;
+		float distance = length(toLight);
+
+		/// Fades to nothing at the light's range, so cutting it off at the cluster edges is never visible
+		float falloff = clamp(1.0 - pow(distance / light.positionRadius.w, 4.0), 0.0, 1.0);
+		falloff *= falloff;
+		if (falloff <= 0.0) {
+			continue;
+		}
+
+		vec3 lightDir = toLight / max(distance, 1e-4);
+		float diff = max(dot(normal, lightDir), 0.0);
+		/// Reflection is based incedent which means a vector from the light source
+		/// not the direction to the light source
+		vec3 reflection = normalize(reflect(-lightDir, normal));
+		float spec = max(dot(eyeDir, reflection), 0.0);
+		if(diff > 0.0){
+			spec = pow(spec, material.specular.w);
+		}
+		else {
+			spec = 0.0;
+		}
+
+		colour += falloff * (light.ambient.rgb * ka + light.diffuse.rgb * (diff * kd + spec * ks));
 	}
-	fragColor =  ka + (diff * kd) + (spec * ks);	
+
+	fragColor = vec4(colour, material.diffuse.w);
 } 
@@ -1,24 +1,58 @@
-#version 410
+#version 430
+#extension GL_ARB_shader_draw_parameters : enable
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 normal;
+layout (location = 1) in vec2 normalOct; /// Octahedral encoded unit normal, see VertexLayout.h
 layout (location = 2) in vec2 texCoords;
-layout (location = 3) in vec3 colour;
 
 out vec3 vertNormal;
-out vec3 lightDir;
-out vec3 eyeDir; 
+out vec3 vertPos;
+flat out uint materialIndex;
 
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 modelMatrix;
-uniform mat3 normalMatrix;
-uniform vec3 lightPos;
+/// Computed exactly like DepthVertex.glsl, so fragments land on the depth the pre-pass wrote
+invariant gl_Position;
+
+/// Written once per frame, see UniformBlocks.h
+layout (std140) uniform FrameData {
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 clusterScale; /// xy: clusters per pixel, zw: scale and bias turning log view depth into a slice
+	uvec4 clusterCounts; /// xyz: clusters along each axis, w: lights this frame
+};
+
+/// Written once per draw, see DrawExtractor. Both matrices hold rows, so vectors are multiplied from the left
+struct ObjectUniforms {
+	mat4 modelViewProjection;
+	mat3x4 modelMatrix;
+	mat3x4 normalMatrix;
+	uvec4 indices; /// x: entry of MaterialData, y: layer of the bound texture array
+};
+
+/// One entry per draw of a multi draw, indexed by the draw's id
+layout (std430) readonly buffer ObjectData {
+	ObjectUniforms objects[];
+};
+
+#ifdef GL_ARB_shader_draw_parameters
+#define DRAW_INDEX gl_DrawIDARB
+#else
+/// Without shader draw parameters every draw is issued on its own, with its index set here
+uniform int drawIndex;
+#define DRAW_INDEX drawIndex
+#endif
+
+vec3 DecodeOctahedral(vec2 e) {
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
 
 void main() {
-	vertNormal = normalize(normalMatrix * normal); /// Rotate the normal to the correct orientation 
-	vec3 vertPos = vec3(viewMatrix * modelMatrix * vec4(position, 1.0) ); /// This is the position of the vertex from the origin
-	vec3 vertDir = normalize(vertPos);
-	eyeDir = -vertDir;
-	lightDir = normalize(lightPos - vertPos); /// Create the light direction. I do the math with in class 
-	gl_Position =  projectionMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
+	materialIndex = objects[DRAW_INDEX].indices.x;
+	vec3 normal = vec4(DecodeOctahedral(normalOct), 0.0) * objects[DRAW_INDEX].normalMatrix;
+	vec3 worldPos = vec4(position, 1.0) * objects[DRAW_INDEX].modelMatrix;
+	vertNormal = normalize(mat3(viewMatrix) * normal); /// Rotate the normal into view space, like the lights
+	vertPos = vec3(viewMatrix * vec4(worldPos, 1.0)); /// This is the position of the vertex from the camera
+	gl_Position = objects[DRAW_INDEX].modelViewProjection * vec4(position, 1.0);
 }
\ No newline at end of file
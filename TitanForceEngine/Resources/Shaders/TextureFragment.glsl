@@ -1,12 +1,13 @@
-#version 410
+#version 430
 
 in vec2 TexCoord;
+flat in uint textureLayer;
 
-uniform sampler2D ourTexture;
+/// Every texture of the same format and size shares one array, see OpenGLTextureArrayPool.h
+uniform sampler2DArray ourTexture;
 
 out vec4 fragColor;
 
 void main() {
-	fragColor = texture(ourTexture, TexCoord);
+	fragColor = texture(ourTexture, vec3(TexCoord, float(textureLayer)));
 }
-
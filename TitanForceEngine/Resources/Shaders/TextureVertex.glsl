@@ -1,18 +1,46 @@
-#version 410
+#version 430
+#extension GL_ARB_shader_draw_parameters : enable
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 normal;
+layout (location = 1) in vec2 normalOct; /// Octahedral encoded unit normal, see VertexLayout.h
 layout (location = 2) in vec2 texCoords;
-layout (location = 3) in vec3 colour;
 
 out vec2 TexCoord;
+flat out uint textureLayer;
 
-uniform mat4 projectionMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 modelMatrix;
-uniform mat3 normalMatrix;
-uniform vec3 lightPos;
+/// Computed exactly like DepthVertex.glsl, so fragments land on the depth the pre-pass wrote
+invariant gl_Position;
+
+/// Written once per frame, see UniformBlocks.h
+layout (std140) uniform FrameData {
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	vec4 clusterScale; /// xy: clusters per pixel, zw: scale and bias turning log view depth into a slice
+	uvec4 clusterCounts; /// xyz: clusters along each axis, w: lights this frame
+};
+
+/// Written once per draw, see DrawExtractor. Both matrices hold rows, so vectors are multiplied from the left
+struct ObjectUniforms {
+	mat4 modelViewProjection;
+	mat3x4 modelMatrix;
+	mat3x4 normalMatrix;
+	uvec4 indices; /// x: entry of MaterialData, y: layer of the bound texture array
+};
+
+/// One entry per draw of a multi draw, indexed by the draw's id
+layout (std430) readonly buffer ObjectData {
+	ObjectUniforms objects[];
+};
+
+#ifdef GL_ARB_shader_draw_parameters
+#define DRAW_INDEX gl_DrawIDARB
+#else
+/// Without shader draw parameters every draw is issued on its own, with its index set here
+uniform int drawIndex;
+#define DRAW_INDEX drawIndex
+#endif
 
 void main() {
 	TexCoord = texCoords;
-	gl_Position =  projectionMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
+	textureLayer = objects[DRAW_INDEX].indices.y;
+	gl_Position = objects[DRAW_INDEX].modelViewProjection * vec4(position, 1.0);
 }
\ No newline at end of file
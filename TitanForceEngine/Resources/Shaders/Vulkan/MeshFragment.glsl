@@ -0,0 +1,27 @@
+#version 450
+/// Compiled to MeshFragment.spv by VulkanRenderer::LoadShaderModule whenever this file is newer, or ahead of time with:
+/// glslangValidator -V -S frag MeshFragment.glsl -o MeshFragment.spv
+layout (location = 0) in vec3 vertNormal;
+layout (location = 1) in vec2 vertTexCoords;
+
+layout (location = 0) out vec4 fragColor;
+
+/// Pushed for every draw, see VulkanRenderer::DrawConstants
+layout (push_constant) uniform DrawConstants {
+	mat4 modelViewProjection;
+	vec4 normalMatrix[3];
+	vec4 diffuse; /// w: opacity
+} draw;
+
+/// The model's texture, or a white placeholder until it is resident, see VulkanTexture2D
+layout (set = 0, binding = 0) uniform sampler2D diffuseMap;
+
+/// Until the Vulkan backend has clustered lights, every model is lit by a single world space light
+const vec3 lightDirection = normalize(vec3(0.3, 1.0, 0.5));
+const float ambient = 0.2;
+
+void main() {
+	vec4 albedo = texture(diffuseMap, vertTexCoords) * draw.diffuse;
+	float diffuseTerm = max(dot(normalize(vertNormal), lightDirection), 0.0);
+	fragColor = vec4(albedo.rgb * (ambient + (1.0 - ambient) * diffuseTerm), albedo.a);
+}
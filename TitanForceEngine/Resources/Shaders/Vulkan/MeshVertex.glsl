@@ -0,0 +1,32 @@
+#version 450
+/// Compiled to MeshVertex.spv by VulkanRenderer::LoadShaderModule whenever this file is newer, or ahead of time with:
+/// glslangValidator -V -S vert MeshVertex.glsl -o MeshVertex.spv
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec2 normalOct; /// Octahedral encoded unit normal, see VertexLayout.h
+layout (location = 2) in vec2 texCoords;
+
+layout (location = 0) out vec3 vertNormal;
+layout (location = 1) out vec2 vertTexCoords;
+
+/// Pushed for every draw, see VulkanRenderer::DrawConstants
+layout (push_constant) uniform DrawConstants {
+	mat4 modelViewProjection; /// Already corrected for Vulkan's clip space
+	vec4 normalMatrix[3]; /// Rows of the world space normal matrix
+	vec4 diffuse; /// w: opacity
+} draw;
+
+vec3 DecodeOctahedral(vec2 e) {
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+void main() {
+	/// Built from rows, so the normal is multiplied from the left
+	mat3 normalRows = mat3(draw.normalMatrix[0].xyz, draw.normalMatrix[1].xyz, draw.normalMatrix[2].xyz);
+	vertNormal = normalize(DecodeOctahedral(normalOct) * normalRows);
+	vertTexCoords = texCoords;
+	gl_Position = draw.modelViewProjection * vec4(position, 1.0);
+}
@@ -1,15 +1,136 @@
 #include "Engine/Core/Engine.h"
+#include "Engine/RenderCore/Loading/AssetCooker.h"
 
 #include "Apps/TestRun/TestRun.h"
 
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
 int main( int args, char* argv[] )
 {
 
-	Engine::Get()->Init( "Titan Force Engine", 120, 1280, 720 );
+	// --cook writes every cooked texture and mesh and exits, without a window or graphics context
+	bool isCooking = false;
+
+	// --headless draws offscreen without a window, for performance runs on machines without a display
+	// --frames, --dump-interval, --output and --capture-commands set the headless run's HeadlessSettings
+	// --baseline compares the run's frame stats against an earlier run's FrameStats.csv and exits with 1 if they regressed
+	// by more than --regression-threshold, a fraction of the baseline's medians
+	// --reference compares the last frame against a PPM image and exits with 1 if it differs by more than --image-tolerance,
+	// a mean difference per colour channel out of 255
+	bool isHeadless = false;
+	HeadlessSettings settings = { 600, 0, "./HeadlessRun", false, "", 0.1f, "", 2.0f };
+
+	// --no-depth-prepass shades every fragment that passes the depth test, for comparing against the depth pre-pass
+	// --no-dynamic-resolution always draws at the window's size, --min-resolution-scale sets how far it may drop
+	// Headless runs always draw at their fixed size, see RenderSettings::dynamicResolution
+	// The scale has to be a number, Engine::SetRenderSettings clamps it to the scales the renderer supports
+	RenderSettings renderSettings = Engine::Get()->GetRenderSettings();
+
+	for ( int i = 1; i < args; ++i )
+	{
+		const std::string argument = argv[i];
+		const bool hasValue = i + 1 < args;
+
+		if ( argument == "--cook" )
+		{
+			isCooking = true;
+		}
+		else if ( argument == "--headless" )
+		{
+			isHeadless = true;
+		}
+		else if ( argument == "--frames" && hasValue )
+		{
+			settings.frameCount = static_cast<unsigned int>( std::strtoul( argv[++i], nullptr, 10 ) );
+		}
+		else if ( argument == "--dump-interval" && hasValue )
+		{
+			settings.dumpInterval = static_cast<unsigned int>( std::strtoul( argv[++i], nullptr, 10 ) );
+		}
+		else if ( argument == "--output" && hasValue )
+		{
+			settings.outputDirectory = argv[++i];
+		}
+		else if ( argument == "--capture-commands" )
+		{
+			settings.captureCommands = true;
+		}
+		else if ( argument == "--baseline" && hasValue )
+		{
+			settings.baselinePath = argv[++i];
+		}
+		else if ( argument == "--regression-threshold" && hasValue )
+		{
+			const char* value = argv[++i];
+			char* end = nullptr;
+			settings.regressionThreshold = std::strtof( value, &end );
+			if ( end == value || *end != '\0' || !( settings.regressionThreshold >= 0.0f ) )
+			{
+				std::cerr << "--regression-threshold needs a fraction of at least 0, got: " << value << std::endl;
+				return 1;
+			}
+		}
+		else if ( argument == "--reference" && hasValue )
+		{
+			settings.referenceImagePath = argv[++i];
+		}
+		else if ( argument == "--image-tolerance" && hasValue )
+		{
+			const char* value = argv[++i];
+			char* end = nullptr;
+			settings.imageTolerance = std::strtof( value, &end );
+			if ( end == value || *end != '\0' || !( settings.imageTolerance >= 0.0f ) )
+			{
+				std::cerr << "--image-tolerance needs a difference of at least 0, got: " << value << std::endl;
+				return 1;
+			}
+		}
+		else if ( argument == "--no-depth-prepass" )
+		{
+			renderSettings.depthPrepass = false;
+		}
+		else if ( argument == "--no-dynamic-resolution" )
+		{
+			renderSettings.dynamicResolution = false;
+		}
+		else if ( argument == "--min-resolution-scale" && hasValue )
+		{
+			const char* value = argv[++i];
+			char* end = nullptr;
+			renderSettings.minResolutionScale = std::strtof( value, &end );
+			if ( end == value || *end != '\0' )
+			{
+				std::cerr << "--min-resolution-scale needs a number, got: " << value << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	if ( isCooking )
+	{
+		return AssetCooker::CookAll() ? 0 : 1;
+	}
+
+	Engine::Get()->SetRenderSettings( renderSettings );
+
+	const bool isInitialized = isHeadless ?
+		Engine::Get()->InitHeadless( "Titan Force Engine", 120, 1280, 720, settings ) :
+		Engine::Get()->Init( "Titan Force Engine", 120, 1280, 720 );
+
+	// Headless runs are scripted, so failing to start has to show in the exit code
+	if ( !isInitialized && isHeadless )
+	{
+		return 1;
+	}
 
-	Engine::Get()->LoadApplication( new TestRun() );
+	if ( !Engine::Get()->LoadApplication( new TestRun() ) && isHeadless )
+	{
+		return 1;
+	}
 
 	Engine::Get()->Run();
 
-	return 0;
-}
\ No newline at end of file
+	return isHeadless && Engine::Get()->HasHeadlessRunFailed() ? 1 : 0;
+}